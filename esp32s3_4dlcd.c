@@ -10,8 +10,11 @@
 
 #include <stdlib.h>
 #include <sys/cdefs.h>
+#include <string.h>
+#include <sys/param.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_lcd_panel_interface.h"
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_vendor.h"
@@ -20,8 +23,13 @@
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "esp_timer.h"
 
 #include "esp32s3_4dlcd.h"
+#include "esp32s3_4dlcd_pixel.h"
+#include "esp32s3_4dlcd_priv.h"
 
 static const char *TAG = "esp32s3_4dlcd";
 
@@ -35,36 +43,46 @@ static esp_err_t esp32s3_4dlcd_swap_xy(esp_lcd_panel_t *panel, bool swap_axes);
 static esp_err_t esp32s3_4dlcd_set_gap(esp_lcd_panel_t *panel, int x_gap, int y_gap);
 static esp_err_t esp32s3_4dlcd_disp_on_off(esp_lcd_panel_t *panel, bool off);
 
-#if defined(CONFIG_LCD_INTERFACE_QSPI)
+// Wait after SLPIN before the next command
+#define LCD_SLPIN_DELAY_MS          5
+
+#define PERF_TIME_RING              16          // colour transactions timed at once, more than any panel IO queues
+
+#define LCD_SLEEP_STATE_MAGIC       0x4D4C4344  // "DCLM", marks an esp32s3_4dlcd_sleep_state_t filled by the driver
+
+// QSPI panels take the command inside a 32-bit address phase: <opcode> <0x00> <cmd> <0x00>
 #define LCD_OPCODE_WRITE_CMD        (0x02ULL)
 #define LCD_OPCODE_READ_CMD         (0x03ULL)
 #define LCD_OPCODE_WRITE_COLOR      (0x32ULL)
 
-static esp_err_t tx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *param, size_t param_size)
-{
-    lcd_cmd &= 0xff;
-    lcd_cmd <<= 8;
-    lcd_cmd |= LCD_OPCODE_WRITE_CMD << 24;
-    return esp_lcd_panel_io_tx_param(io, lcd_cmd, param, param_size);
-}
+// Largest transfer of an SPI bus created with `max_transfer_sz` = 0 and DMA enabled, assumed on QSPI when the
+// application does not tell the bus limit: a larger transaction fails to queue rather than being split
+#define QSPI_DEFAULT_MAX_TRANSFER   4092
+// Users of transaction tracking on one panel at a time, e.g. a present queue and a submission queue
+#define LCD_TRANS_TRACKERS          4
 
-static esp_err_t tx_color(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *param, size_t param_size)
-{
-    lcd_cmd &= 0xff;
-    lcd_cmd <<= 8;
-    lcd_cmd |= LCD_OPCODE_WRITE_COLOR << 24;
-    return esp_lcd_panel_io_tx_color(io, lcd_cmd, param, param_size);
-}
-#else // CONFIG_LCD_INTERFACE_SPI
-#define tx_param(io, lcd_cmd, param, param_size) \
-    esp_lcd_panel_io_tx_param(io, lcd_cmd, param, param_size)
-#define tx_color(io, lcd_cmd, param, param_size) \
-    esp_lcd_panel_io_tx_color(io, lcd_cmd, param, param_size)
-#endif
+// What the driver needs to know about each controller, so panels of different models can be driven side by side
+typedef struct {
+    const char *name;
+    const uint8_t *init_seq;        // default init sequence, INIT_CMD byte code
+    size_t init_seq_size;
+    uint16_t width;                 // columns in native orientation
+    uint16_t height;                // rows in native orientation, the direction the controller scrolls in
+    uint8_t bits_per_pixel;         // default pixel format
+    uint8_t trans_queue_depth;      // colour transactions the panel IO is created to queue
+    uint16_t slpout_delay_ms;       // wait after SLPOUT before the panel accepts commands again
+    bool qspi;                      // commands are framed with a QSPI opcode, the memory write can't carry on without one
+    uint16_t max_transfer;          // colour transaction size assumed when the bus limit is not given, 0 for no limit
+    bool hw_scroll;                 // VSCRDEF/VSCSAD are supported
+    bool low_power_modes;           // partial (PTLAR/PTLON/NORON) and idle (IDMON/IDMOFF) modes are supported
+} esp32s3_4dlcd_model_info_t;
+
+static const esp32s3_4dlcd_model_info_t *model_info_get(esp32s3_4dlcd_model_t model);
 
 typedef struct {
     esp_lcd_panel_t base;
     esp_lcd_panel_io_handle_t io;
+    const esp32s3_4dlcd_model_info_t *model;
     int reset_gpio_num;
     bool reset_level;
     int x_gap;
@@ -72,48 +90,529 @@ typedef struct {
     uint8_t fb_bits_per_pixel;
     uint8_t madctl_val; // save current value of LCD_CMD_MADCTL register
     uint8_t colmod_val; // save current value of LCD_CMD_COLMOD register
+    bool inverted;      // INVON is in effect
+    bool display_on;    // DISPON is in effect
+    bool sleeping;      // SLPIN sent by esp32s3_4dlcd_sleep
     const esp32s3_4dlcd_init_cmd_t *init_cmds;
     uint16_t init_cmds_size;
+    struct {
+        int x_start;
+        int y_start;
+        int x_end;
+        int y_end;
+        bool valid;             // CASET/RASET above are what the controller currently holds
+    } window;                   // last address window sent to the controller, gap already applied
+    size_t stream_remaining;    // bytes left in the window opened by esp32s3_4dlcd_window_begin
+    bool stream_started;        // RAMWR has been sent, further pixels go with RAMWRC
+    uint8_t *chunk_buf[CONFIG_ESP32S3_4DLCD_CHUNK_BUF_COUNT];    // driver owned DMA buffers for pixel data generated by the driver, allocated on first use
+    uint32_t chunk_fence[CONFIG_ESP32S3_4DLCD_CHUNK_BUF_COUNT];  // last colour transaction that may read each buffer
+    uint8_t chunk_next;         // index of the chunk buffer to fill next
+    uint8_t chunk_fill_index;   // index of chunk_fill
+    size_t max_transfer;        // largest colour transaction the bus accepts, 0 if unlimited
+    uint64_t bounce_bytes;      // bytes copied out of PSRAM by draw_bitmap
+    uint64_t bounce_us;         // time spent in those draws
+    uint8_t *chunk_fill;        // chunk buffer being filled through esp32s3_4dlcd_stream_reserve, NULL if none
+    size_t chunk_len;           // bytes already written to chunk_fill
+    size_t chunk_cap;           // usable size of chunk_fill, a whole number of pixels
+    int64_t boot_start_us;      // esp_timer time of the last reset, or of init if it was not preceded by a reset
+    bool boot_reset;            // a reset started the bring-up init is part of
+    bool first_frame_pending;   // no draw_bitmap has completed since init
+    volatile bool first_frame_fenced;   // the first frame is queued, stamped when transaction first_frame_fence is done
+    uint32_t first_frame_fence;
+    esp32s3_4dlcd_boot_timing_t boot_timing;
+    struct {
+        int top;                // first row of the scroll area, gap not applied
+        int height;             // rows in the scroll area, 0 if no area is defined
+        int offset;             // area row shown at the top of the area
+        bool hw;                // the controller scrolls, otherwise esp32s3_4dlcd_scroll_sync redraws the area
+    } scroll;
+    struct {
+        int y_start;            // first row shown in partial mode, gap not applied
+        int y_end;              // row after the last one shown, equal to y_start in normal mode
+        bool hw;                // PTLON is in effect
+    } partial;
+    bool idle;                  // IDMON is in effect
+    esp32s3_4dlcd_rotation_t sw_rotation;   // rotation applied by draw_bitmap in software
+    volatile uint32_t trans_queued;     // colour transactions handed to the panel IO
+    volatile uint32_t trans_done;       // colour transactions completed, only counted while tracking is on
+    SemaphoreHandle_t trans_done_sem;   // given on every completion, NULL while tracking is off
+    struct {
+        esp_lcd_panel_io_color_trans_done_cb_t volatile cb;    // written last on track, cleared first on untrack
+        void *volatile ctx;
+        bool used;
+    } trackers[LCD_TRANS_TRACKERS];     // callbacks chained for each user of transaction tracking
+    uint8_t tracker_refs;
+    esp_lcd_panel_io_color_trans_done_cb_t io_user_cb;  // callback the panel IO was created with, see the vendor config
+    void *io_user_ctx;
+#if CONFIG_ESP32S3_4DLCD_IO_TRACE
+    esp32s3_4dlcd_trace_cb_t trace_cb;
+    void *trace_ctx;
+#endif
+#if CONFIG_ESP32S3_4DLCD_PERF_COUNTERS
+    esp32s3_4dlcd_perf_t perf;
+    portMUX_TYPE perf_lock;             // perf is also updated from the transaction done interrupt
+    int64_t perf_submit_us[PERF_TIME_RING]; // when each colour transaction in flight was handed to the panel IO, by sequence
+    int64_t perf_last_done_us;          // completion time of the previous colour transaction
+#endif
 } esp32s3_4dlcd_panel_t;
 
-esp_err_t esp_lcd_new_esp32s3_4dlcd(const esp_lcd_panel_io_handle_t io, esp_lcd_panel_handle_t *ret_panel)
+static void trans_stop(esp32s3_4dlcd_panel_t *esp32s3_4dlcd);
+
+#if CONFIG_ESP32S3_4DLCD_IO_TRACE
+static void trace_emit(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, esp32s3_4dlcd_trace_type_t type, int lcd_cmd,
+                       const void *data, size_t data_bytes, uint32_t delay_ms, uint32_t duration_us, esp_err_t result)
+{
+    if (esp32s3_4dlcd->trace_cb) {
+        esp32s3_4dlcd_trace_event_t event = {
+            .type = type,
+            .lcd_cmd = lcd_cmd,
+            .data = data,
+            .data_bytes = data_bytes,
+            .delay_ms = delay_ms,
+            .duration_us = duration_us,
+            .result = result,
+        };
+        esp32s3_4dlcd->trace_cb(&event, esp32s3_4dlcd->trace_ctx);
+    }
+}
+#define TRACE_EMIT(...) trace_emit(__VA_ARGS__)
+#else
+#define TRACE_EMIT(...)
+#endif
+
+#if CONFIG_ESP32S3_4DLCD_PERF_COUNTERS
+// Count a transaction handed to the panel IO
+static void perf_count(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, bool color, size_t bytes, esp_err_t result)
+{
+    esp32s3_4dlcd_perf_t *perf = &esp32s3_4dlcd->perf;
+    portENTER_CRITICAL(&esp32s3_4dlcd->perf_lock);
+    if (result != ESP_OK) {
+        if (color) {
+            perf->color_errors++;
+        } else {
+            perf->cmd_errors++;
+        }
+        perf->last_error = result;
+    } else if (color) {
+        perf->color_count++;
+        perf->color_bytes += bytes;
+        // only meaningful while completions are counted
+        uint32_t in_flight = esp32s3_4dlcd->trans_queued - esp32s3_4dlcd->trans_done;
+        if (esp32s3_4dlcd->trans_done_sem && in_flight > perf->queue_high_water) {
+            perf->queue_high_water = in_flight;
+        }
+    } else {
+        perf->cmd_count++;
+        perf->cmd_bytes += bytes;
+    }
+    portEXIT_CRITICAL(&esp32s3_4dlcd->perf_lock);
+}
+
+// Split the life of a completed colour transaction into time spent behind earlier ones and time on the wire
+static void IRAM_ATTR perf_color_done(esp32s3_4dlcd_panel_t *esp32s3_4dlcd)
+{
+    int64_t now_us = esp_timer_get_time();
+    esp32s3_4dlcd_perf_t *perf = &esp32s3_4dlcd->perf;
+    portENTER_CRITICAL_ISR(&esp32s3_4dlcd->perf_lock);
+    int64_t queued_us = esp32s3_4dlcd->perf_submit_us[esp32s3_4dlcd->trans_done % PERF_TIME_RING];
+    int64_t wire_start_us = MAX(queued_us, esp32s3_4dlcd->perf_last_done_us);
+    perf->queued_us += wire_start_us - queued_us;
+    perf->wire_us += now_us - wire_start_us;
+    perf->timed_count++;
+    esp32s3_4dlcd->perf_last_done_us = now_us;
+    portEXIT_CRITICAL_ISR(&esp32s3_4dlcd->perf_lock);
+}
+
+static void perf_draw(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, uint32_t duration_us)
+{
+    esp32s3_4dlcd_perf_t *perf = &esp32s3_4dlcd->perf;
+    int bucket = 0;
+    while (bucket < ESP32S3_4DLCD_PERF_HIST_BUCKETS - 1 && duration_us >= ((uint32_t)ESP32S3_4DLCD_PERF_HIST_BASE_US << bucket)) {
+        bucket++;
+    }
+    portENTER_CRITICAL(&esp32s3_4dlcd->perf_lock);
+    perf->draw_count++;
+    perf->draw_hist[bucket]++;
+    perf->draw_max_us = MAX(perf->draw_max_us, duration_us);
+    portEXIT_CRITICAL(&esp32s3_4dlcd->perf_lock);
+}
+#define PERF_COUNT(...)         perf_count(__VA_ARGS__)
+#define PERF_COLOR_DONE(...)    perf_color_done(__VA_ARGS__)
+#define PERF_DRAW(...)          perf_draw(__VA_ARGS__)
+#else
+#define PERF_COUNT(...)
+#define PERF_COLOR_DONE(...)
+#define PERF_DRAW(...)
+#endif
+
+static esp_err_t tx_param(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, int lcd_cmd, const void *param, size_t param_size)
+{
+    if (esp32s3_4dlcd->model->qspi) {
+        lcd_cmd &= 0xff;
+        lcd_cmd <<= 8;
+        lcd_cmd |= LCD_OPCODE_WRITE_CMD << 24;
+    }
+    esp_err_t ret = esp_lcd_panel_io_tx_param(esp32s3_4dlcd->io, lcd_cmd, param, param_size);
+    PERF_COUNT(esp32s3_4dlcd, false, param_size, ret);
+    TRACE_EMIT(esp32s3_4dlcd, ESP32S3_4DLCD_TRACE_PARAM, lcd_cmd, param, param_size, 0, 0, ret);
+    return ret;
+}
+
+static esp_err_t rx_param(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, int lcd_cmd, void *param, size_t param_size)
+{
+    if (esp32s3_4dlcd->model->qspi) {
+        lcd_cmd &= 0xff;
+        lcd_cmd <<= 8;
+        lcd_cmd |= LCD_OPCODE_READ_CMD << 24;
+    }
+    return esp_lcd_panel_io_rx_param(esp32s3_4dlcd->io, lcd_cmd, param, param_size);
+}
+
+static esp_err_t tx_color(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, int lcd_cmd, const void *param, size_t param_size)
+{
+    if (esp32s3_4dlcd->model->qspi) {
+        lcd_cmd &= 0xff;
+        lcd_cmd <<= 8;
+        lcd_cmd |= LCD_OPCODE_WRITE_COLOR << 24;
+    }
+    if (esp32s3_4dlcd->trans_done_sem) {
+        // back-pressure, never have more colour transactions in flight than the IO queue can hold
+        ESP_RETURN_ON_ERROR(esp32s3_4dlcd_trans_wait(&esp32s3_4dlcd->base, esp32s3_4dlcd->trans_queued - esp32s3_4dlcd->model->trans_queue_depth + 1, portMAX_DELAY),
+                            TAG, "wait for transaction queue failed");
+    }
+#if CONFIG_ESP32S3_4DLCD_PERF_COUNTERS
+    // stamped before queueing, the transaction may complete before tx_color returns
+    esp32s3_4dlcd->perf_submit_us[(esp32s3_4dlcd->trans_queued + 1) % PERF_TIME_RING] = esp_timer_get_time();
+#endif
+    esp_err_t ret = esp_lcd_panel_io_tx_color(esp32s3_4dlcd->io, lcd_cmd, param, param_size);
+    if (ret == ESP_OK) {
+        esp32s3_4dlcd->trans_queued++;
+    }
+    PERF_COUNT(esp32s3_4dlcd, true, param_size, ret);
+    TRACE_EMIT(esp32s3_4dlcd, ESP32S3_4DLCD_TRACE_COLOR, lcd_cmd, param, param_size, 0, 0, ret);
+    return ret;
+}
+
+static void panel_delay_ms(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, uint32_t delay_ms)
+{
+    TRACE_EMIT(esp32s3_4dlcd, ESP32S3_4DLCD_TRACE_DELAY, -1, NULL, 0, delay_ms, 0, ESP_OK);
+    vTaskDelay(pdMS_TO_TICKS(delay_ms));
+}
+
+// Set the address window for the following memory write, skipping CASET/RASET if the controller already holds it
+static esp_err_t set_window(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, int x_start, int y_start, int x_end, int y_end)
+{
+    if (esp32s3_4dlcd->window.valid &&
+            esp32s3_4dlcd->window.x_start == x_start && esp32s3_4dlcd->window.x_end == x_end &&
+            esp32s3_4dlcd->window.y_start == y_start && esp32s3_4dlcd->window.y_end == y_end) {
+        return ESP_OK;
+    }
+    esp32s3_4dlcd->window.valid = false;
+
+    // define an area of frame memory where MCU can access
+    ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_CASET, ((uint8_t[]) {
+        (x_start >> 8) & 0xFF,
+        x_start & 0xFF,
+        ((x_end - 1) >> 8) & 0xFF,
+        (x_end - 1) & 0xFF,
+    }), 4), TAG, "send command failed");
+    ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_RASET, ((uint8_t[]) {
+        (y_start >> 8) & 0xFF,
+        y_start & 0xFF,
+        ((y_end - 1) >> 8) & 0xFF,
+        (y_end - 1) & 0xFF,
+    }), 4), TAG, "send command failed");
+
+    esp32s3_4dlcd->window.x_start = x_start;
+    esp32s3_4dlcd->window.y_start = y_start;
+    esp32s3_4dlcd->window.x_end = x_end;
+    esp32s3_4dlcd->window.y_end = y_end;
+    esp32s3_4dlcd->window.valid = true;
+    return ESP_OK;
+}
+
+// Send pixel data into the current window, continuing where the previous chunk stopped
+static esp_err_t stream_push(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, const void *color_data, size_t len)
+{
+    // RAMWR restarts at the window origin, RAMWRC carries on where the previous chunk stopped
+    int command = esp32s3_4dlcd->stream_started ? LCD_CMD_RAMWRC : LCD_CMD_RAMWR;
+    // on SPI the memory write also carries on with no command at all, which lets the panel IO queue the chunk instead
+    // of waiting for the previous one; only do so when chunk buffers are released through fences.
+    // The QSPI controller takes pixels only in the CS window that opened with the 0x32 opcode, which the panel IO holds
+    // from the command through the data of one transaction, so every segment is framed with its own RAMWR/RAMWRC.
+    if (!esp32s3_4dlcd->model->qspi && esp32s3_4dlcd->stream_started && esp32s3_4dlcd->trans_done_sem) {
+        command = -1;
+    }
+    ESP_RETURN_ON_ERROR(tx_color(esp32s3_4dlcd, command, color_data, len), TAG, "send color failed");
+    esp32s3_4dlcd->stream_started = true;
+    return ESP_OK;
+}
+
+// Get the chunk buffer to fill next, in ring order. While chunks are sent with a command, the panel IO waits for queued
+// colour transactions before sending the next one, so once chunk N has been pushed chunk N-1 is off the wire and two
+// buffers are enough. Chunks queued without a command are released through their fence instead.
+static esp_err_t chunk_buf_get(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, uint8_t **buf)
+{
+    uint8_t i = esp32s3_4dlcd->chunk_next;
+    if (!esp32s3_4dlcd->chunk_buf[i]) {
+        esp32s3_4dlcd->chunk_buf[i] = heap_caps_malloc(CONFIG_ESP32S3_4DLCD_CHUNK_BUF_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        ESP_RETURN_ON_FALSE(esp32s3_4dlcd->chunk_buf[i], ESP_ERR_NO_MEM, TAG, "no mem for chunk buffer");
+    } else if (esp32s3_4dlcd->trans_done_sem) {
+        ESP_RETURN_ON_ERROR(esp32s3_4dlcd_trans_wait(&esp32s3_4dlcd->base, esp32s3_4dlcd->chunk_fence[i], portMAX_DELAY),
+                            TAG, "wait for chunk buffer failed");
+    }
+    *buf = esp32s3_4dlcd->chunk_buf[i];
+    esp32s3_4dlcd->chunk_fill_index = i;
+    esp32s3_4dlcd->chunk_next = (i + 1) % CONFIG_ESP32S3_4DLCD_CHUNK_BUF_COUNT;
+    return ESP_OK;
+}
+
+// RGB565 input is only converted for panels running in 18-bit mode, 16-bit panels take it as is
+static inline bool src_is_rgb565(esp32s3_4dlcd_panel_t *esp32s3_4dlcd)
+{
+#if CONFIG_ESP32S3_4DLCD_RGB565_INPUT
+    return esp32s3_4dlcd->fb_bits_per_pixel == 24;
+#else
+    return false;
+#endif
+}
+
+// Bytes per pixel of the colour data handed to the driver, which differs from the panel format when the driver converts it
+static inline size_t src_bytes_per_pixel(esp32s3_4dlcd_panel_t *esp32s3_4dlcd)
+{
+    return src_is_rgb565(esp32s3_4dlcd) ? 2 : esp32s3_4dlcd->fb_bits_per_pixel / 8;
+}
+
+static void copy_pixels(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, uint8_t *dst, const void *src, size_t pixels)
+{
+    if (src_is_rgb565(esp32s3_4dlcd)) {
+        esp32s3_4dlcd_rgb565_to_rgb666(dst, src, pixels);
+    } else {
+        memcpy(dst, src, pixels * esp32s3_4dlcd->fb_bits_per_pixel / 8);
+    }
+}
+
+// Program the scroll area and offset. The controller counts rows in native orientation, from the top of the glass,
+// so the area is flipped when MY is set and hardware scrolling is given up when MV makes the rows run sideways.
+static esp_err_t scroll_apply(esp32s3_4dlcd_panel_t *esp32s3_4dlcd)
+{
+    int top = esp32s3_4dlcd->scroll.top + esp32s3_4dlcd->y_gap;
+    int height = esp32s3_4dlcd->scroll.height;
+    int offset = esp32s3_4dlcd->scroll.offset;
+
+    int panel_height = esp32s3_4dlcd->model->height;
+    bool hw = esp32s3_4dlcd->model->hw_scroll && height && !(esp32s3_4dlcd->madctl_val & LCD_CMD_MV_BIT) &&
+              top >= 0 && top + height <= panel_height;
+    if (!hw) {
+        if (!esp32s3_4dlcd->scroll.hw) {
+            return ESP_OK;
+        }
+        // the controller was scrolling, put it back to its reset state: one unscrolled area covering the panel
+        top = 0;
+        height = panel_height;
+        offset = 0;
+    }
+    esp32s3_4dlcd->scroll.hw = hw;
+    if (esp32s3_4dlcd->madctl_val & LCD_CMD_MY_BIT) {
+        top = panel_height - top - height;
+        offset = (height - offset) % height;
+    }
+    int bottom = panel_height - top - height;
+    int start = top + offset;
+    ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_VSCRDEF, ((uint8_t[]) {
+        (top >> 8) & 0xFF,
+        top & 0xFF,
+        (height >> 8) & 0xFF,
+        height & 0xFF,
+        (bottom >> 8) & 0xFF,
+        bottom & 0xFF,
+    }), 6), TAG, "send command failed");
+    ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_VSCSAD, ((uint8_t[]) {
+        (start >> 8) & 0xFF,
+        start & 0xFF,
+    }), 2), TAG, "send command failed");
+    return ESP_OK;
+}
+
+// Program the partial area, in native rows like the scroll area. With MV set the rows the application draws run
+// across the native rows, so the whole panel is shown until the axes are swapped back.
+static esp_err_t partial_apply(esp32s3_4dlcd_panel_t *esp32s3_4dlcd)
+{
+    int panel_height = esp32s3_4dlcd->model->height;
+    int start = esp32s3_4dlcd->partial.y_start + esp32s3_4dlcd->y_gap;
+    int end = esp32s3_4dlcd->partial.y_end + esp32s3_4dlcd->y_gap;
+
+    bool hw = end > start && !(esp32s3_4dlcd->madctl_val & LCD_CMD_MV_BIT) && start >= 0 && end <= panel_height;
+    if (!hw) {
+        if (esp32s3_4dlcd->partial.hw) {
+            ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_NORON, NULL, 0), TAG, "send command failed");
+            esp32s3_4dlcd->partial.hw = false;
+        }
+        return ESP_OK;
+    }
+    if (esp32s3_4dlcd->madctl_val & LCD_CMD_MY_BIT) {
+        int flipped_start = panel_height - end;
+        end = panel_height - start;
+        start = flipped_start;
+    }
+    ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_PTLAR, ((uint8_t[]) {
+        (start >> 8) & 0xFF,
+        start & 0xFF,
+        ((end - 1) >> 8) & 0xFF,
+        (end - 1) & 0xFF,
+    }), 4), TAG, "send command failed");
+    if (!esp32s3_4dlcd->partial.hw) {
+        ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_PTLON, NULL, 0), TAG, "send command failed");
+        esp32s3_4dlcd->partial.hw = true;
+    }
+    return ESP_OK;
+}
+
+static inline bool partial_set(esp32s3_4dlcd_panel_t *esp32s3_4dlcd)
+{
+    return esp32s3_4dlcd->partial.y_end > esp32s3_4dlcd->partial.y_start;
+}
+
+static esp_err_t stream_begin(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, int x_start, int y_start, int x_end, int y_end)
+{
+    x_start += esp32s3_4dlcd->x_gap;
+    x_end += esp32s3_4dlcd->x_gap;
+    y_start += esp32s3_4dlcd->y_gap;
+    y_end += esp32s3_4dlcd->y_gap;
+
+    esp32s3_4dlcd->stream_started = false;
+    esp32s3_4dlcd->stream_remaining = 0;
+    esp32s3_4dlcd->chunk_fill = NULL;
+    return set_window(esp32s3_4dlcd, x_start, y_start, x_end, y_end);
+}
+
+static esp_err_t stream_reserve(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, uint8_t **dst, size_t *avail)
+{
+    if (!esp32s3_4dlcd->chunk_fill) {
+        ESP_RETURN_ON_ERROR(chunk_buf_get(esp32s3_4dlcd, &esp32s3_4dlcd->chunk_fill), TAG, "get chunk buffer failed");
+        size_t pixel_bytes = esp32s3_4dlcd->fb_bits_per_pixel / 8;
+        size_t cap = CONFIG_ESP32S3_4DLCD_CHUNK_BUF_SIZE;
+        if (esp32s3_4dlcd->max_transfer) {
+            cap = MIN(cap, esp32s3_4dlcd->max_transfer);
+        }
+        esp32s3_4dlcd->chunk_cap = cap / pixel_bytes * pixel_bytes;
+        esp32s3_4dlcd->chunk_len = 0;
+    }
+    *dst = esp32s3_4dlcd->chunk_fill + esp32s3_4dlcd->chunk_len;
+    *avail = esp32s3_4dlcd->chunk_cap - esp32s3_4dlcd->chunk_len;
+    return ESP_OK;
+}
+
+static esp_err_t stream_end(esp32s3_4dlcd_panel_t *esp32s3_4dlcd)
+{
+    esp_err_t ret = ESP_OK;
+    if (esp32s3_4dlcd->chunk_fill && esp32s3_4dlcd->chunk_len) {
+        ret = stream_push(esp32s3_4dlcd, esp32s3_4dlcd->chunk_fill, esp32s3_4dlcd->chunk_len);
+    }
+    if (esp32s3_4dlcd->chunk_fill) {
+        // whatever was pushed from this buffer is covered by the last queued transaction
+        esp32s3_4dlcd->chunk_fence[esp32s3_4dlcd->chunk_fill_index] = esp32s3_4dlcd->trans_queued;
+    }
+    esp32s3_4dlcd->chunk_fill = NULL;
+    return ret;
+}
+
+static esp_err_t stream_commit(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, size_t len)
+{
+    esp32s3_4dlcd->chunk_len += len;
+    if (esp32s3_4dlcd->chunk_len == esp32s3_4dlcd->chunk_cap) {
+        return stream_end(esp32s3_4dlcd);
+    }
+    return ESP_OK;
+}
+
+// Copy (or convert) source pixels into the chunk buffers, pushing each buffer as soon as it is full
+static esp_err_t stream_copy(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, const void *src, size_t pixels)
+{
+    const uint8_t *p = src;
+    size_t src_bytes = src_bytes_per_pixel(esp32s3_4dlcd);
+    size_t dst_bytes = esp32s3_4dlcd->fb_bits_per_pixel / 8;
+    while (pixels) {
+        uint8_t *dst = NULL;
+        size_t avail = 0;
+        ESP_RETURN_ON_ERROR(stream_reserve(esp32s3_4dlcd, &dst, &avail), TAG, "reserve chunk failed");
+        size_t n = MIN(pixels, avail / dst_bytes);
+        copy_pixels(esp32s3_4dlcd, dst, p, n);
+        ESP_RETURN_ON_ERROR(stream_commit(esp32s3_4dlcd, n * dst_bytes), TAG, "send chunk failed");
+        p += n * src_bytes;
+        pixels -= n;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_new_panel_esp32s3_4dlcd(const esp_lcd_panel_io_handle_t io, const esp_lcd_panel_dev_config_t *panel_dev_config,
+                                         esp_lcd_panel_handle_t *ret_panel)
 {
     esp_err_t ret = ESP_OK;
     esp32s3_4dlcd_panel_t *esp32s3_4dlcd = NULL;
     gpio_config_t io_conf = { 0 };
 
-    ESP_GOTO_ON_FALSE(io && ret_panel, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(io && panel_dev_config && ret_panel, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    const esp32s3_4dlcd_vendor_config_t *vendor_config = panel_dev_config->vendor_config;
+    const esp32s3_4dlcd_model_info_t *model = model_info_get(vendor_config ? vendor_config->model : ESP32S3_4DLCD_MODEL_KCONFIG);
+    ESP_GOTO_ON_FALSE(model, ESP_ERR_NOT_SUPPORTED, err, TAG, "unsupported panel model");
     esp32s3_4dlcd = (esp32s3_4dlcd_panel_t *)calloc(1, sizeof(esp32s3_4dlcd_panel_t));
     ESP_GOTO_ON_FALSE(esp32s3_4dlcd, ESP_ERR_NO_MEM, err, TAG, "no mem for esp32s3_4dlcd panel");
 
-#if LCD_RST_GPIO_NUM >= 0
-    io_conf.mode = GPIO_MODE_OUTPUT;
-    io_conf.pin_bit_mask = 1ULL << LCD_RST_GPIO_NUM;
-    ESP_GOTO_ON_ERROR(gpio_config(&io_conf), err, TAG, "configure GPIO for RST line failed");
-#endif
+    if (panel_dev_config->reset_gpio_num >= 0) {
+        io_conf.mode = GPIO_MODE_OUTPUT;
+        io_conf.pin_bit_mask = 1ULL << panel_dev_config->reset_gpio_num;
+        ESP_GOTO_ON_ERROR(gpio_config(&io_conf), err, TAG, "configure GPIO for RST line failed");
+        // keep the panel out of reset: after deep sleep the pad is still held, and the level latched here is the one
+        // it takes when `esp32s3_4dlcd_resume` releases it
+        gpio_set_level(panel_dev_config->reset_gpio_num, !panel_dev_config->flags.reset_active_high);
+    }
 
-#if (LCD_COLOR_ORDER == LCD_RGB_ELEMENT_ORDER_RGB)
-    esp32s3_4dlcd->madctl_val = 0;
-#elif (LCD_COLOR_ORDER == LCD_RGB_ELEMENT_ORDER_BGR)
-    esp32s3_4dlcd->madctl_val |= LCD_CMD_BGR_BIT;
-#else
-    ESP_GOTO_ON_FALSE(false, ESP_ERR_NOT_SUPPORTED, err, TAG, "unsupported rgb endian");
-#endif
+    switch (panel_dev_config->rgb_ele_order) {
+    case LCD_RGB_ELEMENT_ORDER_RGB:
+        esp32s3_4dlcd->madctl_val = 0;
+        break;
+    case LCD_RGB_ELEMENT_ORDER_BGR:
+        esp32s3_4dlcd->madctl_val |= LCD_CMD_BGR_BIT;
+        break;
+    default:
+        ESP_GOTO_ON_FALSE(false, ESP_ERR_NOT_SUPPORTED, err, TAG, "unsupported rgb endian");
+        break;
+    }
 
-#if (LCD_BITS_PER_PIXEL == 16)
-    esp32s3_4dlcd->colmod_val = 0x55; // 16 bits per pixel, RGB565 format
-    esp32s3_4dlcd->fb_bits_per_pixel = 16;
-#elif (LCD_BITS_PER_PIXEL == 18)
-    esp32s3_4dlcd->colmod_val = 0x66;
-    // each color component (R/G/B) should occupy the 6 high bits of a byte, which means 3 full bytes are required for a pixel
-    esp32s3_4dlcd->fb_bits_per_pixel = 24;
-#else
-    ESP_GOTO_ON_FALSE(false, ESP_ERR_NOT_SUPPORTED, err, TAG, "unsupported pixel width");
-#endif
+    // 0 picks the pixel format the model is wired for
+    switch (panel_dev_config->bits_per_pixel ? panel_dev_config->bits_per_pixel : model->bits_per_pixel) {
+    case 16:
+        esp32s3_4dlcd->colmod_val = 0x55; // 16 bits per pixel, RGB565 format
+        esp32s3_4dlcd->fb_bits_per_pixel = 16;
+        break;
+    case 18:
+        esp32s3_4dlcd->colmod_val = 0x66;
+        // each color component (R/G/B) should occupy the 6 high bits of a byte, which means 3 full bytes are required for a pixel
+        esp32s3_4dlcd->fb_bits_per_pixel = 24;
+        break;
+    default:
+        ESP_GOTO_ON_FALSE(false, ESP_ERR_NOT_SUPPORTED, err, TAG, "unsupported pixel width");
+        break;
+    }
 
     esp32s3_4dlcd->io = io;
-    esp32s3_4dlcd->reset_gpio_num = LCD_RST_GPIO_NUM;
-    esp32s3_4dlcd->reset_level = LCD_RST_ACTIVE_HIGH;
+    esp32s3_4dlcd->model = model;
+#if CONFIG_ESP32S3_4DLCD_PERF_COUNTERS
+    esp32s3_4dlcd->perf_lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+#endif
+    esp32s3_4dlcd->reset_gpio_num = panel_dev_config->reset_gpio_num;
+    esp32s3_4dlcd->reset_level = panel_dev_config->flags.reset_active_high;
+    if (vendor_config) {
+        esp32s3_4dlcd->init_cmds = vendor_config->init_cmds;
+        esp32s3_4dlcd->init_cmds_size = vendor_config->init_cmds_size;
+        esp32s3_4dlcd->io_user_cb = vendor_config->on_color_trans_done;
+        esp32s3_4dlcd->io_user_ctx = vendor_config->user_ctx;
+    }
+    size_t max_transfer = (vendor_config && vendor_config->max_transfer_sz) ? vendor_config->max_transfer_sz : model->max_transfer;
+    size_t pixel_bytes = esp32s3_4dlcd->fb_bits_per_pixel / 8;
+    ESP_GOTO_ON_FALSE(!max_transfer || max_transfer >= pixel_bytes, ESP_ERR_INVALID_ARG, err, TAG, "transfer size below one pixel");
+    esp32s3_4dlcd->max_transfer = max_transfer / pixel_bytes * pixel_bytes;
     esp32s3_4dlcd->base.del = esp32s3_4dlcd_del;
     esp32s3_4dlcd->base.reset = esp32s3_4dlcd_reset;
     esp32s3_4dlcd->base.init = esp32s3_4dlcd_init;
@@ -127,20 +626,26 @@ esp_err_t esp_lcd_new_esp32s3_4dlcd(const esp_lcd_panel_io_handle_t io, esp_lcd_
     *ret_panel = &(esp32s3_4dlcd->base);
     ESP_LOGD(TAG, "new esp32s3_4dlcd panel @%p", esp32s3_4dlcd);
 
-    ESP_LOGI(TAG, "LCD panel create success");
+    ESP_LOGI(TAG, "LCD panel create success, %s", model->name);
 
     return ESP_OK;
 
 err:
     if (esp32s3_4dlcd) {
-#if LCD_RST_GPIO_NUM >= 0
-        gpio_reset_pin(LCD_RST_GPIO_NUM);
-#endif
+        if (panel_dev_config->reset_gpio_num >= 0) {
+            gpio_reset_pin(panel_dev_config->reset_gpio_num);
+        }
         free(esp32s3_4dlcd);
     }
     return ret;
 }
 
+esp_err_t esp_lcd_new_esp32s3_4dlcd(const esp_lcd_panel_io_handle_t io, esp_lcd_panel_handle_t *ret_panel)
+{
+    const esp_lcd_panel_dev_config_t panel_dev_config = ESP32S3_4DLCD_PANEL_DEV_CONFIG(NULL);
+    return esp_lcd_new_panel_esp32s3_4dlcd(io, &panel_dev_config, ret_panel);
+}
+
 static esp_err_t esp32s3_4dlcd_del(esp_lcd_panel_t *panel)
 {
     esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
@@ -148,6 +653,10 @@ static esp_err_t esp32s3_4dlcd_del(esp_lcd_panel_t *panel)
     if (esp32s3_4dlcd->reset_gpio_num >= 0) {
         gpio_reset_pin(esp32s3_4dlcd->reset_gpio_num);
     }
+    trans_stop(esp32s3_4dlcd);
+    for (int i = 0; i < CONFIG_ESP32S3_4DLCD_CHUNK_BUF_COUNT; i++) {
+        heap_caps_free(esp32s3_4dlcd->chunk_buf[i]);
+    }
     ESP_LOGD(TAG, "del esp32s3_4dlcd panel @%p", esp32s3_4dlcd);
     free(esp32s3_4dlcd);
     return ESP_OK;
@@ -156,272 +665,641 @@ static esp_err_t esp32s3_4dlcd_del(esp_lcd_panel_t *panel)
 static esp_err_t esp32s3_4dlcd_reset(esp_lcd_panel_t *panel)
 {
     esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
-    esp_lcd_panel_io_handle_t io = esp32s3_4dlcd->io;
+    esp32s3_4dlcd->window.valid = false;
+    // the controller forgets its scroll area, display modes, inversion and display state on reset
+    esp32s3_4dlcd->scroll.height = 0;
+    esp32s3_4dlcd->scroll.hw = false;
+    esp32s3_4dlcd->partial.y_start = 0;
+    esp32s3_4dlcd->partial.y_end = 0;
+    esp32s3_4dlcd->partial.hw = false;
+    esp32s3_4dlcd->idle = false;
+    esp32s3_4dlcd->inverted = false;
+    esp32s3_4dlcd->display_on = false;
+    esp32s3_4dlcd->sleeping = false;
+    esp32s3_4dlcd->boot_start_us = esp_timer_get_time();
+    esp32s3_4dlcd->boot_reset = true;
+    esp32s3_4dlcd->boot_timing = (esp32s3_4dlcd_boot_timing_t) {
+        0
+    };
 
     // perform hardware reset
     if (esp32s3_4dlcd->reset_gpio_num >= 0) {
         gpio_set_level(esp32s3_4dlcd->reset_gpio_num, esp32s3_4dlcd->reset_level);
-        vTaskDelay(pdMS_TO_TICKS(10));
+        panel_delay_ms(esp32s3_4dlcd, 10);
         gpio_set_level(esp32s3_4dlcd->reset_gpio_num, !esp32s3_4dlcd->reset_level);
-        vTaskDelay(pdMS_TO_TICKS(10));
+        panel_delay_ms(esp32s3_4dlcd, 10);
     } else { // perform software reset
-        ESP_RETURN_ON_ERROR(tx_param(io, LCD_CMD_SWRESET, NULL, 0), TAG, "send command failed");
-        vTaskDelay(pdMS_TO_TICKS(20)); // spec, wait at least 5ms before sending new command
-    }
-
-    return ESP_OK;
-}
-
-static const esp32s3_4dlcd_init_cmd_t vendor_specific_init_default[] = {
-#if defined(CONFIG_ESP32S3_4DLCD_24) || \
-    defined(CONFIG_ESP32S3_4DLCD_28) || \
-    defined(CONFIG_ESP32S3_4DLCD_32)
-    { 0x11, NULL, 0, 120 },
-    { 0x13, NULL, 0, 0 },
-    { 0xEF, (uint8_t[]) { 0x01, 0x01, 0x00 }, 3, 0 },
-    { 0xCF, (uint8_t[]) { 0x00, 0xC1, 0x30 }, 3, 0 },
-    { 0xED, (uint8_t[]) { 0x64, 0x03, 0x12, 0x81 }, 4, 0 },
-    { 0xE8, (uint8_t[]) { 0x85, 0x00, 0x7a }, 3, 0 },
-    { 0xCB, (uint8_t[]) { 0x39, 0x2C, 0x00, 0x34, 0x02 }, 5, 0 },
-    { 0xF7, (uint8_t[]) { 0x20 }, 1, 0 },
-    { 0xEA, (uint8_t[]) { 0x00, 0x00}, 2, 0 },
-    { 0xC0, (uint8_t[]) { 0x26 }, 1, 0 },
-    { 0xC1, (uint8_t[]) { 0x11 }, 1, 0 },
-    { 0xC5, (uint8_t[]) { 0x39, 0x27}, 2, 0},
-    { 0xC7, (uint8_t[]) { 0xa6 }, 1, 0 },
-    { 0x36, (uint8_t[]) { 0x48 }, 1, 0 },
-    { 0x3A, (uint8_t[]) { 0x55 }, 1, 0 },
-    { 0xB1, (uint8_t[]) { 0x00, 0x1b}, 2, 0},
-    { 0xB6, (uint8_t[]) { 0x08, 0x82, 0x27}, 3, 0},
-    { 0xF2, (uint8_t[]) { 0x00 }, 1, 0 },
-    { 0x26, (uint8_t[]) { 0x01 }, 1, 0 },
-    { 0xE0, (uint8_t[]) { 0x0F, 0x2d, 0x0e, 0x08, 0x12, 0x0a, 0x3d, 0x95, 0x31, 0x04, 0x10, 0x09, 0x09, 0x0d, 0x00}, 0, 0 },
-    { 0xE1, (uint8_t[]) { 0x00, 0x12, 0x17, 0x03, 0x0d, 0x05, 0x2c, 0x44, 0x41, 0x05, 0x0F, 0x0a, 0x30, 0x32, 0x0F}, 15, 120 },
-#if defined(CONFIG_ESP32S3_4DLCD_32)
-    { 0x20, NULL, 0, 0 },
-#else
-    { 0x21, NULL, 0, 0 },
-#endif
-    { 0x29, NULL, 0, 120 },
-#elif defined(CONFIG_ESP32S3_4DLCD_35)
-    {0xE0, (uint8_t []){0x00, 0x13, 0x18, 0x04, 0x0F, 0x06, 0x3A, 0x56, 0x4D, 0x03, 0x0A, 0x06, 0x30, 0x3E, 0x0F}, 15, 0},
-    {0xE1, (uint8_t []){0x00, 0x13, 0x18, 0x01, 0x11, 0x06, 0x38, 0x34, 0x4D, 0x06, 0x0D, 0x0B, 0x31, 0x37, 0x0F}, 15, 0},
-    {0xC0, (uint8_t []){0x18, 0x16}, 2, 0},
-    {0xC1, (uint8_t []){0x45}, 1, 0},
-    {0xC5, (uint8_t []){0x00, 0x63, 0x01}, 3, 0},
-    {0x36, (uint8_t []){0x48}, 1, 0},
-    {0x3A, (uint8_t []){0x66}, 1, 0},
-    {0xB0, (uint8_t []){0x00}, 1, 0},
-    {0xB1, (uint8_t []){0xB0}, 1, 0},
-    {0xB4, (uint8_t []){0x02}, 1, 0},
-    {0xB6, (uint8_t []){0x02, 0x02}, 2, 0},
-    {0xE9, (uint8_t []){0x00}, 1, 0},
-    {0xF7, (uint8_t []){0xA9, 0x51, 0x2C, 0x82}, 4, 120},
-    {0x11, NULL, 0, 120},
-    {0x29, NULL, 0, 120},
-    {0x21, NULL, 0, 120},
-#elif defined(CONFIG_ESP32S3_4DLCD_43Q)
-    {0x38, NULL, 0, 0},
-    {0xff, (uint8_t []) {0xa5}, 1, 0},
-    {0xe7, (uint8_t []) {0x10}, 1, 0},
-    {0x35, (uint8_t []) {0x00}, 1, 0},
-    {0x36, (uint8_t []) {0xc0}, 1, 0},
-    {0x3A, (uint8_t []) {0x01}, 1, 0},
-    {0x40, (uint8_t []) {0x01}, 1, 0},
-    {0x41, (uint8_t []) {0x01}, 1, 0},
-    {0x44, (uint8_t []) {0x15}, 1, 0},
-    {0x45, (uint8_t []) {0x15}, 1, 0},
-    {0x7d, (uint8_t []) {0x02}, 1, 0},
-    {0xc1, (uint8_t []) {0xbb}, 1, 0},
-    {0xc2, (uint8_t []) {0x05}, 1, 0},
-    {0xc3, (uint8_t []) {0x10}, 1, 0},
-    {0xc6, (uint8_t []) {0x3e}, 1, 0},
-    {0xc7, (uint8_t []) {0x25}, 1, 0},
-    {0xc8, (uint8_t []) {0x11}, 1, 0},
-    {0x7a, (uint8_t []) {0x5f}, 1, 0},
-    {0x6f, (uint8_t []) {0x44}, 1, 0},
-    {0x78, (uint8_t []) {0x70}, 1, 0},
-    {0xc9, (uint8_t []) {0x00}, 1, 0},
-    {0x67, (uint8_t []) {0x21}, 1, 0},
-    {0x51, (uint8_t []) {0x0a}, 1, 0},
-    {0x52, (uint8_t []) {0x76}, 1, 0},
-    {0x53, (uint8_t []) {0x0a}, 1, 0},
-    {0x54, (uint8_t []) {0x76}, 1, 0},
-    {0x46, (uint8_t []) {0x0a}, 1, 0},
-    {0x47, (uint8_t []) {0x2a}, 1, 0},
-    {0x48, (uint8_t []) {0x0a}, 1, 0},
-    {0x49, (uint8_t []) {0x1a}, 1, 0},
-    {0x56, (uint8_t []) {0x43}, 1, 0},
-    {0x57, (uint8_t []) {0x42}, 1, 0},
-    {0x58, (uint8_t []) {0x3c}, 1, 0},
-    {0x59, (uint8_t []) {0x64}, 1, 0},
-    {0x5a, (uint8_t []) {0x41}, 1, 0},
-    {0x5b, (uint8_t []) {0x3c}, 1, 0},
-    {0x5c, (uint8_t []) {0x02}, 1, 0},
-    {0x5d, (uint8_t []) {0x3c}, 1, 0},
-    {0x5e, (uint8_t []) {0x1f}, 1, 0},
-    {0x60, (uint8_t []) {0x80}, 1, 0},
-    {0x61, (uint8_t []) {0x3f}, 1, 0},
-    {0x62, (uint8_t []) {0x21}, 1, 0},
-    {0x63, (uint8_t []) {0x07}, 1, 0},
-    {0x64, (uint8_t []) {0xe0}, 1, 0},
-    {0x65, (uint8_t []) {0x02}, 1, 0},
-    {0xca, (uint8_t []) {0x20}, 1, 0},
-    {0xcb, (uint8_t []) {0x52}, 1, 0},
-    {0xcc, (uint8_t []) {0x10}, 1, 0},
-    {0xcd, (uint8_t []) {0x42}, 1, 0},
-    {0xd0, (uint8_t []) {0x20}, 1, 0},
-    {0xd1, (uint8_t []) {0x52}, 1, 0},
-    {0xd2, (uint8_t []) {0x10}, 1, 0},
-    {0xd3, (uint8_t []) {0x42}, 1, 0},
-    {0xd4, (uint8_t []) {0x0a}, 1, 0},
-    {0xd5, (uint8_t []) {0x32}, 1, 0},
+        ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_SWRESET, NULL, 0), TAG, "send command failed");
+        panel_delay_ms(esp32s3_4dlcd, 20); // spec, wait at least 5ms before sending new command
+    }
+    esp32s3_4dlcd->boot_timing.reset_us = esp_timer_get_time() - esp32s3_4dlcd->boot_start_us;
+
+    return ESP_OK;
+}
+
+// Init sequences are compiled into a byte code: <len> <cmd> <len bytes of data>, or INIT_OP_DELAY <ms low> <ms high>.
+// The data length is counted by the preprocessor, so it can never disagree with the data itself.
+#define INIT_OP_DELAY               0xFF
+#define INIT_NARGS(...)             INIT_NARGS_(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, \
+                                                16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define INIT_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, \
+                    _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+#define INIT_CMD(cmd, ...)          INIT_NARGS(__VA_ARGS__), (cmd), __VA_ARGS__
+#define INIT_CMD0(cmd)              0, (cmd)
+#define INIT_DELAY(ms)              INIT_OP_DELAY, ((ms) & 0xFF), (((ms) >> 8) & 0xFF)
+
+// ILI9341 settings shared by the gen4-ESP32-24/28/32
+#define INIT_SEQ_ILI9341_COMMON \
+    INIT_CMD0(0x11), INIT_DELAY(120), \
+    INIT_CMD0(0x13), \
+    INIT_CMD(0xEF, 0x01, 0x01, 0x00), \
+    INIT_CMD(0xCF, 0x00, 0xC1, 0x30), \
+    INIT_CMD(0xED, 0x64, 0x03, 0x12, 0x81), \
+    INIT_CMD(0xE8, 0x85, 0x00, 0x7A), \
+    INIT_CMD(0xCB, 0x39, 0x2C, 0x00, 0x34, 0x02), \
+    INIT_CMD(0xF7, 0x20), \
+    INIT_CMD(0xEA, 0x00, 0x00), \
+    INIT_CMD(0xC0, 0x26), \
+    INIT_CMD(0xC1, 0x11), \
+    INIT_CMD(0xC5, 0x39, 0x27), \
+    INIT_CMD(0xC7, 0xA6), \
+    INIT_CMD(0x36, 0x48), \
+    INIT_CMD(0x3A, 0x55), \
+    INIT_CMD(0xB1, 0x00, 0x1B), \
+    INIT_CMD(0xB6, 0x08, 0x82, 0x27), \
+    INIT_CMD(0xF2, 0x00), \
+    INIT_CMD(0x26, 0x01), \
+    INIT_CMD(0xE0, 0x0F, 0x2D, 0x0E, 0x08, 0x12, 0x0A, 0x3D, 0x95, 0x31, 0x04, 0x10, 0x09, 0x09, 0x0D, 0x00), \
+    INIT_CMD(0xE1, 0x00, 0x12, 0x17, 0x03, 0x0D, 0x05, 0x2C, 0x44, 0x41, 0x05, 0x0F, 0x0A, 0x30, 0x32, 0x0F), INIT_DELAY(120),
+
+static const uint8_t init_seq_ili9341[] = {
+    INIT_SEQ_ILI9341_COMMON
+    INIT_CMD0(0x21),
+    INIT_CMD0(0x29), INIT_DELAY(120),
+};
+
+// the gen4-ESP32-32 glass is not inverted
+static const uint8_t init_seq_ili9341_32[] = {
+    INIT_SEQ_ILI9341_COMMON
+    INIT_CMD0(0x20),
+    INIT_CMD0(0x29), INIT_DELAY(120),
+};
+
+static const uint8_t init_seq_ili9488[] = {
+    INIT_CMD(0xE0, 0x00, 0x13, 0x18, 0x04, 0x0F, 0x06, 0x3A, 0x56, 0x4D, 0x03, 0x0A, 0x06, 0x30, 0x3E, 0x0F),
+    INIT_CMD(0xE1, 0x00, 0x13, 0x18, 0x01, 0x11, 0x06, 0x38, 0x34, 0x4D, 0x06, 0x0D, 0x0B, 0x31, 0x37, 0x0F),
+    INIT_CMD(0xC0, 0x18, 0x16),
+    INIT_CMD(0xC1, 0x45),
+    INIT_CMD(0xC5, 0x00, 0x63, 0x01),
+    INIT_CMD(0x36, 0x48),
+    INIT_CMD(0x3A, 0x66),
+    INIT_CMD(0xB0, 0x00),
+    INIT_CMD(0xB1, 0xB0),
+    INIT_CMD(0xB4, 0x02),
+    INIT_CMD(0xB6, 0x02, 0x02),
+    INIT_CMD(0xE9, 0x00),
+    INIT_CMD(0xF7, 0xA9, 0x51, 0x2C, 0x82), INIT_DELAY(120),
+    INIT_CMD0(0x11), INIT_DELAY(120),
+    INIT_CMD0(0x29), INIT_DELAY(120),
+    INIT_CMD0(0x21), INIT_DELAY(120),
+};
+
+static const uint8_t init_seq_nv3041a[] = {
+    INIT_CMD0(0x38),
+    INIT_CMD(0xFF, 0xA5),
+    INIT_CMD(0xE7, 0x10),
+    INIT_CMD(0x35, 0x00),
+    INIT_CMD(0x36, 0xC0),
+    INIT_CMD(0x3A, 0x01),
+    INIT_CMD(0x40, 0x01),
+    INIT_CMD(0x41, 0x01),
+    INIT_CMD(0x44, 0x15),
+    INIT_CMD(0x45, 0x15),
+    INIT_CMD(0x7D, 0x02),
+    INIT_CMD(0xC1, 0xBB),
+    INIT_CMD(0xC2, 0x05),
+    INIT_CMD(0xC3, 0x10),
+    INIT_CMD(0xC6, 0x3E),
+    INIT_CMD(0xC7, 0x25),
+    INIT_CMD(0xC8, 0x11),
+    INIT_CMD(0x7A, 0x5F),
+    INIT_CMD(0x6F, 0x44),
+    INIT_CMD(0x78, 0x70),
+    INIT_CMD(0xC9, 0x00),
+    INIT_CMD(0x67, 0x21),
+    INIT_CMD(0x51, 0x0A),
+    INIT_CMD(0x52, 0x76),
+    INIT_CMD(0x53, 0x0A),
+    INIT_CMD(0x54, 0x76),
+    INIT_CMD(0x46, 0x0A),
+    INIT_CMD(0x47, 0x2A),
+    INIT_CMD(0x48, 0x0A),
+    INIT_CMD(0x49, 0x1A),
+    INIT_CMD(0x56, 0x43),
+    INIT_CMD(0x57, 0x42),
+    INIT_CMD(0x58, 0x3C),
+    INIT_CMD(0x59, 0x64),
+    INIT_CMD(0x5A, 0x41),
+    INIT_CMD(0x5B, 0x3C),
+    INIT_CMD(0x5C, 0x02),
+    INIT_CMD(0x5D, 0x3C),
+    INIT_CMD(0x5E, 0x1F),
+    INIT_CMD(0x60, 0x80),
+    INIT_CMD(0x61, 0x3F),
+    INIT_CMD(0x62, 0x21),
+    INIT_CMD(0x63, 0x07),
+    INIT_CMD(0x64, 0xE0),
+    INIT_CMD(0x65, 0x02),
+    INIT_CMD(0xCA, 0x20),
+    INIT_CMD(0xCB, 0x52),
+    INIT_CMD(0xCC, 0x10),
+    INIT_CMD(0xCD, 0x42),
+    INIT_CMD(0xD0, 0x20),
+    INIT_CMD(0xD1, 0x52),
+    INIT_CMD(0xD2, 0x10),
+    INIT_CMD(0xD3, 0x42),
+    INIT_CMD(0xD4, 0x0A),
+    INIT_CMD(0xD5, 0x32),
     ///test  mode
-    {0xf8, (uint8_t []) {0x03}, 1, 0},
-    {0xf9, (uint8_t []) {0x20}, 1, 0},
-    {0x80, (uint8_t []) {0x00}, 1, 0},
-    {0xa0, (uint8_t []) {0x00}, 1, 0},
-    {0x81, (uint8_t []) {0x07}, 1, 0},
-    {0xa1, (uint8_t []) {0x06}, 1, 0},
-    {0x82, (uint8_t []) {0x02}, 1, 0},
-    {0xa2, (uint8_t []) {0x01}, 1, 0},
-    {0x86, (uint8_t []) {0x11}, 1, 0},
-    {0xa6, (uint8_t []) {0x10}, 1, 0},
-    {0x87, (uint8_t []) {0x27}, 1, 0},
-    {0xa7, (uint8_t []) {0x27}, 1, 0},
-    {0x83, (uint8_t []) {0x37}, 1, 0},
-    {0xa3, (uint8_t []) {0x37}, 1, 0},
-    {0x84, (uint8_t []) {0x35}, 1, 0},
-    {0xa4, (uint8_t []) {0x35}, 1, 0},
-    {0x85, (uint8_t []) {0x3f}, 1, 0},
-    {0xa5, (uint8_t []) {0x3f}, 1, 0},
-    {0x88, (uint8_t []) {0x0b}, 1, 0},
-    {0xa8, (uint8_t []) {0x0b}, 1, 0},
-    {0x89, (uint8_t []) {0x14}, 1, 0},
-    {0xa9, (uint8_t []) {0x14}, 1, 0},
-    {0x8a, (uint8_t []) {0x1a}, 1, 0},
-    {0xaa, (uint8_t []) {0x1a}, 1, 0},
-    {0x8b, (uint8_t []) {0x0a}, 1, 0},
-    {0xab, (uint8_t []) {0x0a}, 1, 0},
-    {0x8c, (uint8_t []) {0x14}, 1, 0},
-    {0xac, (uint8_t []) {0x08}, 1, 0},
-    {0x8d, (uint8_t []) {0x17}, 1, 0},
-    {0xad, (uint8_t []) {0x07}, 1, 0},
-    {0x8e, (uint8_t []) {0x16}, 1, 0},
-    {0xae, (uint8_t []) {0x06}, 1, 0},
-    {0x8f, (uint8_t []) {0x1b}, 1, 0},
-    {0xaf, (uint8_t []) {0x07}, 1, 0},
-    {0x90, (uint8_t []) {0x04}, 1, 0},
-    {0xb0, (uint8_t []) {0x04}, 1, 0},
-    {0x91, (uint8_t []) {0x0a}, 1, 0},
-    {0xb1, (uint8_t []) {0x0a}, 1, 0},
-    {0x92, (uint8_t []) {0x16}, 1, 0},
-    {0xb2, (uint8_t []) {0x15}, 1, 0},
-    {0xff, (uint8_t []) {0x00}, 1, 0},
-    {0x11, (uint8_t []) {0x00}, 1, 700},
-    {0x29, (uint8_t []) {0x00}, 1, 100},
-#else
-#error "No valid 4D Systems LCD model defined"
-#endif
+    INIT_CMD(0xF8, 0x03),
+    INIT_CMD(0xF9, 0x20),
+    INIT_CMD(0x80, 0x00),
+    INIT_CMD(0xA0, 0x00),
+    INIT_CMD(0x81, 0x07),
+    INIT_CMD(0xA1, 0x06),
+    INIT_CMD(0x82, 0x02),
+    INIT_CMD(0xA2, 0x01),
+    INIT_CMD(0x86, 0x11),
+    INIT_CMD(0xA6, 0x10),
+    INIT_CMD(0x87, 0x27),
+    INIT_CMD(0xA7, 0x27),
+    INIT_CMD(0x83, 0x37),
+    INIT_CMD(0xA3, 0x37),
+    INIT_CMD(0x84, 0x35),
+    INIT_CMD(0xA4, 0x35),
+    INIT_CMD(0x85, 0x3F),
+    INIT_CMD(0xA5, 0x3F),
+    INIT_CMD(0x88, 0x0B),
+    INIT_CMD(0xA8, 0x0B),
+    INIT_CMD(0x89, 0x14),
+    INIT_CMD(0xA9, 0x14),
+    INIT_CMD(0x8A, 0x1A),
+    INIT_CMD(0xAA, 0x1A),
+    INIT_CMD(0x8B, 0x0A),
+    INIT_CMD(0xAB, 0x0A),
+    INIT_CMD(0x8C, 0x14),
+    INIT_CMD(0xAC, 0x08),
+    INIT_CMD(0x8D, 0x17),
+    INIT_CMD(0xAD, 0x07),
+    INIT_CMD(0x8E, 0x16),
+    INIT_CMD(0xAE, 0x06),
+    INIT_CMD(0x8F, 0x1B),
+    INIT_CMD(0xAF, 0x07),
+    INIT_CMD(0x90, 0x04),
+    INIT_CMD(0xB0, 0x04),
+    INIT_CMD(0x91, 0x0A),
+    INIT_CMD(0xB1, 0x0A),
+    INIT_CMD(0x92, 0x16),
+    INIT_CMD(0xB2, 0x15),
+    INIT_CMD(0xFF, 0x00),
+    INIT_CMD(0x11, 0x00), INIT_DELAY(700),
+    INIT_CMD(0x29, 0x00), INIT_DELAY(100),
 };
 
+// Indexed by esp32s3_4dlcd_model_t
+static const esp32s3_4dlcd_model_info_t model_info[] = {
+    [ESP32S3_4DLCD_MODEL_24] = {
+        .name = "gen4-ESP32-24", .init_seq = init_seq_ili9341, .init_seq_size = sizeof(init_seq_ili9341),
+        .width = 240, .height = 320, .bits_per_pixel = 16, .trans_queue_depth = LCD_SPI_TRANS_QUEUE_DEPTH, .slpout_delay_ms = 5, .qspi = false, .hw_scroll = true,
+        .low_power_modes = true,
+    },
+    [ESP32S3_4DLCD_MODEL_28] = {
+        .name = "gen4-ESP32-28", .init_seq = init_seq_ili9341, .init_seq_size = sizeof(init_seq_ili9341),
+        .width = 240, .height = 320, .bits_per_pixel = 16, .trans_queue_depth = LCD_SPI_TRANS_QUEUE_DEPTH, .slpout_delay_ms = 5, .qspi = false, .hw_scroll = true,
+        .low_power_modes = true,
+    },
+    [ESP32S3_4DLCD_MODEL_32] = {
+        .name = "gen4-ESP32-32", .init_seq = init_seq_ili9341_32, .init_seq_size = sizeof(init_seq_ili9341_32),
+        .width = 240, .height = 320, .bits_per_pixel = 16, .trans_queue_depth = LCD_SPI_TRANS_QUEUE_DEPTH, .slpout_delay_ms = 5, .qspi = false, .hw_scroll = true,
+        .low_power_modes = true,
+    },
+    [ESP32S3_4DLCD_MODEL_35] = {
+        .name = "gen4-ESP32-35", .init_seq = init_seq_ili9488, .init_seq_size = sizeof(init_seq_ili9488),
+        .width = 320, .height = 480, .bits_per_pixel = 18, .trans_queue_depth = LCD_SPI_TRANS_QUEUE_DEPTH, .slpout_delay_ms = 5, .qspi = false, .hw_scroll = true,
+        .low_power_modes = true,
+    },
+    // the NV3041A has no vertical scrolling and needs longer to wake up
+    [ESP32S3_4DLCD_MODEL_43Q] = {
+        .name = "gen4-ESP32Q-43", .init_seq = init_seq_nv3041a, .init_seq_size = sizeof(init_seq_nv3041a),
+        .width = 480, .height = 272, .bits_per_pixel = 16, .trans_queue_depth = LCD_QSPI_TRANS_QUEUE_DEPTH, .slpout_delay_ms = 120, .qspi = true, .hw_scroll = false,
+        .low_power_modes = false, .max_transfer = QSPI_DEFAULT_MAX_TRANSFER,
+    },
+};
+
+static const esp32s3_4dlcd_model_info_t *model_info_get(esp32s3_4dlcd_model_t model)
+{
+    if (model == ESP32S3_4DLCD_MODEL_KCONFIG) {
+        model = LCD_KCONFIG_MODEL;
+    }
+    if ((unsigned)model >= sizeof(model_info) / sizeof(model_info[0]) || !model_info[model].init_seq) {
+        return NULL;
+    }
+    return &model_info[model];
+}
+
+// Send one init command, keeping track of the state the driver mirrors
+static esp_err_t send_init_cmd(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, int cmd, const uint8_t *data, size_t len)
+{
+    // Check if the command has been used or conflicts with the internal
+    bool is_cmd_overwritten = false;
+    switch (cmd) {
+    case LCD_CMD_MADCTL:
+        is_cmd_overwritten = true;
+        esp32s3_4dlcd->madctl_val = data ? data[0] : esp32s3_4dlcd->madctl_val;
+        break;
+    case LCD_CMD_COLMOD:
+        is_cmd_overwritten = true;
+        esp32s3_4dlcd->colmod_val = data ? data[0] : esp32s3_4dlcd->colmod_val;
+        break;
+    case LCD_CMD_INVON:
+    case LCD_CMD_INVOFF:
+        esp32s3_4dlcd->inverted = cmd == LCD_CMD_INVON;
+        break;
+    case LCD_CMD_DISPON:
+    case LCD_CMD_DISPOFF:
+        esp32s3_4dlcd->display_on = cmd == LCD_CMD_DISPON;
+        break;
+    case LCD_CMD_IDMON:
+    case LCD_CMD_IDMOFF:
+        esp32s3_4dlcd->idle = cmd == LCD_CMD_IDMON;
+        break;
+    default:
+        break;
+    }
+    if (is_cmd_overwritten) {
+        ESP_LOGW(TAG, "The %02Xh command has been used and will be overwritten by external initialization sequence", cmd);
+    }
+
+    ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, cmd, data, len), TAG, "send command failed");
+    if (cmd == LCD_CMD_DISPON) {
+        esp32s3_4dlcd->boot_timing.dispon_us = esp_timer_get_time() - esp32s3_4dlcd->boot_start_us;
+    }
+    return ESP_OK;
+}
+
+// Send an init sequence compiled with INIT_CMD/INIT_CMD0/INIT_DELAY
+static esp_err_t run_init_sequence(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, const uint8_t *seq, size_t size)
+{
+    uint32_t delay_ms = 0;
+    size_t i = 0;
+    while (i < size) {
+        uint8_t len = seq[i++];
+        if (len == INIT_OP_DELAY) {
+            ESP_RETURN_ON_FALSE(i + 2 <= size, ESP_ERR_INVALID_SIZE, TAG, "init sequence truncated at byte %u", (unsigned)i);
+            // consecutive delays are merged and only waited for before the next command
+            delay_ms += seq[i] | (seq[i + 1] << 8);
+            i += 2;
+            continue;
+        }
+        ESP_RETURN_ON_FALSE(i + 1 + len <= size, ESP_ERR_INVALID_SIZE, TAG, "init sequence truncated at byte %u", (unsigned)i);
+        uint8_t cmd = seq[i++];
+        const uint8_t *data = len ? &seq[i] : NULL;
+        i += len;
+
+        if (delay_ms) {
+            panel_delay_ms(esp32s3_4dlcd, delay_ms);
+            delay_ms = 0;
+        }
+        ESP_RETURN_ON_ERROR(send_init_cmd(esp32s3_4dlcd, cmd, data, len), TAG, "send init command failed");
+    }
+    if (delay_ms) {
+        panel_delay_ms(esp32s3_4dlcd, delay_ms);
+    }
+    return ESP_OK;
+}
+
+// Send an init sequence given through esp32s3_4dlcd_vendor_config_t
+static esp_err_t run_init_cmds(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, const esp32s3_4dlcd_init_cmd_t *cmds, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        ESP_RETURN_ON_ERROR(send_init_cmd(esp32s3_4dlcd, cmds[i].cmd, cmds[i].data, cmds[i].data_bytes), TAG, "send init command failed");
+        if (cmds[i].delay_ms) {
+            panel_delay_ms(esp32s3_4dlcd, cmds[i].delay_ms);
+        }
+    }
+    return ESP_OK;
+}
+
 static esp_err_t esp32s3_4dlcd_init(esp_lcd_panel_t *panel)
 {
     esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
-    esp_lcd_panel_io_handle_t io = esp32s3_4dlcd->io;
+    esp32s3_4dlcd->window.valid = false;
 
+    int64_t slpout_start_us = esp_timer_get_time();
+    if (!esp32s3_4dlcd->boot_reset) {
+        // init on its own starts a new bring-up, don't report one from an earlier reset
+        esp32s3_4dlcd->boot_start_us = slpout_start_us;
+        esp32s3_4dlcd->boot_timing = (esp32s3_4dlcd_boot_timing_t) {
+            0
+        };
+    }
+    esp32s3_4dlcd->boot_reset = false;
+    esp32s3_4dlcd->first_frame_fenced = false;
     // LCD goes into sleep mode and display will be turned off after power on reset, exit sleep mode first
-    ESP_RETURN_ON_ERROR(tx_param(io, LCD_CMD_SLPOUT, NULL, 0), TAG, "send command failed");
-    vTaskDelay(pdMS_TO_TICKS(100));
-    ESP_RETURN_ON_ERROR(tx_param(io, LCD_CMD_MADCTL, ((uint8_t[]) {
+    ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_SLPOUT, NULL, 0), TAG, "send command failed");
+    panel_delay_ms(esp32s3_4dlcd, 100);
+    esp32s3_4dlcd->boot_timing.slpout_us = esp_timer_get_time() - slpout_start_us;
+    ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_MADCTL, ((uint8_t[]) {
         esp32s3_4dlcd->madctl_val,
     }), 1), TAG, "send command failed");
-    ESP_RETURN_ON_ERROR(tx_param(io, LCD_CMD_COLMOD, ((uint8_t[]) {
+    ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_COLMOD, ((uint8_t[]) {
         esp32s3_4dlcd->colmod_val,
     }), 1), TAG, "send command failed");
 
-    const esp32s3_4dlcd_init_cmd_t *init_cmds = vendor_specific_init_default;
-    uint16_t init_cmds_size = sizeof(vendor_specific_init_default) / sizeof(esp32s3_4dlcd_init_cmd_t);
-
-    bool is_cmd_overwritten = false;
-    for (int i = 0; i < init_cmds_size; i++) {
-        // Check if the command has been used or conflicts with the internal
-        switch (init_cmds[i].cmd) {
-        case LCD_CMD_MADCTL:
-            is_cmd_overwritten = true;
-            esp32s3_4dlcd->madctl_val = ((uint8_t *)init_cmds[i].data)[0];
-            break;
-        case LCD_CMD_COLMOD:
-            is_cmd_overwritten = true;
-            esp32s3_4dlcd->colmod_val = ((uint8_t *)init_cmds[i].data)[0];
-            break;
-        default:
-            is_cmd_overwritten = false;
-            break;
-        }
-
-        if (is_cmd_overwritten) {
-            ESP_LOGW(TAG, "The %02Xh command has been used and will be overwritten by external initialization sequence", init_cmds[i].cmd);
-        }
-
-        // TODO: this might not work for QSPI 4.3" display
-        ESP_RETURN_ON_ERROR(tx_param(io, init_cmds[i].cmd, init_cmds[i].data, init_cmds[i].data_bytes), TAG, "send command failed");
-        vTaskDelay(pdMS_TO_TICKS(init_cmds[i].delay_ms));
+    int64_t table_start_us = esp_timer_get_time();
+    if (esp32s3_4dlcd->init_cmds) {
+        ESP_RETURN_ON_ERROR(run_init_cmds(esp32s3_4dlcd, esp32s3_4dlcd->init_cmds, esp32s3_4dlcd->init_cmds_size),
+                            TAG, "send init sequence failed");
+    } else {
+        ESP_RETURN_ON_ERROR(run_init_sequence(esp32s3_4dlcd, esp32s3_4dlcd->model->init_seq, esp32s3_4dlcd->model->init_seq_size),
+                            TAG, "send init sequence failed");
     }
+    esp32s3_4dlcd->boot_timing.init_table_us = esp_timer_get_time() - table_start_us;
+    esp32s3_4dlcd->first_frame_pending = true;
     ESP_LOGD(TAG, "send init commands success");
 
     return ESP_OK;
 }
 
-static esp_err_t esp32s3_4dlcd_draw_bitmap(esp_lcd_panel_t *panel, int x_start, int y_start, int x_end, int y_end, const void *color_data)
+// Draw through the software rotation, the frame is the panel as MADCTL presents it
+static esp_err_t draw_rotated(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, int x_start, int y_start, int x_end, int y_end,
+                              const void *color_data, size_t stride)
+{
+    bool swapped = esp32s3_4dlcd->madctl_val & LCD_CMD_MV_BIT;
+    int frame_width = swapped ? esp32s3_4dlcd->model->height : esp32s3_4dlcd->model->width;
+    int frame_height = swapped ? esp32s3_4dlcd->model->width : esp32s3_4dlcd->model->height;
+    return esp32s3_4dlcd_rotate_draw(&esp32s3_4dlcd->base, esp32s3_4dlcd->sw_rotation, frame_width, frame_height,
+                                     x_start, y_start, x_end, y_end, color_data, stride);
+}
+
+// The first frame after init is queued, it counts once its last transaction has left the bus. Only completions
+// counted by transaction tracking can tell, without it the frame goes unstamped rather than cost the draw a bus sync.
+static void first_frame_done(esp32s3_4dlcd_panel_t *esp32s3_4dlcd)
+{
+    if (!esp32s3_4dlcd->first_frame_pending) {
+        return;
+    }
+    esp32s3_4dlcd->first_frame_pending = false;
+    if (esp32s3_4dlcd->trans_done_sem) {
+        // stamped by the transaction done interrupt
+        esp32s3_4dlcd->first_frame_fence = esp32s3_4dlcd->trans_queued;
+        esp32s3_4dlcd->first_frame_fenced = true;
+    }
+}
+
+static esp_err_t draw_bitmap(esp32s3_4dlcd_panel_t *esp32s3_4dlcd, int x_start, int y_start, int x_end, int y_end, const void *color_data)
 {
-    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
     assert((x_start < x_end) && (y_start < y_end) && "start position must be smaller than end position");
-    esp_lcd_panel_io_handle_t io = esp32s3_4dlcd->io;
+
+    if (esp32s3_4dlcd->sw_rotation != ESP32S3_4DLCD_ROTATE_0) {
+        size_t stride = (size_t)(x_end - x_start) * src_bytes_per_pixel(esp32s3_4dlcd);
+        ESP_RETURN_ON_ERROR(draw_rotated(esp32s3_4dlcd, x_start, y_start, x_end, y_end, color_data, stride), TAG, "rotated draw failed");
+        first_frame_done(esp32s3_4dlcd);
+        return ESP_OK;
+    }
 
     x_start += esp32s3_4dlcd->x_gap;
     x_end += esp32s3_4dlcd->x_gap;
     y_start += esp32s3_4dlcd->y_gap;
     y_end += esp32s3_4dlcd->y_gap;
 
-    // define an area of frame memory where MCU can access
-    ESP_RETURN_ON_ERROR(tx_param(io, LCD_CMD_CASET, ((uint8_t[]) {
-        (x_start >> 8) & 0xFF,
-        x_start & 0xFF,
-        ((x_end - 1) >> 8) & 0xFF,
-        (x_end - 1) & 0xFF,
-    }), 4), TAG, "send command failed");
-    ESP_RETURN_ON_ERROR(tx_param(io, LCD_CMD_RASET, ((uint8_t[]) {
-        (y_start >> 8) & 0xFF,
-        y_start & 0xFF,
-        ((y_end - 1) >> 8) & 0xFF,
-        (y_end - 1) & 0xFF,
-    }), 4), TAG, "send command failed");
-    // transfer frame buffer
-    size_t len = (x_end - x_start) * (y_end - y_start) * esp32s3_4dlcd->fb_bits_per_pixel / 8;
-    tx_color(io, LCD_CMD_RAMWR, color_data, len);
+    // a plain draw closes any window opened with esp32s3_4dlcd_window_begin
+    esp32s3_4dlcd->stream_started = false;
+    esp32s3_4dlcd->stream_remaining = 0;
+    ESP_RETURN_ON_ERROR(set_window(esp32s3_4dlcd, x_start, y_start, x_end, y_end), TAG, "set window failed");
+    size_t pixels = (size_t)(x_end - x_start) * (y_end - y_start);
+    size_t len = pixels * esp32s3_4dlcd->fb_bits_per_pixel / 8;
+    if (src_is_rgb565(esp32s3_4dlcd)) {
+        // expand RGB565 into RGB666 chunk by chunk, converting the next chunk while the previous one is on the wire
+        ESP_RETURN_ON_ERROR(stream_copy(esp32s3_4dlcd, color_data, pixels), TAG, "send color failed");
+        ESP_RETURN_ON_ERROR(stream_end(esp32s3_4dlcd), TAG, "send color failed");
+        len = 0;
+    }
+#if CONFIG_ESP32S3_4DLCD_PSRAM_BOUNCE
+    if (len && esp_ptr_external_ram(color_data)) {
+        // copy PSRAM through the internal chunk buffers, the next chunk is copied while the previous one is on the wire
+        int64_t start_us = esp_timer_get_time();
+        ESP_RETURN_ON_ERROR(stream_copy(esp32s3_4dlcd, color_data, pixels), TAG, "send color failed");
+        ESP_RETURN_ON_ERROR(stream_end(esp32s3_4dlcd), TAG, "send color failed");
+        esp32s3_4dlcd->bounce_bytes += len;
+        esp32s3_4dlcd->bounce_us += esp_timer_get_time() - start_us;
+        len = 0;
+    }
+#endif
+    // transfer frame buffer, in pieces the bus accepts
+    const uint8_t *p = color_data;
+    while (len) {
+        size_t n = esp32s3_4dlcd->max_transfer ? MIN(len, esp32s3_4dlcd->max_transfer) : len;
+        ESP_RETURN_ON_ERROR(stream_push(esp32s3_4dlcd, p, n), TAG, "send color failed");
+        p += n;
+        len -= n;
+    }
+
+    first_frame_done(esp32s3_4dlcd);
+    return ESP_OK;
+}
+
+static esp_err_t esp32s3_4dlcd_draw_bitmap(esp_lcd_panel_t *panel, int x_start, int y_start, int x_end, int y_end, const void *color_data)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+#if CONFIG_ESP32S3_4DLCD_PERF_COUNTERS || CONFIG_ESP32S3_4DLCD_IO_TRACE
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = draw_bitmap(esp32s3_4dlcd, x_start, y_start, x_end, y_end, color_data);
+    uint32_t duration_us = esp_timer_get_time() - start_us;
+    PERF_DRAW(esp32s3_4dlcd, duration_us);
+    TRACE_EMIT(esp32s3_4dlcd, ESP32S3_4DLCD_TRACE_DRAW, -1, color_data,
+               (size_t)(x_end - x_start) * (y_end - y_start) * src_bytes_per_pixel(esp32s3_4dlcd), 0, duration_us, ret);
+    return ret;
+#else
+    return draw_bitmap(esp32s3_4dlcd, x_start, y_start, x_end, y_end, color_data);
+#endif
+}
+
+esp_err_t esp32s3_4dlcd_window_begin(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end)
+{
+    ESP_RETURN_ON_FALSE(panel && (x_start < x_end) && (y_start < y_end), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+
+    ESP_RETURN_ON_ERROR(stream_begin(esp32s3_4dlcd, x_start, y_start, x_end, y_end), TAG, "set window failed");
+    esp32s3_4dlcd->stream_remaining = (size_t)(x_end - x_start) * (y_end - y_start) * esp32s3_4dlcd->fb_bits_per_pixel / 8;
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_window_push(esp_lcd_panel_handle_t panel, const void *color_data, size_t len)
+{
+    ESP_RETURN_ON_FALSE(panel && color_data && len, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    ESP_RETURN_ON_FALSE(len <= esp32s3_4dlcd->stream_remaining, ESP_ERR_INVALID_SIZE, TAG, "data exceeds the open window");
+    ESP_RETURN_ON_FALSE(len % (esp32s3_4dlcd->fb_bits_per_pixel / 8) == 0, ESP_ERR_INVALID_SIZE, TAG, "data is not a whole number of pixels");
+
+    ESP_RETURN_ON_ERROR(stream_push(esp32s3_4dlcd, color_data, len), TAG, "send color failed");
+    esp32s3_4dlcd->stream_remaining -= len;
+    return ESP_OK;
+}
 
+esp_err_t esp32s3_4dlcd_window_end(esp_lcd_panel_handle_t panel)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    if (esp32s3_4dlcd->stream_remaining) {
+        ESP_LOGD(TAG, "window closed with %u bytes not written", (unsigned)esp32s3_4dlcd->stream_remaining);
+    }
+    esp32s3_4dlcd->stream_started = false;
+    esp32s3_4dlcd->stream_remaining = 0;
     return ESP_OK;
 }
 
+esp_err_t esp32s3_4dlcd_draw_bitmap_stride(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                          const void *color_data, size_t stride)
+{
+    ESP_RETURN_ON_FALSE(panel && color_data && (x_start < x_end) && (y_start < y_end), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    size_t width = x_end - x_start;
+    size_t row_bytes = width * src_bytes_per_pixel(esp32s3_4dlcd);
+    ESP_RETURN_ON_FALSE(stride >= row_bytes, ESP_ERR_INVALID_ARG, TAG, "stride shorter than a row");
+    if (esp32s3_4dlcd->sw_rotation != ESP32S3_4DLCD_ROTATE_0) {
+        return draw_rotated(esp32s3_4dlcd, x_start, y_start, x_end, y_end, color_data, stride);
+    }
+
+    // always copy, even contiguous rows: DMA would otherwise still be reading `color_data` after this returns
+    ESP_RETURN_ON_ERROR(stream_begin(esp32s3_4dlcd, x_start, y_start, x_end, y_end), TAG, "set window failed");
+    if (stride == row_bytes) {
+        ESP_RETURN_ON_ERROR(stream_copy(esp32s3_4dlcd, color_data, width * (y_end - y_start)), TAG, "send color failed");
+        return stream_end(esp32s3_4dlcd);
+    }
+    const uint8_t *row = color_data;
+    for (int y = y_start; y < y_end; y++) {
+        ESP_RETURN_ON_ERROR(stream_copy(esp32s3_4dlcd, row, width), TAG, "send color failed");
+        row += stride;
+    }
+    return stream_end(esp32s3_4dlcd);
+}
+
+esp_err_t esp32s3_4dlcd_stream_begin(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    return stream_begin(esp32s3_4dlcd, x_start, y_start, x_end, y_end);
+}
+
+esp_err_t esp32s3_4dlcd_stream_reserve(esp_lcd_panel_handle_t panel, uint8_t **dst, size_t *avail)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    return stream_reserve(esp32s3_4dlcd, dst, avail);
+}
+
+esp_err_t esp32s3_4dlcd_stream_commit(esp_lcd_panel_handle_t panel, size_t len)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    return stream_commit(esp32s3_4dlcd, len);
+}
+
+esp_err_t esp32s3_4dlcd_stream_end(esp_lcd_panel_handle_t panel)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    return stream_end(esp32s3_4dlcd);
+}
+
+esp_err_t esp32s3_4dlcd_stream_push(esp_lcd_panel_handle_t panel, const void *data, size_t len)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    return stream_push(esp32s3_4dlcd, data, len);
+}
+
+size_t esp32s3_4dlcd_pixel_bytes(esp_lcd_panel_handle_t panel)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    return esp32s3_4dlcd->fb_bits_per_pixel / 8;
+}
+
+size_t esp32s3_4dlcd_src_pixel_bytes(esp_lcd_panel_handle_t panel)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    return src_bytes_per_pixel(esp32s3_4dlcd);
+}
+
+esp_err_t esp32s3_4dlcd_bus_sync(esp_lcd_panel_handle_t panel)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    if (esp32s3_4dlcd->trans_done_sem) {
+        return esp32s3_4dlcd_trans_wait(panel, esp32s3_4dlcd->trans_queued, portMAX_DELAY);
+    }
+    // the panel IO finishes queued colour transactions before it sends a command
+    return tx_param(esp32s3_4dlcd, LCD_CMD_NOP, NULL, 0);
+}
+
+void esp32s3_4dlcd_frame_size(esp_lcd_panel_handle_t panel, int *width, int *height)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    bool swapped = esp32s3_4dlcd->madctl_val & LCD_CMD_MV_BIT;
+    if (esp32s3_4dlcd->sw_rotation == ESP32S3_4DLCD_ROTATE_90 || esp32s3_4dlcd->sw_rotation == ESP32S3_4DLCD_ROTATE_270) {
+        swapped = !swapped;
+    }
+    *width = swapped ? esp32s3_4dlcd->model->height : esp32s3_4dlcd->model->width;
+    *height = swapped ? esp32s3_4dlcd->model->width : esp32s3_4dlcd->model->height;
+}
+
+void esp32s3_4dlcd_unrotated_size(esp_lcd_panel_handle_t panel, int *width, int *height)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    bool swapped = esp32s3_4dlcd->madctl_val & LCD_CMD_MV_BIT;
+    *width = swapped ? esp32s3_4dlcd->model->height : esp32s3_4dlcd->model->width;
+    *height = swapped ? esp32s3_4dlcd->model->width : esp32s3_4dlcd->model->height;
+}
+
+bool esp32s3_4dlcd_scan_rows(esp_lcd_panel_handle_t panel, int *y_start, int *y_end, int *rows, bool *descending)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    *rows = esp32s3_4dlcd->model->height;
+    *descending = esp32s3_4dlcd->madctl_val & LCD_CMD_MY_BIT;
+    if ((esp32s3_4dlcd->madctl_val & LCD_CMD_MV_BIT) || esp32s3_4dlcd->sw_rotation != ESP32S3_4DLCD_ROTATE_0) {
+        return false;
+    }
+    int start = *y_start + esp32s3_4dlcd->y_gap;
+    int end = *y_end + esp32s3_4dlcd->y_gap;
+    if (esp32s3_4dlcd->madctl_val & LCD_CMD_MY_BIT) {
+        // MY only changes where memory writes land, bottom row first, the glass is still scanned from native row 0
+        int flipped_start = *rows - end;
+        end = *rows - start;
+        start = flipped_start;
+    }
+    *y_start = start;
+    *y_end = end;
+    return true;
+}
+
+const char *esp32s3_4dlcd_model_name(esp_lcd_panel_handle_t panel)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    return esp32s3_4dlcd->model->name;
+}
+
 static esp_err_t esp32s3_4dlcd_invert_color(esp_lcd_panel_t *panel, bool invert_color_data)
 {
     esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
-    esp_lcd_panel_io_handle_t io = esp32s3_4dlcd->io;
     int command = 0;
     if (invert_color_data) {
         command = LCD_CMD_INVON;
     } else {
         command = LCD_CMD_INVOFF;
     }
-    ESP_RETURN_ON_ERROR(tx_param(io, command, NULL, 0), TAG, "send command failed");
+    ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, command, NULL, 0), TAG, "send command failed");
+    esp32s3_4dlcd->inverted = invert_color_data;
     return ESP_OK;
 }
 
 static esp_err_t esp32s3_4dlcd_mirror(esp_lcd_panel_t *panel, bool mirror_x, bool mirror_y)
 {
     esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
-    esp_lcd_panel_io_handle_t io = esp32s3_4dlcd->io;
     if (mirror_x) {
         esp32s3_4dlcd->madctl_val |= LCD_CMD_MX_BIT;
     } else {
@@ -432,24 +1310,39 @@ static esp_err_t esp32s3_4dlcd_mirror(esp_lcd_panel_t *panel, bool mirror_x, boo
     } else {
         esp32s3_4dlcd->madctl_val &= ~LCD_CMD_MY_BIT;
     }
-    ESP_RETURN_ON_ERROR(tx_param(io, LCD_CMD_MADCTL, (uint8_t[]) {
+    // the address window is interpreted through MADCTL, send it again on the next draw
+    esp32s3_4dlcd->window.valid = false;
+    ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_MADCTL, (uint8_t[]) {
         esp32s3_4dlcd->madctl_val
     }, 1), TAG, "send command failed");
+    if (esp32s3_4dlcd->scroll.height) {
+        ESP_RETURN_ON_ERROR(scroll_apply(esp32s3_4dlcd), TAG, "set scroll area failed");
+    }
+    if (partial_set(esp32s3_4dlcd)) {
+        ESP_RETURN_ON_ERROR(partial_apply(esp32s3_4dlcd), TAG, "set partial area failed");
+    }
     return ESP_OK;
 }
 
 static esp_err_t esp32s3_4dlcd_swap_xy(esp_lcd_panel_t *panel, bool swap_axes)
 {
     esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
-    esp_lcd_panel_io_handle_t io = esp32s3_4dlcd->io;
     if (swap_axes) {
         esp32s3_4dlcd->madctl_val |= LCD_CMD_MV_BIT;
     } else {
         esp32s3_4dlcd->madctl_val &= ~LCD_CMD_MV_BIT;
     }
-    ESP_RETURN_ON_ERROR(tx_param(io, LCD_CMD_MADCTL, (uint8_t[]) {
+    // the address window is interpreted through MADCTL, send it again on the next draw
+    esp32s3_4dlcd->window.valid = false;
+    ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_MADCTL, (uint8_t[]) {
         esp32s3_4dlcd->madctl_val
     }, 1), TAG, "send command failed");
+    if (esp32s3_4dlcd->scroll.height) {
+        ESP_RETURN_ON_ERROR(scroll_apply(esp32s3_4dlcd), TAG, "set scroll area failed");
+    }
+    if (partial_set(esp32s3_4dlcd)) {
+        ESP_RETURN_ON_ERROR(partial_apply(esp32s3_4dlcd), TAG, "set partial area failed");
+    }
     return ESP_OK;
 }
 
@@ -458,53 +1351,522 @@ static esp_err_t esp32s3_4dlcd_set_gap(esp_lcd_panel_t *panel, int x_gap, int y_
     esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
     esp32s3_4dlcd->x_gap = x_gap;
     esp32s3_4dlcd->y_gap = y_gap;
+    if (esp32s3_4dlcd->scroll.height) {
+        ESP_RETURN_ON_ERROR(scroll_apply(esp32s3_4dlcd), TAG, "set scroll area failed");
+    }
+    if (partial_set(esp32s3_4dlcd)) {
+        ESP_RETURN_ON_ERROR(partial_apply(esp32s3_4dlcd), TAG, "set partial area failed");
+    }
     return ESP_OK;
 }
 
 static esp_err_t esp32s3_4dlcd_disp_on_off(esp_lcd_panel_t *panel, bool on_off)
 {
     esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
-    esp_lcd_panel_io_handle_t io = esp32s3_4dlcd->io;
     int command = 0;
     if (on_off) {
         command = LCD_CMD_DISPON;
     } else {
         command = LCD_CMD_DISPOFF;
     }
-    ESP_RETURN_ON_ERROR(tx_param(io, command, NULL, 0), TAG, "send command failed");
+    ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, command, NULL, 0), TAG, "send command failed");
+    esp32s3_4dlcd->display_on = on_off;
+    if (on_off && esp32s3_4dlcd->first_frame_pending) {
+        esp32s3_4dlcd->boot_timing.dispon_us = esp_timer_get_time() - esp32s3_4dlcd->boot_start_us;
+    }
     return ESP_OK;
 }
 
-esp_err_t backlight_init(void)
+static bool on_color_trans_done(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = (esp32s3_4dlcd_panel_t *)user_ctx;
+    BaseType_t need_yield = pdFALSE;
+    esp32s3_4dlcd->trans_done++;
+    PERF_COLOR_DONE(esp32s3_4dlcd);
+    if (esp32s3_4dlcd->first_frame_fenced && (int32_t)(esp32s3_4dlcd->trans_done - esp32s3_4dlcd->first_frame_fence) >= 0) {
+        esp32s3_4dlcd->first_frame_fenced = false;
+        esp32s3_4dlcd->boot_timing.first_frame_us = esp_timer_get_time() - esp32s3_4dlcd->boot_start_us;
+    }
+    xSemaphoreGiveFromISR(esp32s3_4dlcd->trans_done_sem, &need_yield);
+    for (int i = 0; i < LCD_TRANS_TRACKERS; i++) {
+        esp_lcd_panel_io_color_trans_done_cb_t cb = esp32s3_4dlcd->trackers[i].cb;
+        if (cb) {
+            need_yield |= cb(panel_io, edata, esp32s3_4dlcd->trackers[i].ctx);
+        }
+    }
+    if (esp32s3_4dlcd->io_user_cb) {
+        need_yield |= esp32s3_4dlcd->io_user_cb(panel_io, edata, esp32s3_4dlcd->io_user_ctx);
+    }
+    return need_yield == pdTRUE;
+}
+
+// Hand the panel IO callback back to the application, whoever is still tracking
+static void trans_stop(esp32s3_4dlcd_panel_t *esp32s3_4dlcd)
 {
-    // 1. Configure timer with 10-bit resolution
-    ledc_timer_config_t ledc_timer = {
-        .speed_mode       = LEDC_LOW_SPEED_MODE,
-        .duty_resolution  = LCD_BL_PWM_RESOLUTION,
-        .timer_num        = LEDC_TIMER_0,
-        .freq_hz          = LCD_BL_PWM_FREQ_HZ,
-        .clk_cfg          = LEDC_AUTO_CLK
+    if (!esp32s3_4dlcd->trans_done_sem) {
+        return;
+    }
+    const esp_lcd_panel_io_callbacks_t cbs = {
+        .on_color_trans_done = esp32s3_4dlcd->io_user_cb,
     };
-    ESP_RETURN_ON_ERROR(ledc_timer_config(&ledc_timer), TAG, "backlight timer configuration failed");
-
-    // 2. Configure channel
-    ledc_channel_config_t ledc_channel = {
-        .speed_mode     = LEDC_LOW_SPEED_MODE,
-        .channel        = LEDC_CHANNEL_0,
-        .timer_sel      = LEDC_TIMER_0,
-        .intr_type      = LEDC_INTR_DISABLE,
-        .gpio_num       = LCD_BL_GPIO_NUM,
-        .duty           = 0,    // Start with 0% duty cycle
-        .hpoint         = 0
+    esp_lcd_panel_io_register_event_callbacks(esp32s3_4dlcd->io, &cbs, esp32s3_4dlcd->io_user_ctx);
+    vSemaphoreDelete(esp32s3_4dlcd->trans_done_sem);
+    esp32s3_4dlcd->trans_done_sem = NULL;
+    memset(esp32s3_4dlcd->trackers, 0, sizeof(esp32s3_4dlcd->trackers));
+    esp32s3_4dlcd->tracker_refs = 0;
+}
+
+esp_err_t esp32s3_4dlcd_trans_track(esp_lcd_panel_handle_t panel, esp_lcd_panel_io_color_trans_done_cb_t user_cb, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    int slot = 0;
+    while (slot < LCD_TRANS_TRACKERS && esp32s3_4dlcd->trackers[slot].used) {
+        slot++;
+    }
+    ESP_RETURN_ON_FALSE(slot < LCD_TRANS_TRACKERS, ESP_ERR_NO_MEM, TAG, "too many users of transaction tracking");
+
+    if (!esp32s3_4dlcd->trans_done_sem) {
+        // colour transactions queued untracked would complete into the count and run it past trans_queued, which
+        // passes every later fence early; let them leave the bus before counting starts from trans_queued
+        ESP_RETURN_ON_ERROR(esp32s3_4dlcd_bus_sync(panel), TAG, "sync bus failed");
+        SemaphoreHandle_t sem = xSemaphoreCreateBinary();
+        ESP_RETURN_ON_FALSE(sem, ESP_ERR_NO_MEM, TAG, "no mem for transaction semaphore");
+        esp32s3_4dlcd->trans_done = esp32s3_4dlcd->trans_queued;
+        esp32s3_4dlcd->trans_done_sem = sem;
+        const esp_lcd_panel_io_callbacks_t cbs = {
+            .on_color_trans_done = on_color_trans_done,
+        };
+        esp_err_t ret = esp_lcd_panel_io_register_event_callbacks(esp32s3_4dlcd->io, &cbs, esp32s3_4dlcd);
+        if (ret != ESP_OK) {
+            esp32s3_4dlcd->trans_done_sem = NULL;
+            vSemaphoreDelete(sem);
+            ESP_LOGE(TAG, "register IO callbacks failed");
+            return ret;
+        }
+    }
+    // the done interrupt reads the callback, publish it after its context
+    esp32s3_4dlcd->trackers[slot].used = true;
+    esp32s3_4dlcd->trackers[slot].ctx = user_ctx;
+    esp32s3_4dlcd->trackers[slot].cb = user_cb;
+    esp32s3_4dlcd->tracker_refs++;
+    return ESP_OK;
+}
+
+void esp32s3_4dlcd_trans_untrack(esp_lcd_panel_handle_t panel, esp_lcd_panel_io_color_trans_done_cb_t user_cb, void *user_ctx)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    for (int i = 0; i < LCD_TRANS_TRACKERS; i++) {
+        if (esp32s3_4dlcd->trackers[i].used && esp32s3_4dlcd->trackers[i].cb == user_cb &&
+                esp32s3_4dlcd->trackers[i].ctx == user_ctx) {
+            esp32s3_4dlcd->trackers[i].cb = NULL;
+            esp32s3_4dlcd->trackers[i].used = false;
+            if (--esp32s3_4dlcd->tracker_refs == 0) {
+                trans_stop(esp32s3_4dlcd);
+            }
+            return;
+        }
+    }
+}
+
+uint32_t esp32s3_4dlcd_trans_seq(esp_lcd_panel_handle_t panel)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    return esp32s3_4dlcd->trans_queued;
+}
+
+bool esp32s3_4dlcd_trans_is_done(esp_lcd_panel_handle_t panel, uint32_t seq)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    // sequence numbers wrap, compare them through their signed distance
+    return (int32_t)(esp32s3_4dlcd->trans_done - seq) >= 0;
+}
+
+esp_err_t esp32s3_4dlcd_trans_wait(esp_lcd_panel_handle_t panel, uint32_t seq, TickType_t timeout)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    ESP_RETURN_ON_FALSE(esp32s3_4dlcd->trans_done_sem, ESP_ERR_INVALID_STATE, TAG, "transaction tracking not started");
+    TickType_t start = xTaskGetTickCount();
+    bool took = false;
+    while (!esp32s3_4dlcd_trans_is_done(panel, seq)) {
+        TickType_t wait = portMAX_DELAY;
+        if (timeout != portMAX_DELAY) {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if (elapsed >= timeout) {
+                return ESP_ERR_TIMEOUT;
+            }
+            wait = timeout - elapsed;
+        }
+        took |= xSemaphoreTake(esp32s3_4dlcd->trans_done_sem, wait) == pdTRUE;
+    }
+    if (took) {
+        // several users may be waiting on the panel, pass the wake-up on rather than keep it
+        xSemaphoreGive(esp32s3_4dlcd->trans_done_sem);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_get_boot_timing(esp_lcd_panel_handle_t panel, esp32s3_4dlcd_boot_timing_t *timing)
+{
+    ESP_RETURN_ON_FALSE(panel && timing, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    *timing = esp32s3_4dlcd->boot_timing;
+    return ESP_OK;
+}
+
+#if CONFIG_ESP32S3_4DLCD_IO_TRACE
+esp_err_t esp32s3_4dlcd_set_trace_callback(esp_lcd_panel_handle_t panel, esp32s3_4dlcd_trace_cb_t callback, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    esp32s3_4dlcd->trace_cb = callback;
+    esp32s3_4dlcd->trace_ctx = user_ctx;
+    return ESP_OK;
+}
+#endif
+
+#if CONFIG_ESP32S3_4DLCD_PERF_COUNTERS
+esp_err_t esp32s3_4dlcd_get_perf(esp_lcd_panel_handle_t panel, esp32s3_4dlcd_perf_t *perf)
+{
+    ESP_RETURN_ON_FALSE(panel && perf, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    portENTER_CRITICAL(&esp32s3_4dlcd->perf_lock);
+    *perf = esp32s3_4dlcd->perf;
+    portEXIT_CRITICAL(&esp32s3_4dlcd->perf_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_reset_perf(esp_lcd_panel_handle_t panel)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    portENTER_CRITICAL(&esp32s3_4dlcd->perf_lock);
+    esp32s3_4dlcd->perf = (esp32s3_4dlcd_perf_t) {
+        0
     };
-    ESP_RETURN_ON_ERROR(ledc_channel_config(&ledc_channel), TAG, "backlight channel configuration failed");
+    portEXIT_CRITICAL(&esp32s3_4dlcd->perf_lock);
+    return ESP_OK;
+}
+#endif
+
+esp_err_t esp32s3_4dlcd_sleep(esp_lcd_panel_handle_t panel, esp32s3_4dlcd_sleep_state_t *state)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+
+    ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_SLPIN, NULL, 0), TAG, "send command failed");
+    panel_delay_ms(esp32s3_4dlcd, LCD_SLPIN_DELAY_MS);
+    esp32s3_4dlcd->sleeping = true;
+    // the panel keeps its registers and frame memory for as long as it is not reset
+    if (esp32s3_4dlcd->reset_gpio_num >= 0) {
+        gpio_hold_en(esp32s3_4dlcd->reset_gpio_num);
+    }
+
+    if (state) {
+        *state = (esp32s3_4dlcd_sleep_state_t) {
+            .magic = LCD_SLEEP_STATE_MAGIC,
+            .madctl_val = esp32s3_4dlcd->madctl_val,
+            .colmod_val = esp32s3_4dlcd->colmod_val,
+            .inverted = esp32s3_4dlcd->inverted,
+            .display_on = esp32s3_4dlcd->display_on,
+            .x_gap = esp32s3_4dlcd->x_gap,
+            .y_gap = esp32s3_4dlcd->y_gap,
+            .scroll_top = esp32s3_4dlcd->scroll.top,
+            .scroll_height = esp32s3_4dlcd->scroll.height,
+            .scroll_offset = esp32s3_4dlcd->scroll.offset,
+            .partial_y_start = esp32s3_4dlcd->partial.y_start,
+            .partial_y_end = esp32s3_4dlcd->partial.y_end,
+            .idle = esp32s3_4dlcd->idle,
+        };
+    }
+    return ESP_OK;
+}
+
+// Check that the controller still holds the pixel format and orientation the driver believes it does
+static bool registers_intact(esp32s3_4dlcd_panel_t *esp32s3_4dlcd)
+{
+    // the first byte read back is a dummy
+    uint8_t madctl[2] = { 0 };
+    uint8_t colmod[2] = { 0 };
+    if (rx_param(esp32s3_4dlcd, LCD_CMD_RDD_MADCTL, madctl, sizeof(madctl)) != ESP_OK ||
+            rx_param(esp32s3_4dlcd, LCD_CMD_RDD_COLMOD, colmod, sizeof(colmod)) != ESP_OK) {
+        return false;
+    }
+    // the two lowest MADCTL bits and the top COLMOD bit are not reported
+    return (madctl[1] & 0xFC) == (esp32s3_4dlcd->madctl_val & 0xFC) && (colmod[1] & 0x77) == (esp32s3_4dlcd->colmod_val & 0x77);
+}
+
+esp_err_t esp32s3_4dlcd_resume(esp_lcd_panel_handle_t panel, const esp32s3_4dlcd_sleep_state_t *state, bool verify, bool *full_init)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    bool warm = state ? state->magic == LCD_SLEEP_STATE_MAGIC : esp32s3_4dlcd->sleeping;
+
+    if (esp32s3_4dlcd->reset_gpio_num >= 0) {
+        // latch the inactive level first, releasing the hold drives whatever is latched
+        gpio_set_level(esp32s3_4dlcd->reset_gpio_num, !esp32s3_4dlcd->reset_level);
+        gpio_hold_dis(esp32s3_4dlcd->reset_gpio_num);
+    }
+    if (state && warm) {
+        // the driver was restarted, e.g. after deep sleep, take over what the panel was left with
+        esp32s3_4dlcd->madctl_val = state->madctl_val;
+        esp32s3_4dlcd->colmod_val = state->colmod_val;
+        esp32s3_4dlcd->inverted = state->inverted;
+        esp32s3_4dlcd->display_on = state->display_on;
+        esp32s3_4dlcd->x_gap = state->x_gap;
+        esp32s3_4dlcd->y_gap = state->y_gap;
+        esp32s3_4dlcd->scroll.top = state->scroll_top;
+        esp32s3_4dlcd->scroll.height = state->scroll_height;
+        esp32s3_4dlcd->scroll.offset = state->scroll_offset;
+        esp32s3_4dlcd->scroll.hw = false;
+        esp32s3_4dlcd->partial.y_start = state->partial_y_start;
+        esp32s3_4dlcd->partial.y_end = state->partial_y_end;
+        esp32s3_4dlcd->partial.hw = false;
+        esp32s3_4dlcd->idle = state->idle;
+    }
+    esp32s3_4dlcd->window.valid = false;
+
+    if (warm) {
+        int64_t start_us = esp_timer_get_time();
+        ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_SLPOUT, NULL, 0), TAG, "send command failed");
+        panel_delay_ms(esp32s3_4dlcd, esp32s3_4dlcd->model->slpout_delay_ms);
+        esp32s3_4dlcd->boot_timing.slpout_us = esp_timer_get_time() - start_us;
+        if (verify && !registers_intact(esp32s3_4dlcd)) {
+            ESP_LOGW(TAG, "panel registers lost during sleep, running full init");
+            warm = false;
+        }
+    }
+    esp32s3_4dlcd->sleeping = false;
+    if (full_init) {
+        *full_init = !warm;
+    }
+    if (warm) {
+        // scrolling and the partial area are recomputed against the restored orientation, a few commands at most
+        if (esp32s3_4dlcd->scroll.height) {
+            ESP_RETURN_ON_ERROR(scroll_apply(esp32s3_4dlcd), TAG, "restore scroll area failed");
+        }
+        if (partial_set(esp32s3_4dlcd)) {
+            ESP_RETURN_ON_ERROR(partial_apply(esp32s3_4dlcd), TAG, "restore partial area failed");
+        }
+        return ESP_OK;
+    }
+
+    // cold path: the panel contents are gone, bring it back to the recorded state
+    uint8_t madctl_val = esp32s3_4dlcd->madctl_val;
+    bool inverted = esp32s3_4dlcd->inverted;
+    bool display_on = esp32s3_4dlcd->display_on;
+    int scroll_top = esp32s3_4dlcd->scroll.top;
+    int scroll_height = esp32s3_4dlcd->scroll.height;
+    int scroll_offset = esp32s3_4dlcd->scroll.offset;
+    int partial_y_start = esp32s3_4dlcd->partial.y_start;
+    int partial_y_end = esp32s3_4dlcd->partial.y_end;
+    bool idle = esp32s3_4dlcd->idle;
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_reset(panel), TAG, "reset failed");
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_init(panel), TAG, "init failed");
+    if (esp32s3_4dlcd->madctl_val != madctl_val) {
+        // the vendor table set its own orientation, put back the one the application chose
+        esp32s3_4dlcd->madctl_val = madctl_val;
+        ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_MADCTL, (uint8_t[]) {
+            madctl_val
+        }, 1), TAG, "send command failed");
+    }
+    if (esp32s3_4dlcd->inverted != inverted) {
+        ESP_RETURN_ON_ERROR(esp_lcd_panel_invert_color(panel, inverted), TAG, "restore inversion failed");
+    }
+    if (scroll_height) {
+        esp32s3_4dlcd->scroll.top = scroll_top;
+        esp32s3_4dlcd->scroll.height = scroll_height;
+        esp32s3_4dlcd->scroll.offset = scroll_offset;
+        ESP_RETURN_ON_ERROR(scroll_apply(esp32s3_4dlcd), TAG, "restore scroll area failed");
+    }
+    if (partial_y_end > partial_y_start) {
+        ESP_RETURN_ON_ERROR(esp32s3_4dlcd_set_partial_area(panel, partial_y_start, partial_y_end), TAG, "restore partial area failed");
+    }
+    if (esp32s3_4dlcd->idle != idle) {
+        ESP_RETURN_ON_ERROR(esp32s3_4dlcd_set_idle_mode(panel, idle), TAG, "restore idle mode failed");
+    }
+    if (esp32s3_4dlcd->display_on != display_on) {
+        ESP_RETURN_ON_ERROR(esp_lcd_panel_disp_on_off(panel, display_on), TAG, "restore display state failed");
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_set_sw_rotation(esp_lcd_panel_handle_t panel, esp32s3_4dlcd_rotation_t rotation)
+{
+    ESP_RETURN_ON_FALSE(panel && rotation >= ESP32S3_4DLCD_ROTATE_0 && rotation <= ESP32S3_4DLCD_ROTATE_270,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    esp32s3_4dlcd->sw_rotation = rotation;
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_set_partial_area(esp_lcd_panel_handle_t panel, int y_start, int y_end)
+{
+    ESP_RETURN_ON_FALSE(panel && y_start >= 0 && y_start < y_end, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    ESP_RETURN_ON_FALSE(esp32s3_4dlcd->model->low_power_modes, ESP_ERR_NOT_SUPPORTED, TAG, "partial mode not supported by %s",
+                        esp32s3_4dlcd->model->name);
+    ESP_RETURN_ON_FALSE(y_start + esp32s3_4dlcd->y_gap >= 0 && y_end + esp32s3_4dlcd->y_gap <= esp32s3_4dlcd->model->height,
+                        ESP_ERR_INVALID_ARG, TAG, "rows %d..%d are outside the panel", y_start, y_end);
+    esp32s3_4dlcd->partial.y_start = y_start;
+    esp32s3_4dlcd->partial.y_end = y_end;
+    return partial_apply(esp32s3_4dlcd);
+}
+
+esp_err_t esp32s3_4dlcd_set_normal_mode(esp_lcd_panel_handle_t panel)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    esp32s3_4dlcd->partial.y_start = 0;
+    esp32s3_4dlcd->partial.y_end = 0;
+    return partial_apply(esp32s3_4dlcd);
+}
+
+esp_err_t esp32s3_4dlcd_set_idle_mode(esp_lcd_panel_handle_t panel, bool idle)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    ESP_RETURN_ON_FALSE(esp32s3_4dlcd->model->low_power_modes, ESP_ERR_NOT_SUPPORTED, TAG, "idle mode not supported by %s",
+                        esp32s3_4dlcd->model->name);
+    // only the colour depth on the glass changes, frame memory and COLMOD keep the full format
+    ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, idle ? LCD_CMD_IDMON : LCD_CMD_IDMOFF, NULL, 0), TAG, "send command failed");
+    esp32s3_4dlcd->idle = idle;
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_set_tearing_effect(esp_lcd_panel_handle_t panel, bool on)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    if (on) {
+        // mode 0: the TE line only pulses during vertical blanking
+        ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_TEON, ((uint8_t[]) {
+            0x00,
+        }), 1), TAG, "send command failed");
+    } else {
+        ESP_RETURN_ON_ERROR(tx_param(esp32s3_4dlcd, LCD_CMD_TEOFF, NULL, 0), TAG, "send command failed");
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_set_max_transfer(esp_lcd_panel_handle_t panel, size_t max_transfer_sz)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    size_t pixel_bytes = esp32s3_4dlcd->fb_bits_per_pixel / 8;
+    ESP_RETURN_ON_FALSE(!max_transfer_sz || max_transfer_sz >= pixel_bytes, ESP_ERR_INVALID_ARG, TAG, "transfer size below one pixel");
+    // keep every transfer a whole number of pixels
+    esp32s3_4dlcd->max_transfer = max_transfer_sz / pixel_bytes * pixel_bytes;
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_get_bounce_stats(esp_lcd_panel_handle_t panel, esp32s3_4dlcd_bounce_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(panel && stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    stats->bytes = esp32s3_4dlcd->bounce_bytes;
+    stats->busy_us = esp32s3_4dlcd->bounce_us;
+    stats->bytes_per_sec = stats->busy_us ? (uint32_t)(stats->bytes * 1000000 / stats->busy_us) : 0;
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_reset_bounce_stats(esp_lcd_panel_handle_t panel)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    esp32s3_4dlcd->bounce_bytes = 0;
+    esp32s3_4dlcd->bounce_us = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_scroll_set_area(esp_lcd_panel_handle_t panel, int top, int height)
+{
+    ESP_RETURN_ON_FALSE(panel && top >= 0 && height >= 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    esp32s3_4dlcd->scroll.top = top;
+    esp32s3_4dlcd->scroll.height = height;
+    esp32s3_4dlcd->scroll.offset = 0;
+    return scroll_apply(esp32s3_4dlcd);
+}
+
+esp_err_t esp32s3_4dlcd_scroll_set_offset(esp_lcd_panel_handle_t panel, int offset)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    int height = esp32s3_4dlcd->scroll.height;
+    ESP_RETURN_ON_FALSE(height, ESP_ERR_INVALID_STATE, TAG, "no scroll area");
+
+    offset %= height;
+    esp32s3_4dlcd->scroll.offset = offset < 0 ? offset + height : offset;
+    return scroll_apply(esp32s3_4dlcd);
+}
+
+bool esp32s3_4dlcd_scroll_is_hw(esp_lcd_panel_handle_t panel)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    return esp32s3_4dlcd->scroll.hw;
+}
+
+int esp32s3_4dlcd_scroll_map_row(esp_lcd_panel_handle_t panel, int y)
+{
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    int top = esp32s3_4dlcd->scroll.top;
+    int height = esp32s3_4dlcd->scroll.height;
+    if (y < top || y >= top + height) {
+        return y;
+    }
+    return top + (y - top + esp32s3_4dlcd->scroll.offset) % height;
+}
+
+esp_err_t esp32s3_4dlcd_scroll_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                          const void *color_data)
+{
+    ESP_RETURN_ON_FALSE(panel && color_data && (x_start < x_end) && (y_start < y_end), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    if (!esp32s3_4dlcd->scroll.hw) {
+        // without hardware scrolling the screen is not rotated, draw where the caller asked
+        return esp_lcd_panel_draw_bitmap(panel, x_start, y_start, x_end, y_end, color_data);
+    }
+
+    // split into runs of rows that stay contiguous in frame memory: the fixed areas and the two sides of the wrap
+    size_t row_bytes = (size_t)(x_end - x_start) * src_bytes_per_pixel(esp32s3_4dlcd);
+    int area_end = esp32s3_4dlcd->scroll.top + esp32s3_4dlcd->scroll.height;
+    const uint8_t *p = color_data;
+    int y = y_start;
+    while (y < y_end) {
+        int mapped = esp32s3_4dlcd_scroll_map_row(panel, y);
+        int rows = y_end - y;
+        if (y < esp32s3_4dlcd->scroll.top) {
+            rows = MIN(rows, esp32s3_4dlcd->scroll.top - y);
+        } else if (y < area_end) {
+            rows = MIN(rows, MIN(area_end - y, area_end - mapped));
+        }
+        ESP_RETURN_ON_ERROR(esp_lcd_panel_draw_bitmap(panel, x_start, mapped, x_end, mapped + rows, p), TAG, "draw failed");
+        p += rows * row_bytes;
+        y += rows;
+    }
     return ESP_OK;
 }
 
-// Set brightness (0-255)
-esp_err_t backlight_set(uint8_t brightness)
+esp_err_t esp32s3_4dlcd_scroll_sync(esp_lcd_panel_handle_t panel, int x_start, int x_end, const void *area_data, size_t stride)
 {
-    ESP_RETURN_ON_ERROR(ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, brightness), TAG, "set backlight duty failed");
-    ESP_RETURN_ON_ERROR(ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0), TAG, "update backlight duty failed");
+    ESP_RETURN_ON_FALSE(panel && area_data && (x_start < x_end), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_panel_t *esp32s3_4dlcd = __containerof(panel, esp32s3_4dlcd_panel_t, base);
+    int top = esp32s3_4dlcd->scroll.top;
+    int height = esp32s3_4dlcd->scroll.height;
+    int offset = esp32s3_4dlcd->scroll.offset;
+    ESP_RETURN_ON_FALSE(height, ESP_ERR_INVALID_STATE, TAG, "no scroll area");
+    if (esp32s3_4dlcd->scroll.hw) {
+        return ESP_OK;
+    }
+
+    // redraw the area rotated by the offset: area rows offset..height-1 first, then 0..offset-1
+    const uint8_t *rows = area_data;
+    ESP_RETURN_ON_ERROR(esp32s3_4dlcd_draw_bitmap_stride(panel, x_start, top, x_end, top + height - offset,
+                        rows + offset * stride, stride), TAG, "draw failed");
+    if (offset) {
+        ESP_RETURN_ON_ERROR(esp32s3_4dlcd_draw_bitmap_stride(panel, x_start, top + height - offset, x_end, top + height,
+                            rows, stride), TAG, "draw failed");
+    }
     return ESP_OK;
 }
@@ -0,0 +1,238 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "driver/ledc.h"
+
+#include "esp32s3_4dlcd.h"
+
+static const char *TAG = "esp32s3_4dlcd_backlight";
+
+struct esp32s3_4dlcd_backlight_t {
+    esp32s3_4dlcd_backlight_config_t config;
+    esp_timer_handle_t idle_timer;  // NULL without auto-dim
+    SemaphoreHandle_t lock;         // level, dimmed and the fades they start, shared with the idle timer task
+    volatile uint8_t level;         // level last asked for by the application
+    volatile uint8_t target;        // level the hardware is at or fading to
+    volatile bool dimmed;           // auto-dim took over from `level`
+    uint16_t lut[256];              // duty per level, gamma corrected at the full timer resolution
+};
+
+static bool IRAM_ATTR fade_end_cb(const ledc_cb_param_t *param, void *user_arg)
+{
+    esp32s3_4dlcd_backlight_handle_t bl = user_arg;
+    if (param->event == LEDC_FADE_END_EVT && bl->config.on_fade_done) {
+        return bl->config.on_fade_done(bl, bl->target, bl->config.user_ctx);
+    }
+    return false;
+}
+
+static esp_err_t start_fade(esp32s3_4dlcd_backlight_handle_t bl, uint8_t level, uint32_t fade_ms)
+{
+    const esp32s3_4dlcd_backlight_config_t *c = &bl->config;
+    bl->target = level;
+    // the thread safe LEDC calls, none of them waits for a fade to end
+    if (!fade_ms) {
+        ledc_fade_stop(LEDC_LOW_SPEED_MODE, c->channel);
+        return ledc_set_duty_and_update(LEDC_LOW_SPEED_MODE, c->channel, bl->lut[level], 0);
+    }
+    // the fade runs in the LEDC hardware, the CPU is only involved again in the fade end interrupt
+    return ledc_set_fade_time_and_start(LEDC_LOW_SPEED_MODE, c->channel, bl->lut[level], fade_ms, LEDC_FADE_NO_WAIT);
+}
+
+static void idle_timer_cb(void *arg)
+{
+    esp32s3_4dlcd_backlight_handle_t bl = arg;
+    xSemaphoreTake(bl->lock, portMAX_DELAY);
+    if (bl->config.idle_level < bl->level) {
+        bl->dimmed = true;
+        if (start_fade(bl, bl->config.idle_level, bl->config.idle_fade_ms) != ESP_OK) {
+            ESP_LOGW(TAG, "start idle fade failed");
+        }
+    }
+    xSemaphoreGive(bl->lock);
+}
+
+esp_err_t esp32s3_4dlcd_backlight_new(const esp32s3_4dlcd_backlight_config_t *config, esp32s3_4dlcd_backlight_handle_t *ret_bl)
+{
+    esp_err_t ret = ESP_OK;
+    esp32s3_4dlcd_backlight_handle_t bl = NULL;
+    bool cb_registered = false;
+
+    ESP_GOTO_ON_FALSE(config && ret_bl && config->gpio_num >= 0 && config->gamma > 0, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    bl = calloc(1, sizeof(struct esp32s3_4dlcd_backlight_t));
+    ESP_GOTO_ON_FALSE(bl, ESP_ERR_NO_MEM, err, TAG, "no mem for backlight");
+    bl->config = *config;
+    bl->lock = xSemaphoreCreateMutex();
+    ESP_GOTO_ON_FALSE(bl->lock, ESP_ERR_NO_MEM, err, TAG, "no mem for backlight lock");
+
+    // perceived brightness is roughly duty^(1/gamma), so spread the levels along duty = level^gamma
+    uint32_t max_duty = (1U << config->duty_resolution) - 1;
+    for (int i = 0; i < 256; i++) {
+        uint32_t duty = lroundf(powf(i / 255.0f, config->gamma) * max_duty);
+        bl->lut[i] = i ? MAX(duty, 1) : 0;
+    }
+
+    ledc_timer_config_t ledc_timer = {
+        .speed_mode       = LEDC_LOW_SPEED_MODE,
+        .duty_resolution  = config->duty_resolution,
+        .timer_num        = config->timer,
+        .freq_hz          = config->freq_hz,
+        .clk_cfg          = LEDC_AUTO_CLK
+    };
+    ESP_GOTO_ON_ERROR(ledc_timer_config(&ledc_timer), err, TAG, "backlight timer configuration failed");
+    ledc_channel_config_t ledc_channel = {
+        .speed_mode     = LEDC_LOW_SPEED_MODE,
+        .channel        = config->channel,
+        .timer_sel      = config->timer,
+        .intr_type      = LEDC_INTR_DISABLE,
+        .gpio_num       = config->gpio_num,
+        .duty           = 0,
+        .hpoint         = 0
+    };
+    ESP_GOTO_ON_ERROR(ledc_channel_config(&ledc_channel), err, TAG, "backlight channel configuration failed");
+
+    // the fade service is shared by every LEDC user, it may already be installed
+    ret = ledc_fade_func_install(0);
+    ESP_GOTO_ON_FALSE(ret == ESP_OK || ret == ESP_ERR_INVALID_STATE, ret, err, TAG, "install fade service failed");
+    ledc_cbs_t cbs = {
+        .fade_cb = fade_end_cb,
+    };
+    ESP_GOTO_ON_ERROR(ledc_cb_register(LEDC_LOW_SPEED_MODE, config->channel, &cbs, bl), err, TAG, "register fade callback failed");
+    cb_registered = true;
+
+    if (config->idle_timeout_ms) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = idle_timer_cb,
+            .arg = bl,
+            .name = "lcd_bl_idle",
+        };
+        ESP_GOTO_ON_ERROR(esp_timer_create(&timer_args, &bl->idle_timer), err, TAG, "create idle timer failed");
+    }
+
+    *ret_bl = bl;
+    return ESP_OK;
+
+err:
+    if (bl) {
+        if (cb_registered) {
+            // the fade end interrupt must not find a freed handle
+            ledc_cbs_t no_cbs = { 0 };
+            ledc_cb_register(LEDC_LOW_SPEED_MODE, config->channel, &no_cbs, NULL);
+        }
+        if (bl->lock) {
+            vSemaphoreDelete(bl->lock);
+        }
+        free(bl);
+    }
+    return ret;
+}
+
+esp_err_t esp32s3_4dlcd_backlight_del(esp32s3_4dlcd_backlight_handle_t bl)
+{
+    ESP_RETURN_ON_FALSE(bl, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (bl->idle_timer) {
+        esp_timer_stop(bl->idle_timer);
+        esp_timer_delete(bl->idle_timer);
+    }
+    ledc_fade_stop(LEDC_LOW_SPEED_MODE, bl->config.channel);
+    ledc_cbs_t cbs = { 0 };
+    ledc_cb_register(LEDC_LOW_SPEED_MODE, bl->config.channel, &cbs, NULL);
+    ledc_stop(LEDC_LOW_SPEED_MODE, bl->config.channel, 0);
+    vSemaphoreDelete(bl->lock);
+    free(bl);
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_backlight_fade(esp32s3_4dlcd_backlight_handle_t bl, uint8_t level, uint32_t fade_ms)
+{
+    ESP_RETURN_ON_FALSE(bl, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(bl->lock, portMAX_DELAY);
+    bl->level = level;
+    bl->dimmed = false;
+    ESP_GOTO_ON_ERROR(start_fade(bl, level, fade_ms), out, TAG, "start fade failed");
+    if (bl->idle_timer) {
+        esp_timer_stop(bl->idle_timer);
+        ESP_GOTO_ON_ERROR(esp_timer_start_once(bl->idle_timer, (uint64_t)bl->config.idle_timeout_ms * 1000), out, TAG, "start idle timer failed");
+    }
+out:
+    xSemaphoreGive(bl->lock);
+    return ret;
+}
+
+esp_err_t esp32s3_4dlcd_backlight_set(esp32s3_4dlcd_backlight_handle_t bl, uint8_t level)
+{
+    return esp32s3_4dlcd_backlight_fade(bl, level, 0);
+}
+
+esp_err_t esp32s3_4dlcd_backlight_activity(esp32s3_4dlcd_backlight_handle_t bl)
+{
+    ESP_RETURN_ON_FALSE(bl, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (!bl->idle_timer) {
+        return ESP_OK;
+    }
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(bl->lock, portMAX_DELAY);
+    if (bl->dimmed) {
+        bl->dimmed = false;
+        ESP_GOTO_ON_ERROR(start_fade(bl, bl->level, bl->config.idle_fade_ms), out, TAG, "start fade failed");
+    }
+    esp_timer_stop(bl->idle_timer);
+    ret = esp_timer_start_once(bl->idle_timer, (uint64_t)bl->config.idle_timeout_ms * 1000);
+out:
+    xSemaphoreGive(bl->lock);
+    return ret;
+}
+
+uint8_t esp32s3_4dlcd_backlight_get_level(esp32s3_4dlcd_backlight_handle_t bl)
+{
+    return bl ? bl->target : 0;
+}
+
+esp_err_t backlight_init(void)
+{
+    // 1. Configure timer with 10-bit resolution
+    ledc_timer_config_t ledc_timer = {
+        .speed_mode       = LEDC_LOW_SPEED_MODE,
+        .duty_resolution  = LCD_BL_PWM_RESOLUTION,
+        .timer_num        = LEDC_TIMER_0,
+        .freq_hz          = LCD_BL_PWM_FREQ_HZ,
+        .clk_cfg          = LEDC_AUTO_CLK
+    };
+    ESP_RETURN_ON_ERROR(ledc_timer_config(&ledc_timer), TAG, "backlight timer configuration failed");
+
+    // 2. Configure channel
+    ledc_channel_config_t ledc_channel = {
+        .speed_mode     = LEDC_LOW_SPEED_MODE,
+        .channel        = LEDC_CHANNEL_0,
+        .timer_sel      = LEDC_TIMER_0,
+        .intr_type      = LEDC_INTR_DISABLE,
+        .gpio_num       = LCD_BL_GPIO_NUM,
+        .duty           = 0,    // Start with 0% duty cycle
+        .hpoint         = 0
+    };
+    ESP_RETURN_ON_ERROR(ledc_channel_config(&ledc_channel), TAG, "backlight channel configuration failed");
+    return ESP_OK;
+}
+
+// Set brightness (0-255)
+esp_err_t backlight_set(uint8_t brightness)
+{
+    ESP_RETURN_ON_ERROR(ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, brightness), TAG, "set backlight duty failed");
+    ESP_RETURN_ON_ERROR(ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0), TAG, "update backlight duty failed");
+    return ESP_OK;
+}
@@ -0,0 +1,154 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+
+#include "esp32s3_4dlcd.h"
+#include "esp32s3_4dlcd_priv.h"
+
+static const char *TAG = "esp32s3_4dlcd_compose";
+
+typedef struct {
+    const esp32s3_4dlcd_layer_t *layers;
+    int layer_count;
+    int x_start;
+    int width;
+    size_t pixel_bytes;
+    uint32_t *line;         // one row of the window as 0x00RRGGBB, blended into before conversion to the panel format
+} compose_ctx_t;
+
+static inline uint32_t rgb565_to_rgb888(uint16_t c)
+{
+    uint32_t r = (c >> 11) & 0x1F;
+    uint32_t g = (c >> 5) & 0x3F;
+    uint32_t b = c & 0x1F;
+    return ((r << 3 | r >> 2) << 16) | ((g << 2 | g >> 4) << 8) | (b << 3 | b >> 2);
+}
+
+static inline uint32_t argb4444_to_argb8888(uint16_t c)
+{
+    // each nibble times 0x11 stretches it over the full byte
+    uint32_t v = ((c & 0xF000) << 12) | ((c & 0x0F00) << 8) | ((c & 0x00F0) << 4) | (c & 0x000F);
+    return v * 0x11;
+}
+
+// Blend two 0x00RRGGBB pixels, red and blue in one multiply and green in another. alpha is 0..256
+static inline uint32_t blend(uint32_t dst, uint32_t src, uint32_t alpha)
+{
+    uint32_t rb = (((src & 0xFF00FF) * alpha + (dst & 0xFF00FF) * (256 - alpha)) >> 8) & 0xFF00FF;
+    uint32_t g = (((src & 0x00FF00) * alpha + (dst & 0x00FF00) * (256 - alpha)) >> 8) & 0x00FF00;
+    return rb | g;
+}
+
+// Blend n pixels of one layer row over the line, opacity is 0..256
+static void blend_row(uint32_t *line, const esp32s3_4dlcd_layer_t *layer, const uint8_t *src, int n, uint32_t opacity)
+{
+    switch (layer->format) {
+    case ESP32S3_4DLCD_LAYER_RGB565: {
+        const uint16_t *p = (const uint16_t *)src;
+        if (opacity == 256) {
+            for (int i = 0; i < n; i++) {
+                line[i] = rgb565_to_rgb888(p[i]);
+            }
+        } else {
+            for (int i = 0; i < n; i++) {
+                line[i] = blend(line[i], rgb565_to_rgb888(p[i]), opacity);
+            }
+        }
+        break;
+    }
+    case ESP32S3_4DLCD_LAYER_ARGB8888:
+    case ESP32S3_4DLCD_LAYER_ARGB4444: {
+        bool wide = layer->format == ESP32S3_4DLCD_LAYER_ARGB8888;
+        for (int i = 0; i < n; i++) {
+            uint32_t c = wide ? ((const uint32_t *)src)[i] : argb4444_to_argb8888(((const uint16_t *)src)[i]);
+            uint32_t a = c >> 24;
+            if (!a) {
+                continue;   // HUD layers are mostly transparent
+            }
+            a = ((a + (a >> 7)) * opacity) >> 8;
+            line[i] = a == 256 ? (c & 0xFFFFFF) : blend(line[i], c, a);
+        }
+        break;
+    }
+    }
+}
+
+static esp_err_t compose_lines(int y, int lines, void *dst, void *user_ctx)
+{
+    compose_ctx_t *ctx = (compose_ctx_t *)user_ctx;
+    int x_start = ctx->x_start;
+    int x_end = x_start + ctx->width;
+    uint8_t *out = dst;
+
+    for (int row = y; row < y + lines; row++) {
+        // whatever no layer covers is black
+        memset(ctx->line, 0, ctx->width * sizeof(uint32_t));
+        for (int i = 0; i < ctx->layer_count; i++) {
+            const esp32s3_4dlcd_layer_t *layer = &ctx->layers[i];
+            int x0 = MAX(x_start, layer->x);
+            int x1 = MIN(x_end, layer->x + layer->width);
+            if (row < layer->y || row >= layer->y + layer->height || x0 >= x1 || !layer->opacity) {
+                continue;
+            }
+            size_t src_bytes = layer->format == ESP32S3_4DLCD_LAYER_ARGB8888 ? 4 : 2;
+            const uint8_t *src = (const uint8_t *)layer->data + (row - layer->y) * layer->stride + (x0 - layer->x) * src_bytes;
+            blend_row(ctx->line + (x0 - x_start), layer, src, x1 - x0, layer->opacity + (layer->opacity >> 7));
+        }
+
+        // convert to the panel format: big endian RGB565, or RGB666 in the top bits of each byte
+        if (ctx->pixel_bytes == 3) {
+            for (int i = 0; i < ctx->width; i++) {
+                uint32_t c = ctx->line[i];
+                *out++ = (c >> 16) & 0xFC;
+                *out++ = (c >> 8) & 0xFC;
+                *out++ = c & 0xFC;
+            }
+        } else {
+            for (int i = 0; i < ctx->width; i++) {
+                uint32_t c = ctx->line[i];
+                uint16_t v = ((c >> 8) & 0xF800) | ((c >> 5) & 0x07E0) | ((c >> 3) & 0x001F);
+                *out++ = v >> 8;
+                *out++ = v & 0xFF;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_compose(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                const esp32s3_4dlcd_layer_t *layers, int layer_count)
+{
+    ESP_RETURN_ON_FALSE(panel && (x_start < x_end) && (y_start < y_end) && layer_count >= 0 &&
+                        layer_count <= ESP32S3_4DLCD_COMPOSE_MAX_LAYERS && (layers || !layer_count),
+                        ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    for (int i = 0; i < layer_count; i++) {
+        ESP_RETURN_ON_FALSE(layers[i].data && layers[i].width >= 0 && layers[i].height >= 0 &&
+                            layers[i].format <= ESP32S3_4DLCD_LAYER_ARGB4444, ESP_ERR_INVALID_ARG, TAG, "invalid layer %d", i);
+    }
+    esp_err_t ret = ESP_OK;
+    compose_ctx_t ctx = {
+        .layers = layers,
+        .layer_count = layer_count,
+        .x_start = x_start,
+        .width = x_end - x_start,
+        .pixel_bytes = esp32s3_4dlcd_pixel_bytes(panel),
+    };
+    ctx.line = heap_caps_malloc(ctx.width * sizeof(uint32_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    ESP_RETURN_ON_FALSE(ctx.line, ESP_ERR_NO_MEM, TAG, "no mem for compose line");
+
+    // layers are blended row by row straight into the chunk buffers on their way to the panel
+    ret = esp32s3_4dlcd_draw_lines(panel, x_start, y_start, x_end, y_end, compose_lines, &ctx);
+    heap_caps_free(ctx.line);
+    return ret;
+}
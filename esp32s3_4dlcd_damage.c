@@ -0,0 +1,231 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+
+#include "esp32s3_4dlcd.h"
+#include "esp32s3_4dlcd_priv.h"
+
+static const char *TAG = "esp32s3_4dlcd_damage";
+
+// CASET + 4 bytes, RASET + 4 bytes and RAMWR, all sent on a single data line
+#define WINDOW_CMD_BYTES            11
+#define WINDOW_TRANSACTIONS         3
+
+struct esp32s3_4dlcd_damage_t {
+    esp32s3_4dlcd_damage_config_t config;
+    size_t num_rects;
+    esp32s3_4dlcd_rect_t rects[];   // max_rects + 1 entries, the extra one holds a rectangle before it is merged
+};
+
+static inline bool rect_empty(const esp32s3_4dlcd_rect_t *r)
+{
+    return r->x_start >= r->x_end || r->y_start >= r->y_end;
+}
+
+static inline bool rect_contains(const esp32s3_4dlcd_rect_t *outer, const esp32s3_4dlcd_rect_t *inner)
+{
+    return outer->x_start <= inner->x_start && outer->x_end >= inner->x_end &&
+           outer->y_start <= inner->y_start && outer->y_end >= inner->y_end;
+}
+
+static inline bool rect_intersects(const esp32s3_4dlcd_rect_t *a, const esp32s3_4dlcd_rect_t *b)
+{
+    return a->x_start < b->x_end && b->x_start < a->x_end && a->y_start < b->y_end && b->y_start < a->y_end;
+}
+
+static inline esp32s3_4dlcd_rect_t rect_union(const esp32s3_4dlcd_rect_t *a, const esp32s3_4dlcd_rect_t *b)
+{
+    return (esp32s3_4dlcd_rect_t) {
+        .x_start = MIN(a->x_start, b->x_start),
+        .y_start = MIN(a->y_start, b->y_start),
+        .x_end = MAX(a->x_end, b->x_end),
+        .y_end = MAX(a->y_end, b->y_end),
+    };
+}
+
+// Wire time of a window in nanoseconds: per transaction overhead, command bytes on one line, pixel bytes on all lines
+static uint64_t rect_cost_ns(const esp32s3_4dlcd_damage_config_t *config, const esp32s3_4dlcd_rect_t *r)
+{
+    uint64_t pixels = (uint64_t)(r->x_end - r->x_start) * (r->y_end - r->y_start);
+    uint64_t pixel_bits = pixels * config->bits_per_pixel;
+    uint64_t ns = (uint64_t)WINDOW_TRANSACTIONS * config->trans_overhead_ns;
+    ns += (uint64_t)WINDOW_CMD_BYTES * 8 * 1000000000ULL / config->pclk_hz;
+    ns += pixel_bits * 1000000000ULL / ((uint64_t)config->pclk_hz * config->bus_width);
+    return ns;
+}
+
+// Extra wire time of sending the bounding box of `a` and `b` instead of both, negative if merging is a win
+static int64_t merge_penalty_ns(const esp32s3_4dlcd_damage_config_t *config, const esp32s3_4dlcd_rect_t *a, const esp32s3_4dlcd_rect_t *b)
+{
+    esp32s3_4dlcd_rect_t u = rect_union(a, b);
+    return (int64_t)rect_cost_ns(config, &u) - (int64_t)rect_cost_ns(config, a) - (int64_t)rect_cost_ns(config, b);
+}
+
+// Check whether `grown`, grown from `r` by merging window `skip`, reaches into a window `r` does not overlap
+static bool grows_into_other(esp32s3_4dlcd_damage_handle_t damage, const esp32s3_4dlcd_rect_t *r,
+                             const esp32s3_4dlcd_rect_t *grown, size_t skip)
+{
+    for (size_t i = 0; i < damage->num_rects; i++) {
+        if (i != skip && rect_intersects(grown, &damage->rects[i]) && !rect_intersects(r, &damage->rects[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void remove_rect(esp32s3_4dlcd_damage_handle_t damage, size_t i)
+{
+    damage->rects[i] = damage->rects[--damage->num_rects];
+}
+
+// Merge the pair of rectangles whose bounding box costs the least extra wire time
+static void merge_cheapest_pair(esp32s3_4dlcd_damage_handle_t damage)
+{
+    size_t best_i = 0, best_j = 1;
+    int64_t best = INT64_MAX;
+    for (size_t i = 0; i < damage->num_rects; i++) {
+        for (size_t j = i + 1; j < damage->num_rects; j++) {
+            int64_t penalty = merge_penalty_ns(&damage->config, &damage->rects[i], &damage->rects[j]);
+            if (penalty < best) {
+                best = penalty;
+                best_i = i;
+                best_j = j;
+            }
+        }
+    }
+    damage->rects[best_i] = rect_union(&damage->rects[best_i], &damage->rects[best_j]);
+    remove_rect(damage, best_j);
+}
+
+static void add_rect(esp32s3_4dlcd_damage_handle_t damage, esp32s3_4dlcd_rect_t r)
+{
+    size_t i = 0;
+    while (i < damage->num_rects) {
+        esp32s3_4dlcd_rect_t *cur = &damage->rects[i];
+        if (rect_contains(cur, &r)) {
+            return;
+        }
+        if (rect_contains(&r, cur)) {
+            remove_rect(damage, i);
+            continue;
+        }
+        esp32s3_4dlcd_rect_t grown = rect_union(cur, &r);
+        // a part cut away from a window must not grow back into it, or splitting and merging never ends
+        if (merge_penalty_ns(&damage->config, cur, &r) <= 0 && !grows_into_other(damage, &r, &grown, i)) {
+            // the bounding box is cheaper than two windows, grow and check it against everything again
+            r = grown;
+            remove_rect(damage, i);
+            i = 0;
+            continue;
+        }
+        if (rect_intersects(cur, &r)) {
+            // keep both windows but do not send the overlap twice: split `r` into the parts outside `cur`
+            esp32s3_4dlcd_rect_t parts[4] = {
+                { r.x_start, r.y_start, r.x_end, cur->y_start },                                    // above
+                { r.x_start, cur->y_end, r.x_end, r.y_end },                                        // below
+                { r.x_start, MAX(r.y_start, cur->y_start), cur->x_start, MIN(r.y_end, cur->y_end) }, // left
+                { cur->x_end, MAX(r.y_start, cur->y_start), r.x_end, MIN(r.y_end, cur->y_end) },     // right
+            };
+            for (int p = 0; p < 4; p++) {
+                if (!rect_empty(&parts[p])) {
+                    add_rect(damage, parts[p]);
+                }
+            }
+            return;
+        }
+        i++;
+    }
+
+    damage->rects[damage->num_rects++] = r;
+    if (damage->num_rects > damage->config.max_rects) {
+        merge_cheapest_pair(damage);
+    }
+}
+
+esp_err_t esp32s3_4dlcd_damage_new(const esp32s3_4dlcd_damage_config_t *config, esp32s3_4dlcd_damage_handle_t *ret_damage)
+{
+    ESP_RETURN_ON_FALSE(config && ret_damage, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(config->width > 0 && config->height > 0 && config->max_rects >= 1, ESP_ERR_INVALID_ARG, TAG, "invalid size");
+    ESP_RETURN_ON_FALSE(config->pclk_hz && config->bus_width && config->bits_per_pixel, ESP_ERR_INVALID_ARG, TAG, "invalid bus parameters");
+
+    esp32s3_4dlcd_damage_handle_t damage = calloc(1, sizeof(struct esp32s3_4dlcd_damage_t) +
+                                                  (config->max_rects + 1) * sizeof(esp32s3_4dlcd_rect_t));
+    ESP_RETURN_ON_FALSE(damage, ESP_ERR_NO_MEM, TAG, "no mem for damage tracker");
+    damage->config = *config;
+    *ret_damage = damage;
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_damage_del(esp32s3_4dlcd_damage_handle_t damage)
+{
+    ESP_RETURN_ON_FALSE(damage, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    free(damage);
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_damage_add(esp32s3_4dlcd_damage_handle_t damage, int x_start, int y_start, int x_end, int y_end)
+{
+    ESP_RETURN_ON_FALSE(damage, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_rect_t r = {
+        .x_start = MAX(x_start, 0),
+        .y_start = MAX(y_start, 0),
+        .x_end = MIN(x_end, damage->config.width),
+        .y_end = MIN(y_end, damage->config.height),
+    };
+    if (!rect_empty(&r)) {
+        add_rect(damage, r);
+    }
+    return ESP_OK;
+}
+
+size_t esp32s3_4dlcd_damage_get_rects(esp32s3_4dlcd_damage_handle_t damage, const esp32s3_4dlcd_rect_t **rects)
+{
+    if (!damage) {
+        return 0;
+    }
+    if (rects) {
+        *rects = damage->rects;
+    }
+    return damage->num_rects;
+}
+
+void esp32s3_4dlcd_damage_clear(esp32s3_4dlcd_damage_handle_t damage)
+{
+    if (damage) {
+        damage->num_rects = 0;
+    }
+}
+
+esp_err_t esp32s3_4dlcd_damage_flush(esp32s3_4dlcd_damage_handle_t damage, esp_lcd_panel_handle_t panel, const void *fb,
+                                     esp32s3_4dlcd_damage_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(damage && panel && fb, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    size_t bytes_per_pixel = esp32s3_4dlcd_src_pixel_bytes(panel);
+    size_t stride = damage->config.width * bytes_per_pixel;
+    esp32s3_4dlcd_damage_stats_t s = { 0 };
+
+    for (size_t i = 0; i < damage->num_rects; i++) {
+        const esp32s3_4dlcd_rect_t *r = &damage->rects[i];
+        const uint8_t *first = (const uint8_t *)fb + r->y_start * stride + r->x_start * bytes_per_pixel;
+        ESP_RETURN_ON_ERROR(esp32s3_4dlcd_draw_bitmap_stride(panel, r->x_start, r->y_start, r->x_end, r->y_end, first, stride),
+                            TAG, "draw rectangle %u failed", (unsigned)i);
+        s.windows++;
+        s.pixels += (uint32_t)(r->x_end - r->x_start) * (r->y_end - r->y_start);
+        s.wire_time_ns += rect_cost_ns(&damage->config, r);
+    }
+    damage->num_rects = 0;
+    if (stats) {
+        *stats = s;
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,95 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+
+#include "esp32s3_4dlcd.h"
+#include "esp32s3_4dlcd_pixel.h"
+#include "esp32s3_4dlcd_priv.h"
+
+static const char *TAG = "esp32s3_4dlcd_fill";
+
+static void rgb565_to_panel(size_t pixel_bytes, uint8_t *dst, const uint16_t *src, size_t pixels)
+{
+    if (pixel_bytes == 3) {
+        esp32s3_4dlcd_rgb565_to_rgb666(dst, src, pixels);
+    } else {
+        esp32s3_4dlcd_rgb565_to_be(dst, src, pixels);
+    }
+}
+
+esp_err_t esp32s3_4dlcd_fill_rect(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end, uint16_t color)
+{
+    ESP_RETURN_ON_FALSE(panel && (x_start < x_end) && (y_start < y_end), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp_err_t ret = ESP_OK;
+    size_t pixel_bytes = esp32s3_4dlcd_pixel_bytes(panel);
+    size_t remaining = (size_t)(x_end - x_start) * (y_end - y_start) * pixel_bytes;
+    uint8_t *buf = NULL;
+    size_t cap = 0;
+
+    ESP_RETURN_ON_ERROR(esp32s3_4dlcd_stream_begin(panel, x_start, y_start, x_end, y_end), TAG, "set window failed");
+    // fill one chunk buffer with the colour and send it as many times as needed, it is only read by the DMA
+    ESP_GOTO_ON_ERROR(esp32s3_4dlcd_stream_reserve(panel, &buf, &cap), err, TAG, "reserve chunk failed");
+    cap = MIN(cap, remaining);
+    rgb565_to_panel(pixel_bytes, buf, &color, 1);
+    esp32s3_4dlcd_repeat(buf, pixel_bytes, cap);
+    while (remaining) {
+        size_t len = MIN(cap, remaining);
+        ESP_GOTO_ON_ERROR(esp32s3_4dlcd_stream_push(panel, buf, len), err, TAG, "send color failed");
+        remaining -= len;
+    }
+    // nothing was committed, this only releases the chunk buffer
+    return esp32s3_4dlcd_stream_end(panel);
+
+err:
+    // release the chunk buffer behind the chunks already queued, the memory write is left unfinished
+    esp32s3_4dlcd_stream_end(panel);
+    return ret;
+}
+
+esp_err_t esp32s3_4dlcd_fill_pattern(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                     const uint16_t *tile, int tile_width, int tile_height)
+{
+    ESP_RETURN_ON_FALSE(panel && tile && tile_width > 0 && tile_height > 0 && (x_start < x_end) && (y_start < y_end),
+                        ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp_err_t ret = ESP_OK;
+    size_t pixel_bytes = esp32s3_4dlcd_pixel_bytes(panel);
+    int width = x_end - x_start;
+
+    ESP_RETURN_ON_ERROR(esp32s3_4dlcd_stream_begin(panel, x_start, y_start, x_end, y_end), TAG, "set window failed");
+    for (int y = 0; y < y_end - y_start; y++) {
+        const uint16_t *tile_row = tile + (y % tile_height) * tile_width;
+        int x = 0;
+        while (x < width) {
+            uint8_t *dst = NULL;
+            size_t avail = 0;
+            ESP_GOTO_ON_ERROR(esp32s3_4dlcd_stream_reserve(panel, &dst, &avail), err, TAG, "reserve chunk failed");
+            int n = MIN(width - x, (int)(avail / pixel_bytes));
+
+            // convert one period of the tile row starting at the right phase, then repeat it over the rest
+            int phase = x % tile_width;
+            int head = MIN(n, tile_width - phase);
+            int tail = MIN(n - head, phase);
+            rgb565_to_panel(pixel_bytes, dst, tile_row + phase, head);
+            rgb565_to_panel(pixel_bytes, dst + head * pixel_bytes, tile_row, tail);
+            esp32s3_4dlcd_repeat(dst, (head + tail) * pixel_bytes, n * pixel_bytes);
+
+            ESP_GOTO_ON_ERROR(esp32s3_4dlcd_stream_commit(panel, n * pixel_bytes), err, TAG, "send color failed");
+            x += n;
+        }
+    }
+    return esp32s3_4dlcd_stream_end(panel);
+
+err:
+    // release the chunk buffer, the memory write is left unfinished
+    esp32s3_4dlcd_stream_end(panel);
+    return ret;
+}
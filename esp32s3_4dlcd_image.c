@@ -0,0 +1,208 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+
+#include "esp32s3_4dlcd.h"
+#include "esp32s3_4dlcd_priv.h"
+#include "esp32s3_4dlcd_pixel.h"
+
+static const char *TAG = "esp32s3_4dlcd_image";
+
+// Image layout, little endian, written by tools/4dlcd_image.py:
+//   0  "4DIM"
+//   4  u8  version, 1
+//   5  u8  reserved, 0
+//   6  u16 width
+//   8  u16 height
+//   10 u16 palette size, 0 for images with more than 256 colours
+//   12 u32 size of the pixel stream
+//   16 palette, u16 RGB565 each
+//   .. pixel stream
+// The pixel stream is a run of ops covering the image left to right, top to bottom, across row ends. Each op is a
+// byte, the op in the top two bits and the pixel count less one in the rest, or 63 for a count of 64 plus the u16
+// after it. Colours are palette indices when there is a palette, RGB565 otherwise.
+#define IMAGE_MAGIC             "4DIM"
+#define IMAGE_VERSION           1
+#define IMAGE_HEADER_SIZE       16
+#define IMAGE_LONG_COUNT        63
+
+typedef enum {
+    IMAGE_OP_SKIP,              // pixels unchanged from the row above, black on the first row
+    IMAGE_OP_RUN,               // one colour, given after the count
+    IMAGE_OP_LITERAL,           // a colour per pixel
+    IMAGE_OP_REPEAT,            // the last colour written, again
+} image_op_t;
+
+typedef struct {
+    int width;
+    size_t pixel_bytes;
+    const uint8_t *p;           // next byte of the pixel stream
+    const uint8_t *end;
+    size_t colour_bytes;        // 1 with a palette, 2 without
+    const uint16_t *palette;
+    image_op_t op;
+    uint32_t remaining;         // pixels left in the current op
+    uint16_t colour;            // last colour written
+    uint16_t *line;             // the row being decoded, holding the row above until it is overwritten
+} image_ctx_t;
+
+static inline uint32_t read_u16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint16_t image_colour(const image_ctx_t *ctx, const uint8_t *p)
+{
+    return ctx->palette ? ctx->palette[*p] : read_u16(p);
+}
+
+static esp_err_t image_next_op(image_ctx_t *ctx)
+{
+    ESP_RETURN_ON_FALSE(ctx->p < ctx->end, ESP_FAIL, TAG, "corrupt image: pixel stream ends early");
+    uint8_t code = *ctx->p++;
+    ctx->op = code >> 6;
+    ctx->remaining = (code & 0x3F) + 1;
+    if ((code & 0x3F) == IMAGE_LONG_COUNT) {
+        ESP_RETURN_ON_FALSE(ctx->end - ctx->p >= 2, ESP_FAIL, TAG, "corrupt image: pixel stream ends early");
+        ctx->remaining = 64 + read_u16(ctx->p);
+        ctx->p += 2;
+    }
+    if (ctx->op == IMAGE_OP_RUN) {
+        ESP_RETURN_ON_FALSE((size_t)(ctx->end - ctx->p) >= ctx->colour_bytes, ESP_FAIL, TAG, "corrupt image: pixel stream ends early");
+        ctx->colour = image_colour(ctx, ctx->p);
+        ctx->p += ctx->colour_bytes;
+    }
+    return ESP_OK;
+}
+
+// Decode the next row over the previous one in the line buffer
+static esp_err_t image_row(image_ctx_t *ctx)
+{
+    uint16_t *line = ctx->line;
+    for (int x = 0; x < ctx->width;) {
+        if (!ctx->remaining) {
+            ESP_RETURN_ON_ERROR(image_next_op(ctx), TAG, "decode failed");
+        }
+        int n = MIN(ctx->remaining, (uint32_t)(ctx->width - x));
+        switch (ctx->op) {
+        case IMAGE_OP_SKIP:
+            break;
+        case IMAGE_OP_RUN:
+        case IMAGE_OP_REPEAT:
+            for (int i = 0; i < n; i++) {
+                line[x + i] = ctx->colour;
+            }
+            break;
+        case IMAGE_OP_LITERAL: {
+            size_t cb = ctx->colour_bytes;
+            ESP_RETURN_ON_FALSE((size_t)(ctx->end - ctx->p) >= n * cb, ESP_FAIL, TAG, "corrupt image: pixel stream ends early");
+            if (ctx->palette) {
+                for (int i = 0; i < n; i++) {
+                    line[x + i] = ctx->palette[ctx->p[i]];
+                }
+            } else {
+                for (int i = 0; i < n; i++) {
+                    line[x + i] = read_u16(ctx->p + 2 * i);
+                }
+            }
+            ctx->p += n * cb;
+            ctx->colour = line[x + n - 1];
+            break;
+        }
+        }
+        x += n;
+        ctx->remaining -= n;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t image_lines(int y, int lines, void *dst, void *user_ctx)
+{
+    image_ctx_t *ctx = (image_ctx_t *)user_ctx;
+    uint8_t *out = dst;
+
+    for (int i = 0; i < lines; i++) {
+        ESP_RETURN_ON_ERROR(image_row(ctx), TAG, "row %d", y + i);
+        if (ctx->pixel_bytes == 3) {
+            esp32s3_4dlcd_rgb565_to_rgb666(out, ctx->line, ctx->width);
+        } else {
+            esp32s3_4dlcd_rgb565_to_be(out, ctx->line, ctx->width);
+        }
+        out += ctx->width * ctx->pixel_bytes;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t image_parse(const uint8_t *image, size_t size, int *width, int *height, int *palette_count, size_t *data_size)
+{
+    ESP_RETURN_ON_FALSE(size >= IMAGE_HEADER_SIZE && !memcmp(image, IMAGE_MAGIC, 4) && image[4] == IMAGE_VERSION,
+                        ESP_ERR_INVALID_ARG, TAG, "not an image");
+    *width = read_u16(image + 6);
+    *height = read_u16(image + 8);
+    *palette_count = read_u16(image + 10);
+    *data_size = read_u16(image + 12) | (read_u16(image + 14) << 16);
+    ESP_RETURN_ON_FALSE(*width && *height && *palette_count <= 256 && (size_t)(IMAGE_HEADER_SIZE + *palette_count * 2) <= size &&
+                        *data_size <= size - IMAGE_HEADER_SIZE - *palette_count * 2, ESP_ERR_INVALID_ARG, TAG, "invalid image header");
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_image_info(const void *image, size_t size, int *width, int *height)
+{
+    ESP_RETURN_ON_FALSE(image && width && height, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    int palette_count;
+    size_t data_size;
+    return image_parse(image, size, width, height, &palette_count, &data_size);
+}
+
+esp_err_t esp32s3_4dlcd_draw_image(esp_lcd_panel_handle_t panel, int x, int y, const void *image, size_t size)
+{
+    ESP_RETURN_ON_FALSE(panel && image && x >= 0 && y >= 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    const uint8_t *bytes = image;
+    int width;
+    int height;
+    int palette_count;
+    size_t data_size;
+    ESP_RETURN_ON_ERROR(image_parse(bytes, size, &width, &height, &palette_count, &data_size), TAG, "parse image failed");
+    int frame_width;
+    int frame_height;
+    // drawn through draw_lines, which software rotation does not apply to
+    esp32s3_4dlcd_unrotated_size(panel, &frame_width, &frame_height);
+    ESP_RETURN_ON_FALSE(x + width <= frame_width && y + height <= frame_height, ESP_ERR_INVALID_ARG, TAG,
+                        "%dx%d image at %d,%d does not fit the panel", width, height, x, y);
+
+    esp_err_t ret = ESP_OK;
+    const uint8_t *palette = bytes + IMAGE_HEADER_SIZE;
+    image_ctx_t ctx = {
+        .width = width,
+        .pixel_bytes = esp32s3_4dlcd_pixel_bytes(panel),
+        .p = palette + palette_count * 2,
+        .end = palette + palette_count * 2 + data_size,
+        .colour_bytes = palette_count ? 1 : 2,
+    };
+    // the palette is looked up for every pixel, keep it in internal RAM next to the line. It always takes 256 entries,
+    // black past the image's own, so no index can read outside it
+    ctx.line = heap_caps_calloc(width + (palette_count ? 256 : 0), sizeof(uint16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    ESP_RETURN_ON_FALSE(ctx.line, ESP_ERR_NO_MEM, TAG, "no mem for image line");
+    if (palette_count) {
+        uint16_t *copy = ctx.line + width;
+        for (int i = 0; i < palette_count; i++) {
+            copy[i] = read_u16(palette + 2 * i);
+        }
+        ctx.palette = copy;
+    }
+
+    ret = esp32s3_4dlcd_draw_lines(panel, x, y, x + width, y + height, image_lines, &ctx);
+    heap_caps_free(ctx.line);
+    return ret;
+}
@@ -0,0 +1,57 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <sys/param.h>
+#include "esp32s3_4dlcd_pixel.h"
+
+static inline void rgb565_to_rgb666_one(uint8_t *dst, uint16_t p)
+{
+    dst[0] = ((p >> 8) & 0xF8) | ((p >> 13) & 0x04);
+    dst[1] = (p >> 3) & 0xFC;
+    dst[2] = ((p << 3) & 0xF8) | ((p >> 2) & 0x04);
+}
+
+void esp32s3_4dlcd_rgb565_to_rgb666(uint8_t *dst, const uint16_t *src, size_t pixels)
+{
+    // four pixels per iteration keeps the loop body free of branches and lets the compiler pipeline the loads
+    while (pixels >= 4) {
+        rgb565_to_rgb666_one(dst + 0, src[0]);
+        rgb565_to_rgb666_one(dst + 3, src[1]);
+        rgb565_to_rgb666_one(dst + 6, src[2]);
+        rgb565_to_rgb666_one(dst + 9, src[3]);
+        dst += 12;
+        src += 4;
+        pixels -= 4;
+    }
+    while (pixels--) {
+        rgb565_to_rgb666_one(dst, *src++);
+        dst += 3;
+    }
+}
+
+void esp32s3_4dlcd_rgb565_to_be(uint8_t *dst, const uint16_t *src, size_t pixels)
+{
+    while (pixels--) {
+        uint16_t p = *src++;
+        dst[0] = p >> 8;
+        dst[1] = p & 0xFF;
+        dst += 2;
+    }
+}
+
+void esp32s3_4dlcd_repeat(uint8_t *buf, size_t period, size_t len)
+{
+    size_t filled = MIN(period, len);
+    while (filled < len) {
+        size_t n = MIN(filled, len - filled);
+        memcpy(buf + filled, buf, n);
+        filled += n;
+    }
+}
@@ -0,0 +1,115 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_check.h"
+
+#include "esp32s3_4dlcd.h"
+#include "esp32s3_4dlcd_priv.h"
+
+static const char *TAG = "esp32s3_4dlcd_present";
+
+typedef struct {
+    void *buf;
+    uint32_t fence;     // sequence number of the last colour transaction reading this buffer
+    bool in_flight;     // submitted and fence not yet known to have passed
+} present_slot_t;
+
+struct esp32s3_4dlcd_present_t {
+    esp_lcd_panel_handle_t panel;
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done;    // chained while tracking, needed to stop it
+    void *user_ctx;
+    size_t next;        // slot handed out by the next acquire
+    size_t num_buffers;
+    present_slot_t slots[];
+};
+
+esp_err_t esp32s3_4dlcd_present_new(esp_lcd_panel_handle_t panel, const esp32s3_4dlcd_present_config_t *config,
+                                    esp32s3_4dlcd_present_handle_t *ret_present)
+{
+    esp_err_t ret = ESP_OK;
+    esp32s3_4dlcd_present_handle_t present = NULL;
+
+    ESP_GOTO_ON_FALSE(panel && config && ret_present && config->buffers && config->num_buffers, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    present = calloc(1, sizeof(struct esp32s3_4dlcd_present_t) + config->num_buffers * sizeof(present_slot_t));
+    ESP_GOTO_ON_FALSE(present, ESP_ERR_NO_MEM, err, TAG, "no mem for present queue");
+    for (size_t i = 0; i < config->num_buffers; i++) {
+        ESP_GOTO_ON_FALSE(config->buffers[i], ESP_ERR_INVALID_ARG, err, TAG, "buffer %u is NULL", (unsigned)i);
+        present->slots[i].buf = config->buffers[i];
+    }
+    present->panel = panel;
+    present->num_buffers = config->num_buffers;
+    present->on_color_trans_done = config->on_color_trans_done;
+    present->user_ctx = config->user_ctx;
+    ESP_GOTO_ON_ERROR(esp32s3_4dlcd_trans_track(panel, config->on_color_trans_done, config->user_ctx), err, TAG, "track transactions failed");
+
+    *ret_present = present;
+    ESP_LOGD(TAG, "new present queue @%p with %u buffers", present, (unsigned)present->num_buffers);
+    return ESP_OK;
+
+err:
+    free(present);
+    return ret;
+}
+
+esp_err_t esp32s3_4dlcd_present_del(esp32s3_4dlcd_present_handle_t present)
+{
+    ESP_RETURN_ON_FALSE(present, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_ERROR(esp32s3_4dlcd_present_flush(present, portMAX_DELAY), TAG, "flush failed");
+    esp32s3_4dlcd_trans_untrack(present->panel, present->on_color_trans_done, present->user_ctx);
+    free(present);
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_present_acquire(esp32s3_4dlcd_present_handle_t present, TickType_t timeout, int *index, void **buf)
+{
+    ESP_RETURN_ON_FALSE(present && index, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    size_t i = present->next;
+    ESP_RETURN_ON_ERROR(esp32s3_4dlcd_present_wait(present, i, timeout), TAG, "buffer %u still in use", (unsigned)i);
+    present->next = (i + 1) % present->num_buffers;
+    *index = i;
+    if (buf) {
+        *buf = present->slots[i].buf;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_present_submit(esp32s3_4dlcd_present_handle_t present, int index, int x_start, int y_start, int x_end, int y_end)
+{
+    ESP_RETURN_ON_FALSE(present && index >= 0 && (size_t)index < present->num_buffers, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    present_slot_t *slot = &present->slots[index];
+    esp_err_t ret = esp_lcd_panel_draw_bitmap(present->panel, x_start, y_start, x_end, y_end, slot->buf);
+    // a draw that failed part way may have queued transactions reading the buffer, fence them all the same
+    slot->fence = esp32s3_4dlcd_trans_seq(present->panel);
+    slot->in_flight = true;
+    ESP_RETURN_ON_ERROR(ret, TAG, "draw failed");
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_present_wait(esp32s3_4dlcd_present_handle_t present, int index, TickType_t timeout)
+{
+    ESP_RETURN_ON_FALSE(present && index >= 0 && (size_t)index < present->num_buffers, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    present_slot_t *slot = &present->slots[index];
+    if (slot->in_flight) {
+        ESP_RETURN_ON_ERROR(esp32s3_4dlcd_trans_wait(present->panel, slot->fence, timeout), TAG, "wait for buffer failed");
+        slot->in_flight = false;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_present_flush(esp32s3_4dlcd_present_handle_t present, TickType_t timeout)
+{
+    ESP_RETURN_ON_FALSE(present, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    for (size_t i = 0; i < present->num_buffers; i++) {
+        ESP_RETURN_ON_ERROR(esp32s3_4dlcd_present_wait(present, i, timeout), TAG, "wait for buffer %u failed", (unsigned)i);
+    }
+    return ESP_OK;
+}
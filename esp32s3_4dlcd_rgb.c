@@ -0,0 +1,314 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_lcd_panel_rgb.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+
+#include "esp32s3_4dlcd.h"
+#include "esp32s3_4dlcd_priv.h"
+#include "esp32s3_4dlcd_rgb_flip.h"
+
+static const char *TAG = "esp32s3_4dlcd_rgb";
+
+#define RGB_BYTES_PER_PIXEL     2
+#define RGB_DATA_WIDTH          16      // RGB565 on B0-B4, G0-G5 and R0-R4
+
+// Cost model handed to the catch-up damage trackers: a PSRAM to PSRAM copy moves about 40MB/s, plus a little
+// per rectangle for the row loop set up
+#define COPY_BYTES_PER_S        (40 * 1000 * 1000)
+#define COPY_RECT_OVERHEAD_NS   1000
+
+typedef struct {
+    const char *name;
+    uint16_t width;
+    uint16_t height;
+    esp_lcd_rgb_timing_t timings;
+} esp32s3_4dlcd_rgb_model_info_t;
+
+// Indexed by esp32s3_4dlcd_model_t. The pixel clock of the 800x480 panels is bounded by the PSRAM bandwidth left
+// once the CPU draws, rather than by the panels, which all accept more.
+static const esp32s3_4dlcd_rgb_model_info_t rgb_model_info[] = {
+    [ESP32S3_4DLCD_MODEL_43] = {
+        .name = "gen4-ESP32-43", .width = 480, .height = 272,
+        .timings = {
+            .pclk_hz = 9 * 1000 * 1000, .h_res = 480, .v_res = 272,
+            .hsync_pulse_width = 4, .hsync_back_porch = 43, .hsync_front_porch = 8,
+            .vsync_pulse_width = 4, .vsync_back_porch = 12, .vsync_front_porch = 8,
+            .flags.pclk_active_neg = 1,
+        },
+    },
+    [ESP32S3_4DLCD_MODEL_50] = {
+        .name = "gen4-ESP32-50", .width = 800, .height = 480,
+        .timings = {
+            .pclk_hz = 16 * 1000 * 1000, .h_res = 800, .v_res = 480,
+            .hsync_pulse_width = 4, .hsync_back_porch = 8, .hsync_front_porch = 8,
+            .vsync_pulse_width = 4, .vsync_back_porch = 8, .vsync_front_porch = 8,
+            .flags.pclk_active_neg = 1,
+        },
+    },
+    [ESP32S3_4DLCD_MODEL_70] = {
+        .name = "gen4-ESP32-70", .width = 800, .height = 480,
+        .timings = {
+            .pclk_hz = 16 * 1000 * 1000, .h_res = 800, .v_res = 480,
+            .hsync_pulse_width = 30, .hsync_back_porch = 16, .hsync_front_porch = 210,
+            .vsync_pulse_width = 13, .vsync_back_porch = 10, .vsync_front_porch = 22,
+            .flags.pclk_active_neg = 1,
+        },
+    },
+    [ESP32S3_4DLCD_MODEL_90] = {
+        .name = "ESP32-90", .width = 800, .height = 480,
+        .timings = {
+            .pclk_hz = 16 * 1000 * 1000, .h_res = 800, .v_res = 480,
+            .hsync_pulse_width = 30, .hsync_back_porch = 16, .hsync_front_porch = 210,
+            .vsync_pulse_width = 13, .vsync_back_porch = 10, .vsync_front_porch = 22,
+            .flags.pclk_active_neg = 1,
+        },
+    },
+};
+
+struct esp32s3_4dlcd_rgb_t {
+    esp_lcd_panel_handle_t panel;
+    int width;
+    int height;
+    size_t num_fbs;
+    esp32s3_4dlcd_rgb_flip_t flip;  // frame buffer states, see esp32s3_4dlcd_rgb_flip.c
+    SemaphoreHandle_t flip_sem;
+    portMUX_TYPE lock;      // state shared with the vsync ISR
+    esp32s3_4dlcd_rgb_stats_t stats;
+};
+
+static const esp32s3_4dlcd_rgb_model_info_t *rgb_model_info_get(esp32s3_4dlcd_model_t model)
+{
+    if (model == ESP32S3_4DLCD_MODEL_KCONFIG) {
+        model = LCD_KCONFIG_MODEL;
+    }
+    if ((unsigned)model >= sizeof(rgb_model_info) / sizeof(rgb_model_info[0]) || !rgb_model_info[model].name) {
+        return NULL;
+    }
+    return &rgb_model_info[model];
+}
+
+static bool IRAM_ATTR rgb_on_vsync(esp_lcd_panel_handle_t panel, const esp_lcd_rgb_panel_event_data_t *edata, void *user_ctx)
+{
+    esp32s3_4dlcd_rgb_handle_t rgb = (esp32s3_4dlcd_rgb_handle_t)user_ctx;
+    BaseType_t need_yield = pdFALSE;
+
+    portENTER_CRITICAL_ISR(&rgb->lock);
+    rgb->stats.vsyncs++;
+    bool flipped = esp32s3_4dlcd_rgb_flip_vsync(&rgb->flip);
+    if (flipped) {
+        rgb->stats.flips++;
+    }
+    portEXIT_CRITICAL_ISR(&rgb->lock);
+
+    if (flipped) {
+        xSemaphoreGiveFromISR(rgb->flip_sem, &need_yield);
+    }
+    return need_yield == pdTRUE;
+}
+
+// Hand out a free frame buffer, or return -1
+static int take_free_fb(esp32s3_4dlcd_rgb_handle_t rgb)
+{
+    portENTER_CRITICAL(&rgb->lock);
+    int fb = esp32s3_4dlcd_rgb_flip_take(&rgb->flip);
+    portEXIT_CRITICAL(&rgb->lock);
+    return fb;
+}
+
+static bool flip_pending(esp32s3_4dlcd_rgb_handle_t rgb)
+{
+    portENTER_CRITICAL(&rgb->lock);
+    bool pending = rgb->flip.pending >= 0;
+    portEXIT_CRITICAL(&rgb->lock);
+    return pending;
+}
+
+esp_err_t esp32s3_4dlcd_rgb_new(const esp32s3_4dlcd_rgb_config_t *config, esp32s3_4dlcd_rgb_handle_t *ret_rgb)
+{
+    esp_err_t ret = ESP_OK;
+    esp32s3_4dlcd_rgb_handle_t rgb = NULL;
+
+    ESP_GOTO_ON_FALSE(config && ret_rgb, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(config->num_fbs >= 1 && config->num_fbs <= ESP32S3_4DLCD_RGB_MAX_FBS, ESP_ERR_INVALID_ARG, err, TAG,
+                      "invalid number of frame buffers");
+    const esp32s3_4dlcd_rgb_model_info_t *model = rgb_model_info_get(config->model);
+    ESP_GOTO_ON_FALSE(model, ESP_ERR_NOT_SUPPORTED, err, TAG, "not an RGB panel model");
+    const esp_lcd_rgb_timing_t *timings = config->timings ? config->timings : &model->timings;
+    ESP_GOTO_ON_FALSE(timings->h_res == model->width && timings->v_res == model->height, ESP_ERR_INVALID_ARG, err, TAG,
+                      "timings do not match the panel resolution");
+    ESP_GOTO_ON_FALSE(!config->bounce_buffer_lines || model->height % config->bounce_buffer_lines == 0, ESP_ERR_INVALID_ARG,
+                      err, TAG, "bounce buffer lines must divide the height");
+    ESP_GOTO_ON_FALSE(config->pclk_gpio_num >= 0 && (config->de_gpio_num >= 0 ||
+                      (config->hsync_gpio_num >= 0 && config->vsync_gpio_num >= 0)), ESP_ERR_INVALID_ARG, err, TAG,
+                      "RGB clock or sync pins not set");
+    for (size_t i = 0; i < sizeof(config->data_gpio_nums) / sizeof(config->data_gpio_nums[0]); i++) {
+        ESP_GOTO_ON_FALSE(config->data_gpio_nums[i] >= 0, ESP_ERR_INVALID_ARG, err, TAG, "RGB data pin %u not set", (unsigned)i);
+    }
+
+    rgb = calloc(1, sizeof(struct esp32s3_4dlcd_rgb_t));
+    ESP_GOTO_ON_FALSE(rgb, ESP_ERR_NO_MEM, err, TAG, "no mem for RGB frame buffer manager");
+    rgb->width = model->width;
+    rgb->height = model->height;
+    rgb->num_fbs = config->num_fbs;
+    rgb->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    rgb->flip_sem = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(rgb->flip_sem, ESP_ERR_NO_MEM, err, TAG, "no mem for flip semaphore");
+
+    esp32s3_4dlcd_damage_config_t damage_config = {
+        .width = rgb->width,
+        .height = rgb->height,
+        .max_rects = config->max_rects ? config->max_rects : 16,
+        .pclk_hz = COPY_BYTES_PER_S,
+        .bus_width = 8,
+        .bits_per_pixel = RGB_BYTES_PER_PIXEL * 8,
+        .trans_overhead_ns = COPY_RECT_OVERHEAD_NS,
+    };
+    ESP_GOTO_ON_ERROR(esp32s3_4dlcd_rgb_flip_init(&rgb->flip, rgb->num_fbs, &damage_config), err, TAG,
+                      "create damage trackers failed");
+
+    esp_lcd_rgb_panel_config_t panel_config = {
+        .clk_src = LCD_CLK_SRC_DEFAULT,
+        .timings = *timings,
+        .data_width = RGB_DATA_WIDTH,
+        .bits_per_pixel = RGB_BYTES_PER_PIXEL * 8,
+        .num_fbs = rgb->num_fbs,
+        .bounce_buffer_size_px = config->bounce_buffer_lines * rgb->width,
+        .psram_trans_align = 64,
+        .hsync_gpio_num = config->hsync_gpio_num,
+        .vsync_gpio_num = config->vsync_gpio_num,
+        .de_gpio_num = config->de_gpio_num,
+        .pclk_gpio_num = config->pclk_gpio_num,
+        .disp_gpio_num = config->disp_gpio_num,
+        .flags.fb_in_psram = 1,
+    };
+    memcpy(panel_config.data_gpio_nums, config->data_gpio_nums, sizeof(config->data_gpio_nums));
+    ESP_GOTO_ON_ERROR(esp_lcd_new_rgb_panel(&panel_config, &rgb->panel), err, TAG, "create RGB panel failed");
+
+    esp_lcd_rgb_panel_event_callbacks_t cbs = {
+        .on_vsync = rgb_on_vsync,
+    };
+    ESP_GOTO_ON_ERROR(esp_lcd_rgb_panel_register_event_callbacks(rgb->panel, &cbs, rgb), err, TAG, "register vsync callback failed");
+    ESP_GOTO_ON_ERROR(esp_lcd_rgb_panel_get_frame_buffer(rgb->panel, rgb->num_fbs, (void **)&rgb->flip.fbs[0],
+                                                         (void **)&rgb->flip.fbs[1], (void **)&rgb->flip.fbs[2]), err, TAG,
+                      "get frame buffers failed");
+    ESP_GOTO_ON_ERROR(esp_lcd_panel_reset(rgb->panel), err, TAG, "reset RGB panel failed");
+    ESP_GOTO_ON_ERROR(esp_lcd_panel_init(rgb->panel), err, TAG, "init RGB panel failed");
+
+    ESP_LOGD(TAG, "%s: %u frame buffers, %u line bounce buffers, pclk %"PRIu32" Hz", model->name, (unsigned)rgb->num_fbs,
+             (unsigned)config->bounce_buffer_lines, timings->pclk_hz);
+    *ret_rgb = rgb;
+    return ESP_OK;
+
+err:
+    if (rgb) {
+        if (rgb->panel) {
+            esp_lcd_panel_del(rgb->panel);
+        }
+        esp32s3_4dlcd_rgb_flip_deinit(&rgb->flip);
+        if (rgb->flip_sem) {
+            vSemaphoreDelete(rgb->flip_sem);
+        }
+        free(rgb);
+    }
+    return ret;
+}
+
+esp_err_t esp32s3_4dlcd_rgb_del(esp32s3_4dlcd_rgb_handle_t rgb)
+{
+    ESP_RETURN_ON_FALSE(rgb, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp_lcd_panel_del(rgb->panel);
+    esp32s3_4dlcd_rgb_flip_deinit(&rgb->flip);
+    vSemaphoreDelete(rgb->flip_sem);
+    free(rgb);
+    return ESP_OK;
+}
+
+esp_lcd_panel_handle_t esp32s3_4dlcd_rgb_get_panel(esp32s3_4dlcd_rgb_handle_t rgb)
+{
+    return rgb ? rgb->panel : NULL;
+}
+
+esp_err_t esp32s3_4dlcd_rgb_begin_frame(esp32s3_4dlcd_rgb_handle_t rgb, void **fb, TickType_t timeout)
+{
+    ESP_RETURN_ON_FALSE(rgb && fb, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(rgb->flip.back < 0, ESP_ERR_INVALID_STATE, TAG, "frame already begun");
+
+    int64_t start = esp_timer_get_time();
+    int back;
+    while ((back = take_free_fb(rgb)) < 0) {
+        if (xSemaphoreTake(rgb->flip_sem, timeout) != pdTRUE) {
+            rgb->stats.wait_us += esp_timer_get_time() - start;
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    rgb->stats.wait_us += esp_timer_get_time() - start;
+
+    // copy what was drawn since this frame buffer was last current from the newest frame
+    rgb->stats.copied_pixels += esp32s3_4dlcd_rgb_flip_catch_up(&rgb->flip, back);
+    *fb = rgb->flip.fbs[back];
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_rgb_damage(esp32s3_4dlcd_rgb_handle_t rgb, int x_start, int y_start, int x_end, int y_end)
+{
+    ESP_RETURN_ON_FALSE(rgb, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(rgb->flip.back >= 0, ESP_ERR_INVALID_STATE, TAG, "no frame begun");
+
+    ESP_RETURN_ON_ERROR(esp32s3_4dlcd_rgb_flip_damage(&rgb->flip, x_start, y_start, x_end, y_end), TAG, "add damage failed");
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_rgb_present(esp32s3_4dlcd_rgb_handle_t rgb, TickType_t timeout)
+{
+    ESP_RETURN_ON_FALSE(rgb, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(rgb->flip.back >= 0, ESP_ERR_INVALID_STATE, TAG, "no frame begun");
+    int back = rgb->flip.back;
+
+    if (rgb->num_fbs > 1) {
+        int64_t start = esp_timer_get_time();
+        while (flip_pending(rgb)) {
+            if (xSemaphoreTake(rgb->flip_sem, timeout) != pdTRUE) {
+                rgb->stats.wait_us += esp_timer_get_time() - start;
+                return ESP_ERR_TIMEOUT;
+            }
+        }
+        rgb->stats.wait_us += esp_timer_get_time() - start;
+    }
+
+    // Given one of its own frame buffers, the RGB panel only switches to it from the next frame on, and writes the
+    // CPU cache back when the DMA reads PSRAM directly. Mark the flip pending only afterwards: a vsync in between
+    // then retires the previous frame buffer one frame late rather than too early.
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_draw_bitmap(rgb->panel, 0, 0, rgb->width, rgb->height, rgb->flip.fbs[back]), TAG,
+                        "flip frame buffer failed");
+    rgb->stats.frames++;
+
+    portENTER_CRITICAL(&rgb->lock);
+    esp32s3_4dlcd_rgb_flip_present(&rgb->flip);
+    portEXIT_CRITICAL(&rgb->lock);
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_rgb_get_stats(esp32s3_4dlcd_rgb_handle_t rgb, esp32s3_4dlcd_rgb_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(rgb && stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    portENTER_CRITICAL(&rgb->lock);
+    *stats = rgb->stats;
+    portEXIT_CRITICAL(&rgb->lock);
+    return ESP_OK;
+}
@@ -0,0 +1,122 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_attr.h"
+#include "esp32s3_4dlcd_rgb_flip.h"
+
+esp_err_t esp32s3_4dlcd_rgb_flip_init(esp32s3_4dlcd_rgb_flip_t *flip, size_t num_fbs,
+                                      const esp32s3_4dlcd_damage_config_t *damage_config)
+{
+    *flip = (esp32s3_4dlcd_rgb_flip_t) {
+        .num_fbs = num_fbs,
+        .width = damage_config->width,
+        .pixel_bytes = damage_config->bits_per_pixel / 8,
+        .back = -1,
+        .pending = -1,
+    };
+    for (size_t i = 0; i < num_fbs; i++) {
+        esp_err_t ret = esp32s3_4dlcd_damage_new(damage_config, &flip->stale[i]);
+        if (ret != ESP_OK) {
+            esp32s3_4dlcd_rgb_flip_deinit(flip);
+            return ret;
+        }
+    }
+    // the peripheral starts on the first frame buffer, the frame buffers are allocated cleared so none is stale
+    flip->scanned = 0;
+    flip->latest = 0;
+    flip->state[0] = ESP32S3_4DLCD_RGB_FB_SCANNED;
+    return ESP_OK;
+}
+
+void esp32s3_4dlcd_rgb_flip_deinit(esp32s3_4dlcd_rgb_flip_t *flip)
+{
+    for (size_t i = 0; i < ESP32S3_4DLCD_RGB_MAX_FBS; i++) {
+        if (flip->stale[i]) {
+            esp32s3_4dlcd_damage_del(flip->stale[i]);
+            flip->stale[i] = NULL;
+        }
+    }
+}
+
+bool IRAM_ATTR esp32s3_4dlcd_rgb_flip_vsync(esp32s3_4dlcd_rgb_flip_t *flip)
+{
+    if (flip->pending < 0) {
+        return false;
+    }
+    // the peripheral has moved on to the pending frame buffer, the one it scanned so far can be drawn again
+    flip->state[flip->scanned] = ESP32S3_4DLCD_RGB_FB_FREE;
+    flip->state[flip->pending] = ESP32S3_4DLCD_RGB_FB_SCANNED;
+    flip->scanned = flip->pending;
+    flip->pending = -1;
+    return true;
+}
+
+int esp32s3_4dlcd_rgb_flip_take(esp32s3_4dlcd_rgb_flip_t *flip)
+{
+    if (flip->num_fbs == 1) {
+        // drawn while scanned
+        flip->back = 0;
+        return 0;
+    }
+    for (size_t i = 0; i < flip->num_fbs; i++) {
+        if (flip->state[i] == ESP32S3_4DLCD_RGB_FB_FREE) {
+            flip->state[i] = ESP32S3_4DLCD_RGB_FB_DRAWING;
+            flip->back = i;
+            return i;
+        }
+    }
+    return -1;
+}
+
+esp_err_t esp32s3_4dlcd_rgb_flip_damage(esp32s3_4dlcd_rgb_flip_t *flip, int x_start, int y_start, int x_end, int y_end)
+{
+    for (size_t i = 0; i < flip->num_fbs; i++) {
+        if ((int)i != flip->back) {
+            esp_err_t ret = esp32s3_4dlcd_damage_add(flip->stale[i], x_start, y_start, x_end, y_end);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+uint64_t esp32s3_4dlcd_rgb_flip_catch_up(esp32s3_4dlcd_rgb_flip_t *flip, int fb)
+{
+    const esp32s3_4dlcd_rect_t *rects;
+    size_t num_rects = esp32s3_4dlcd_damage_get_rects(flip->stale[fb], &rects);
+    size_t stride = (size_t)flip->width * flip->pixel_bytes;
+    uint64_t copied = 0;
+
+    for (size_t i = 0; i < num_rects; i++) {
+        const esp32s3_4dlcd_rect_t *r = &rects[i];
+        size_t offset = (size_t)r->y_start * stride + (size_t)r->x_start * flip->pixel_bytes;
+        size_t len = (size_t)(r->x_end - r->x_start) * flip->pixel_bytes;
+        for (int y = r->y_start; y < r->y_end; y++) {
+            memcpy(flip->fbs[fb] + offset, flip->fbs[flip->latest] + offset, len);
+            offset += stride;
+        }
+        copied += (uint64_t)(r->x_end - r->x_start) * (r->y_end - r->y_start);
+    }
+    esp32s3_4dlcd_damage_clear(flip->stale[fb]);
+    return copied;
+}
+
+void esp32s3_4dlcd_rgb_flip_present(esp32s3_4dlcd_rgb_flip_t *flip)
+{
+    int back = flip->back;
+    flip->back = -1;
+    if (flip->num_fbs == 1) {
+        return;
+    }
+    flip->state[back] = ESP32S3_4DLCD_RGB_FB_PENDING;
+    flip->pending = back;
+    flip->latest = back;
+}
@@ -0,0 +1,154 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+
+#include "esp32s3_4dlcd.h"
+#include "esp32s3_4dlcd_pixel.h"
+#include "esp32s3_4dlcd_priv.h"
+
+static const char *TAG = "esp32s3_4dlcd_rotate";
+
+typedef enum {
+    PIXEL_COPY2,            // 16-bit panel, 16-bit source
+    PIXEL_COPY3,            // 18-bit panel, RGB666 source
+    PIXEL_RGB565_TO_RGB666, // 18-bit panel, RGB565 source converted by the driver
+} pixel_op_t;
+
+static inline void move_pixel(uint8_t *dst, const uint8_t *src, pixel_op_t op)
+{
+    switch (op) {
+    case PIXEL_COPY2:
+        memcpy(dst, src, 2);
+        break;
+    case PIXEL_COPY3:
+        memcpy(dst, src, 3);
+        break;
+    case PIXEL_RGB565_TO_RGB666: {
+        uint16_t c;
+        memcpy(&c, src, 2);
+        esp32s3_4dlcd_rgb565_to_rgb666(dst, &c, 1);
+        break;
+    }
+    }
+}
+
+// Fill `rows` output rows starting at output row `row`. The window is w x h source pixels; for 90/270 each output
+// row is a source column, so the source is walked row by row and each row scatters `rows` pixels, one into every
+// output row. Source reads stay sequential and the scattered writes land in the small internal chunk buffer.
+static void rotate_rows(uint8_t *dst, const uint8_t *src, size_t stride, int w, int h, int row, int rows,
+                        esp32s3_4dlcd_rotation_t rotation, size_t src_bytes, size_t dst_bytes, pixel_op_t op)
+{
+    switch (rotation) {
+    case ESP32S3_4DLCD_ROTATE_90: {
+        // output row r is source column row + r, read bottom to top
+        size_t out_row_bytes = h * dst_bytes;
+        for (int sy = 0; sy < h; sy++) {
+            const uint8_t *s = src + sy * stride + row * src_bytes;
+            uint8_t *d = dst + (h - 1 - sy) * dst_bytes;
+            for (int r = 0; r < rows; r++) {
+                move_pixel(d, s, op);
+                s += src_bytes;
+                d += out_row_bytes;
+            }
+        }
+        break;
+    }
+    case ESP32S3_4DLCD_ROTATE_270: {
+        // output row r is source column w - 1 - (row + r), read top to bottom
+        size_t out_row_bytes = h * dst_bytes;
+        for (int sy = 0; sy < h; sy++) {
+            const uint8_t *s = src + sy * stride + (w - 1 - row) * src_bytes;
+            uint8_t *d = dst + sy * dst_bytes;
+            for (int r = 0; r < rows; r++) {
+                move_pixel(d, s, op);
+                s -= src_bytes;
+                d += out_row_bytes;
+            }
+        }
+        break;
+    }
+    case ESP32S3_4DLCD_ROTATE_180:
+        // output row r is source row h - 1 - (row + r), read right to left
+        for (int r = 0; r < rows; r++) {
+            const uint8_t *s = src + (h - 1 - row - r) * stride + (w - 1) * src_bytes;
+            for (int x = 0; x < w; x++) {
+                move_pixel(dst, s, op);
+                s -= src_bytes;
+                dst += dst_bytes;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+esp_err_t esp32s3_4dlcd_rotate_draw(esp_lcd_panel_handle_t panel, esp32s3_4dlcd_rotation_t rotation, int frame_width,
+                                    int frame_height, int x_start, int y_start, int x_end, int y_end,
+                                    const void *color_data, size_t stride)
+{
+    esp_err_t ret = ESP_OK;
+    size_t src_bytes = esp32s3_4dlcd_src_pixel_bytes(panel);
+    size_t dst_bytes = esp32s3_4dlcd_pixel_bytes(panel);
+    pixel_op_t op = dst_bytes == 2 ? PIXEL_COPY2 : src_bytes == 2 ? PIXEL_RGB565_TO_RGB666 : PIXEL_COPY3;
+    int w = x_end - x_start;
+    int h = y_end - y_start;
+
+    // where the rectangle lands once the image is turned clockwise on the glass
+    int px_start, py_start, px_end, py_end;
+    switch (rotation) {
+    case ESP32S3_4DLCD_ROTATE_90:
+        px_start = frame_width - y_end;
+        px_end = frame_width - y_start;
+        py_start = x_start;
+        py_end = x_end;
+        break;
+    case ESP32S3_4DLCD_ROTATE_180:
+        px_start = frame_width - x_end;
+        px_end = frame_width - x_start;
+        py_start = frame_height - y_end;
+        py_end = frame_height - y_start;
+        break;
+    case ESP32S3_4DLCD_ROTATE_270:
+        px_start = y_start;
+        px_end = y_end;
+        py_start = frame_height - x_end;
+        py_end = frame_height - x_start;
+        break;
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+    int out_width = px_end - px_start;
+    int out_rows = py_end - py_start;
+    size_t out_row_bytes = out_width * dst_bytes;
+
+    ESP_RETURN_ON_ERROR(esp32s3_4dlcd_stream_begin(panel, px_start, py_start, px_end, py_end), TAG, "set window failed");
+    for (int row = 0; row < out_rows;) {
+        uint8_t *dst = NULL;
+        size_t avail = 0;
+        ESP_GOTO_ON_ERROR(esp32s3_4dlcd_stream_reserve(panel, &dst, &avail), err, TAG, "reserve chunk failed");
+        int rows = MIN(out_rows - row, (int)(avail / out_row_bytes));
+        ESP_GOTO_ON_FALSE(rows, ESP_ERR_INVALID_SIZE, err, TAG, "a row of %u bytes does not fit a chunk buffer", (unsigned)out_row_bytes);
+
+        rotate_rows(dst, color_data, stride, w, h, row, rows, rotation, src_bytes, dst_bytes, op);
+        ESP_GOTO_ON_ERROR(esp32s3_4dlcd_stream_commit(panel, rows * out_row_bytes), err, TAG, "send color failed");
+        // send now, the next rows are rotated into another buffer while these are on the wire
+        ESP_GOTO_ON_ERROR(esp32s3_4dlcd_stream_end(panel), err, TAG, "send color failed");
+        row += rows;
+    }
+    return ESP_OK;
+
+err:
+    esp32s3_4dlcd_stream_end(panel);
+    return ret;
+}
@@ -0,0 +1,46 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+
+#include "esp32s3_4dlcd.h"
+#include "esp32s3_4dlcd_priv.h"
+
+static const char *TAG = "esp32s3_4dlcd_scanline";
+
+esp_err_t esp32s3_4dlcd_draw_lines(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                   esp32s3_4dlcd_line_producer_t producer, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(panel && producer && (x_start < x_end) && (y_start < y_end), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp_err_t ret = ESP_OK;
+    size_t row_bytes = (size_t)(x_end - x_start) * esp32s3_4dlcd_pixel_bytes(panel);
+
+    ESP_RETURN_ON_ERROR(esp32s3_4dlcd_stream_begin(panel, x_start, y_start, x_end, y_end), TAG, "set window failed");
+    for (int y = y_start; y < y_end;) {
+        uint8_t *dst = NULL;
+        size_t avail = 0;
+        ESP_GOTO_ON_ERROR(esp32s3_4dlcd_stream_reserve(panel, &dst, &avail), err, TAG, "reserve chunk failed");
+        int lines = MIN(y_end - y, (int)(avail / row_bytes));
+        ESP_GOTO_ON_FALSE(lines, ESP_ERR_INVALID_SIZE, err, TAG, "a row of %u bytes does not fit a chunk buffer", (unsigned)row_bytes);
+
+        ESP_GOTO_ON_ERROR(producer(y, lines, dst, user_ctx), err, TAG, "line producer failed at row %d", y);
+        ESP_GOTO_ON_ERROR(esp32s3_4dlcd_stream_commit(panel, lines * row_bytes), err, TAG, "send color failed");
+        // send what is there now, the next lines are produced into another buffer while these are on the wire
+        ESP_GOTO_ON_ERROR(esp32s3_4dlcd_stream_end(panel), err, TAG, "send color failed");
+        y += lines;
+    }
+    return ESP_OK;
+
+err:
+    // release the chunk buffer, the memory write is left unfinished
+    esp32s3_4dlcd_stream_end(panel);
+    return ret;
+}
@@ -0,0 +1,332 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+
+#include "esp32s3_4dlcd.h"
+#include "esp32s3_4dlcd_priv.h"
+
+static const char *TAG = "esp32s3_4dlcd_submit";
+
+#define SUBMIT_BATCH_MAX    16      // commands taken from the ring before they are issued together
+
+typedef struct {
+    atomic_uint seq;        // ring position this cell can be written at, or position + 1 once it holds a command
+    int64_t enqueue_us;
+    esp32s3_4dlcd_submit_cmd_t cmd;
+} submit_cell_t;
+
+typedef struct {
+    esp32s3_4dlcd_submit_done_cb_t done_cb;
+    void *user_ctx;
+    int64_t enqueue_us;
+    uint8_t producer;
+    uint8_t op_index;       // entry of the batch whose result is reported
+} submit_completion_t;
+
+struct esp32s3_4dlcd_submit_t {
+    esp_lcd_panel_handle_t panel;
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done;    // chained while tracking, needed to stop it
+    void *user_ctx;
+    TaskHandle_t task;
+    TaskHandle_t waiter;            // task waiting in esp32s3_4dlcd_submit_del
+    volatile bool stop;
+    portMUX_TYPE stats_lock;
+    esp32s3_4dlcd_submit_stats_t stats;
+    atomic_uint queue_full;
+    atomic_uint enqueue_pos;
+    unsigned dequeue_pos;           // only touched by the flush task
+    unsigned mask;
+    esp32s3_4dlcd_submit_cmd_t ops[SUBMIT_BATCH_MAX];
+    submit_completion_t completions[SUBMIT_BATCH_MAX];
+    submit_cell_t cells[];
+};
+
+// Bounded multi-producer ring after D. Vyukov: a producer claims a position with a CAS on enqueue_pos, and each cell
+// sequence number tells whether it is free for that position or holds a published command. No locks are taken.
+static bool ring_push(esp32s3_4dlcd_submit_handle_t submit, const esp32s3_4dlcd_submit_cmd_t *cmd)
+{
+    unsigned pos = atomic_load_explicit(&submit->enqueue_pos, memory_order_relaxed);
+    submit_cell_t *cell;
+    for (;;) {
+        cell = &submit->cells[pos & submit->mask];
+        unsigned seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        int diff = (int)(seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&submit->enqueue_pos, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false; // the consumer has not freed this cell yet, ring is full
+        } else {
+            pos = atomic_load_explicit(&submit->enqueue_pos, memory_order_relaxed);
+        }
+    }
+    cell->cmd = *cmd;
+    cell->enqueue_us = esp_timer_get_time();
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    return true;
+}
+
+static bool ring_pop(esp32s3_4dlcd_submit_handle_t submit, esp32s3_4dlcd_submit_cmd_t *cmd, int64_t *enqueue_us)
+{
+    unsigned pos = submit->dequeue_pos;
+    submit_cell_t *cell = &submit->cells[pos & submit->mask];
+    unsigned seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+    if ((int)(seq - (pos + 1)) < 0) {
+        return false;
+    }
+    *cmd = cell->cmd;
+    *enqueue_us = cell->enqueue_us;
+    atomic_store_explicit(&cell->seq, pos + submit->mask + 1, memory_order_release);
+    submit->dequeue_pos = pos + 1;
+    return true;
+}
+
+// Try to fold `next` into `prev`: a draw whose rows continue the previous one in the same source buffer becomes one
+// transfer, and a state command followed by another of the same kind only needs the last one
+static bool merge_cmd(esp32s3_4dlcd_submit_cmd_t *prev, const esp32s3_4dlcd_submit_cmd_t *next, size_t src_pixel_bytes)
+{
+    if (prev->op != next->op) {
+        return false;
+    }
+    switch (next->op) {
+    case ESP32S3_4DLCD_SUBMIT_DRAW: {
+        size_t bytes = (size_t)(prev->draw.x_end - prev->draw.x_start) * (prev->draw.y_end - prev->draw.y_start) * src_pixel_bytes;
+        if (next->draw.x_start != prev->draw.x_start || next->draw.x_end != prev->draw.x_end ||
+                next->draw.y_start != prev->draw.y_end ||
+                next->draw.color_data != (const uint8_t *)prev->draw.color_data + bytes) {
+            return false;
+        }
+        prev->draw.y_end = next->draw.y_end;
+        return true;
+    }
+    case ESP32S3_4DLCD_SUBMIT_MIRROR:
+    case ESP32S3_4DLCD_SUBMIT_SWAP_XY:
+    case ESP32S3_4DLCD_SUBMIT_INVERT:
+    case ESP32S3_4DLCD_SUBMIT_GAP:
+    case ESP32S3_4DLCD_SUBMIT_DISP_ON_OFF:
+        *prev = *next;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static esp_err_t issue_cmd(esp_lcd_panel_handle_t panel, const esp32s3_4dlcd_submit_cmd_t *cmd)
+{
+    switch (cmd->op) {
+    case ESP32S3_4DLCD_SUBMIT_DRAW:
+        return esp_lcd_panel_draw_bitmap(panel, cmd->draw.x_start, cmd->draw.y_start, cmd->draw.x_end, cmd->draw.y_end,
+                                         cmd->draw.color_data);
+    case ESP32S3_4DLCD_SUBMIT_FILL:
+        return esp32s3_4dlcd_fill_rect(panel, cmd->fill.x_start, cmd->fill.y_start, cmd->fill.x_end, cmd->fill.y_end,
+                                       cmd->fill.color);
+    case ESP32S3_4DLCD_SUBMIT_MIRROR:
+        return esp_lcd_panel_mirror(panel, cmd->mirror.mirror_x, cmd->mirror.mirror_y);
+    case ESP32S3_4DLCD_SUBMIT_SWAP_XY:
+        return esp_lcd_panel_swap_xy(panel, cmd->swap_axes);
+    case ESP32S3_4DLCD_SUBMIT_INVERT:
+        return esp_lcd_panel_invert_color(panel, cmd->invert_color);
+    case ESP32S3_4DLCD_SUBMIT_GAP:
+        return esp_lcd_panel_set_gap(panel, cmd->gap.x_gap, cmd->gap.y_gap);
+    case ESP32S3_4DLCD_SUBMIT_DISP_ON_OFF:
+        return esp_lcd_panel_disp_on_off(panel, cmd->on_off);
+    case ESP32S3_4DLCD_SUBMIT_SYNC:
+        return ESP_OK;
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+}
+
+// Take up to a batch of commands off the ring, issue them, wait for their pixels to leave and report completion
+static bool drain_batch(esp32s3_4dlcd_submit_handle_t submit)
+{
+    size_t src_pixel_bytes = esp32s3_4dlcd_src_pixel_bytes(submit->panel);
+    esp32s3_4dlcd_submit_cmd_t cmd;
+    int64_t enqueue_us;
+    size_t num_ops = 0;
+    size_t num_done = 0;
+    uint32_t merged = 0;
+
+    unsigned depth = atomic_load_explicit(&submit->enqueue_pos, memory_order_relaxed) - submit->dequeue_pos;
+    while (num_done < SUBMIT_BATCH_MAX && ring_pop(submit, &cmd, &enqueue_us)) {
+        if (num_ops && merge_cmd(&submit->ops[num_ops - 1], &cmd, src_pixel_bytes)) {
+            merged++;
+        } else {
+            submit->ops[num_ops++] = cmd;
+        }
+        submit->completions[num_done++] = (submit_completion_t) {
+            .done_cb = cmd.done_cb,
+            .user_ctx = cmd.user_ctx,
+            .enqueue_us = enqueue_us,
+            .producer = cmd.producer,
+            .op_index = num_ops - 1,
+        };
+    }
+    if (!num_done) {
+        return false;
+    }
+
+    esp_err_t results[SUBMIT_BATCH_MAX];
+    for (size_t i = 0; i < num_ops; i++) {
+        results[i] = issue_cmd(submit->panel, &submit->ops[i]);
+        if (results[i] != ESP_OK) {
+            ESP_LOGW(TAG, "command %d failed: %s", submit->ops[i].op, esp_err_to_name(results[i]));
+        }
+    }
+    // once the last colour transaction of the batch is done, every draw buffer of the batch can be reused
+    esp_err_t wait_ret = esp32s3_4dlcd_trans_wait(submit->panel, esp32s3_4dlcd_trans_seq(submit->panel), portMAX_DELAY);
+    if (wait_ret != ESP_OK) {
+        // the buffers may still be read, tell every producer rather than report success
+        ESP_LOGE(TAG, "wait for the batch to leave the bus failed: %s", esp_err_to_name(wait_ret));
+        for (size_t i = 0; i < num_ops; i++) {
+            if (results[i] == ESP_OK) {
+                results[i] = wait_ret;
+            }
+        }
+    }
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&submit->stats_lock);
+    submit->stats.commands += num_done;
+    submit->stats.batches++;
+    submit->stats.merged += merged;
+    submit->stats.queue_high_water = MAX(submit->stats.queue_high_water, depth);
+    for (size_t i = 0; i < num_done; i++) {
+        esp32s3_4dlcd_submit_producer_stats_t *p = &submit->stats.producers[submit->completions[i].producer];
+        uint32_t latency_us = now - submit->completions[i].enqueue_us;
+        p->commands++;
+        p->total_latency_us += latency_us;
+        p->max_latency_us = MAX(p->max_latency_us, latency_us);
+    }
+    portEXIT_CRITICAL(&submit->stats_lock);
+
+    for (size_t i = 0; i < num_done; i++) {
+        if (submit->completions[i].done_cb) {
+            submit->completions[i].done_cb(results[submit->completions[i].op_index], submit->completions[i].user_ctx);
+        }
+    }
+    return true;
+}
+
+static void flush_task(void *arg)
+{
+    esp32s3_4dlcd_submit_handle_t submit = arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (drain_batch(submit)) {
+        }
+        if (submit->stop) {
+            break;
+        }
+    }
+    xTaskNotifyGive(submit->waiter);
+    vTaskDelete(NULL);
+}
+
+esp_err_t esp32s3_4dlcd_submit_new(esp_lcd_panel_handle_t panel, const esp32s3_4dlcd_submit_config_t *config,
+                                   esp32s3_4dlcd_submit_handle_t *ret_submit)
+{
+    esp_err_t ret = ESP_OK;
+    esp32s3_4dlcd_submit_handle_t submit = NULL;
+    bool tracking = false;
+
+    ESP_GOTO_ON_FALSE(panel && config && ret_submit, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(config->queue_size >= 2 && !(config->queue_size & (config->queue_size - 1)),
+                      ESP_ERR_INVALID_ARG, err, TAG, "queue size must be a power of two");
+    submit = calloc(1, sizeof(struct esp32s3_4dlcd_submit_t) + config->queue_size * sizeof(submit_cell_t));
+    ESP_GOTO_ON_FALSE(submit, ESP_ERR_NO_MEM, err, TAG, "no mem for submission queue");
+    submit->panel = panel;
+    submit->mask = config->queue_size - 1;
+    submit->on_color_trans_done = config->on_color_trans_done;
+    submit->user_ctx = config->user_ctx;
+    submit->stats_lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    for (size_t i = 0; i < config->queue_size; i++) {
+        atomic_init(&submit->cells[i].seq, i);
+    }
+    ESP_GOTO_ON_ERROR(esp32s3_4dlcd_trans_track(panel, config->on_color_trans_done, config->user_ctx), err, TAG, "track transactions failed");
+    tracking = true;
+    ESP_GOTO_ON_FALSE(xTaskCreatePinnedToCore(flush_task, "lcd_flush", config->task_stack, submit, config->task_priority,
+                      &submit->task, config->task_core) == pdPASS, ESP_ERR_NO_MEM, err, TAG, "create flush task failed");
+
+    *ret_submit = submit;
+    ESP_LOGD(TAG, "new submission queue @%p with %u entries", submit, (unsigned)config->queue_size);
+    return ESP_OK;
+
+err:
+    if (tracking) {
+        esp32s3_4dlcd_trans_untrack(panel, config->on_color_trans_done, config->user_ctx);
+    }
+    free(submit);
+    return ret;
+}
+
+esp_err_t esp32s3_4dlcd_submit_del(esp32s3_4dlcd_submit_handle_t submit)
+{
+    ESP_RETURN_ON_FALSE(submit, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    // the flush task drains what is left, then hands back control
+    submit->waiter = xTaskGetCurrentTaskHandle();
+    submit->stop = true;
+    xTaskNotifyGive(submit->task);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    esp32s3_4dlcd_trans_untrack(submit->panel, submit->on_color_trans_done, submit->user_ctx);
+    free(submit);
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_submit(esp32s3_4dlcd_submit_handle_t submit, const esp32s3_4dlcd_submit_cmd_t *cmd, TickType_t timeout)
+{
+    ESP_RETURN_ON_FALSE(submit && cmd && cmd->producer < ESP32S3_4DLCD_SUBMIT_MAX_PRODUCERS, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    TickType_t start = xTaskGetTickCount();
+    bool full = false;
+    while (!ring_push(submit, cmd)) {
+        // one event per submission that found the ring full, however long it then waits
+        if (!full) {
+            full = true;
+            atomic_fetch_add_explicit(&submit->queue_full, 1, memory_order_relaxed);
+        }
+        if (timeout != portMAX_DELAY && xTaskGetTickCount() - start >= timeout) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(1);
+    }
+    xTaskNotifyGive(submit->task);
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_submit_get_stats(esp32s3_4dlcd_submit_handle_t submit, esp32s3_4dlcd_submit_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(submit && stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    portENTER_CRITICAL(&submit->stats_lock);
+    *stats = submit->stats;
+    portEXIT_CRITICAL(&submit->stats_lock);
+    stats->queue_full = atomic_load_explicit(&submit->queue_full, memory_order_relaxed);
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_submit_reset_stats(esp32s3_4dlcd_submit_handle_t submit)
+{
+    ESP_RETURN_ON_FALSE(submit, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    portENTER_CRITICAL(&submit->stats_lock);
+    submit->stats = (esp32s3_4dlcd_submit_stats_t) {
+        0
+    };
+    portEXIT_CRITICAL(&submit->stats_lock);
+    atomic_store_explicit(&submit->queue_full, 0, memory_order_relaxed);
+    return ESP_OK;
+}
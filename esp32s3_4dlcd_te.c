@@ -0,0 +1,204 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+
+#include "esp32s3_4dlcd.h"
+#include "esp32s3_4dlcd_priv.h"
+#include "esp32s3_4dlcd_te_schedule.h"
+
+static const char *TAG = "esp32s3_4dlcd_te";
+
+// Longest wait for a TE pulse before giving up, the slowest panels refresh at about 30Hz
+#define TE_PULSE_TIMEOUT_MS     100
+
+struct esp32s3_4dlcd_te_t {
+    esp_lcd_panel_handle_t panel;
+    esp32s3_4dlcd_te_config_t config;
+    SemaphoreHandle_t pulse_sem;
+    portMUX_TYPE lock;          // pulse timing shared with the ISR
+    uint32_t pulses;
+    int64_t pulse_us;           // time of the last pulse
+    uint32_t period_us;         // running average of the pulse interval
+    uint32_t next_due;          // pulse the next paced frame is due at, 0 before the first frame
+    esp32s3_4dlcd_te_stats_t stats;
+};
+
+static void IRAM_ATTR te_isr(void *arg)
+{
+    esp32s3_4dlcd_te_handle_t te = (esp32s3_4dlcd_te_handle_t)arg;
+    int64_t now = esp_timer_get_time();
+    BaseType_t need_yield = pdFALSE;
+
+    portENTER_CRITICAL_ISR(&te->lock);
+    if (te->pulses) {
+        uint32_t interval = now - te->pulse_us;
+        te->period_us = te->period_us ? (te->period_us * 7 + interval) / 8 : interval;
+    }
+    te->pulse_us = now;
+    te->pulses++;
+    portEXIT_CRITICAL_ISR(&te->lock);
+
+    xSemaphoreGiveFromISR(te->pulse_sem, &need_yield);
+    if (need_yield == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static void te_snapshot(esp32s3_4dlcd_te_handle_t te, uint32_t *pulses, int64_t *pulse_us, uint32_t *period_us)
+{
+    portENTER_CRITICAL(&te->lock);
+    *pulses = te->pulses;
+    *pulse_us = te->pulse_us;
+    *period_us = te->period_us;
+    portEXIT_CRITICAL(&te->lock);
+}
+
+esp_err_t esp32s3_4dlcd_te_new(esp_lcd_panel_handle_t panel, const esp32s3_4dlcd_te_config_t *config, esp32s3_4dlcd_te_handle_t *ret_te)
+{
+    esp_err_t ret = ESP_OK;
+    esp32s3_4dlcd_te_handle_t te = NULL;
+    bool isr_added = false;
+
+    ESP_GOTO_ON_FALSE(panel && config && ret_te && config->gpio_num >= 0 && config->pclk_hz && config->bus_width,
+                      ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    te = calloc(1, sizeof(struct esp32s3_4dlcd_te_t));
+    ESP_GOTO_ON_FALSE(te, ESP_ERR_NO_MEM, err, TAG, "no mem for TE presenter");
+    te->panel = panel;
+    te->config = *config;
+    te->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    te->pulse_sem = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(te->pulse_sem, ESP_ERR_NO_MEM, err, TAG, "no mem for TE semaphore");
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << config->gpio_num,
+        .mode = GPIO_MODE_INPUT,
+        .intr_type = GPIO_INTR_POSEDGE,
+    };
+    ESP_GOTO_ON_ERROR(gpio_config(&io_conf), err, TAG, "configure TE GPIO failed");
+    ret = gpio_install_isr_service(0);
+    ESP_GOTO_ON_FALSE(ret == ESP_OK || ret == ESP_ERR_INVALID_STATE, ret, err, TAG, "install GPIO ISR service failed");
+    ESP_GOTO_ON_ERROR(gpio_isr_handler_add(config->gpio_num, te_isr, te), err, TAG, "add TE ISR failed");
+    isr_added = true;
+    ESP_GOTO_ON_ERROR(esp32s3_4dlcd_set_tearing_effect(panel, true), err, TAG, "turn TE output on failed");
+
+    *ret_te = te;
+    return ESP_OK;
+
+err:
+    if (te) {
+        if (isr_added) {
+            gpio_isr_handler_remove(config->gpio_num);
+        }
+        if (te->pulse_sem) {
+            vSemaphoreDelete(te->pulse_sem);
+        }
+        free(te);
+    }
+    return ret;
+}
+
+esp_err_t esp32s3_4dlcd_te_del(esp32s3_4dlcd_te_handle_t te)
+{
+    ESP_RETURN_ON_FALSE(te, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_set_tearing_effect(te->panel, false);
+    gpio_isr_handler_remove(te->config.gpio_num);
+    vSemaphoreDelete(te->pulse_sem);
+    free(te);
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_te_present(esp32s3_4dlcd_te_handle_t te, int x_start, int y_start, int x_end, int y_end, const void *color_data)
+{
+    ESP_RETURN_ON_FALSE(te && color_data && (x_start < x_end) && (y_start < y_end), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    uint32_t pulses;
+    int64_t pulse_us;
+    uint32_t period_us;
+
+    // whole refreshes per paced frame, known once the refresh period has been measured
+    te_snapshot(te, &pulses, &pulse_us, &period_us);
+    uint32_t interval = 1;
+    if (te->config.target_fps && period_us) {
+        uint32_t panel_fps = 1000000 / period_us;
+        interval = MAX(1, (panel_fps + te->config.target_fps / 2) / te->config.target_fps);
+    }
+    if (te->next_due && pulses >= te->next_due) {
+        // the refresh this frame was due at has passed, and maybe more
+        te->stats.dropped += 1 + (pulses - te->next_due) / interval;
+    }
+
+    // a pulse that came before this call is already too old to start from
+    xSemaphoreTake(te->pulse_sem, 0);
+    do {
+        ESP_RETURN_ON_FALSE(xSemaphoreTake(te->pulse_sem, pdMS_TO_TICKS(TE_PULSE_TIMEOUT_MS)) == pdTRUE, ESP_ERR_TIMEOUT,
+                            TAG, "no TE pulse");
+        te_snapshot(te, &pulses, &pulse_us, &period_us);
+    } while (te->next_due && pulses < te->next_due);
+
+    int64_t delay_ns = 0;
+    bool synced = false;
+    int scan_start = y_start;
+    int scan_end = y_end;
+    int rows;
+    bool descending;
+    if (period_us && esp32s3_4dlcd_scan_rows(te->panel, &scan_start, &scan_end, &rows, &descending)) {
+        size_t row_bytes = (size_t)(x_end - x_start) * esp32s3_4dlcd_pixel_bytes(te->panel);
+        int64_t row_ns = (int64_t)row_bytes * 8 * 1000000000LL / ((int64_t)te->config.pclk_hz * te->config.bus_width);
+        synced = esp32s3_4dlcd_te_schedule((int64_t)period_us * 1000, rows, row_ns, scan_start, scan_end, descending,
+                                           (int64_t)te->config.margin_us * 1000, &delay_ns);
+        if (te->config.mode == ESP32S3_4DLCD_TE_VBLANK) {
+            // starting right after the pulse is only clear of the scan if the schedule would not delay it
+            synced = synced && delay_ns == 0;
+            delay_ns = 0;
+        }
+    }
+    if (!synced) {
+        te->stats.unsynced++;
+    }
+
+    // the delay can be most of a refresh: sleep the whole ticks of it, which never oversleeps, and busy wait the rest
+    int64_t start_us = pulse_us + delay_ns / 1000;
+    int64_t wait_us = start_us - esp_timer_get_time();
+    TickType_t ticks = wait_us > 0 ? wait_us / (portTICK_PERIOD_MS * 1000) : 0;
+    if (ticks) {
+        vTaskDelay(ticks);
+        wait_us = start_us - esp_timer_get_time();
+    }
+    if (wait_us > 0) {
+        esp_rom_delay_us(wait_us);
+    }
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_draw_bitmap(te->panel, x_start, y_start, x_end, y_end, color_data), TAG, "draw failed");
+
+    te->next_due = pulses + interval;
+    te->stats.frames++;
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_te_get_stats(esp32s3_4dlcd_te_handle_t te, esp32s3_4dlcd_te_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(te && stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    uint32_t pulses;
+    int64_t pulse_us;
+    uint32_t period_us;
+    te_snapshot(te, &pulses, &pulse_us, &period_us);
+    *stats = te->stats;
+    stats->pulses = pulses;
+    stats->period_us = period_us;
+    return ESP_OK;
+}
@@ -0,0 +1,38 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <sys/param.h>
+#include "esp32s3_4dlcd_te_schedule.h"
+
+bool esp32s3_4dlcd_te_schedule(int64_t period_ns, int rows, int64_t row_ns, int y_start, int y_end, bool descending,
+                               int64_t margin_ns, int64_t *delay_ns)
+{
+    int64_t scan_ns = period_ns / rows;
+    int64_t write_ns = (int64_t)(y_end - y_start) * row_ns;
+    // the time row r is written at, relative to the time the scan reads it, is linear in r: the extremes are at the ends
+    int64_t lead_first = (int64_t)(descending ? y_end : y_start) * scan_ns;
+    int64_t lead_last = (int64_t)(descending ? y_start : y_end) * scan_ns - write_ns;
+    int64_t lead_min = MIN(lead_first, lead_last);
+    int64_t lead_max = MAX(lead_first, lead_last);
+
+    // ahead of the scan: starting now, every row is written at least the margin before it is read
+    if (lead_min >= margin_ns) {
+        *delay_ns = 0;
+        return true;
+    }
+    // behind the scan: start once it has passed the whole window, finish before it comes round again
+    int64_t earliest = lead_max + margin_ns;
+    int64_t latest = period_ns + lead_min - margin_ns;
+    if (earliest <= latest) {
+        *delay_ns = MAX(earliest, 0);
+        return true;
+    }
+    *delay_ns = 0;
+    return false;
+}
@@ -0,0 +1,222 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+
+#include "esp32s3_4dlcd.h"
+#include "esp32s3_4dlcd_priv.h"
+#include "esp32s3_4dlcd_pixel.h"
+
+static const char *TAG = "esp32s3_4dlcd_text";
+
+struct esp32s3_4dlcd_text_t {
+    esp_lcd_panel_handle_t panel;
+    esp32s3_4dlcd_font_t font;      // glyphs and bitmap point into the atlas
+    uint8_t *atlas;                 // glyph table followed by the bitmap, in internal RAM
+    size_t pixel_bytes;
+    int pixels_per_byte;
+    size_t lut_entry;               // bytes of panel pixels one byte of alpha expands to
+    uint8_t *lut;                   // 256 entries of `lut_entry` bytes
+    bool lut_valid;
+    uint16_t fg;                    // colours the table was built for
+    uint16_t bg;
+};
+
+typedef struct {
+    esp32s3_4dlcd_text_handle_t text;
+    const uint8_t *str;
+    int y;                          // panel row of the top of the text
+    int width;                      // columns to draw, the run clipped to the panel
+} text_ctx_t;
+
+static const esp32s3_4dlcd_glyph_t *text_glyph(esp32s3_4dlcd_text_handle_t text, uint8_t c)
+{
+    const esp32s3_4dlcd_font_t *font = &text->font;
+    uint32_t index = (uint32_t)c - font->first;
+    return &font->glyphs[index < font->count ? index : font->fallback];
+}
+
+// Blend two RGB565 colours per channel, alpha is 0..max
+static uint16_t blend565(uint16_t fg, uint16_t bg, uint32_t alpha, uint32_t max)
+{
+    uint32_t r = (((fg >> 11) & 0x1F) * alpha + ((bg >> 11) & 0x1F) * (max - alpha) + max / 2) / max;
+    uint32_t g = (((fg >> 5) & 0x3F) * alpha + ((bg >> 5) & 0x3F) * (max - alpha) + max / 2) / max;
+    uint32_t b = ((fg & 0x1F) * alpha + (bg & 0x1F) * (max - alpha) + max / 2) / max;
+    return (r << 11) | (g << 5) | b;
+}
+
+// Expand every byte of alpha to its row of panel pixels, so a glyph row becomes one copy per byte
+static void text_build_lut(esp32s3_4dlcd_text_handle_t text, uint16_t fg, uint16_t bg)
+{
+    int bpp = text->font.bpp;
+    uint32_t max = (1 << bpp) - 1;
+    uint16_t shades[16];
+    uint8_t palette[16 * 3];
+
+    for (uint32_t a = 0; a <= max; a++) {
+        shades[a] = blend565(fg, bg, a, max);
+    }
+    if (text->pixel_bytes == 3) {
+        esp32s3_4dlcd_rgb565_to_rgb666(palette, shades, max + 1);
+    } else {
+        esp32s3_4dlcd_rgb565_to_be(palette, shades, max + 1);
+    }
+
+    for (int v = 0; v < 256; v++) {
+        uint8_t *entry = text->lut + v * text->lut_entry;
+        for (int i = 0; i < text->pixels_per_byte; i++) {
+            uint32_t a = (v >> (8 - bpp * (i + 1))) & max;
+            memcpy(entry + i * text->pixel_bytes, palette + a * text->pixel_bytes, text->pixel_bytes);
+        }
+    }
+    text->fg = fg;
+    text->bg = bg;
+    text->lut_valid = true;
+}
+
+// Render `cols` columns of glyph row `row` into `out`, background past the bitmap
+static uint8_t *text_glyph_row(esp32s3_4dlcd_text_handle_t text, const esp32s3_4dlcd_glyph_t *glyph, int row, int cols, uint8_t *out)
+{
+    size_t pb = text->pixel_bytes;
+    int ppb = text->pixels_per_byte;
+    int n = MIN(cols, glyph->width);
+    const uint8_t *src = text->font.bitmap + glyph->offset + row * ((glyph->width + ppb - 1) / ppb);
+
+    for (; n >= ppb; n -= ppb) {
+        memcpy(out, text->lut + *src++ * text->lut_entry, text->lut_entry);
+        out += text->lut_entry;
+    }
+    if (n) {
+        memcpy(out, text->lut + *src * text->lut_entry, n * pb);
+        out += n * pb;
+    }
+    // zero alpha is the background, in the first entry
+    for (int i = glyph->width; i < cols; i++) {
+        memcpy(out, text->lut, pb);
+        out += pb;
+    }
+    return out;
+}
+
+static esp_err_t text_lines(int y, int lines, void *dst, void *user_ctx)
+{
+    text_ctx_t *ctx = (text_ctx_t *)user_ctx;
+    esp32s3_4dlcd_text_handle_t text = ctx->text;
+    uint8_t *out = dst;
+
+    for (int row = y - ctx->y; row < y - ctx->y + lines; row++) {
+        int remaining = ctx->width;
+        for (const uint8_t *s = ctx->str; *s && remaining > 0; s++) {
+            const esp32s3_4dlcd_glyph_t *glyph = text_glyph(text, *s);
+            int cols = MIN(glyph->advance, remaining);
+            out = text_glyph_row(text, glyph, row, cols, out);
+            remaining -= cols;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp32s3_4dlcd_text_new(esp_lcd_panel_handle_t panel, const esp32s3_4dlcd_font_t *font, esp32s3_4dlcd_text_handle_t *ret_text)
+{
+    ESP_RETURN_ON_FALSE(panel && font && ret_text && font->glyphs && font->bitmap && font->count && font->height &&
+                        font->fallback < font->count && (font->bpp == 1 || font->bpp == 2 || font->bpp == 4),
+                        ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    int ppb = 8 / font->bpp;
+    for (int i = 0; i < font->count; i++) {
+        const esp32s3_4dlcd_glyph_t *glyph = &font->glyphs[i];
+        size_t size = (size_t)((glyph->width + ppb - 1) / ppb) * font->height;
+        ESP_RETURN_ON_FALSE(glyph->advance >= glyph->width && glyph->offset + size <= font->bitmap_size,
+                            ESP_ERR_INVALID_ARG, TAG, "invalid glyph %d", i);
+    }
+
+    esp_err_t ret = ESP_OK;
+    esp32s3_4dlcd_text_handle_t text = calloc(1, sizeof(struct esp32s3_4dlcd_text_t));
+    ESP_RETURN_ON_FALSE(text, ESP_ERR_NO_MEM, TAG, "no mem for text renderer");
+    text->panel = panel;
+    text->pixel_bytes = esp32s3_4dlcd_pixel_bytes(panel);
+    text->pixels_per_byte = ppb;
+    text->lut_entry = ppb * text->pixel_bytes;
+
+    // glyphs are read for every row of every character, keep them out of flash and PSRAM
+    size_t glyphs_size = font->count * sizeof(esp32s3_4dlcd_glyph_t);
+    text->atlas = heap_caps_malloc(glyphs_size + font->bitmap_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    ESP_GOTO_ON_FALSE(text->atlas, ESP_ERR_NO_MEM, err, TAG, "no mem for glyph atlas");
+    memcpy(text->atlas, font->glyphs, glyphs_size);
+    memcpy(text->atlas + glyphs_size, font->bitmap, font->bitmap_size);
+    text->font = *font;
+    text->font.glyphs = (const esp32s3_4dlcd_glyph_t *)text->atlas;
+    text->font.bitmap = text->atlas + glyphs_size;
+
+    text->lut = heap_caps_malloc(256 * text->lut_entry, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    ESP_GOTO_ON_FALSE(text->lut, ESP_ERR_NO_MEM, err, TAG, "no mem for colour table");
+
+    *ret_text = text;
+    return ESP_OK;
+
+err:
+    heap_caps_free(text->atlas);
+    free(text);
+    return ret;
+}
+
+esp_err_t esp32s3_4dlcd_text_del(esp32s3_4dlcd_text_handle_t text)
+{
+    ESP_RETURN_ON_FALSE(text, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    heap_caps_free(text->lut);
+    heap_caps_free(text->atlas);
+    free(text);
+    return ESP_OK;
+}
+
+int esp32s3_4dlcd_text_width(esp32s3_4dlcd_text_handle_t text, const char *str)
+{
+    if (!text || !str) {
+        return 0;
+    }
+    int width = 0;
+    for (const uint8_t *s = (const uint8_t *)str; *s; s++) {
+        width += text_glyph(text, *s)->advance;
+    }
+    return width;
+}
+
+esp_err_t esp32s3_4dlcd_text_draw(esp32s3_4dlcd_text_handle_t text, int x, int y, const char *str, uint16_t fg, uint16_t bg,
+                                  int *width)
+{
+    ESP_RETURN_ON_FALSE(text && str && x >= 0 && y >= 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    int frame_width;
+    int frame_height;
+    // drawn through draw_lines, which software rotation does not apply to
+    esp32s3_4dlcd_unrotated_size(text->panel, &frame_width, &frame_height);
+
+    text_ctx_t ctx = {
+        .text = text,
+        .str = (const uint8_t *)str,
+        .y = y,
+        .width = MIN(esp32s3_4dlcd_text_width(text, str), frame_width - x),
+    };
+    int y_end = MIN(y + text->font.height, frame_height);
+    if (width) {
+        *width = MAX(ctx.width, 0);
+    }
+    if (ctx.width <= 0 || y_end <= y) {
+        return ESP_OK;
+    }
+    if (!text->lut_valid || text->fg != fg || text->bg != bg) {
+        text_build_lut(text, fg, bg);
+    }
+
+    // the whole run is one window, its rows rendered straight into the chunk buffers
+    return esp32s3_4dlcd_draw_lines(text->panel, x, y, x + ctx.width, y_end, text_lines, &ctx);
+}
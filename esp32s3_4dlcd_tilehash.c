@@ -0,0 +1,191 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+
+#include "esp32s3_4dlcd.h"
+
+static const char *TAG = "esp32s3_4dlcd_tilehash";
+
+#define HASH_PRIME      0x01000193U
+#define HASH_SEED       0x811C9DC5U
+
+typedef struct {
+    int x_start;    // first tile column of the run
+    int x_end;      // tile column after the run
+    int y_start;    // first tile row of the run
+} tile_run_t;
+
+struct esp32s3_4dlcd_tilehash_t {
+    esp32s3_4dlcd_tilehash_config_t config;
+    int tiles_x;
+    int tiles_y;
+    bool valid;             // hashes describe what the panel shows
+    uint32_t *hashes;       // tiles_x * tiles_y entries
+    tile_run_t *open_runs;  // runs of changed tiles still growing downwards
+    tile_run_t *row_runs;   // runs of changed tiles in the current tile row
+};
+
+static inline uint32_t load_u32(const uint8_t *p)
+{
+    uint32_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+// Four independent lanes keep the multiplies free of dependencies, so they pipeline (or vectorise) well
+static uint32_t hash_tile(const uint8_t *p, size_t row_bytes, size_t stride, int rows)
+{
+    uint32_t h0 = HASH_SEED, h1 = HASH_SEED ^ 1, h2 = HASH_SEED ^ 2, h3 = HASH_SEED ^ 3;
+    for (int y = 0; y < rows; y++, p += stride) {
+        size_t i = 0;
+        for (; i + 16 <= row_bytes; i += 16) {
+            h0 = (h0 ^ load_u32(p + i)) * HASH_PRIME;
+            h1 = (h1 ^ load_u32(p + i + 4)) * HASH_PRIME;
+            h2 = (h2 ^ load_u32(p + i + 8)) * HASH_PRIME;
+            h3 = (h3 ^ load_u32(p + i + 12)) * HASH_PRIME;
+        }
+        for (; i < row_bytes; i++) {
+            h0 = (h0 ^ p[i]) * HASH_PRIME;
+        }
+    }
+    return ((h0 ^ (h1 << 7 | h1 >> 25)) * HASH_PRIME) ^ (h2 << 13 | h2 >> 19) ^ (h3 << 21 | h3 >> 11);
+}
+
+static esp_err_t emit_run(esp32s3_4dlcd_tilehash_handle_t th, const tile_run_t *run, int y_end, esp32s3_4dlcd_damage_handle_t damage)
+{
+    const esp32s3_4dlcd_tilehash_config_t *c = &th->config;
+    return esp32s3_4dlcd_damage_add(damage, run->x_start * c->tile_width, run->y_start * c->tile_height,
+                                    MIN(run->x_end * c->tile_width, c->width), MIN(y_end * c->tile_height, c->height));
+}
+
+esp_err_t esp32s3_4dlcd_tilehash_new(const esp32s3_4dlcd_tilehash_config_t *config, esp32s3_4dlcd_tilehash_handle_t *ret_tilehash)
+{
+    esp_err_t ret = ESP_OK;
+    esp32s3_4dlcd_tilehash_handle_t th = NULL;
+
+    ESP_GOTO_ON_FALSE(config && ret_tilehash, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(config->width > 0 && config->height > 0 && config->bytes_per_pixel &&
+                      config->tile_width && config->tile_height, ESP_ERR_INVALID_ARG, err, TAG, "invalid size");
+    th = calloc(1, sizeof(struct esp32s3_4dlcd_tilehash_t));
+    ESP_GOTO_ON_FALSE(th, ESP_ERR_NO_MEM, err, TAG, "no mem for tile hash");
+    th->config = *config;
+
+    // grow the tiles until their hashes fit in the memory budget, alternating width and height to keep them square-ish
+    for (;;) {
+        th->tiles_x = (config->width + th->config.tile_width - 1) / th->config.tile_width;
+        th->tiles_y = (config->height + th->config.tile_height - 1) / th->config.tile_height;
+        if (!config->max_hash_bytes || (size_t)th->tiles_x * th->tiles_y * sizeof(uint32_t) <= config->max_hash_bytes) {
+            break;
+        }
+        ESP_GOTO_ON_FALSE(th->tiles_x > 1 || th->tiles_y > 1, ESP_ERR_INVALID_SIZE, err, TAG, "hash budget too small");
+        if (th->config.tile_width <= th->config.tile_height && th->tiles_x > 1) {
+            th->config.tile_width *= 2;
+        } else {
+            th->config.tile_height *= 2;
+        }
+    }
+    ESP_LOGD(TAG, "%dx%d tiles of %ux%u pixels", th->tiles_x, th->tiles_y, th->config.tile_width, th->config.tile_height);
+
+    th->hashes = calloc((size_t)th->tiles_x * th->tiles_y, sizeof(uint32_t));
+    th->open_runs = calloc(th->tiles_x, sizeof(tile_run_t));
+    th->row_runs = calloc(th->tiles_x, sizeof(tile_run_t));
+    ESP_GOTO_ON_FALSE(th->hashes && th->open_runs && th->row_runs, ESP_ERR_NO_MEM, err, TAG, "no mem for tile hashes");
+
+    *ret_tilehash = th;
+    return ESP_OK;
+
+err:
+    if (th) {
+        free(th->hashes);
+        free(th->open_runs);
+        free(th->row_runs);
+        free(th);
+    }
+    return ret;
+}
+
+esp_err_t esp32s3_4dlcd_tilehash_del(esp32s3_4dlcd_tilehash_handle_t tilehash)
+{
+    ESP_RETURN_ON_FALSE(tilehash, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    free(tilehash->hashes);
+    free(tilehash->open_runs);
+    free(tilehash->row_runs);
+    free(tilehash);
+    return ESP_OK;
+}
+
+void esp32s3_4dlcd_tilehash_invalidate(esp32s3_4dlcd_tilehash_handle_t tilehash)
+{
+    if (tilehash) {
+        tilehash->valid = false;
+    }
+}
+
+esp_err_t esp32s3_4dlcd_tilehash_scan(esp32s3_4dlcd_tilehash_handle_t tilehash, const void *fb, esp32s3_4dlcd_damage_handle_t damage)
+{
+    ESP_RETURN_ON_FALSE(tilehash && fb && damage, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp32s3_4dlcd_tilehash_handle_t th = tilehash;
+    const esp32s3_4dlcd_tilehash_config_t *c = &th->config;
+    const size_t stride = (size_t)c->width * c->bytes_per_pixel;
+    size_t num_open = 0;
+
+    for (int ty = 0; ty < th->tiles_y; ty++) {
+        int y = ty * c->tile_height;
+        int rows = MIN(c->tile_height, c->height - y);
+        size_t num_row = 0;
+
+        // collect the runs of changed tiles in this tile row
+        for (int tx = 0; tx < th->tiles_x; tx++) {
+            int x = tx * c->tile_width;
+            size_t row_bytes = (size_t)MIN(c->tile_width, c->width - x) * c->bytes_per_pixel;
+            uint32_t h = hash_tile((const uint8_t *)fb + y * stride + x * c->bytes_per_pixel, row_bytes, stride, rows);
+            uint32_t *slot = &th->hashes[ty * th->tiles_x + tx];
+            bool changed = !th->valid || *slot != h;
+            *slot = h;
+            if (!changed) {
+                continue;
+            }
+            if (num_row && th->row_runs[num_row - 1].x_end == tx) {
+                th->row_runs[num_row - 1].x_end = tx + 1;
+            } else {
+                th->row_runs[num_row++] = (tile_run_t) {
+                    .x_start = tx, .x_end = tx + 1, .y_start = ty
+                };
+            }
+        }
+
+        // a run spanning the same columns as an open run extends it downwards, other open runs are complete
+        for (size_t i = 0; i < num_open; i++) {
+            tile_run_t *open = &th->open_runs[i];
+            bool extended = false;
+            for (size_t j = 0; j < num_row; j++) {
+                if (th->row_runs[j].x_start == open->x_start && th->row_runs[j].x_end == open->x_end) {
+                    th->row_runs[j].y_start = open->y_start;
+                    extended = true;
+                    break;
+                }
+            }
+            if (!extended) {
+                ESP_RETURN_ON_ERROR(emit_run(th, open, ty, damage), TAG, "add damage failed");
+            }
+        }
+        memcpy(th->open_runs, th->row_runs, num_row * sizeof(tile_run_t));
+        num_open = num_row;
+    }
+    for (size_t i = 0; i < num_open; i++) {
+        ESP_RETURN_ON_ERROR(emit_run(th, &th->open_runs[i], th->tiles_y, damage), TAG, "add damage failed");
+    }
+    th->valid = true;
+    return ESP_OK;
+}
@@ -8,16 +8,36 @@ extern "C" {
 #define LCD_RST_ACTIVE_HIGH     0 // Reset pin active low
 
 // Resolution and bits per pixel for different 4D Systems ESP32-S3 RGB LCD models
+#if defined(CONFIG_ESP32S3_4DLCD_43)
+#define LCD_WIDTH               480
+#define LCD_HEIGHT              272
+#else
 #define LCD_WIDTH               800
 #define LCD_HEIGHT              480
+#endif
 #define LCD_BITS_PER_PIXEL      16
 
-// Pin definitions for SPI/QSPI, backlight, and reset
-// TODO
+// Pin definitions for the RGB bus, backlight, and reset.
+// The RGB panels have no reset line. The bus and backlight pins are board specific and not set here yet: define
+// them for your board (e.g. with target_compile_definitions) to use the default configurations.
+// `esp32s3_4dlcd_rgb_new` rejects a configuration without PCLK or data pins.
+#define LCD_RST_GPIO_NUM        -1      // GPIO for LCD reset (not used)
+#ifndef LCD_BL_GPIO_NUM
+#define LCD_BL_GPIO_NUM         -1      // GPIO for backlight control
+#endif
+#ifndef LCD_RGB_PCLK_GPIO_NUM
+#define LCD_RGB_PCLK_GPIO_NUM   -1      // GPIO for PCLK
+#define LCD_RGB_DE_GPIO_NUM     -1      // GPIO for DE (Data Enable)
+#define LCD_RGB_HSYNC_GPIO_NUM  -1      // GPIO for HSYNC
+#define LCD_RGB_VSYNC_GPIO_NUM  -1      // GPIO for VSYNC
+#define LCD_RGB_DISP_GPIO_NUM   -1      // GPIO for DISP (display enable), not used
+#define LCD_RGB_DATA_GPIO_NUMS  { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 } // B0-B4, G0-G5, R0-R4
+#endif
 
 #define LCD_BL_PWM_FREQ_HZ      25000    // PWM frequency (25kHz)
 #define LCD_BL_PWM_RESOLUTION   LEDC_TIMER_8_BIT  // 8-bit resolution (0-255)
+#define LCD_BL_FADE_RESOLUTION  LEDC_TIMER_11_BIT // Highest resolution at 25kHz, for gamma corrected fades
 
 #if defined(__cplusplus)
 }
-#endif
\ No newline at end of file
+#endif
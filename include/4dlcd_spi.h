@@ -34,6 +34,8 @@ extern "C" {
 #define LCD_QSPI_DAT2_GPIO_NUM  4       // GPIO for QSPI DATA2
 #define LCD_QSPI_DAT3_GPIO_NUM  3       // GPIO for QSPI DATA3
 #define LCD_SPI_PCLK_MHZ        30      // QSPI clock frequency in MHz
+#define LCD_TRANS_QUEUE_DEPTH   LCD_QSPI_TRANS_QUEUE_DEPTH
+#define LCD_BUS_WIDTH           4       // Data lines carrying pixel data
 #else
 #define LCD_BL_GPIO_NUM         4       // GPIO for backlight control
 #define LCD_RST_GPIO_NUM        7       // GPIO for LCD reset
@@ -43,10 +45,13 @@ extern "C" {
 #define LCD_SPI_MISO_GPIO_NUM   12      // GPIO for SPI MISO
 #define LCD_SPI_MOSI_GPIO_NUM   13      // GPIO for SPI MOSI
 #define LCD_SPI_PCLK_MHZ        60      // SPI clock frequency in MHz
+#define LCD_TRANS_QUEUE_DEPTH   LCD_SPI_TRANS_QUEUE_DEPTH
+#define LCD_BUS_WIDTH           1       // Data lines carrying pixel data
 #endif
 
 #define LCD_BL_PWM_FREQ_HZ      25000    // PWM frequency (25kHz)
 #define LCD_BL_PWM_RESOLUTION   LEDC_TIMER_8_BIT  // 8-bit resolution (0-255)
+#define LCD_BL_FADE_RESOLUTION  LEDC_TIMER_11_BIT // Highest resolution at 25kHz, for gamma corrected fades
 
 #if defined(__cplusplus)
 }
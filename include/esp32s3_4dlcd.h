@@ -14,14 +14,20 @@
 
 #pragma once
 
+#include "freertos/FreeRTOS.h"
 #include "esp_lcd_panel_vendor.h"
 #include "esp_lcd_panel_ops.h"
 #include "esp_lcd_io_spi.h"
+#include "esp_lcd_panel_rgb.h"
 #include "esp_check.h"
 #include "driver/ledc.h"
 
-#if defined(LCD_INTERFACE_RGB)
-#include "4dlcd_rgb.h" // TODO
+// Colour transactions the panel IO can queue, per bus type
+#define LCD_SPI_TRANS_QUEUE_DEPTH   7
+#define LCD_QSPI_TRANS_QUEUE_DEPTH  10
+
+#if defined(CONFIG_LCD_INTERFACE_RGB)
+#include "4dlcd_rgb.h"
 #else // LCD_INTERFACE_QSPI or LCD_INTERFACE_SPI
 #include "4dlcd_spi.h"
 #endif // LCD_INTERFACE
@@ -30,6 +36,13 @@
 extern "C" {
 #endif
 
+// Bytes per pixel of the colour data passed to `esp_lcd_panel_draw_bitmap`
+#if CONFIG_ESP32S3_4DLCD_RGB565_INPUT
+#define LCD_DRAW_BYTES_PER_PIXEL    2
+#else
+#define LCD_DRAW_BYTES_PER_PIXEL    ((LCD_BITS_PER_PIXEL + 7) / 8)
+#endif
+
 /**
  * @brief LCD panel initialization commands.
  *
@@ -41,6 +54,40 @@ typedef struct {
     unsigned int delay_ms;  /*<! Delay in milliseconds after this command */
 } esp32s3_4dlcd_init_cmd_t;
 
+/**
+ * @brief Time spent in each phase of bringing the panel up, in microseconds.
+ *
+ * `reset_us`, `slpout_us` and `init_table_us` are durations. `dispon_us` and `first_frame_us` are measured
+ * from the start of the last reset, or of init if it was not preceded by a reset, in which case `reset_us` is 0.
+ * A value of 0 means the phase has not happened yet.
+ *
+ */
+typedef struct {
+    uint32_t reset_us;          /*!< Hardware or software reset, including its settle delay */
+    uint32_t slpout_us;         /*!< Sleep Out and its wake-up delay */
+    uint32_t init_table_us;     /*!< Vendor specific initialization sequence, including its delays */
+    uint32_t dispon_us;         /*!< Display On sent, from the start of the reset */
+    uint32_t first_frame_us;    /*!< First `esp_lcd_panel_draw_bitmap` after init finished on the bus, from the start of the reset.
+                                     *   Only measured while a present or submission queue tracks transactions, 0 otherwise */
+} esp32s3_4dlcd_boot_timing_t;
+
+/**
+ * @brief 4D Systems ESP32-S3 display models.
+ *
+ */
+typedef enum {
+    ESP32S3_4DLCD_MODEL_KCONFIG = 0,    /*!< Model selected in menuconfig */
+    ESP32S3_4DLCD_MODEL_24,             /*!< gen4-ESP32-24, ILI9341, 240x320 SPI */
+    ESP32S3_4DLCD_MODEL_28,             /*!< gen4-ESP32-28, ILI9341, 240x320 SPI */
+    ESP32S3_4DLCD_MODEL_32,             /*!< gen4-ESP32-32, ILI9341, 240x320 SPI */
+    ESP32S3_4DLCD_MODEL_35,             /*!< gen4-ESP32-35, ILI9488, 320x480 SPI, 18 bits per pixel */
+    ESP32S3_4DLCD_MODEL_43Q,            /*!< gen4-ESP32Q-43, NV3041A, 480x272 QSPI */
+    ESP32S3_4DLCD_MODEL_43,             /*!< gen4-ESP32-43, 480x272 RGB, driven with `esp32s3_4dlcd_rgb_new` */
+    ESP32S3_4DLCD_MODEL_50,             /*!< gen4-ESP32-50, 800x480 RGB, driven with `esp32s3_4dlcd_rgb_new` */
+    ESP32S3_4DLCD_MODEL_70,             /*!< gen4-ESP32-70, 800x480 RGB, driven with `esp32s3_4dlcd_rgb_new` */
+    ESP32S3_4DLCD_MODEL_90,             /*!< ESP32-90, 800x480 RGB, driven with `esp32s3_4dlcd_rgb_new` */
+} esp32s3_4dlcd_model_t;
+
 /**
  * @brief LCD panel vendor configuration.
  *
@@ -50,15 +97,60 @@ typedef struct {
 typedef struct {
     const esp32s3_4dlcd_init_cmd_t *init_cmds;      /*!< Pointer to initialization commands array. Set to NULL if using default commands.
                                                          *   The array should be declared as `static const` and positioned outside the function.
-                                                         *   Please refer to `vendor_specific_init_default` in source file.
+                                                         *   Please refer to the `init_seq_*` tables in source file.
                                                          */
     uint16_t init_cmds_size;                            /*<! Number of commands in above array */
+    esp32s3_4dlcd_model_t model;                        /*!< Panel model, decides the default init sequence, command framing and timings */
+    size_t max_transfer_sz;                             /*!< `max_transfer_sz` the SPI bus was created with. Colour data is split into
+                                                         *   transfers of at most this size. 0 for the model default: no limit on SPI,
+                                                         *   the 4092 bytes of a bus created with 0 on QSPI
+                                                         */
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done; /*!< The callback the panel IO was created with, or NULL.
+                                                         *   The present and submission queues replace the panel IO callback with
+                                                         *   the driver's own while they run; it chains this one, and puts it back
+                                                         *   after the last of them is deleted
+                                                         */
+    void *user_ctx;                                     /*!< Context the panel IO callback was created with */
 } esp32s3_4dlcd_vendor_config_t;
 
+/**
+ * @brief Panel device configuration for the model selected in menuconfig
+ *
+ * @param[in] vendor_cfg Pointer to an `esp32s3_4dlcd_vendor_config_t`, or NULL
+ *
+ */
+#define ESP32S3_4DLCD_PANEL_DEV_CONFIG(vendor_cfg)              \
+    {                                                           \
+        .reset_gpio_num = LCD_RST_GPIO_NUM,                     \
+        .rgb_ele_order = LCD_COLOR_ORDER,                       \
+        .bits_per_pixel = LCD_BITS_PER_PIXEL,                   \
+        .flags.reset_active_high = LCD_RST_ACTIVE_HIGH,         \
+        .vendor_config = (vendor_cfg),                          \
+    }
+
+/**
+ * @brief Create LCD panel for a 4D Systems ESP32-S3 display
+ *
+ * @note  Several panels can be created, each on its own panel IO. The model is taken from the vendor configuration,
+ *        or from menuconfig when `vendor_config` is NULL.
+ *
+ * @param[in] io LCD panel IO handle
+ * @param[in] panel_dev_config General panel device configuration, `bits_per_pixel` may be 0 for the model default
+ * @param[out] ret_panel Returned LCD panel handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NOT_SUPPORTED if the model, colour order or pixel width is not supported
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_new_panel_esp32s3_4dlcd(const esp_lcd_panel_io_handle_t io, const esp_lcd_panel_dev_config_t *panel_dev_config,
+                                         esp_lcd_panel_handle_t *ret_panel);
+
 /**
  * @brief Create LCD panel for 4D Systems ESP32-S3 series of displays
  *
  * @note  Vendor specific initialization can be different between manufacturers, should consult the LCD supplier for initialization sequence code.
+ * @note  Same as `esp_lcd_new_panel_esp32s3_4dlcd` with `ESP32S3_4DLCD_PANEL_DEV_CONFIG(NULL)`.
  *
  * @param[in] io LCD panel IO handle
  * @param[out] ret_panel Returned LCD panel handle
@@ -70,70 +162,1686 @@ typedef struct {
 esp_err_t esp_lcd_new_esp32s3_4dlcd(const esp_lcd_panel_io_handle_t io, esp_lcd_panel_handle_t *ret_panel);
 
 /**
- * @brief LCD panel bus configuration structure
+ * @brief Get the time spent in each phase of the last panel bring-up
  *
- * @param[in] max_trans_sz Maximum transfer size in bytes
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[out] timing Returned phase timing
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_get_boot_timing(esp_lcd_panel_handle_t panel, esp32s3_4dlcd_boot_timing_t *timing);
+
+/**
+ * @brief Open an address window for streaming pixel data in several chunks
+ *
+ * @note  CASET/RASET are only sent if the window differs from the last one sent to the controller.
+ *        Coordinates follow `esp_lcd_panel_draw_bitmap`: end positions are exclusive and the panel gap is applied.
  *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] x_start Start column of the window
+ * @param[in] y_start Start row of the window
+ * @param[in] x_end End column of the window (exclusive)
+ * @param[in] y_end End row of the window (exclusive)
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
  */
-#if defined(CONFIG_LCD_INTERFACE_SPI)
-#define ESP32S3_4DLCD_BUS_SPI_CONFIG(max_trans_sz)              \
-    {                                                           \
-        .sclk_io_num = LCD_SPI_SCLK_GPIO_NUM,                   \
-        .mosi_io_num = LCD_SPI_MOSI_GPIO_NUM,                   \
-        .miso_io_num = LCD_SPI_MISO_GPIO_NUM,                   \
-        .quadhd_io_num = -1,                                    \
-        .quadwp_io_num = -1,                                    \
-        .max_transfer_sz = max_trans_sz,                        \
-    }
-#elif defined(CONFIG_LCD_INTERFACE_QSPI)
-#define ESP32S3_4DLCD_BUS_SPI_CONFIG(max_trans_sz)              \
-    {                                                           \
-        .sclk_io_num = LCD_SPI_SCLK_GPIO_NUM,                   \
-        .data0_io_num = LCD_QSPI_DAT0_GPIO_NUM,                 \
-        .data1_io_num = LCD_QSPI_DAT1_GPIO_NUM,                 \
-        .data2_io_num = LCD_QSPI_DAT2_GPIO_NUM,                 \
-        .data3_io_num = LCD_QSPI_DAT3_GPIO_NUM,                 \
-        .max_transfer_sz = max_trans_sz,                        \
-    }
-#else // CONFIG_ LCD_INTERFACE_RGB
-// TODO
-#endif // CONFIG_LCD_INTERFACE
+esp_err_t esp32s3_4dlcd_window_begin(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end);
 
 /**
- * @brief LCD panel IO configuration structure
+ * @brief Send the next chunk of pixel data into the window opened by `esp32s3_4dlcd_window_begin`
  *
- * @param[in] cb Callback function when SPI transfer is done
- * @param[in] cb_ctx Callback function context
+ * @note  The first chunk is sent with RAMWR, the following ones with RAMWRC (Memory Write Continue),
+ *        so the address window is never set again. `color_data` has the same lifetime rules as in `esp_lcd_panel_draw_bitmap`.
  *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] color_data Pixel data, in the panel format
+ * @param[in] len Size of `color_data` in bytes, a whole number of pixels
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_INVALID_SIZE  if `len` overruns the window or splits a pixel
+ *          - ESP_OK                on success
  */
-#if defined(CONFIG_LCD_INTERFACE_SPI)
-#define ESP32S3_4DLCD_IO_SPI_CONFIG(callback, callback_ctx)     \
-    {                                                           \
-        .cs_gpio_num = LCD_SPI_CS_GPIO_NUM,                     \
-        .dc_gpio_num = LCD_SPI_DC_GPIO_NUM,                     \
-        .spi_mode = 0,                                          \
-        .pclk_hz = LCD_SPI_PCLK_MHZ * 1000 * 1000,              \
-        .trans_queue_depth = 7,                                 \
-        .on_color_trans_done = callback,                        \
-        .user_ctx = callback_ctx,                               \
-        .lcd_cmd_bits = 8,                                      \
-        .lcd_param_bits = 8,                                    \
-    }
-#else // CONFIG_LCD_INTERFACE_QSPI
-#define ESP32S3_4DLCD_IO_SPI_CONFIG(callback, callback_ctx)     \
-    {                                                           \
-        .cs_gpio_num = LCD_SPI_CS_GPIO_NUM,                     \
-        .dc_gpio_num = LCD_SPI_DC_GPIO_NUM,                     \
-        .spi_mode = 0,                                          \
-        .pclk_hz = LCD_SPI_PCLK_MHZ * 1000 * 1000,              \
-        .trans_queue_depth = 10,                                \
-        .on_color_trans_done = callback,                        \
-        .user_ctx = callback_ctx,                               \
-        .lcd_cmd_bits = 32,                                     \
-        .lcd_param_bits = 8,                                    \
-        .flags.quad_mode = true                                 \
-    }
-#endif // CONFIG_LCD_INTERFACE
+esp_err_t esp32s3_4dlcd_window_push(esp_lcd_panel_handle_t panel, const void *color_data, size_t len);
+
+/**
+ * @brief Close the window opened by `esp32s3_4dlcd_window_begin`
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_window_end(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Draw an area whose rows are not contiguous in memory, e.g. a rectangle inside a larger frame buffer
+ *
+ * @note  Rows are gathered into the driver chunk buffers, so `color_data` may be reused as soon as this returns.
+ *        This holds even when `stride` equals the row size, unlike `esp_lcd_panel_draw_bitmap`.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] x_start Start column
+ * @param[in] y_start Start row
+ * @param[in] x_end End column (exclusive)
+ * @param[in] y_end End row (exclusive)
+ * @param[in] color_data First pixel of the area, in the format accepted by `esp_lcd_panel_draw_bitmap`
+ * @param[in] stride Distance between the start of two rows, in bytes
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NO_MEM        if the chunk buffers cannot be allocated
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_draw_bitmap_stride(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                          const void *color_data, size_t stride);
+
+/**
+ * @brief Panel state kept across sleep, small enough for RTC memory (`RTC_DATA_ATTR`) to survive deep sleep.
+ *
+ */
+typedef struct {
+    uint32_t magic;             /*!< Set by `esp32s3_4dlcd_sleep`, anything else makes `esp32s3_4dlcd_resume` run a full init */
+    uint8_t madctl_val;         /*!< LCD_CMD_MADCTL register */
+    uint8_t colmod_val;         /*!< LCD_CMD_COLMOD register */
+    bool inverted;              /*!< Colour inversion on */
+    bool display_on;            /*!< Display on */
+    int x_gap;                  /*!< Gap set with `esp_lcd_panel_set_gap` */
+    int y_gap;
+    int scroll_top;             /*!< Scroll area, see `esp32s3_4dlcd_scroll_set_area` */
+    int scroll_height;
+    int scroll_offset;
+    int partial_y_start;        /*!< Partial area, see `esp32s3_4dlcd_set_partial_area`, equal rows in normal mode */
+    int partial_y_end;
+    bool idle;                  /*!< Idle (8-colour) mode on */
+} esp32s3_4dlcd_sleep_state_t;
+
+/**
+ * @brief Put the panel into sleep mode, keeping its registers and frame memory
+ *
+ * @note  The reset line is held with `gpio_hold_en` so it stays released through light sleep; for deep sleep the
+ *        application also calls `gpio_deep_sleep_hold_en`. The backlight is left to the application.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[out] state Returned panel state, for resuming from a new driver instance after deep sleep. May be NULL.
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_sleep(esp_lcd_panel_handle_t panel, esp32s3_4dlcd_sleep_state_t *state);
+
+/**
+ * @brief Wake the panel with SLPOUT only, falling back to reset and full init when its state cannot be trusted
+ *
+ * @note  After deep sleep, create the panel as usual but call this instead of `esp_lcd_panel_reset` and
+ *        `esp_lcd_panel_init`, passing the state saved by `esp32s3_4dlcd_sleep`. If `*full_init` is returned true the
+ *        frame memory was lost and the screen has to be redrawn.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] state State saved by `esp32s3_4dlcd_sleep`, or NULL to resume from this driver instance's own state
+ * @param[in] verify Read MADCTL and COLMOD back and run a full init if they do not match
+ * @param[out] full_init Returned true if a full init was done. May be NULL.
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_resume(esp_lcd_panel_handle_t panel, const esp32s3_4dlcd_sleep_state_t *state, bool verify, bool *full_init);
+
+/**
+ * @brief Software rotation, clockwise.
+ *
+ */
+typedef enum {
+    ESP32S3_4DLCD_ROTATE_0 = 0,     /*!< No rotation */
+    ESP32S3_4DLCD_ROTATE_90,        /*!< 90 degrees, the drawing frame is as wide as the panel is tall */
+    ESP32S3_4DLCD_ROTATE_180,       /*!< 180 degrees */
+    ESP32S3_4DLCD_ROTATE_270,       /*!< 270 degrees, the drawing frame is as wide as the panel is tall */
+} esp32s3_4dlcd_rotation_t;
+
+/**
+ * @brief Rotate what `esp_lcd_panel_draw_bitmap` and `esp32s3_4dlcd_draw_bitmap_stride` draw, in software
+ *
+ * @note  For controllers that cannot rotate through MADCTL, or whose init table fixes it. Coordinates passed to the
+ *        draw calls are in the rotated frame and are mapped to the panel before the gap is applied; the gap stays in
+ *        panel coordinates. Pixels are rotated chunk by chunk into the driver chunk buffers, so no extra frame
+ *        buffer is needed, but a panel row must fit in `CONFIG_ESP32S3_4DLCD_CHUNK_BUF_SIZE`. Rotation is applied
+ *        on top of `esp_lcd_panel_swap_xy`/`esp_lcd_panel_mirror`. Other drawing calls are not rotated.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] rotation Rotation applied to every draw from now on
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_set_sw_rotation(esp_lcd_panel_handle_t panel, esp32s3_4dlcd_rotation_t rotation);
+
+/**
+ * @brief Enter partial mode, showing only a band of rows and leaving the rest of the panel blank
+ *
+ * @note  Rows are in `esp_lcd_panel_draw_bitmap` coordinates and follow mirroring and the gap. While the axes are
+ *        swapped the band cannot be expressed and the whole panel is shown, until they are swapped back.
+ *        Drawing is not restricted, rows outside the band are written to frame memory but not shown.
+ *        Supported on the ILI9341/ILI9488 models, the area is forgotten on panel reset.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] y_start First row shown
+ * @param[in] y_end Row after the last one shown
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid or the band, gap applied, runs past the panel
+ *          - ESP_ERR_NOT_SUPPORTED if the controller has no partial mode
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_set_partial_area(esp_lcd_panel_handle_t panel, int y_start, int y_end);
+
+/**
+ * @brief Leave partial mode and show the whole panel again
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_set_normal_mode(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Enter or leave idle mode, where the panel shows 8 colours from the top bit of each component
+ *
+ * @note  Frame memory and the pixel format are unchanged, colour data is still drawn in the full format and
+ *        reappears in full once idle mode is left. Supported on the ILI9341/ILI9488 models.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] idle True to enter idle mode
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NOT_SUPPORTED if the controller has no idle mode
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_set_idle_mode(esp_lcd_panel_handle_t panel, bool idle);
+
+/**
+ * @brief Turn the tearing effect output on (pulsing during vertical blanking) or off
+ *
+ * @note  `esp32s3_4dlcd_te_new` turns it on, only needed to drive the TE line some other way.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] on True to send TEON, false to send TEOFF
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_set_tearing_effect(esp_lcd_panel_handle_t panel, bool on);
+
+/**
+ * @brief Tell the driver the largest colour transfer the SPI bus accepts
+ *
+ * @note  Pass the `max_transfer_sz` given to `ESP32S3_4DLCD_BUS_SPI_CONFIG`. Draws and driver chunks are then split
+ *        into transfers of at most that size, continuing the same memory write. Same as the `max_transfer_sz` field of
+ *        `esp32s3_4dlcd_vendor_config_t`. On QSPI each transfer carries its own command, so larger ones cost fewer commands.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] max_transfer_sz Size in bytes, rounded down to whole pixels, or 0 for no limit
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_set_max_transfer(esp_lcd_panel_handle_t panel, size_t max_transfer_sz);
+
+/**
+ * @brief Throughput of draws bounced out of PSRAM.
+ *
+ */
+typedef struct {
+    uint64_t bytes;             /*!< Colour data copied out of PSRAM */
+    uint64_t busy_us;           /*!< Time spent in those draws, until their last chunk was queued */
+    uint32_t bytes_per_sec;     /*!< bytes / busy_us */
+} esp32s3_4dlcd_bounce_stats_t;
+
+/**
+ * @brief Get the throughput of draws whose colour data was bounced out of PSRAM
+ *
+ * @note  Only counted with `CONFIG_ESP32S3_4DLCD_PSRAM_BOUNCE`.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[out] stats Returned statistics
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_get_bounce_stats(esp_lcd_panel_handle_t panel, esp32s3_4dlcd_bounce_stats_t *stats);
+
+/**
+ * @brief Reset the PSRAM bounce statistics
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_reset_bounce_stats(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Fill a rectangle with one colour
+ *
+ * @note  A single driver chunk buffer is filled with the colour and sent repeatedly, so no buffer the size of the
+ *        rectangle is needed.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] x_start Start column
+ * @param[in] y_start Start row
+ * @param[in] x_end End column (exclusive)
+ * @param[in] y_end End row (exclusive)
+ * @param[in] color RGB565 colour in CPU byte order, converted to the panel format
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NO_MEM        if the chunk buffers cannot be allocated
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_fill_rect(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end, uint16_t color);
+
+/**
+ * @brief Fill a rectangle by repeating a small tile, anchored at the top left corner of the rectangle
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] x_start Start column
+ * @param[in] y_start Start row
+ * @param[in] x_end End column (exclusive)
+ * @param[in] y_end End row (exclusive)
+ * @param[in] tile RGB565 pixels in CPU byte order, `tile_width * tile_height` of them, row after row
+ * @param[in] tile_width Tile width in pixels
+ * @param[in] tile_height Tile height in pixels
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NO_MEM        if the chunk buffers cannot be allocated
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_fill_pattern(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                     const uint16_t *tile, int tile_width, int tile_height);
+
+/**
+ * @brief Fill rows of pixel data for `esp32s3_4dlcd_draw_lines`
+ *
+ * @param[in] y First row to produce
+ * @param[in] lines Number of rows to produce
+ * @param[out] dst Buffer for `lines` rows of the window, back to back, in the format accepted by `esp32s3_4dlcd_window_push`
+ * @param[in] user_ctx User context given to `esp32s3_4dlcd_draw_lines`
+ * @return ESP_OK to carry on, anything else stops the draw and is returned by `esp32s3_4dlcd_draw_lines`
+ */
+typedef esp_err_t (*esp32s3_4dlcd_line_producer_t)(int y, int lines, void *dst, void *user_ctx);
+
+/**
+ * @brief Draw a window whose pixels are pulled from a callback, a few rows at a time
+ *
+ * @note  Rows are produced straight into the driver chunk buffers and sent under a single memory write, each chunk
+ *        going out while the next one is produced. No buffer the size of the window is needed, but a row must fit
+ *        in `CONFIG_ESP32S3_4DLCD_CHUNK_BUF_SIZE`; larger buffers mean more rows per call.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] x_start Start column
+ * @param[in] y_start Start row
+ * @param[in] x_end End column (exclusive)
+ * @param[in] y_end End row (exclusive)
+ * @param[in] producer Called in row order until the window is complete
+ * @param[in] user_ctx User context passed to the producer
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_INVALID_SIZE  if a row does not fit a chunk buffer
+ *          - ESP_ERR_NO_MEM        if the chunk buffers cannot be allocated
+ *          - the producer's error, if it failed
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_draw_lines(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                   esp32s3_4dlcd_line_producer_t producer, void *user_ctx);
+
+/**
+ * @brief Most layers `esp32s3_4dlcd_compose` blends in one call
+ *
+ */
+#define ESP32S3_4DLCD_COMPOSE_MAX_LAYERS    8
+
+/**
+ * @brief Pixel format of a compositor layer, all in CPU byte order
+ *
+ */
+typedef enum {
+    ESP32S3_4DLCD_LAYER_RGB565,         /*!< Opaque RGB565, e.g. a camera or background frame */
+    ESP32S3_4DLCD_LAYER_ARGB8888,       /*!< 32-bit 0xAARRGGBB */
+    ESP32S3_4DLCD_LAYER_ARGB4444,       /*!< 16-bit 0xARGB */
+} esp32s3_4dlcd_layer_format_t;
+
+/**
+ * @brief Compositor layer, placed in panel coordinates.
+ *
+ */
+typedef struct {
+    esp32s3_4dlcd_layer_format_t format;    /*!< Pixel format of `data` */
+    const void *data;                       /*!< Top left pixel of the layer */
+    size_t stride;                          /*!< Distance between the start of two rows, in bytes */
+    int x;                                  /*!< Panel column of the layer's left edge */
+    int y;                                  /*!< Panel row of the layer's top edge */
+    int width;                              /*!< Width of the layer in pixels */
+    int height;                             /*!< Height of the layer in pixels */
+    uint8_t opacity;                        /*!< Layer opacity, 255 for opaque, multiplied with the per-pixel alpha */
+} esp32s3_4dlcd_layer_t;
+
+/**
+ * @brief Blend layers and draw the result, without an intermediate frame buffer
+ *
+ * @note  Layers are blended bottom to top, one row at a time, straight into the driver chunk buffers on their way to the
+ *        panel (see `esp32s3_4dlcd_draw_lines`), and converted to the panel format on the fly. Parts of the window
+ *        no layer covers are black. The layer data may live in PSRAM; only a row of the window is allocated.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] x_start Start column
+ * @param[in] y_start Start row
+ * @param[in] x_end End column (exclusive)
+ * @param[in] y_end End row (exclusive)
+ * @param[in] layers Layers, bottom first
+ * @param[in] layer_count Number of layers, at most `ESP32S3_4DLCD_COMPOSE_MAX_LAYERS`
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_INVALID_SIZE  if a row does not fit a chunk buffer
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_compose(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                const esp32s3_4dlcd_layer_t *layers, int layer_count);
+
+/**
+ * @brief Glyph of a bitmap font
+ *
+ */
+typedef struct {
+    uint32_t offset;        /*!< Offset of the glyph's first row in the font bitmap, in bytes */
+    uint8_t width;          /*!< Width of the glyph bitmap in pixels, may be 0 for blanks */
+    uint8_t advance;        /*!< Columns the pen moves on by, at least `width`, the rest is background */
+} esp32s3_4dlcd_glyph_t;
+
+/**
+ * @brief Bitmap font for `esp32s3_4dlcd_text_new`
+ *
+ * @note  Every glyph is `height` rows of alpha, `bpp` bits per pixel with the leftmost pixel in the most significant
+ *        bits, and every row starts on a byte boundary. Glyphs are drawn at the pen position with no offsets: bake
+ *        bearings and baseline into the bitmaps.
+ *
+ */
+typedef struct {
+    uint8_t bpp;                                /*!< Bits of alpha per pixel: 1, 2 or 4 */
+    uint8_t height;                             /*!< Rows of every glyph, the height of a line of text */
+    uint16_t first;                             /*!< Character code of the first glyph */
+    uint16_t count;                             /*!< Number of glyphs */
+    uint16_t fallback;                          /*!< Index of the glyph drawn for characters the font has not got */
+    const esp32s3_4dlcd_glyph_t *glyphs;        /*!< `count` glyphs, for character codes `first` onwards */
+    const uint8_t *bitmap;                      /*!< Glyph rows */
+    size_t bitmap_size;                         /*!< Size of `bitmap` in bytes */
+} esp32s3_4dlcd_font_t;
+
+/**
+ * @brief Type of text renderer handle
+ *
+ */
+typedef struct esp32s3_4dlcd_text_t *esp32s3_4dlcd_text_handle_t;
+
+/**
+ * @brief Create a text renderer for a font
+ *
+ * @note  The glyphs are copied to an atlas in internal RAM, so the font may live in flash or PSRAM. Next to it the
+ *        renderer keeps a colour table that expands a byte of alpha to panel pixels in one copy, rebuilt whenever
+ *        the colours change: 4KB for a 1-bit font, half that for 2-bit and a quarter for 4-bit, times 1.5 in 18-bit
+ *        colour.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] font Font to draw with
+ * @param[out] ret_text Returned text renderer handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_text_new(esp_lcd_panel_handle_t panel, const esp32s3_4dlcd_font_t *font, esp32s3_4dlcd_text_handle_t *ret_text);
+
+/**
+ * @brief Delete a text renderer
+ *
+ * @param[in] text Text renderer handle returned by `esp32s3_4dlcd_text_new`
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_text_del(esp32s3_4dlcd_text_handle_t text);
+
+/**
+ * @brief Width of a string in pixels, the sum of the glyph advances
+ *
+ * @param[in] text Text renderer handle returned by `esp32s3_4dlcd_text_new`
+ * @param[in] str NUL terminated string, one byte per character
+ * @return Width in pixels, 0 if the arguments are invalid
+ */
+int esp32s3_4dlcd_text_width(esp32s3_4dlcd_text_handle_t text, const char *str);
+
+/**
+ * @brief Draw a line of text
+ *
+ * @note  The whole string is sent as a single window of `width` x font height, rendered a row at a time straight into
+ *        the driver chunk buffers (see `esp32s3_4dlcd_draw_lines`), rather than a window per glyph. Alpha is blended
+ *        between `bg` and `fg` in the table lookup, so antialiased fonts cost no more than 1-bit ones. Text running
+ *        off the right or bottom of the panel is clipped. Like `esp32s3_4dlcd_draw_lines`, text is not rotated by
+ *        `esp32s3_4dlcd_set_sw_rotation`: coordinates are in the frame set by MADCTL alone.
+ *
+ * @param[in] text Text renderer handle returned by `esp32s3_4dlcd_text_new`
+ * @param[in] x Panel column of the left edge of the text
+ * @param[in] y Panel row of the top edge of the text
+ * @param[in] str NUL terminated string, one byte per character
+ * @param[in] fg Text colour, RGB565 in CPU byte order
+ * @param[in] bg Background colour, RGB565 in CPU byte order
+ * @param[out] width Columns drawn, the pen advance for the next string, may be NULL
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_INVALID_SIZE  if a row of text does not fit a chunk buffer
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_text_draw(esp32s3_4dlcd_text_handle_t text, int x, int y, const char *str, uint16_t fg, uint16_t bg,
+                                  int *width);
+
+/**
+ * @brief Get the size of a compressed image
+ *
+ * @param[in] image Image made by `tools/4dlcd_image.py`, e.g. embedded in flash with `target_add_binary_data`
+ * @param[in] size Size of the image in bytes
+ * @param[out] width Width of the image in pixels
+ * @param[out] height Height of the image in pixels
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid or the image header is not recognised
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_image_info(const void *image, size_t size, int *width, int *height);
+
+/**
+ * @brief Draw a compressed image
+ *
+ * @note  The image is decompressed a row at a time straight into the driver chunk buffers, each filled while the one
+ *        before it is on the wire (see `esp32s3_4dlcd_draw_lines`), and converted to the panel format on the way. It
+ *        is read in place, so an image in flash is never copied to RAM: only a row of the image is allocated.
+ *        The image is encoded as runs of pixels unchanged from the row above, runs of one colour and literal pixels,
+ *        with colours as indices into a palette of up to 256 when the image has that few. See `tools/4dlcd_image.py`.
+ *        Like `esp32s3_4dlcd_draw_lines`, the image is not rotated by `esp32s3_4dlcd_set_sw_rotation`: coordinates
+ *        are in the frame set by MADCTL alone.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] x Panel column of the left edge of the image
+ * @param[in] y Panel row of the top edge of the image
+ * @param[in] image Image made by `tools/4dlcd_image.py`
+ * @param[in] size Size of the image in bytes
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid or the image does not fit the panel
+ *          - ESP_FAIL              if the image data is corrupt, after drawing the rows before it
+ *          - ESP_ERR_INVALID_SIZE  if a row does not fit a chunk buffer
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_draw_image(esp_lcd_panel_handle_t panel, int x, int y, const void *image, size_t size);
+
+/**
+ * @brief Define the vertical scroll area
+ *
+ * @note  Rows outside the area stay fixed. On controllers that scroll in hardware (ILI9341/ILI9488, with the axes not
+ *        swapped) scrolling costs two commands; elsewhere the driver falls back to redrawing the area with
+ *        `esp32s3_4dlcd_scroll_sync`. The area is forgotten on panel reset.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] top First row of the area
+ * @param[in] height Rows in the area, 0 to stop scrolling
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_scroll_set_area(esp_lcd_panel_handle_t panel, int top, int height);
+
+/**
+ * @brief Scroll the area so that its row `offset` is shown at the top of the area, rows wrap around at the bottom
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] offset Area row shown first, taken modulo the area height
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_INVALID_STATE if no scroll area is defined
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_scroll_set_offset(esp_lcd_panel_handle_t panel, int offset);
+
+/**
+ * @brief Check whether the controller scrolls the current area itself
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @return true if scrolling is done in hardware, false if `esp32s3_4dlcd_scroll_sync` has to redraw the area
+ */
+bool esp32s3_4dlcd_scroll_is_hw(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Map a row on screen to the row of the scroll area contents that is shown there
+ *
+ * @note  Rows outside the scroll area map to themselves. Use it to find where a newly exposed line belongs in
+ *        the buffer passed to `esp32s3_4dlcd_scroll_sync`.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] y Row on screen
+ * @return Row of the contents, between `top` and `top + height - 1` for rows inside the area
+ */
+int esp32s3_4dlcd_scroll_map_row(esp_lcd_panel_handle_t panel, int y);
+
+/**
+ * @brief Draw an area given in screen rows, taking the scroll offset into account
+ *
+ * @note  With hardware scrolling, only the rows drawn are sent, split where the area wraps around.
+ *        Otherwise this is `esp_lcd_panel_draw_bitmap`.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] x_start Start column
+ * @param[in] y_start Start row on screen
+ * @param[in] x_end End column (exclusive)
+ * @param[in] y_end End row on screen (exclusive)
+ * @param[in] color_data Pixels, in the format accepted by `esp_lcd_panel_draw_bitmap`
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_scroll_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                          const void *color_data);
+
+/**
+ * @brief Software fallback: redraw the scroll area rotated by the current offset
+ *
+ * @note  `area_data` holds the area contents unrotated, row `esp32s3_4dlcd_scroll_map_row(y) - top` for screen row `y`,
+ *        as the controller frame memory would. Does nothing when the controller scrolls in hardware.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] x_start Start column
+ * @param[in] x_end End column (exclusive)
+ * @param[in] area_data First row of the area contents
+ * @param[in] stride Distance between the start of two rows, in bytes
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_INVALID_STATE if no scroll area is defined
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_scroll_sync(esp_lcd_panel_handle_t panel, int x_start, int x_end, const void *area_data, size_t stride);
+
+/**
+ * @brief Present queue handle
+ *
+ */
+typedef struct esp32s3_4dlcd_present_t *esp32s3_4dlcd_present_handle_t;
+
+/**
+ * @brief Present queue configuration.
+ *
+ */
+typedef struct {
+    void *const *buffers;                                   /*!< Frame buffers or strips presented through the queue, owned by the caller */
+    size_t num_buffers;                                     /*!< Number of entries in `buffers` */
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done; /*!< Optional callback chained after the queue's own completion handling.
+                                                             *   The queue takes over the panel IO callback, so pass here what was given to `ESP32S3_4DLCD_IO_SPI_CONFIG`.
+                                                             */
+    void *user_ctx;                                         /*!< Context passed to `on_color_trans_done` */
+} esp32s3_4dlcd_present_config_t;
+
+/**
+ * @brief Create a present queue that tracks when each registered buffer may be reused
+ *
+ * @note  Buffers are handed out round-robin by `esp32s3_4dlcd_present_acquire`. A buffer is released when the
+ *        last colour transaction reading it completes, so rendering into the next buffer overlaps the transfer.
+ *        The queue is meant to be driven from a single task.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] config Present queue configuration
+ * @param[out] ret_present Returned present queue handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_present_new(esp_lcd_panel_handle_t panel, const esp32s3_4dlcd_present_config_t *config,
+                                    esp32s3_4dlcd_present_handle_t *ret_present);
+
+/**
+ * @brief Wait for all buffers to be released and delete the present queue
+ *
+ * @param[in] present Present queue handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_present_del(esp32s3_4dlcd_present_handle_t present);
+
+/**
+ * @brief Get the next buffer to render into, waiting until its previous transfer has completed
+ *
+ * @param[in] present Present queue handle
+ * @param[in] timeout Maximum time to wait for the buffer, in ticks
+ * @param[out] index Returned buffer index, to pass to `esp32s3_4dlcd_present_submit`
+ * @param[out] buf Returned buffer pointer, may be NULL
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_TIMEOUT       if the buffer is still being transferred
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_present_acquire(esp32s3_4dlcd_present_handle_t present, TickType_t timeout, int *index, void **buf);
+
+/**
+ * @brief Queue a buffer for transfer to the given area of the panel
+ *
+ * @note  Returns as soon as the transfer is queued. Errors from the panel IO are returned here; the buffer is then
+ *        still released only once whatever part of it was queued has left the bus.
+ *
+ * @param[in] present Present queue handle
+ * @param[in] index Buffer index returned by `esp32s3_4dlcd_present_acquire`
+ * @param[in] x_start Start column
+ * @param[in] y_start Start row
+ * @param[in] x_end End column (exclusive)
+ * @param[in] y_end End row (exclusive)
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ *          - Error returned by the panel IO otherwise
+ */
+esp_err_t esp32s3_4dlcd_present_submit(esp32s3_4dlcd_present_handle_t present, int index, int x_start, int y_start, int x_end, int y_end);
+
+/**
+ * @brief Wait until a buffer is no longer read by the panel IO
+ *
+ * @param[in] present Present queue handle
+ * @param[in] index Buffer index
+ * @param[in] timeout Maximum time to wait, in ticks
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_TIMEOUT       if the buffer is still being transferred
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_present_wait(esp32s3_4dlcd_present_handle_t present, int index, TickType_t timeout);
+
+/**
+ * @brief Wait until every buffer of the queue has been released
+ *
+ * @param[in] present Present queue handle
+ * @param[in] timeout Maximum time to wait for each buffer, in ticks
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_TIMEOUT       if a buffer is still being transferred
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_present_flush(esp32s3_4dlcd_present_handle_t present, TickType_t timeout);
+
+/**
+ * @brief TE synchronised presenter handle
+ *
+ */
+typedef struct esp32s3_4dlcd_te_t *esp32s3_4dlcd_te_handle_t;
+
+/**
+ * @brief When a draw starts relative to the TE pulse.
+ *
+ */
+typedef enum {
+    ESP32S3_4DLCD_TE_VBLANK,    /*!< Start every draw right after the pulse, tear free as long as a frame is written within two scans */
+    ESP32S3_4DLCD_TE_CHASE,     /*!< Delay each draw so that its rows are written wholly before or wholly after the scan reads them */
+} esp32s3_4dlcd_te_mode_t;
+
+/**
+ * @brief TE synchronised presenter configuration.
+ *
+ * @note  The bus parameters feed the model of how long a window takes to write, used to place it against the scan.
+ *
+ */
+typedef struct {
+    int gpio_num;                   /*!< GPIO wired to the panel TE output */
+    esp32s3_4dlcd_te_mode_t mode;   /*!< When draws start */
+    uint32_t target_fps;            /*!< Frames per second to pace presents to, rounded to a whole number of panel refreshes, 0 to present at every refresh */
+    uint32_t pclk_hz;               /*!< Bus clock */
+    uint8_t bus_width;              /*!< Data lines carrying pixel data, 1 for SPI and 4 for QSPI */
+    uint32_t margin_us;             /*!< Kept between the scan and the write to absorb command overhead and clock tolerance */
+} esp32s3_4dlcd_te_config_t;
+
+#define ESP32S3_4DLCD_TE_DEFAULT_CONFIG(te_gpio)                \
+    {                                                           \
+        .gpio_num = (te_gpio),                                  \
+        .mode = ESP32S3_4DLCD_TE_CHASE,                         \
+        .target_fps = 0,                                        \
+        .pclk_hz = LCD_SPI_PCLK_MHZ * 1000 * 1000,              \
+        .bus_width = LCD_BUS_WIDTH,                             \
+        .margin_us = 500,                                       \
+    }
+
+/**
+ * @brief TE synchronised presenter statistics.
+ *
+ */
+typedef struct {
+    uint32_t pulses;            /*!< TE pulses seen */
+    uint32_t frames;            /*!< Frames presented */
+    uint32_t dropped;           /*!< Paced refreshes that passed without a frame because the present came late */
+    uint32_t unsynced;          /*!< Frames whose window could not be placed clear of the scan, drawn right after the pulse */
+    uint32_t period_us;         /*!< Measured refresh period, 0 until two pulses were seen */
+} esp32s3_4dlcd_te_stats_t;
+
+/**
+ * @brief Turn the panel TE output on and start timing its pulses
+ *
+ * @note  Installs the GPIO ISR service if nobody has. Chasing the scan needs the rows of `esp_lcd_panel_draw_bitmap`
+ *        to run along the native rows; with swapped axes or software rotation, draws start right after the pulse.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] config TE configuration
+ * @param[out] ret_te Returned TE presenter handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_te_new(esp_lcd_panel_handle_t panel, const esp32s3_4dlcd_te_config_t *config, esp32s3_4dlcd_te_handle_t *ret_te);
+
+/**
+ * @brief Turn the panel TE output off and delete the presenter
+ *
+ * @param[in] te TE presenter handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_te_del(esp32s3_4dlcd_te_handle_t te);
+
+/**
+ * @brief Draw a bitmap in step with the panel refresh
+ *
+ * @note  Waits for the next TE pulse, or the next paced one with `target_fps`, then for the start time of the
+ *        configured mode, and calls `esp_lcd_panel_draw_bitmap`. Presents must come from one task.
+ *
+ * @param[in] te TE presenter handle
+ * @param[in] x_start Start column index of the bitmap
+ * @param[in] y_start Start row index of the bitmap
+ * @param[in] x_end End column index of the bitmap, exclusive
+ * @param[in] y_end End row index of the bitmap, exclusive
+ * @param[in] color_data Bitmap data, as for `esp_lcd_panel_draw_bitmap`
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_TIMEOUT       if no TE pulse came in time
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_te_present(esp32s3_4dlcd_te_handle_t te, int x_start, int y_start, int x_end, int y_end, const void *color_data);
+
+/**
+ * @brief Get the TE presenter statistics
+ *
+ * @param[in] te TE presenter handle
+ * @param[out] stats Statistics
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_te_get_stats(esp32s3_4dlcd_te_handle_t te, esp32s3_4dlcd_te_stats_t *stats);
+
+/**
+ * @brief Rectangle on the panel, end positions are exclusive.
+ *
+ */
+typedef struct {
+    int x_start;    /*!< Start column */
+    int y_start;    /*!< Start row */
+    int x_end;      /*!< End column (exclusive) */
+    int y_end;      /*!< End row (exclusive) */
+} esp32s3_4dlcd_rect_t;
+
+/**
+ * @brief Submission queue handle
+ *
+ */
+typedef struct esp32s3_4dlcd_submit_t *esp32s3_4dlcd_submit_handle_t;
+
+#define ESP32S3_4DLCD_SUBMIT_MAX_PRODUCERS  4   /*!< Producers with their own latency statistics */
+
+/**
+ * @brief Panel operation carried by a submitted command.
+ *
+ */
+typedef enum {
+    ESP32S3_4DLCD_SUBMIT_DRAW,          /*!< `esp_lcd_panel_draw_bitmap` */
+    ESP32S3_4DLCD_SUBMIT_FILL,          /*!< `esp32s3_4dlcd_fill_rect` */
+    ESP32S3_4DLCD_SUBMIT_MIRROR,        /*!< `esp_lcd_panel_mirror` */
+    ESP32S3_4DLCD_SUBMIT_SWAP_XY,       /*!< `esp_lcd_panel_swap_xy` */
+    ESP32S3_4DLCD_SUBMIT_INVERT,        /*!< `esp_lcd_panel_invert_color` */
+    ESP32S3_4DLCD_SUBMIT_GAP,           /*!< `esp_lcd_panel_set_gap` */
+    ESP32S3_4DLCD_SUBMIT_DISP_ON_OFF,   /*!< `esp_lcd_panel_disp_on_off` */
+    ESP32S3_4DLCD_SUBMIT_SYNC,          /*!< No operation, completes once every earlier command has completed */
+} esp32s3_4dlcd_submit_op_t;
+
+/**
+ * @brief Called from the flush task once a command has completed; for draws the colour data may then be reused.
+ *
+ * @param[in] result Result of the panel operation
+ * @param[in] user_ctx User context given with the command
+ */
+typedef void (*esp32s3_4dlcd_submit_done_cb_t)(esp_err_t result, void *user_ctx);
+
+/**
+ * @brief Command pushed into the submission queue.
+ *
+ */
+typedef struct {
+    esp32s3_4dlcd_submit_op_t op;   /*!< Operation */
+    uint8_t producer;               /*!< Producer index for the statistics, below `ESP32S3_4DLCD_SUBMIT_MAX_PRODUCERS` */
+    union {
+        struct {
+            int x_start;
+            int y_start;
+            int x_end;
+            int y_end;
+            const void *color_data; /*!< Must stay valid until `done_cb` is called */
+        } draw;                     /*!< ESP32S3_4DLCD_SUBMIT_DRAW */
+        struct {
+            int x_start;
+            int y_start;
+            int x_end;
+            int y_end;
+            uint16_t color;
+        } fill;                     /*!< ESP32S3_4DLCD_SUBMIT_FILL */
+        struct {
+            bool mirror_x;
+            bool mirror_y;
+        } mirror;                   /*!< ESP32S3_4DLCD_SUBMIT_MIRROR */
+        bool swap_axes;             /*!< ESP32S3_4DLCD_SUBMIT_SWAP_XY */
+        bool invert_color;          /*!< ESP32S3_4DLCD_SUBMIT_INVERT */
+        struct {
+            int x_gap;
+            int y_gap;
+        } gap;                      /*!< ESP32S3_4DLCD_SUBMIT_GAP */
+        bool on_off;                /*!< ESP32S3_4DLCD_SUBMIT_DISP_ON_OFF */
+    };
+    esp32s3_4dlcd_submit_done_cb_t done_cb; /*!< Completion callback, or NULL */
+    void *user_ctx;                 /*!< User context passed to `done_cb` */
+} esp32s3_4dlcd_submit_cmd_t;
+
+/**
+ * @brief Submission queue configuration.
+ *
+ */
+typedef struct {
+    size_t queue_size;              /*!< Commands the queue holds, a power of two */
+    uint32_t task_stack;            /*!< Flush task stack size in bytes */
+    UBaseType_t task_priority;      /*!< Flush task priority */
+    BaseType_t task_core;           /*!< Core the flush task is pinned to, or tskNO_AFFINITY */
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done; /*!< Optional, chained from the driver's own handler */
+    void *user_ctx;                 /*!< User context passed to `on_color_trans_done` */
+} esp32s3_4dlcd_submit_config_t;
+
+#define ESP32S3_4DLCD_SUBMIT_DEFAULT_CONFIG()                   \
+    {                                                           \
+        .queue_size = 32,                                       \
+        .task_stack = 3072,                                     \
+        .task_priority = 5,                                     \
+        .task_core = 1,                                         \
+    }
+
+/**
+ * @brief Latency statistics of one producer.
+ *
+ */
+typedef struct {
+    uint32_t commands;              /*!< Commands completed */
+    uint32_t max_latency_us;        /*!< Longest time from submission to completion */
+    uint64_t total_latency_us;      /*!< Sum of the times from submission to completion */
+} esp32s3_4dlcd_submit_producer_stats_t;
+
+/**
+ * @brief Submission queue statistics.
+ *
+ */
+typedef struct {
+    uint32_t commands;              /*!< Commands completed */
+    uint32_t batches;               /*!< Batches issued by the flush task */
+    uint32_t merged;                /*!< Commands folded into the previous one of their batch */
+    uint32_t queue_full;            /*!< Submissions that found the queue full, counted once however long they waited */
+    size_t queue_high_water;        /*!< Most commands waiting in the queue at once */
+    esp32s3_4dlcd_submit_producer_stats_t producers[ESP32S3_4DLCD_SUBMIT_MAX_PRODUCERS];
+} esp32s3_4dlcd_submit_stats_t;
+
+/**
+ * @brief Create a submission queue and its flush task, after which the panel must only be used through it
+ *
+ * @note  Any task on either core can submit commands without locking. The flush task is the only one touching the
+ *        panel IO: it drains the queue in batches, merges draws that continue each other in memory and state
+ *        commands that override each other, then reports completion.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] config Submission queue configuration
+ * @param[out] ret_submit Returned submission queue handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_submit_new(esp_lcd_panel_handle_t panel, const esp32s3_4dlcd_submit_config_t *config,
+                                   esp32s3_4dlcd_submit_handle_t *ret_submit);
+
+/**
+ * @brief Complete the queued commands, stop the flush task and delete the submission queue
+ *
+ * @param[in] submit Submission queue handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_submit_del(esp32s3_4dlcd_submit_handle_t submit);
+
+/**
+ * @brief Queue a command for the flush task
+ *
+ * @param[in] submit Submission queue handle
+ * @param[in] cmd Command, copied into the queue
+ * @param[in] timeout Time to wait for room in the queue
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_TIMEOUT       if the queue stayed full
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_submit(esp32s3_4dlcd_submit_handle_t submit, const esp32s3_4dlcd_submit_cmd_t *cmd, TickType_t timeout);
+
+/**
+ * @brief Get the submission queue statistics
+ *
+ * @param[in] submit Submission queue handle
+ * @param[out] stats Returned statistics
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_submit_get_stats(esp32s3_4dlcd_submit_handle_t submit, esp32s3_4dlcd_submit_stats_t *stats);
+
+/**
+ * @brief Reset the submission queue statistics
+ *
+ * @param[in] submit Submission queue handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_submit_reset_stats(esp32s3_4dlcd_submit_handle_t submit);
+
+/**
+ * @brief Damage tracker handle
+ *
+ */
+typedef struct esp32s3_4dlcd_damage_t *esp32s3_4dlcd_damage_handle_t;
+
+/**
+ * @brief Damage tracker configuration.
+ *
+ * @note  The bus parameters feed the cost model used to decide between merging two rectangles into their
+ *        bounding box, or sending them as separate windows.
+ *
+ */
+typedef struct {
+    int width;                  /*!< Frame buffer width in pixels, rectangles are clipped to it */
+    int height;                 /*!< Frame buffer height in pixels */
+    size_t max_rects;           /*!< Maximum number of windows kept, the cheapest pair is merged beyond it */
+    uint32_t pclk_hz;           /*!< Bus clock */
+    uint8_t bus_width;          /*!< Data lines carrying pixel data, 1 for SPI and 4 for QSPI */
+    uint8_t bits_per_pixel;     /*!< Bits sent per pixel, 24 for the RGB666 layout */
+    uint32_t trans_overhead_ns; /*!< Fixed cost of one command or colour transaction (setup, DC toggle, driver overhead) */
+} esp32s3_4dlcd_damage_config_t;
+
+#define ESP32S3_4DLCD_DAMAGE_DEFAULT_CONFIG()                   \
+    {                                                           \
+        .width = LCD_WIDTH,                                     \
+        .height = LCD_HEIGHT,                                   \
+        .max_rects = 16,                                        \
+        .pclk_hz = LCD_SPI_PCLK_MHZ * 1000 * 1000,              \
+        .bus_width = LCD_BUS_WIDTH,                             \
+        .bits_per_pixel = (LCD_BITS_PER_PIXEL == 18) ? 24 : LCD_BITS_PER_PIXEL, \
+        .trans_overhead_ns = 15000,                             \
+    }
+
+/**
+ * @brief Result of a damage flush.
+ *
+ */
+typedef struct {
+    uint32_t windows;           /*!< Windows sent, each costing CASET, RASET and RAMWR */
+    uint32_t pixels;            /*!< Pixels sent */
+    uint64_t wire_time_ns;      /*!< Wire time estimated by the cost model */
+} esp32s3_4dlcd_damage_stats_t;
+
+/**
+ * @brief Create a damage tracker
+ *
+ * @param[in] config Damage tracker configuration
+ * @param[out] ret_damage Returned damage tracker handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_damage_new(const esp32s3_4dlcd_damage_config_t *config, esp32s3_4dlcd_damage_handle_t *ret_damage);
+
+/**
+ * @brief Delete a damage tracker
+ *
+ * @param[in] damage Damage tracker handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_damage_del(esp32s3_4dlcd_damage_handle_t damage);
+
+/**
+ * @brief Mark an area of the frame buffer as changed
+ *
+ * @note  The rectangle is merged with the tracked ones whenever their bounding box is cheaper to send than
+ *        separate windows and does not reach into another window. Otherwise the part overlapping an existing window
+ *        is cut away, so no pixel is sent twice.
+ *
+ * @param[in] damage Damage tracker handle
+ * @param[in] x_start Start column
+ * @param[in] y_start Start row
+ * @param[in] x_end End column (exclusive)
+ * @param[in] y_end End row (exclusive)
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_damage_add(esp32s3_4dlcd_damage_handle_t damage, int x_start, int y_start, int x_end, int y_end);
+
+/**
+ * @brief Get the windows currently tracked
+ *
+ * @param[in] damage Damage tracker handle
+ * @param[out] rects Returned pointer to the windows, valid until the tracker is next modified. May be NULL.
+ * @return Number of windows
+ */
+size_t esp32s3_4dlcd_damage_get_rects(esp32s3_4dlcd_damage_handle_t damage, const esp32s3_4dlcd_rect_t **rects);
+
+/**
+ * @brief Forget all tracked windows
+ *
+ * @param[in] damage Damage tracker handle
+ */
+void esp32s3_4dlcd_damage_clear(esp32s3_4dlcd_damage_handle_t damage);
+
+/**
+ * @brief Send every tracked window from the frame buffer to the panel, then clear the tracker
+ *
+ * @param[in] damage Damage tracker handle
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] fb Full frame buffer, `width` x `height` pixels in the format accepted by `esp_lcd_panel_draw_bitmap`
+ * @param[out] stats Returned flush statistics, may be NULL
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_damage_flush(esp32s3_4dlcd_damage_handle_t damage, esp_lcd_panel_handle_t panel, const void *fb,
+                                     esp32s3_4dlcd_damage_stats_t *stats);
+
+/**
+ * @brief Tile hash handle
+ *
+ */
+typedef struct esp32s3_4dlcd_tilehash_t *esp32s3_4dlcd_tilehash_handle_t;
+
+/**
+ * @brief Tile hash configuration.
+ *
+ */
+typedef struct {
+    int width;                  /*!< Frame buffer width in pixels */
+    int height;                 /*!< Frame buffer height in pixels */
+    size_t bytes_per_pixel;     /*!< Bytes per pixel of the frame buffer */
+    uint16_t tile_width;        /*!< Preferred tile width in pixels */
+    uint16_t tile_height;       /*!< Preferred tile height in pixels */
+    size_t max_hash_bytes;      /*!< Memory budget for the hash table, tiles are enlarged until it fits. 0 for no limit */
+} esp32s3_4dlcd_tilehash_config_t;
+
+#define ESP32S3_4DLCD_TILEHASH_DEFAULT_CONFIG()                 \
+    {                                                           \
+        .width = LCD_WIDTH,                                     \
+        .height = LCD_HEIGHT,                                   \
+        .bytes_per_pixel = LCD_DRAW_BYTES_PER_PIXEL,            \
+        .tile_width = 16,                                       \
+        .tile_height = 16,                                      \
+        .max_hash_bytes = 4096,                                 \
+    }
+
+/**
+ * @brief Create a tile hash, which finds the areas of a full frame buffer that changed since the last scan
+ *
+ * @param[in] config Tile hash configuration
+ * @param[out] ret_tilehash Returned tile hash handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_INVALID_SIZE  if `max_hash_bytes` cannot hold even a single tile
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_tilehash_new(const esp32s3_4dlcd_tilehash_config_t *config, esp32s3_4dlcd_tilehash_handle_t *ret_tilehash);
+
+/**
+ * @brief Delete a tile hash
+ *
+ * @param[in] tilehash Tile hash handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_tilehash_del(esp32s3_4dlcd_tilehash_handle_t tilehash);
+
+/**
+ * @brief Treat every tile as changed on the next scan, e.g. after the panel was reinitialised
+ *
+ * @param[in] tilehash Tile hash handle
+ */
+void esp32s3_4dlcd_tilehash_invalidate(esp32s3_4dlcd_tilehash_handle_t tilehash);
+
+/**
+ * @brief Hash every tile of the frame buffer and add the changed ones to a damage tracker
+ *
+ * @note  Adjacent changed tiles of a tile row are joined, and runs covering the same columns on consecutive
+ *        tile rows are joined into one rectangle. The first scan reports the whole frame.
+ *        Send the result with `esp32s3_4dlcd_damage_flush`.
+ *
+ * @param[in] tilehash Tile hash handle
+ * @param[in] fb Full frame buffer
+ * @param[in] damage Damage tracker receiving the changed areas
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_tilehash_scan(esp32s3_4dlcd_tilehash_handle_t tilehash, const void *fb, esp32s3_4dlcd_damage_handle_t damage);
+
+#if CONFIG_ESP32S3_4DLCD_IO_TRACE
+/**
+ * @brief Kind of bus activity reported to a trace callback.
+ *
+ */
+typedef enum {
+    ESP32S3_4DLCD_TRACE_PARAM,  /*!< Command with parameters sent through `esp_lcd_panel_io_tx_param` */
+    ESP32S3_4DLCD_TRACE_COLOR,  /*!< Command with pixel data sent through `esp_lcd_panel_io_tx_color` */
+    ESP32S3_4DLCD_TRACE_DELAY,  /*!< Delay requested by the driver between transactions */
+    ESP32S3_4DLCD_TRACE_DRAW,   /*!< `esp_lcd_panel_draw_bitmap` returned, reported after the transactions it issued */
+} esp32s3_4dlcd_trace_type_t;
+
+/**
+ * @brief Single bus transaction or delay issued by the driver.
+ *
+ */
+typedef struct {
+    esp32s3_4dlcd_trace_type_t type;    /*!< Kind of event */
+    int lcd_cmd;                        /*!< Command as passed to the panel IO, including the QSPI opcode framing; -1 for delays */
+    const void *data;                   /*!< Parameter or pixel bytes, only valid during the callback */
+    size_t data_bytes;                  /*!< Size of `data` in bytes */
+    uint32_t delay_ms;                  /*!< Requested delay in milliseconds, for `ESP32S3_4DLCD_TRACE_DELAY` */
+    uint32_t duration_us;               /*!< Time spent in the call, for `ESP32S3_4DLCD_TRACE_DRAW` */
+    esp_err_t result;                   /*!< Value returned by the panel IO */
+} esp32s3_4dlcd_trace_event_t;
+
+/**
+ * @brief Trace callback, invoked from the calling task after every transaction and before every delay.
+ *
+ */
+typedef void (*esp32s3_4dlcd_trace_cb_t)(const esp32s3_4dlcd_trace_event_t *event, void *user_ctx);
+
+/**
+ * @brief Record every bus transaction issued by the panel
+ *
+ * @note  Available when `CONFIG_ESP32S3_4DLCD_IO_TRACE` is enabled. Pass NULL to stop tracing.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] callback Function called for every transaction, or NULL
+ * @param[in] user_ctx User context passed to the callback
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_set_trace_callback(esp_lcd_panel_handle_t panel, esp32s3_4dlcd_trace_cb_t callback, void *user_ctx);
+#endif // CONFIG_ESP32S3_4DLCD_IO_TRACE
+
+#if CONFIG_ESP32S3_4DLCD_PERF_COUNTERS
+#define ESP32S3_4DLCD_PERF_HIST_BUCKETS     12  /*!< Buckets in the draw latency histogram */
+#define ESP32S3_4DLCD_PERF_HIST_BASE_US     64  /*!< Upper bound of the first bucket, each following bucket doubles it */
+
+/**
+ * @brief Panel performance counters, accumulated since creation or the last `esp32s3_4dlcd_reset_perf`.
+ *
+ * Queue and wire times and the queue high-water mark need completed transactions to be counted, i.e. a present
+ * queue or submission queue on the panel. Wire time starts when the previous colour transaction completed, or when
+ * the transaction was queued if the bus was idle.
+ *
+ */
+typedef struct {
+    uint32_t cmd_count;                 /*!< Commands sent through `esp_lcd_panel_io_tx_param` */
+    uint32_t color_count;               /*!< Colour transactions sent through `esp_lcd_panel_io_tx_color` */
+    uint64_t cmd_bytes;                 /*!< Parameter bytes of those commands */
+    uint64_t color_bytes;               /*!< Pixel bytes of those colour transactions */
+    uint32_t cmd_errors;                /*!< Commands the panel IO refused */
+    uint32_t color_errors;              /*!< Colour transactions the panel IO refused */
+    esp_err_t last_error;               /*!< Last error returned by the panel IO */
+    uint32_t timed_count;               /*!< Colour transactions seen completing, covered by the two times below */
+    uint64_t queued_us;                 /*!< Time colour transactions spent waiting behind earlier ones */
+    uint64_t wire_us;                   /*!< Time colour transactions spent on the wire */
+    uint32_t queue_high_water;          /*!< Most colour transactions in flight at once */
+    uint32_t draw_count;                /*!< Calls to `esp_lcd_panel_draw_bitmap` */
+    uint32_t draw_max_us;               /*!< Longest of those calls */
+    uint32_t draw_hist[ESP32S3_4DLCD_PERF_HIST_BUCKETS]; /*!< Calls by duration, bucket `i` counts those under
+                                                              `ESP32S3_4DLCD_PERF_HIST_BASE_US << i`, the last one the rest */
+} esp32s3_4dlcd_perf_t;
+
+/**
+ * @brief Get a consistent snapshot of the panel performance counters
+ *
+ * @note  Available when `CONFIG_ESP32S3_4DLCD_PERF_COUNTERS` is enabled.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[out] perf Returned counters
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_get_perf(esp_lcd_panel_handle_t panel, esp32s3_4dlcd_perf_t *perf);
+
+/**
+ * @brief Clear the panel performance counters
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_reset_perf(esp_lcd_panel_handle_t panel);
+#endif // CONFIG_ESP32S3_4DLCD_PERF_COUNTERS
+
+/**
+ * @brief SPI bus configuration for a panel wired to the given pins
+ *
+ * @param[in] sclk SCLK GPIO
+ * @param[in] mosi MOSI GPIO
+ * @param[in] miso MISO GPIO, or -1
+ * @param[in] max_trans_sz Maximum transfer size in bytes
+ *
+ */
+#define ESP32S3_4DLCD_BUS_SPI_CONFIG_EX(sclk, mosi, miso, max_trans_sz)         \
+    {                                                                           \
+        .sclk_io_num = (sclk),                                                  \
+        .mosi_io_num = (mosi),                                                  \
+        .miso_io_num = (miso),                                                  \
+        .quadhd_io_num = -1,                                                    \
+        .quadwp_io_num = -1,                                                    \
+        .max_transfer_sz = max_trans_sz,                                        \
+    }
+
+/**
+ * @brief QSPI bus configuration for a panel wired to the given pins
+ *
+ * @param[in] sclk SCLK GPIO
+ * @param[in] d0 DATA0 GPIO
+ * @param[in] d1 DATA1 GPIO
+ * @param[in] d2 DATA2 GPIO
+ * @param[in] d3 DATA3 GPIO
+ * @param[in] max_trans_sz Maximum transfer size in bytes
+ *
+ */
+#define ESP32S3_4DLCD_BUS_QSPI_CONFIG_EX(sclk, d0, d1, d2, d3, max_trans_sz)    \
+    {                                                                           \
+        .sclk_io_num = (sclk),                                                  \
+        .data0_io_num = (d0),                                                   \
+        .data1_io_num = (d1),                                                   \
+        .data2_io_num = (d2),                                                   \
+        .data3_io_num = (d3),                                                   \
+        .max_transfer_sz = max_trans_sz,                                        \
+    }
+
+/**
+ * @brief SPI panel IO configuration for a panel wired to the given pins
+ *
+ * @param[in] cs CS GPIO, or -1
+ * @param[in] dc D/C GPIO
+ * @param[in] pclk_mhz SPI clock in MHz
+ * @param[in] callback Callback function when SPI transfer is done
+ * @param[in] callback_ctx Callback function context
+ *
+ */
+#define ESP32S3_4DLCD_IO_SPI_CONFIG_EX(cs, dc, pclk_mhz, callback, callback_ctx) \
+    {                                                                           \
+        .cs_gpio_num = (cs),                                                    \
+        .dc_gpio_num = (dc),                                                    \
+        .spi_mode = 0,                                                          \
+        .pclk_hz = (pclk_mhz) * 1000 * 1000,                                    \
+        .trans_queue_depth = LCD_SPI_TRANS_QUEUE_DEPTH,                         \
+        .on_color_trans_done = callback,                                        \
+        .user_ctx = callback_ctx,                                               \
+        .lcd_cmd_bits = 8,                                                      \
+        .lcd_param_bits = 8,                                                    \
+    }
+
+/**
+ * @brief QSPI panel IO configuration for a panel wired to the given pins
+ *
+ * @param[in] cs CS GPIO
+ * @param[in] pclk_mhz QSPI clock in MHz
+ * @param[in] callback Callback function when SPI transfer is done
+ * @param[in] callback_ctx Callback function context
+ *
+ */
+#define ESP32S3_4DLCD_IO_QSPI_CONFIG_EX(cs, pclk_mhz, callback, callback_ctx)   \
+    {                                                                           \
+        .cs_gpio_num = (cs),                                                    \
+        .dc_gpio_num = -1,                                                      \
+        .spi_mode = 0,                                                          \
+        .pclk_hz = (pclk_mhz) * 1000 * 1000,                                    \
+        .trans_queue_depth = LCD_QSPI_TRANS_QUEUE_DEPTH,                        \
+        .on_color_trans_done = callback,                                        \
+        .user_ctx = callback_ctx,                                               \
+        .lcd_cmd_bits = 32,                                                     \
+        .lcd_param_bits = 8,                                                    \
+        .flags.quad_mode = true                                                 \
+    }
+
+/**
+ * @brief LCD panel bus configuration structure
+ *
+ * @param[in] max_trans_sz Maximum transfer size in bytes
+ *
+ */
+#if defined(CONFIG_LCD_INTERFACE_SPI)
+#define ESP32S3_4DLCD_BUS_SPI_CONFIG(max_trans_sz)              \
+    ESP32S3_4DLCD_BUS_SPI_CONFIG_EX(LCD_SPI_SCLK_GPIO_NUM, LCD_SPI_MOSI_GPIO_NUM, LCD_SPI_MISO_GPIO_NUM, max_trans_sz)
+#elif defined(CONFIG_LCD_INTERFACE_QSPI)
+#define ESP32S3_4DLCD_BUS_SPI_CONFIG(max_trans_sz)              \
+    ESP32S3_4DLCD_BUS_QSPI_CONFIG_EX(LCD_SPI_SCLK_GPIO_NUM, LCD_QSPI_DAT0_GPIO_NUM, LCD_QSPI_DAT1_GPIO_NUM, \
+                                     LCD_QSPI_DAT2_GPIO_NUM, LCD_QSPI_DAT3_GPIO_NUM, max_trans_sz)
+#else // CONFIG_LCD_INTERFACE_RGB
+// RGB panels have no SPI bus, see ESP32S3_4DLCD_RGB_DEFAULT_CONFIG
+#endif // CONFIG_LCD_INTERFACE
+
+/**
+ * @brief LCD panel IO configuration structure
+ *
+ * @param[in] cb Callback function when SPI transfer is done
+ * @param[in] cb_ctx Callback function context
+ *
+ */
+#if defined(CONFIG_LCD_INTERFACE_SPI)
+#define ESP32S3_4DLCD_IO_SPI_CONFIG(callback, callback_ctx)     \
+    ESP32S3_4DLCD_IO_SPI_CONFIG_EX(LCD_SPI_CS_GPIO_NUM, LCD_SPI_DC_GPIO_NUM, LCD_SPI_PCLK_MHZ, callback, callback_ctx)
+#elif defined(CONFIG_LCD_INTERFACE_QSPI)
+#define ESP32S3_4DLCD_IO_SPI_CONFIG(callback, callback_ctx)     \
+    ESP32S3_4DLCD_IO_QSPI_CONFIG_EX(LCD_SPI_CS_GPIO_NUM, LCD_SPI_PCLK_MHZ, callback, callback_ctx)
+#endif // CONFIG_LCD_INTERFACE
+
+/**
+ * @brief RGB frame buffer manager handle
+ *
+ */
+typedef struct esp32s3_4dlcd_rgb_t *esp32s3_4dlcd_rgb_handle_t;
+
+#define ESP32S3_4DLCD_RGB_MAX_FBS   3
+
+/**
+ * @brief RGB frame buffer manager configuration.
+ *
+ * @note  Frame buffers are RGB565 (CPU byte order), `width * 2` bytes per row, in PSRAM. The LCD peripheral either
+ *        reads them directly, or, with `bounce_buffer_lines` set, through two internal SRAM bounce buffers the
+ *        driver refills from PSRAM while the other one is sent; this sustains a higher pixel clock.
+ *
+ */
+typedef struct {
+    esp32s3_4dlcd_model_t model;            /*!< One of the RGB models, ESP32S3_4DLCD_MODEL_KCONFIG for the model selected in menuconfig */
+    const esp_lcd_rgb_timing_t *timings;    /*!< Timings to use instead of the model's, or NULL */
+    int pclk_gpio_num;                      /*!< PCLK GPIO */
+    int de_gpio_num;                        /*!< DE GPIO, or -1 to use HSYNC and VSYNC only */
+    int hsync_gpio_num;                     /*!< HSYNC GPIO */
+    int vsync_gpio_num;                     /*!< VSYNC GPIO */
+    int disp_gpio_num;                      /*!< DISP GPIO, or -1 */
+    int data_gpio_nums[16];                 /*!< Data GPIOs, B0-B4, G0-G5 then R0-R4 */
+    size_t num_fbs;                         /*!< Frame buffers, 1 to ESP32S3_4DLCD_RGB_MAX_FBS */
+    size_t bounce_buffer_lines;             /*!< Lines in each internal bounce buffer, must divide the height, 0 to let the DMA read PSRAM */
+    size_t max_rects;                       /*!< Rectangles kept per frame buffer to catch it up, the cheapest pair is merged beyond it */
+} esp32s3_4dlcd_rgb_config_t;
+
+#if defined(CONFIG_LCD_INTERFACE_RGB)
+#define ESP32S3_4DLCD_RGB_DEFAULT_CONFIG()                      \
+    {                                                           \
+        .model = ESP32S3_4DLCD_MODEL_KCONFIG,                   \
+        .timings = NULL,                                        \
+        .pclk_gpio_num = LCD_RGB_PCLK_GPIO_NUM,                 \
+        .de_gpio_num = LCD_RGB_DE_GPIO_NUM,                     \
+        .hsync_gpio_num = LCD_RGB_HSYNC_GPIO_NUM,               \
+        .vsync_gpio_num = LCD_RGB_VSYNC_GPIO_NUM,               \
+        .disp_gpio_num = LCD_RGB_DISP_GPIO_NUM,                 \
+        .data_gpio_nums = LCD_RGB_DATA_GPIO_NUMS,               \
+        .num_fbs = 2,                                           \
+        .bounce_buffer_lines = 10,                              \
+        .max_rects = 16,                                        \
+    }
+#endif // CONFIG_LCD_INTERFACE_RGB
+
+/**
+ * @brief Frame buffer manager statistics.
+ *
+ */
+typedef struct {
+    uint32_t frames;            /*!< Frames presented */
+    uint32_t flips;             /*!< Frame buffer flips completed at a vsync */
+    uint32_t vsyncs;            /*!< Vsync events seen */
+    uint64_t copied_pixels;     /*!< Pixels copied to bring frame buffers up to date */
+    uint64_t wait_us;           /*!< Time spent waiting for a free frame buffer or for a pending flip */
+} esp32s3_4dlcd_rgb_stats_t;
+
+/**
+ * @brief Create an RGB panel with its frame buffers in PSRAM, reset and initialize it
+ *
+ * @note  Flips are aligned to vsync: a presented frame buffer is scanned from the next frame on, and the one it
+ *        replaces is only handed out again once it is no longer scanned. Nothing is copied to flip. A frame buffer
+ *        that missed frames is caught up by copying only the rectangles drawn since it was last current.
+ *
+ * @param[in] config RGB configuration
+ * @param[out] ret_rgb Returned frame buffer manager handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NOT_SUPPORTED if the model is not an RGB model
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_rgb_new(const esp32s3_4dlcd_rgb_config_t *config, esp32s3_4dlcd_rgb_handle_t *ret_rgb);
+
+/**
+ * @brief Delete the RGB panel and its frame buffers
+ *
+ * @param[in] rgb Frame buffer manager handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_rgb_del(esp32s3_4dlcd_rgb_handle_t rgb);
+
+/**
+ * @brief Get the underlying esp_lcd RGB panel, e.g. for `esp_lcd_panel_disp_on_off`
+ *
+ * @note  Do not call `esp_lcd_panel_draw_bitmap` on it while frames are presented through the manager.
+ *
+ * @param[in] rgb Frame buffer manager handle
+ * @return Panel handle
+ */
+esp_lcd_panel_handle_t esp32s3_4dlcd_rgb_get_panel(esp32s3_4dlcd_rgb_handle_t rgb);
+
+/**
+ * @brief Get a frame buffer to draw the next frame into
+ *
+ * @note  Waits for a frame buffer that is neither scanned nor waiting for a flip, which with two frame buffers
+ *        means the vsync after the previous `esp32s3_4dlcd_rgb_present`. It is returned holding the last presented
+ *        frame. With a single frame buffer, that one is returned at once and drawing into it may tear.
+ *        Frames must be drawn by one task at a time.
+ *
+ * @param[in] rgb Frame buffer manager handle
+ * @param[out] fb Frame buffer
+ * @param[in] timeout Time to wait for a frame buffer
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_INVALID_STATE if a frame has begun and not been presented
+ *          - ESP_ERR_TIMEOUT       if no frame buffer got free in time
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_rgb_begin_frame(esp32s3_4dlcd_rgb_handle_t rgb, void **fb, TickType_t timeout);
+
+/**
+ * @brief Record an area drawn in the current frame
+ *
+ * @note  Areas not recorded are not copied to the other frame buffers, which then show stale content once they are
+ *        current again.
+ *
+ * @param[in] rgb Frame buffer manager handle
+ * @param[in] x_start Start column index of the area
+ * @param[in] y_start Start row index of the area
+ * @param[in] x_end End column index of the area, exclusive
+ * @param[in] y_end End row index of the area, exclusive
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_INVALID_STATE if no frame has begun
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_rgb_damage(esp32s3_4dlcd_rgb_handle_t rgb, int x_start, int y_start, int x_end, int y_end);
+
+/**
+ * @brief Present the current frame at the next vsync
+ *
+ * @note  Only one flip can wait for vsync: this waits for the previous one first.
+ *
+ * @param[in] rgb Frame buffer manager handle
+ * @param[in] timeout Time to wait for the previous flip
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_INVALID_STATE if no frame has begun
+ *          - ESP_ERR_TIMEOUT       if the previous flip did not happen in time
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_rgb_present(esp32s3_4dlcd_rgb_handle_t rgb, TickType_t timeout);
+
+/**
+ * @brief Get the frame buffer manager statistics
+ *
+ * @param[in] rgb Frame buffer manager handle
+ * @param[out] stats Statistics
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_rgb_get_stats(esp32s3_4dlcd_rgb_handle_t rgb, esp32s3_4dlcd_rgb_stats_t *stats);
+
+/**
+ * @brief Backlight handle
+ *
+ */
+typedef struct esp32s3_4dlcd_backlight_t *esp32s3_4dlcd_backlight_handle_t;
+
+/**
+ * @brief Called from the LEDC interrupt when a fade has finished, must be placed in IRAM
+ *
+ * @param[in] bl Backlight handle
+ * @param[in] level Level reached
+ * @param[in] user_ctx User context given in the configuration
+ * @return Whether a high priority task has been woken up by this function
+ */
+typedef bool (*esp32s3_4dlcd_backlight_fade_cb_t)(esp32s3_4dlcd_backlight_handle_t bl, uint8_t level, void *user_ctx);
+
+/**
+ * @brief Backlight configuration.
+ *
+ */
+typedef struct {
+    int gpio_num;                       /*!< Backlight GPIO */
+    ledc_timer_t timer;                 /*!< LEDC timer, may be shared with other channels at the same frequency */
+    ledc_channel_t channel;             /*!< LEDC channel, one per backlight */
+    uint32_t freq_hz;                   /*!< PWM frequency */
+    ledc_timer_bit_t duty_resolution;   /*!< PWM resolution, the 256 levels are spread over it */
+    float gamma;                        /*!< Exponent mapping levels to duty, 1 for linear */
+    uint32_t idle_timeout_ms;           /*!< Dim after this long without `esp32s3_4dlcd_backlight_activity`, 0 to disable */
+    uint8_t idle_level;                 /*!< Level dimmed to */
+    uint32_t idle_fade_ms;              /*!< Duration of the dim and undim fades */
+    esp32s3_4dlcd_backlight_fade_cb_t on_fade_done; /*!< Fade end callback, or NULL */
+    void *user_ctx;                     /*!< User context passed to `on_fade_done` */
+} esp32s3_4dlcd_backlight_config_t;
+
+#define ESP32S3_4DLCD_BACKLIGHT_DEFAULT_CONFIG()                \
+    {                                                           \
+        .gpio_num = LCD_BL_GPIO_NUM,                            \
+        .timer = LEDC_TIMER_0,                                  \
+        .channel = LEDC_CHANNEL_0,                              \
+        .freq_hz = LCD_BL_PWM_FREQ_HZ,                          \
+        .duty_resolution = LCD_BL_FADE_RESOLUTION,              \
+        .gamma = 2.2f,                                          \
+    }
+
+/**
+ * @brief Set up a backlight on an LEDC channel, with hardware fades and optional idle auto-dim
+ *
+ * @note  Installs the shared LEDC fade service if nobody has. The backlight starts off.
+ *
+ * @param[in] config Backlight configuration
+ * @param[out] ret_bl Returned backlight handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_backlight_new(const esp32s3_4dlcd_backlight_config_t *config, esp32s3_4dlcd_backlight_handle_t *ret_bl);
+
+/**
+ * @brief Turn the backlight off and release it
+ *
+ * @param[in] bl Backlight handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_backlight_del(esp32s3_4dlcd_backlight_handle_t bl);
+
+/**
+ * @brief Fade to a level in the background
+ *
+ * @note  Returns at once, the LEDC hardware ramps the duty and `on_fade_done` is called at the end.
+ *        Also counts as activity for the auto-dim.
+ *
+ * @param[in] bl Backlight handle
+ * @param[in] level Perceptual level, 0 (off) to 255
+ * @param[in] fade_ms Fade duration, 0 to change at once
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_backlight_fade(esp32s3_4dlcd_backlight_handle_t bl, uint8_t level, uint32_t fade_ms);
+
+/**
+ * @brief Set a level at once, same as `esp32s3_4dlcd_backlight_fade` with no fade time
+ *
+ * @param[in] bl Backlight handle
+ * @param[in] level Perceptual level, 0 (off) to 255
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_backlight_set(esp32s3_4dlcd_backlight_handle_t bl, uint8_t level);
+
+/**
+ * @brief Report user activity: restart the idle timer and fade back up if the backlight was dimmed
+ *
+ * @param[in] bl Backlight handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_backlight_activity(esp32s3_4dlcd_backlight_handle_t bl);
+
+/**
+ * @brief Get the level the backlight is at or fading to
+ *
+ * @param[in] bl Backlight handle
+ * @return Level, 0 to 255
+ */
+uint8_t esp32s3_4dlcd_backlight_get_level(esp32s3_4dlcd_backlight_handle_t bl);
 
 esp_err_t backlight_init(void);
 esp_err_t backlight_set(uint8_t brightness);
@@ -0,0 +1,59 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file
+ * @brief Pixel format conversion kernels used on the flush path.
+ *
+ * These helpers only depend on the C library so they can be built and checked on a host.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Expand RGB565 pixels to the RGB666 layout expected with COLMOD = 0x66.
+ *
+ * Each output pixel takes 3 bytes, R, G then B, with the 6 colour bits in the high bits of each byte.
+ * The missing low bit of R and B is filled with their top bit, so white stays white.
+ *
+ * @param[out] dst Output buffer, at least `pixels * 3` bytes
+ * @param[in] src RGB565 pixels in CPU byte order
+ * @param[in] pixels Number of pixels to convert
+ */
+void esp32s3_4dlcd_rgb565_to_rgb666(uint8_t *dst, const uint16_t *src, size_t pixels);
+
+/**
+ * @brief Store RGB565 pixels high byte first, the order they are sent on the wire with COLMOD = 0x55.
+ *
+ * @param[out] dst Output buffer, at least `pixels * 2` bytes
+ * @param[in] src RGB565 pixels in CPU byte order
+ * @param[in] pixels Number of pixels to convert
+ */
+void esp32s3_4dlcd_rgb565_to_be(uint8_t *dst, const uint16_t *src, size_t pixels);
+
+/**
+ * @brief Repeat the first `period` bytes of `buf` until `len` bytes are filled.
+ *
+ * The filled part is doubled on every copy, so a buffer is filled in log2(len / period) calls to memcpy.
+ *
+ * @param[in,out] buf Buffer whose first `period` bytes hold the pattern
+ * @param[in] period Pattern length in bytes, at least 1
+ * @param[in] len Bytes to fill, including the pattern
+ */
+void esp32s3_4dlcd_repeat(uint8_t *buf, size_t period, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
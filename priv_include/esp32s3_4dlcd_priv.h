@@ -0,0 +1,180 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file
+ * @brief Internal interface between the panel driver and the layers built on top of it.
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp32s3_4dlcd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Model picked in menuconfig, used for ESP32S3_4DLCD_MODEL_KCONFIG
+#if defined(CONFIG_ESP32S3_4DLCD_24)
+#define LCD_KCONFIG_MODEL           ESP32S3_4DLCD_MODEL_24
+#elif defined(CONFIG_ESP32S3_4DLCD_28)
+#define LCD_KCONFIG_MODEL           ESP32S3_4DLCD_MODEL_28
+#elif defined(CONFIG_ESP32S3_4DLCD_32)
+#define LCD_KCONFIG_MODEL           ESP32S3_4DLCD_MODEL_32
+#elif defined(CONFIG_ESP32S3_4DLCD_35)
+#define LCD_KCONFIG_MODEL           ESP32S3_4DLCD_MODEL_35
+#elif defined(CONFIG_ESP32S3_4DLCD_43Q)
+#define LCD_KCONFIG_MODEL           ESP32S3_4DLCD_MODEL_43Q
+#elif defined(CONFIG_ESP32S3_4DLCD_43)
+#define LCD_KCONFIG_MODEL           ESP32S3_4DLCD_MODEL_43
+#elif defined(CONFIG_ESP32S3_4DLCD_50)
+#define LCD_KCONFIG_MODEL           ESP32S3_4DLCD_MODEL_50
+#elif defined(CONFIG_ESP32S3_4DLCD_70)
+#define LCD_KCONFIG_MODEL           ESP32S3_4DLCD_MODEL_70
+#elif defined(CONFIG_ESP32S3_4DLCD_90)
+#define LCD_KCONFIG_MODEL           ESP32S3_4DLCD_MODEL_90
+#else
+#error "No valid 4D Systems LCD model defined"
+#endif
+
+/**
+ * @brief Start counting completed colour transactions of a panel.
+ *
+ * Registers the driver's own `on_color_trans_done` handler on the panel IO, which replaces the callback given in
+ * `ESP32S3_4DLCD_IO_SPI_CONFIG`; that one is chained from it if it was also given in the vendor config, and so is
+ * `user_cb`. Tracking is reference counted: every user calls this once and `esp32s3_4dlcd_trans_untrack` once, and
+ * the panel IO callback is only put back after the last one. The first user waits for colour transactions already
+ * queued to leave the bus, they were queued uncounted.
+ * Once tracking is on, the driver also never queues more colour transactions than the panel IO of its model is created to queue.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] user_cb Callback to chain after the driver's own handling, or NULL
+ * @param[in] user_ctx Context passed to `user_cb`
+ * @return
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_trans_track(esp_lcd_panel_handle_t panel, esp_lcd_panel_io_color_trans_done_cb_t user_cb, void *user_ctx);
+
+/**
+ * @brief Drop a user of transaction tracking, given the callback and context it started tracking with.
+ *
+ * The last user to go stops the counting and restores the panel IO callback from the vendor config.
+ */
+void esp32s3_4dlcd_trans_untrack(esp_lcd_panel_handle_t panel, esp_lcd_panel_io_color_trans_done_cb_t user_cb, void *user_ctx);
+
+/**
+ * @brief Sequence number of the last colour transaction queued on the panel.
+ */
+uint32_t esp32s3_4dlcd_trans_seq(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Check whether the colour transaction with sequence number `seq` has completed.
+ */
+bool esp32s3_4dlcd_trans_is_done(esp_lcd_panel_handle_t panel, uint32_t seq);
+
+/**
+ * @brief Wait until the colour transaction with sequence number `seq` has completed.
+ *
+ * @return
+ *          - ESP_ERR_INVALID_STATE if tracking has not been started
+ *          - ESP_ERR_TIMEOUT       if the transaction did not complete in time
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_trans_wait(esp_lcd_panel_handle_t panel, uint32_t seq, TickType_t timeout);
+
+/**
+ * @brief Set the address window for pixel data the caller generates itself in the driver chunk buffers.
+ *
+ * Coordinates follow `esp_lcd_panel_draw_bitmap`, the panel gap is applied.
+ */
+esp_err_t esp32s3_4dlcd_stream_begin(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end);
+
+/**
+ * @brief Get free space in the current chunk buffer.
+ *
+ * Data is written in the panel format, see `esp32s3_4dlcd_pixel_bytes`. `avail` is always a whole number of pixels.
+ */
+esp_err_t esp32s3_4dlcd_stream_reserve(esp_lcd_panel_handle_t panel, uint8_t **dst, size_t *avail);
+
+/**
+ * @brief Mark `len` reserved bytes as written, sending the chunk once it is full.
+ */
+esp_err_t esp32s3_4dlcd_stream_commit(esp_lcd_panel_handle_t panel, size_t len);
+
+/**
+ * @brief Send the partially filled chunk, if any.
+ */
+esp_err_t esp32s3_4dlcd_stream_end(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Send caller-owned panel format data into the current window, after any data already pushed.
+ *
+ * `data` is read by DMA and must stay untouched until the next chunk has been pushed or the transaction completed.
+ * A reserved but uncommitted chunk buffer may be pushed any number of times, it stays reserved.
+ */
+esp_err_t esp32s3_4dlcd_stream_push(esp_lcd_panel_handle_t panel, const void *data, size_t len);
+
+/**
+ * @brief Bytes per pixel of the data sent to the panel (2 for RGB565, 3 for RGB666).
+ */
+size_t esp32s3_4dlcd_pixel_bytes(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Map rows in `esp_lcd_panel_draw_bitmap` coordinates to the native rows the controller scans, top first.
+ *
+ * @param[in,out] y_start First row, mapped in place
+ * @param[in,out] y_end Row after the last, mapped in place
+ * @param[out] rows Native rows of the panel
+ * @param[out] descending True if a draw writes the native rows bottom first, as it does with MY set
+ * @return False if the rows run across the scan (swapped axes or software rotation), in which case they are left as is
+ */
+bool esp32s3_4dlcd_scan_rows(esp_lcd_panel_handle_t panel, int *y_start, int *y_end, int *rows, bool *descending);
+
+/**
+ * @brief Bytes per pixel of the colour data accepted by `esp_lcd_panel_draw_bitmap` (2 when the driver converts RGB565).
+ */
+size_t esp32s3_4dlcd_src_pixel_bytes(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Wait until every colour transaction handed to the panel IO has left the bus.
+ */
+esp_err_t esp32s3_4dlcd_bus_sync(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Size of the frame `esp_lcd_panel_draw_bitmap` coordinates live in, after MADCTL and software rotation.
+ */
+void esp32s3_4dlcd_frame_size(esp_lcd_panel_handle_t panel, int *width, int *height);
+
+/**
+ * @brief Size of the frame the unrotated draw paths address (`esp32s3_4dlcd_draw_lines`, fills, the window API):
+ *        after MADCTL, before software rotation.
+ */
+void esp32s3_4dlcd_unrotated_size(esp_lcd_panel_handle_t panel, int *width, int *height);
+
+/**
+ * @brief Name of the panel model, e.g. "gen4-ESP32-35".
+ */
+const char *esp32s3_4dlcd_model_name(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Draw a rectangle turned clockwise by `rotation` within a `frame_width` x `frame_height` frame.
+ *
+ * Coordinates are in the rotated frame, `color_data` is in the `esp_lcd_panel_draw_bitmap` format with rows `stride`
+ * bytes apart. The pixels are rotated into the chunk buffers and streamed to the matching unrotated window.
+ */
+esp_err_t esp32s3_4dlcd_rotate_draw(esp_lcd_panel_handle_t panel, esp32s3_4dlcd_rotation_t rotation, int frame_width,
+                                    int frame_height, int x_start, int y_start, int x_end, int y_end,
+                                    const void *color_data, size_t stride);
+
+#ifdef __cplusplus
+}
+#endif
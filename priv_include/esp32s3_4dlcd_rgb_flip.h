@@ -0,0 +1,125 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file
+ * @brief Frame buffer flips of the RGB frame buffer manager, and the copies that catch a frame buffer up.
+ *
+ * Only the damage trackers are used, no FreeRTOS and no LCD peripheral, so the flip order can be built and checked on
+ * a host. The caller serialises the calls that touch the states against the vsync interrupt.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp32s3_4dlcd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief State of one frame buffer
+ *
+ */
+typedef enum {
+    ESP32S3_4DLCD_RGB_FB_FREE,          /*!< Can be handed out */
+    ESP32S3_4DLCD_RGB_FB_DRAWING,       /*!< Handed out to draw the next frame */
+    ESP32S3_4DLCD_RGB_FB_PENDING,       /*!< Presented, becomes scanned at the next vsync */
+    ESP32S3_4DLCD_RGB_FB_SCANNED,       /*!< Read by the LCD peripheral */
+} esp32s3_4dlcd_rgb_fb_state_t;
+
+/**
+ * @brief Frame buffers and their states
+ *
+ */
+typedef struct {
+    size_t num_fbs;
+    uint8_t *fbs[ESP32S3_4DLCD_RGB_MAX_FBS];    /*!< Set by the caller once the frame buffers exist */
+    int width;
+    size_t pixel_bytes;
+    esp32s3_4dlcd_damage_handle_t stale[ESP32S3_4DLCD_RGB_MAX_FBS];    /*!< Drawn in other frame buffers since this one was last current */
+    esp32s3_4dlcd_rgb_fb_state_t state[ESP32S3_4DLCD_RGB_MAX_FBS];
+    int back;               /*!< Frame buffer being drawn, -1 if none */
+    int pending;            /*!< Frame buffer waiting for vsync, -1 if none */
+    int scanned;            /*!< Frame buffer read by the LCD peripheral */
+    int latest;             /*!< Last frame buffer presented, holds the newest frame */
+} esp32s3_4dlcd_rgb_flip_t;
+
+/**
+ * @brief Create the damage trackers and start with the first frame buffer scanned and none stale
+ *
+ * @param[out] flip Flip state
+ * @param[in] num_fbs Frame buffers, 1 to `ESP32S3_4DLCD_RGB_MAX_FBS`
+ * @param[in] damage_config Size and copy cost model of the frame buffers
+ * @return
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_rgb_flip_init(esp32s3_4dlcd_rgb_flip_t *flip, size_t num_fbs,
+                                      const esp32s3_4dlcd_damage_config_t *damage_config);
+
+/**
+ * @brief Delete the damage trackers
+ *
+ * @param[in] flip Flip state
+ */
+void esp32s3_4dlcd_rgb_flip_deinit(esp32s3_4dlcd_rgb_flip_t *flip);
+
+/**
+ * @brief Move the pending frame buffer to scanned and free the one scanned so far
+ *
+ * @param[in] flip Flip state
+ * @return True if a flip completed
+ */
+bool esp32s3_4dlcd_rgb_flip_vsync(esp32s3_4dlcd_rgb_flip_t *flip);
+
+/**
+ * @brief Hand out a free frame buffer to draw into, the only one if there is a single frame buffer
+ *
+ * @param[in] flip Flip state
+ * @return Frame buffer, or -1 if none is free
+ */
+int esp32s3_4dlcd_rgb_flip_take(esp32s3_4dlcd_rgb_flip_t *flip);
+
+/**
+ * @brief Record an area drawn in the frame buffer handed out, as stale in every other one
+ *
+ * @param[in] flip Flip state
+ * @param[in] x_start Start column
+ * @param[in] y_start Start row
+ * @param[in] x_end End column (exclusive)
+ * @param[in] y_end End row (exclusive)
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if the area is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp32s3_4dlcd_rgb_flip_damage(esp32s3_4dlcd_rgb_flip_t *flip, int x_start, int y_start, int x_end, int y_end);
+
+/**
+ * @brief Copy the areas stale in frame buffer `fb` from the newest frame, and forget them
+ *
+ * @param[in] flip Flip state
+ * @param[in] fb Frame buffer to catch up
+ * @return Pixels copied
+ */
+uint64_t esp32s3_4dlcd_rgb_flip_catch_up(esp32s3_4dlcd_rgb_flip_t *flip, int fb);
+
+/**
+ * @brief Mark the frame buffer handed out as presented, to be scanned from the next vsync on
+ *
+ * @param[in] flip Flip state
+ */
+void esp32s3_4dlcd_rgb_flip_present(esp32s3_4dlcd_rgb_flip_t *flip);
+
+#ifdef __cplusplus
+}
+#endif
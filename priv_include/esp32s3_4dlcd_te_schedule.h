@@ -0,0 +1,47 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file
+ * @brief Placement of a frame write against the panel scan, used by the TE presenter.
+ *
+ * This helper only depends on the C library so it can be built and checked on a host.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Delay after a TE pulse to start writing native rows [y_start, y_end) without crossing the scan.
+ *
+ * The panel scans `rows` rows per `period_ns`, starting at the pulse, and one row takes `row_ns` to write. Either
+ * every row is written at least `margin_ns` before the scan reads it in this refresh, or at least `margin_ns` after
+ * it and before the next refresh reads it again.
+ *
+ * @param[in] period_ns Refresh period
+ * @param[in] rows Native rows of the panel
+ * @param[in] row_ns Time to write one row of the window
+ * @param[in] y_start First native row written
+ * @param[in] y_end Native row after the last one written
+ * @param[in] descending True if the rows are written from `y_end - 1` down to `y_start`, against the scan
+ * @param[in] margin_ns Least distance kept from the scan
+ * @param[out] delay_ns Delay after the pulse to start writing, less than `period_ns`
+ * @return False if neither placement fits, `delay_ns` is then 0
+ */
+bool esp32s3_4dlcd_te_schedule(int64_t period_ns, int rows, int64_t row_ns, int y_start, int y_end, bool descending,
+                               int64_t margin_ns, int64_t *delay_ns);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,222 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Damage sequences from damage/ replayed per model, each rectangle drawn as it comes against the damage tracker's
+// windows: bus bytes, transactions and simulated time per frame, on a bus whose transactions cost the setup time the
+// tracker's cost model assumes. Prints one JSON object per model and sequence, and fails if coalescing costs more.
+
+#include <string.h>
+#include <sys/param.h>
+#include "esp32s3_4dlcd_pixel.h"
+#include "esp32s3_4dlcd_priv.h"
+#include "test_host.h"
+
+#define BENCH_TRANS_OVERHEAD_NS     15000   // as ESP32S3_4DLCD_DAMAGE_DEFAULT_CONFIG
+#define BENCH_MAX_RECTS             16
+
+static const char *const trace_names[] = { "clock", "list", "widgets", "graph" };
+
+/**
+ * @brief A recorded damage sequence.
+ */
+typedef struct {
+    esp32s3_4dlcd_rect_t *rects;
+    size_t rect_count;
+    size_t *frame_ends;         // rects of frame `i` end at `frame_ends[i]`
+    size_t frame_count;
+} damage_trace_t;
+
+typedef struct {
+    uint64_t bytes;             // command, parameter and colour bytes on the bus
+    uint64_t transactions;      // commands and colour transactions
+    uint64_t windows;           // windows drawn
+    uint64_t model_ns;          // wire time the tracker's cost model predicts, coalesced only
+    int64_t ns;                 // simulated time from the first draw to the bus going idle after the last
+} damage_cost_t;
+
+// Read damage/<name>.damage: a rectangle per line, frames separated by blank lines, `#` starts a comment
+static void trace_load(const char *name, damage_trace_t *trace)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "damage/%s.damage", name);
+    FILE *f = fopen(path, "r");
+    CHECK(f);
+    memset(trace, 0, sizeof(*trace));
+    size_t rect_cap = 0;
+    size_t frame_cap = 0;
+    char line[128];
+    bool more = true;
+    while (more) {
+        more = fgets(line, sizeof(line), f) != NULL;
+        if (more && line[0] == '#') {
+            continue;
+        }
+        esp32s3_4dlcd_rect_t r;
+        if (more && sscanf(line, "%d %d %d %d", &r.x_start, &r.y_start, &r.x_end, &r.y_end) == 4) {
+            if (trace->rect_count == rect_cap) {
+                rect_cap = rect_cap ? rect_cap * 2 : 64;
+                trace->rects = realloc(trace->rects, rect_cap * sizeof(r));
+                CHECK(trace->rects);
+            }
+            trace->rects[trace->rect_count++] = r;
+            continue;
+        }
+        // a blank line or the end of the file closes a frame that has rectangles
+        size_t frame_start = trace->frame_count ? trace->frame_ends[trace->frame_count - 1] : 0;
+        if (trace->rect_count > frame_start) {
+            if (trace->frame_count == frame_cap) {
+                frame_cap = frame_cap ? frame_cap * 2 : 16;
+                trace->frame_ends = realloc(trace->frame_ends, frame_cap * sizeof(size_t));
+                CHECK(trace->frame_ends);
+            }
+            trace->frame_ends[trace->frame_count++] = trace->rect_count;
+        }
+    }
+    fclose(f);
+    CHECK(trace->frame_count);
+}
+
+static void trace_free(damage_trace_t *trace)
+{
+    free(trace->rects);
+    free(trace->frame_ends);
+}
+
+// Clip `r` to the screen, false if nothing is left
+static bool rect_clip(const host_model_t *model, esp32s3_4dlcd_rect_t *r)
+{
+    r->x_start = MAX(r->x_start, 0);
+    r->y_start = MAX(r->y_start, 0);
+    r->x_end = MIN(r->x_end, model->width);
+    r->y_end = MIN(r->y_end, model->height);
+    return r->x_start < r->x_end && r->y_start < r->y_end;
+}
+
+// Add the recorded events to `cost` and drop them
+static void count_bus(const host_model_t *model, damage_cost_t *cost)
+{
+    size_t cmd_bytes = model->io.cmd_bits / 8;
+    for (size_t i = 0; i < mock_trace_count(); i++) {
+        const mock_trace_entry_t *e = mock_trace_get(i);
+        if (e->type == MOCK_TRACE_PARAM || e->type == MOCK_TRACE_COLOR) {
+            cost->transactions++;
+            cost->bytes += (e->lcd_cmd >= 0 ? cmd_bytes : 0) + e->bytes;
+        }
+    }
+    mock_trace_clear();
+}
+
+static damage_cost_t replay(const host_model_t *model, const damage_trace_t *trace, bool coalesce)
+{
+    host_model_t bench_model = *model;
+    bench_model.io.trans_overhead_ns = BENCH_TRANS_OVERHEAD_NS;
+    host_panel_t hp;
+    host_panel_new(&bench_model, &hp);
+    host_panel_start(&hp);
+
+    size_t pixel_bytes = esp32s3_4dlcd_pixel_bytes(hp.panel);
+    size_t stride = model->width * pixel_bytes;
+    uint8_t *fb = calloc(model->height, stride);
+    CHECK(fb);
+    esp32s3_4dlcd_damage_config_t damage_config = {
+        .width = model->width,
+        .height = model->height,
+        .max_rects = BENCH_MAX_RECTS,
+        .pclk_hz = model->io.pclk_hz,
+        .bus_width = model->io.bus_width,
+        .bits_per_pixel = pixel_bytes * 8,
+        .trans_overhead_ns = BENCH_TRANS_OVERHEAD_NS,
+    };
+    esp32s3_4dlcd_damage_handle_t damage;
+    CHECK_OK(esp32s3_4dlcd_damage_new(&damage_config, &damage));
+
+    damage_cost_t cost = { 0 };
+    mock_trace_clear();
+    int64_t start_ns = mock_time_ns();
+    size_t first = 0;
+    for (size_t frame = 0; frame < trace->frame_count; frame++) {
+        // the application redraws the damaged areas into the frame buffer, a colour per rectangle
+        for (size_t i = first; i < trace->frame_ends[frame]; i++) {
+            esp32s3_4dlcd_rect_t r = trace->rects[i];
+            if (!rect_clip(model, &r)) {
+                continue;
+            }
+            for (int y = r.y_start; y < r.y_end; y++) {
+                memset(fb + y * stride + r.x_start * pixel_bytes, (int)(frame * 37 + i) & 0xFF,
+                       (r.x_end - r.x_start) * pixel_bytes);
+            }
+            if (coalesce) {
+                CHECK_OK(esp32s3_4dlcd_damage_add(damage, r.x_start, r.y_start, r.x_end, r.y_end));
+            } else {
+                CHECK_OK(esp32s3_4dlcd_draw_bitmap_stride(hp.panel, r.x_start, r.y_start, r.x_end, r.y_end,
+                                                          fb + r.y_start * stride + r.x_start * pixel_bytes, stride));
+                cost.windows++;
+            }
+        }
+        if (coalesce) {
+            esp32s3_4dlcd_damage_stats_t stats;
+            CHECK_OK(esp32s3_4dlcd_damage_flush(damage, hp.panel, fb, &stats));
+            cost.windows += stats.windows;
+            cost.model_ns += stats.wire_time_ns;
+        }
+        first = trace->frame_ends[frame];
+        count_bus(model, &cost);
+    }
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    cost.ns = mock_time_ns() - start_ns;
+    count_bus(model, &cost);
+
+    // whatever the windows, the panel ends up showing the frame buffer
+    for (int y = 0; y < model->height; y++) {
+        for (int x = 0; x < model->width; x++) {
+            if (memcmp(mock_io_gram(hp.io, x, y), fb + y * stride + x * pixel_bytes, pixel_bytes)) {
+                fprintf(stderr, "%s: %s differs at %d,%d\n", model->name, coalesce ? "coalesced" : "naive", x, y);
+                exit(1);
+            }
+        }
+    }
+    CHECK(mock_io_gram_overruns(hp.io) == 0);
+
+    CHECK_OK(esp32s3_4dlcd_damage_del(damage));
+    free(fb);
+    host_panel_del(&hp);
+    return cost;
+}
+
+static void bench(const host_model_t *model, const char *name)
+{
+    damage_trace_t trace;
+    trace_load(name, &trace);
+    damage_cost_t naive = replay(model, &trace, false);
+    damage_cost_t coalesced = replay(model, &trace, true);
+
+    double frames = trace.frame_count;
+    printf("{\"model\":\"%s\",\"trace\":\"%s\",\"frames\":%zu,"
+           "\"naive_bytes_per_frame\":%.0f,\"naive_transactions_per_frame\":%.1f,\"naive_windows_per_frame\":%.1f,"
+           "\"naive_us_per_frame\":%.1f,\"coalesced_bytes_per_frame\":%.0f,\"coalesced_transactions_per_frame\":%.1f,"
+           "\"coalesced_windows_per_frame\":%.1f,\"coalesced_us_per_frame\":%.1f,\"model_us_per_frame\":%.1f}\n",
+           model->name, name, trace.frame_count, naive.bytes / frames, naive.transactions / frames,
+           naive.windows / frames, naive.ns / frames / 1000, coalesced.bytes / frames, coalesced.transactions / frames,
+           coalesced.windows / frames, coalesced.ns / frames / 1000, coalesced.model_ns / frames / 1000);
+    if (coalesced.ns > naive.ns) {
+        fprintf(stderr, "%s %s: coalesced windows take %lld ns, drawing each rectangle %lld ns\n", model->name, name,
+                (long long)coalesced.ns, (long long)naive.ns);
+        exit(1);
+    }
+    trace_free(&trace);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < host_model_count; i++) {
+        for (size_t t = 0; t < sizeof(trace_names) / sizeof(trace_names[0]); t++) {
+            bench(&host_models[i], trace_names[t]);
+        }
+    }
+    return 0;
+}
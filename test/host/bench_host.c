@@ -0,0 +1,115 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// The benchmark of test_apps/bench run against the mock panel IO. The host clock runs into simulated time, so the
+// driver's CPU time is measured for real while the bus takes the time its clock gives it.
+//
+//   bench_host [model|pair|all] [pclk_mhz] [iterations]
+//
+// The model defaults to all of them, the clock to the board's. `pair` runs a 35 and a 24 on separate mock IOs at
+// once, each from its own task pinned to core 0 and core 1, and reports the throughput of each and of both; `all`
+// runs every model alone, then the pair. The tasks take turns on the host CPU, so the combined throughput shows how
+// much of the two buses' time overlaps.
+
+#include <string.h>
+#include "bench.h"
+#include "test_host.h"
+
+// Start a panel of `model` on its own mock IO, and the benchmark configuration for it
+static void bench_panel_new(const host_model_t *model, uint32_t pclk_mhz, int iterations, host_model_t *link,
+                            host_panel_t *hp, bench_config_t *config)
+{
+    *link = *model;
+    if (pclk_mhz) {
+        link->io.pclk_hz = pclk_mhz * 1000 * 1000;
+    }
+    // frame memory writes would count as driver CPU time
+    link->io.gram_width = 0;
+    host_panel_new(link, hp);
+    host_panel_start(hp);
+
+    *config = (bench_config_t)BENCH_CONFIG_DEFAULT();
+    config->pclk_hz = link->io.pclk_hz;
+    config->bus_width = link->io.bus_width;
+    config->iterations = iterations;
+    config->run_init = true;
+}
+
+static const host_model_t *find_model(const char *name)
+{
+    for (size_t i = 0; i < host_model_count; i++) {
+        if (!strcmp(name, host_models[i].name)) {
+            return &host_models[i];
+        }
+    }
+    return NULL;
+}
+
+static void bench_model(const host_model_t *model, uint32_t pclk_mhz, int iterations)
+{
+    host_model_t link;
+    host_panel_t hp;
+    bench_config_t config;
+    bench_panel_new(model, pclk_mhz, iterations, &link, &hp, &config);
+    bench_result_t results[BENCH_MAX];
+    size_t count = BENCH_MAX;
+    mock_set_realtime(true);
+    CHECK_OK(bench_run(hp.panel, &config, results, &count));
+    mock_set_realtime(false);
+    bench_print(hp.panel, results, count);
+    host_panel_del(&hp);
+}
+
+// The dual display rig: a 35 and a 24 flushing at once, one per core
+static void bench_pair(uint32_t pclk_mhz, int iterations)
+{
+    const char *const names[2] = { "35", "24" };
+    host_model_t links[2];
+    host_panel_t hps[2];
+    bench_panel_t panels[2];
+    for (int i = 0; i < 2; i++) {
+        panels[i] = (bench_panel_t) {
+            .core = i,
+        };
+        bench_panel_new(find_model(names[i]), pclk_mhz, iterations, &links[i], &hps[i], &panels[i].config);
+        panels[i].panel = hps[i].panel;
+        // the init delays would dilute the flush throughput
+        panels[i].config.run_init = false;
+    }
+    mock_set_realtime(true);
+    CHECK_OK(bench_run_parallel(panels, 2));
+    mock_set_realtime(false);
+    bench_print_parallel(panels, 2);
+    for (int i = 0; i < 2; i++) {
+        host_panel_del(&hps[i]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = argc > 1 ? argv[1] : "all";
+    uint32_t pclk_mhz = argc > 2 ? atoi(argv[2]) : 0;
+    int iterations = argc > 3 ? atoi(argv[3]) : 20;
+    bool all = !strcmp(name, "all");
+    if (all) {
+        for (size_t i = 0; i < host_model_count; i++) {
+            bench_model(&host_models[i], pclk_mhz, iterations);
+        }
+    }
+    if (all || !strcmp(name, "pair")) {
+        bench_pair(pclk_mhz, iterations);
+        return 0;
+    }
+    const host_model_t *model = find_model(name);
+    if (!model) {
+        fprintf(stderr, "unknown model %s\n", name);
+        return 1;
+    }
+    bench_model(model, pclk_mhz, iterations);
+    return 0;
+}
@@ -0,0 +1,124 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Compressed images against drawing them raw: the compression ratio of kinds of full screen image, the decode rate on
+// the host clock with a bus that takes no time, and the time to the panel in simulated time at the model's pixel
+// clock. Prints one JSON object per model and kind; `argv[1]` sets the images drawn per measurement.
+
+#include <string.h>
+#include <time.h>
+#include "esp32s3_4dlcd_pixel.h"
+#include "esp32s3_4dlcd_priv.h"
+#include "test_host.h"
+
+typedef enum {
+    IMAGE_UI,                   // flat panels and bars, the common case for a display like this
+    IMAGE_ICONS,                // a grid of small paletted tiles
+    IMAGE_PHOTO,                // smooth gradients with noise, no palette
+} image_kind_t;
+
+static const char *const image_kind_names[] = { "ui", "icons", "photo" };
+
+static double host_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void image_pixels(image_kind_t kind, int width, int height, uint16_t *pixels)
+{
+    uint32_t seed = 0x4D15;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint16_t *p = &pixels[y * width + x];
+            seed = seed * 1103515245 + 12345;
+            switch (kind) {
+            case IMAGE_UI:
+                *p = y < 32 ? 0x2945 : x < 80 ? 0x4208 : (y / 40) % 2 ? 0xFFFF : 0xEF7D;
+                break;
+            case IMAGE_ICONS:
+                *p = ((x / 32 + y / 32) & 1) ? (uint16_t)(((x & 31) ^ (y & 31)) * 0x0841) : 0x0000;
+                break;
+            case IMAGE_PHOTO:
+                *p = (x * 31 / width) << 11 | (((y * 63 / height) + (seed >> 30)) & 0x3F) << 5 | ((x + y) / 16 & 0x1F);
+                break;
+            }
+        }
+    }
+}
+
+// Seconds to draw `images` times, the compressed image or the raw frame, on the host clock or in simulated time
+static double run(host_panel_t *hp, const uint8_t *image, size_t size, const uint8_t *raw, bool simulated, int images)
+{
+    double start = host_seconds();
+    int64_t start_ns = mock_time_ns();
+    for (int i = 0; i < images; i++) {
+        if (image) {
+            CHECK_OK(esp32s3_4dlcd_draw_image(hp->panel, 0, 0, image, size));
+        } else {
+            CHECK_OK(esp_lcd_panel_draw_bitmap(hp->panel, 0, 0, hp->model->width, hp->model->height, raw));
+        }
+        mock_trace_clear();
+    }
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp->panel));
+    return simulated ? (mock_time_ns() - start_ns) * 1e-9 : host_seconds() - start;
+}
+
+static void bench(const host_model_t *model, image_kind_t kind, int images)
+{
+    size_t pixels_count = (size_t)model->width * model->height;
+    uint16_t *pixels = malloc(pixels_count * sizeof(uint16_t));
+    uint8_t *raw = malloc(pixels_count * 3);
+    CHECK(pixels && raw);
+    image_pixels(kind, model->width, model->height, pixels);
+    size_t size;
+    uint8_t *image = host_image_encode(model->width, model->height, pixels, &size);
+
+    double seconds[2][2];
+    size_t pixel_bytes = 0;
+    for (int simulated = 0; simulated < 2; simulated++) {
+        host_model_t bench_model = *model;
+        bench_model.io.gram_width = 0;
+        if (!simulated) {
+            bench_model.io.pclk_hz = 0;
+        }
+        host_panel_t hp;
+        host_panel_new(&bench_model, &hp);
+        host_panel_start(&hp);
+        pixel_bytes = esp32s3_4dlcd_pixel_bytes(hp.panel);
+        if (pixel_bytes == 3) {
+            esp32s3_4dlcd_rgb565_to_rgb666(raw, pixels, pixels_count);
+        } else {
+            esp32s3_4dlcd_rgb565_to_be(raw, pixels, pixels_count);
+        }
+        seconds[simulated][0] = run(&hp, image, size, raw, simulated, images);
+        seconds[simulated][1] = run(&hp, NULL, 0, raw, simulated, images);
+        host_panel_del(&hp);
+    }
+
+    double mbytes = (double)pixels_count * pixel_bytes * images / 1e6;
+    printf("{\"model\":\"%s\",\"image\":\"%s\",\"raw_bytes\":%zu,\"encoded_bytes\":%zu,\"ratio\":%.2f,"
+           "\"decode_mb_s\":%.1f,\"raw_mb_s\":%.1f,\"decode_bus_fps\":%.1f,\"raw_bus_fps\":%.1f}\n", model->name,
+           image_kind_names[kind], pixels_count * 2, size, (double)pixels_count * 2 / size, mbytes / seconds[0][0],
+           mbytes / seconds[0][1], images / seconds[1][0], images / seconds[1][1]);
+    free(image);
+    free(raw);
+    free(pixels);
+}
+
+int main(int argc, char **argv)
+{
+    int images = argc > 1 ? atoi(argv[1]) : 5;
+    for (size_t i = 0; i < host_model_count; i++) {
+        for (image_kind_t kind = IMAGE_UI; kind <= IMAGE_PHOTO; kind++) {
+            bench(&host_models[i], kind, images);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Software rotation against the naive alternative: rotating the frame pixel by pixel into a second frame buffer and
+// drawing that unrotated. The bus takes no time here, so only the CPU work is timed. Prints one JSON object per
+// model and rotation; `argv[1]` sets the frames drawn per measurement.
+
+#include <string.h>
+#include <time.h>
+#include "esp32s3_4dlcd_priv.h"
+#include "test_host.h"
+
+static double host_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void naive_rotate(uint8_t *dst, const uint8_t *src, esp32s3_4dlcd_rotation_t rotation, int width, int height,
+                         int frame_width, int frame_height, size_t pixel_bytes)
+{
+    for (int fy = 0; fy < frame_height; fy++) {
+        for (int fx = 0; fx < frame_width; fx++) {
+            int px;
+            int py;
+            host_rotate_pixel(rotation, width, height, fx, fy, &px, &py);
+            memcpy(dst + ((size_t)py * width + px) * pixel_bytes, src + ((size_t)fy * frame_width + fx) * pixel_bytes, pixel_bytes);
+        }
+    }
+}
+
+static void bench(const host_model_t *model, esp32s3_4dlcd_rotation_t rotation, int frames)
+{
+    host_model_t fast = *model;
+    fast.io.pclk_hz = 0;
+    fast.io.gram_width = 0;
+    host_panel_t hp;
+    host_panel_new(&fast, &hp);
+    host_panel_start(&hp);
+
+    size_t pixel_bytes = esp32s3_4dlcd_pixel_bytes(hp.panel);
+    size_t frame_bytes = (size_t)model->width * model->height * pixel_bytes;
+    uint8_t *src = malloc(frame_bytes);
+    uint8_t *rotated = malloc(frame_bytes);
+    CHECK(src && rotated);
+    for (size_t i = 0; i < frame_bytes; i++) {
+        src[i] = (uint8_t)(i * 131);
+    }
+    CHECK_OK(esp32s3_4dlcd_set_sw_rotation(hp.panel, rotation));
+    int frame_width;
+    int frame_height;
+    esp32s3_4dlcd_frame_size(hp.panel, &frame_width, &frame_height);
+
+    double start = host_seconds();
+    for (int i = 0; i < frames; i++) {
+        CHECK_OK(esp_lcd_panel_draw_bitmap(hp.panel, 0, 0, frame_width, frame_height, src));
+    }
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    double driver_s = host_seconds() - start;
+
+    CHECK_OK(esp32s3_4dlcd_set_sw_rotation(hp.panel, ESP32S3_4DLCD_ROTATE_0));
+    start = host_seconds();
+    for (int i = 0; i < frames; i++) {
+        naive_rotate(rotated, src, rotation, model->width, model->height, frame_width, frame_height, pixel_bytes);
+        CHECK_OK(esp_lcd_panel_draw_bitmap(hp.panel, 0, 0, model->width, model->height, rotated));
+    }
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    double naive_s = host_seconds() - start;
+
+    double mpixels = (double)model->width * model->height * frames / 1e6;
+    printf("{\"model\":\"%s\",\"rotation\":%d,\"frames\":%d,\"driver_mpix_s\":%.1f,\"naive_mpix_s\":%.1f,"
+           "\"naive_extra_bytes\":%zu}\n", model->name, rotation * 90, frames, mpixels / driver_s, mpixels / naive_s,
+           frame_bytes);
+    free(rotated);
+    free(src);
+    host_panel_del(&hp);
+}
+
+int main(int argc, char **argv)
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 5;
+    for (size_t i = 0; i < host_model_count; i++) {
+        for (int rotation = ESP32S3_4DLCD_ROTATE_90; rotation <= ESP32S3_4DLCD_ROTATE_270; rotation++) {
+            bench(&host_models[i], rotation, frames);
+        }
+    }
+    return 0;
+}
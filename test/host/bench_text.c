@@ -0,0 +1,135 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Text rendering against the per-glyph alternative: blending each character cell pixel by pixel and drawing it as a
+// window of its own. Each is timed twice, on the host clock with a bus that takes no time for the CPU work, and in
+// simulated time at the model's pixel clock for the bus. Prints one JSON object per model and bit depth; `argv[1]`
+// sets the lines drawn per measurement.
+
+#include <string.h>
+#include <time.h>
+#include "esp32s3_4dlcd_pixel.h"
+#include "esp32s3_4dlcd_priv.h"
+#include "test_host.h"
+
+#define FONT_HEIGHT     16
+
+static double host_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void per_glyph_draw(host_panel_t *hp, const esp32s3_4dlcd_font_t *font, int x, int y, const char *str,
+                           uint16_t fg, uint16_t bg, uint8_t *cell)
+{
+    size_t pixel_bytes = esp32s3_4dlcd_pixel_bytes(hp->panel);
+    uint32_t max = (1 << font->bpp) - 1;
+    for (const uint8_t *s = (const uint8_t *)str; *s; s++) {
+        const esp32s3_4dlcd_glyph_t *glyph = host_font_glyph(font, *s);
+        uint8_t *out = cell;
+        for (int row = 0; row < font->height; row++) {
+            for (int col = 0; col < glyph->advance; col++) {
+                uint16_t colour = host_blend565(fg, bg, host_font_alpha(font, glyph, row, col), max);
+                if (pixel_bytes == 3) {
+                    esp32s3_4dlcd_rgb565_to_rgb666(out, &colour, 1);
+                } else {
+                    esp32s3_4dlcd_rgb565_to_be(out, &colour, 1);
+                }
+                out += pixel_bytes;
+            }
+        }
+        CHECK_OK(esp_lcd_panel_draw_bitmap(hp->panel, x, y, x + glyph->advance, y + font->height, cell));
+        x += glyph->advance;
+    }
+}
+
+// Seconds to draw `lines` lines of `str` either way, on the host clock or in simulated time
+static double run(host_panel_t *hp, esp32s3_4dlcd_text_handle_t text, const esp32s3_4dlcd_font_t *font, const char *str,
+                  bool per_glyph, bool simulated, int lines, uint8_t *cell)
+{
+    double start = host_seconds();
+    int64_t start_ns = mock_time_ns();
+    for (int i = 0; i < lines; i++) {
+        // colours alternate so the text renderer rebuilds its table every line, as the worst case
+        uint16_t fg = i & 1 ? 0xFFFF : 0xFFE0;
+        int y = (i * font->height) % (hp->model->height - font->height + 1);
+        if (per_glyph) {
+            per_glyph_draw(hp, font, 0, y, str, fg, 0x0000, cell);
+        } else {
+            CHECK_OK(esp32s3_4dlcd_text_draw(text, 0, y, str, fg, 0x0000, NULL));
+        }
+        mock_trace_clear();
+    }
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp->panel));
+    return simulated ? (mock_time_ns() - start_ns) * 1e-9 : host_seconds() - start;
+}
+
+static void bench(const host_model_t *model, int bpp, int lines)
+{
+    esp32s3_4dlcd_font_t font;
+    host_font_make(bpp, FONT_HEIGHT, &font);
+    // as many characters as fit a line, cycling through the font
+    char str[256];
+    int len = 0;
+    for (int width = 0; len < (int)sizeof(str) - 1; len++) {
+        char c = ' ' + len % font.count;
+        width += host_font_glyph(&font, c)->advance;
+        if (width > model->width) {
+            break;
+        }
+        str[len] = c;
+    }
+    str[len] = '\0';
+    uint8_t *cell = malloc((size_t)9 * FONT_HEIGHT * 3);
+    CHECK(cell);
+
+    double seconds[2][2];
+    for (int simulated = 0; simulated < 2; simulated++) {
+        host_model_t bench_model = *model;
+        bench_model.io.gram_width = 0;
+        if (!simulated) {
+            bench_model.io.pclk_hz = 0;
+        }
+        host_panel_t hp;
+        host_panel_new(&bench_model, &hp);
+        host_panel_start(&hp);
+        esp32s3_4dlcd_text_handle_t text;
+        CHECK_OK(esp32s3_4dlcd_text_new(hp.panel, &font, &text));
+        for (int per_glyph = 0; per_glyph < 2; per_glyph++) {
+            seconds[simulated][per_glyph] = run(&hp, text, &font, str, per_glyph, simulated, lines, cell);
+        }
+        size_t pixel_bytes = esp32s3_4dlcd_pixel_bytes(hp.panel);
+        if (simulated) {
+            int width = esp32s3_4dlcd_text_width(text, str);
+            double glyphs = (double)len * lines;
+            double bytes = (double)width * FONT_HEIGHT * pixel_bytes * lines;
+            printf("{\"model\":\"%s\",\"bpp\":%d,\"glyphs\":%.0f,\"text_glyphs_s\":%.0f,\"text_bytes_s\":%.0f,"
+                   "\"per_glyph_glyphs_s\":%.0f,\"per_glyph_bytes_s\":%.0f,\"text_bus_glyphs_s\":%.0f,"
+                   "\"per_glyph_bus_glyphs_s\":%.0f}\n", model->name, bpp, glyphs, glyphs / seconds[0][0],
+                   bytes / seconds[0][0], glyphs / seconds[0][1], bytes / seconds[0][1], glyphs / seconds[1][0],
+                   glyphs / seconds[1][1]);
+        }
+        CHECK_OK(esp32s3_4dlcd_text_del(text));
+        host_panel_del(&hp);
+    }
+    free(cell);
+    host_font_free(&font);
+}
+
+int main(int argc, char **argv)
+{
+    int lines = argc > 1 ? atoi(argv[1]) : 200;
+    for (size_t i = 0; i < host_model_count; i++) {
+        for (int bpp = 1; bpp <= 4; bpp *= 2) {
+            bench(&host_models[i], bpp, lines);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,215 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file
+ * @brief Host stand-ins for the panel IO, the clock and the bus, used by the host tests and benchmarks
+ *
+ * The driver runs on one thread. Time is simulated: it only passes when the driver waits (a delay, a semaphore, a
+ * full transaction queue, a command behind queued pixels) or, in real time mode, as the host clock runs. Colour
+ * transactions finish when the simulated bus has clocked their bytes out, and their done callback runs then, in
+ * place of the interrupt. GPIO pulses run their ISR handler the same way.
+ *
+ * Tasks created with `xTaskCreatePinnedToCore` are host threads that take turns with the one that started them: one
+ * runs at a time, until it waits, creates a task or notifies one waiting in `ulTaskNotifyTake`, and time only passes
+ * once every task waits. The CPU time of the tasks is therefore not overlapped, the buses of several panel IOs are.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_lcd_panel_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Kind of a recorded event.
+ */
+typedef enum {
+    MOCK_TRACE_PARAM,           /*!< `esp_lcd_panel_io_tx_param` */
+    MOCK_TRACE_COLOR,           /*!< `esp_lcd_panel_io_tx_color` */
+    MOCK_TRACE_READ,            /*!< `esp_lcd_panel_io_rx_param` */
+    MOCK_TRACE_DELAY,           /*!< `vTaskDelay`, in ticks of 1 ms */
+    MOCK_TRACE_GPIO,            /*!< `gpio_set_level` */
+    MOCK_TRACE_GPIO_HOLD,       /*!< `gpio_hold_en` (1) or `gpio_hold_dis` (0) */
+} mock_trace_type_t;
+
+#define MOCK_TRACE_DATA_MAX     32  // parameter bytes kept per command, more than any command the driver sends
+
+/**
+ * @brief One recorded event.
+ */
+typedef struct {
+    mock_trace_type_t type;
+    int lcd_cmd;                /*!< Command as handed to the panel IO, QSPI opcode framing included, -1 for none */
+    size_t bytes;               /*!< Parameter or colour bytes */
+    uint8_t data[MOCK_TRACE_DATA_MAX];  /*!< Parameter bytes, the first `MOCK_TRACE_DATA_MAX` of them */
+    uint32_t hash;              /*!< FNV-1a of the colour bytes */
+    uint32_t value;             /*!< Delay in ticks, or GPIO number */
+    uint32_t level;             /*!< GPIO level */
+    int64_t time_ns;            /*!< Simulated time the event was handed over at */
+    int64_t bus_start_ns;       /*!< Colour transactions: when the bus starts clocking out the first byte */
+    int64_t bus_end_ns;         /*!< Colour transactions: when the bus is done with the last byte */
+} mock_trace_entry_t;
+
+/**
+ * @brief Bus a mock panel IO simulates.
+ */
+typedef struct {
+    uint32_t pclk_hz;           /*!< Bus clock, 0 for a bus that takes no time */
+    uint8_t bus_width;          /*!< Data lines carrying colour data, commands always go out on one */
+    uint8_t cmd_bits;           /*!< Bits of the command phase, 8 for SPI and 32 for QSPI */
+    size_t trans_queue_depth;   /*!< Colour transactions the IO queues before tx_color blocks */
+    int gram_width;             /*!< Columns of the simulated frame memory, 0 for none */
+    int gram_height;            /*!< Rows of the simulated frame memory */
+    size_t gram_pixel_bytes;    /*!< Bytes per pixel written to the frame memory */
+    uint32_t trans_overhead_ns; /*!< Bus time every command and colour transaction costs on top of its bits */
+} mock_io_config_t;
+
+/**
+ * @brief Mock panel IO for a display model: its bus clock, queue depth and frame memory.
+ */
+#define MOCK_IO_CONFIG(pclk_mhz, width, cmd_bits_, depth, gram_w, gram_h, pixel_bytes)   \
+    {                                                                               \
+        .pclk_hz = (pclk_mhz) * 1000 * 1000,                                        \
+        .bus_width = (width),                                                       \
+        .cmd_bits = (cmd_bits_),                                                    \
+        .trans_queue_depth = (depth),                                               \
+        .gram_width = (gram_w),                                                     \
+        .gram_height = (gram_h),                                                    \
+        .gram_pixel_bytes = (pixel_bytes),                                          \
+    }
+
+/**
+ * @brief Create a mock panel IO
+ */
+esp_err_t mock_io_new(const mock_io_config_t *config, esp_lcd_panel_io_handle_t *ret_io);
+
+/**
+ * @brief Delete a mock panel IO, waiting for its queued transactions first
+ */
+void mock_io_del(esp_lcd_panel_io_handle_t io);
+
+/**
+ * @brief Set the bytes `esp_lcd_panel_io_rx_param` returns for `lcd_cmd`, zeros for commands never set
+ */
+void mock_io_set_read(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *data, size_t len);
+
+/**
+ * @brief Pixel at `x`, `y` of the simulated frame memory, in controller addresses, NULL outside it
+ */
+const uint8_t *mock_io_gram(esp_lcd_panel_io_handle_t io, int x, int y);
+
+/**
+ * @brief Colour bytes that fell outside the address window or the frame memory
+ */
+size_t mock_io_gram_overruns(esp_lcd_panel_io_handle_t io);
+
+/**
+ * @brief Colour transactions queued and not finished yet
+ */
+size_t mock_io_in_flight(esp_lcd_panel_io_handle_t io);
+
+/**
+ * @brief Check whether a queued colour transaction of `io` still has to read any of the `len` bytes at `buf`
+ */
+bool mock_io_reading(esp_lcd_panel_io_handle_t io, const void *buf, size_t len);
+
+/**
+ * @brief Make a call of `type` (`MOCK_TRACE_PARAM` or `MOCK_TRACE_COLOR`) fail with `err` once, after `after` more
+ *        calls of that type have gone through. A failed call sends nothing and is not recorded
+ */
+void mock_io_fail(esp_lcd_panel_io_handle_t io, mock_trace_type_t type, size_t after, esp_err_t err);
+
+/**
+ * @brief Drop every recorded event
+ */
+void mock_trace_clear(void);
+
+/**
+ * @brief Number of recorded events
+ */
+size_t mock_trace_count(void);
+
+/**
+ * @brief Recorded event `index`, in order
+ */
+const mock_trace_entry_t *mock_trace_get(size_t index);
+
+/**
+ * @brief Record a delay, for the FreeRTOS stand-ins
+ */
+void mock_trace_delay(uint32_t ticks);
+
+/**
+ * @brief Record a GPIO level or hold change, for the GPIO stand-ins
+ */
+void mock_trace_gpio(mock_trace_type_t type, int gpio_num, uint32_t level);
+
+/**
+ * @brief Write the recorded events as text, one per line, the format of the golden traces
+ */
+void mock_trace_write(FILE *f);
+
+/**
+ * @brief Simulated time in nanoseconds, what `esp_timer_get_time` reports in microseconds
+ */
+int64_t mock_time_ns(void);
+
+/**
+ * @brief Let simulated time pass, finishing every transaction due by then
+ */
+void mock_advance_ns(int64_t ns);
+
+/**
+ * @brief Let the host clock run into simulated time, so driver overhead shows up in `esp_timer_get_time`
+ */
+void mock_set_realtime(bool realtime);
+
+/**
+ * @brief Run every event due by now: finish colour transactions, running their done callbacks, and pulse GPIOs
+ */
+void mock_poll(void);
+
+/**
+ * @brief Pulse a GPIO every `period_ns` from `first_ns` on, running its ISR handler, as a panel TE output does
+ *
+ * @note  One pulse source at a time, a `period_ns` of 0 stops it.
+ */
+void mock_gpio_pulse(int gpio_num, int64_t first_ns, int64_t period_ns);
+
+/**
+ * @brief Let time pass up to the next event, a colour transaction finishing or a GPIO pulse, and run it, if that is by
+ *        `deadline_ns`
+ *
+ * @return False if nothing happens by then, time has then passed up to the deadline unless it is INT64_MAX
+ */
+bool mock_wait_next(int64_t deadline_ns);
+
+/**
+ * @brief Wait as a task: let the other tasks run, or time pass once they all wait, until something the caller may
+ *        be waiting for has happened (a give, a notification, an event) or `deadline_ns` has passed
+ *
+ * @note  Aborts if every task waits without a deadline and no event is pending, which never ends on target either.
+ */
+void mock_task_wait(int64_t deadline_ns);
+
+/**
+ * @brief Wake the waiting tasks to check their condition again
+ */
+void mock_task_wake(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,461 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_panel_interface.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+
+#include "mock.h"
+
+#define TICK_NS     ((int64_t)portTICK_PERIOD_MS * 1000 * 1000)
+// A wait without timeout that sees nothing give the semaphore for this long never returns on target either
+#define DEADLOCK_NS ((int64_t)60 * 1000 * 1000 * 1000)
+
+struct mock_semaphore {
+    UBaseType_t count;
+    UBaseType_t max;
+};
+
+// A task is a thread that only runs while it holds the baton, `s_current`
+typedef struct mock_task {
+    pthread_t thread;
+    pthread_cond_t turn;        // signalled when the task is handed the baton
+    TaskFunction_t code;
+    void *arg;
+    uint32_t notify;
+    bool waiting;
+    bool notify_waiting;        // waiting in ulTaskNotifyTake
+    bool exited;
+    uint32_t wait_gen;          // `s_gen` when the task started waiting
+    int64_t deadline_ns;        // when the task wakes up anyway
+    struct mock_task *next;     // ring of tasks, in creation order
+} mock_task_t;
+
+static pthread_mutex_t s_baton_lock = PTHREAD_MUTEX_INITIALIZER;
+static mock_task_t s_main_task = { .turn = PTHREAD_COND_INITIALIZER, .next = &s_main_task };
+static mock_task_t *s_current = &s_main_task;
+static uint32_t s_gen;          // bumped whenever a waiting task may find what it waits for
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+void esp_error_check_failed(esp_err_t rc, const char *file, int line, const char *expr)
+{
+    fprintf(stderr, "%s:%d: ESP_ERROR_CHECK(%s) failed: %s\n", file, line, expr, esp_err_to_name(rc));
+    abort();
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    (void)caps;
+    return malloc(size);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return calloc(n, size);
+}
+
+void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps)
+{
+    (void)caps;
+    void *p = NULL;
+    return posix_memalign(&p, alignment < sizeof(void *) ? sizeof(void *) : alignment, size) ? NULL : p;
+}
+
+void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
+
+// everything is in internal RAM on the host
+bool esp_ptr_external_ram(const void *p)
+{
+    (void)p;
+    return false;
+}
+
+bool esp_ptr_dma_capable(const void *p)
+{
+    (void)p;
+    return true;
+}
+
+bool esp_ptr_internal(const void *p)
+{
+    (void)p;
+    return true;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return mock_time_ns() / 1000;
+}
+
+void esp_rom_delay_us(uint32_t us)
+{
+    mock_advance_ns((int64_t)us * 1000);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    mock_trace_delay(ticks);
+    int64_t deadline = mock_time_ns() + ticks * TICK_NS;
+    while (mock_time_ns() < deadline) {
+        mock_task_wait(deadline);
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    mock_poll();
+    return (TickType_t)(mock_time_ns() / TICK_NS);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+    SemaphoreHandle_t sem = calloc(1, sizeof(struct mock_semaphore));
+    if (sem) {
+        sem->count = initial_count;
+        sem->max = max_count;
+    }
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    free(sem);
+}
+
+// Another task, a finishing transaction or a GPIO pulse can give the semaphore while the caller waits
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait)
+{
+    bool forever = ticks_to_wait == portMAX_DELAY;
+    int64_t deadline = mock_time_ns() + (forever ? DEADLOCK_NS : ticks_to_wait * TICK_NS);
+    mock_poll();
+    while (!sem->count && mock_time_ns() < deadline) {
+        mock_task_wait(deadline);
+    }
+    if (!sem->count) {
+        if (forever) {
+            fprintf(stderr, "deadlock: waiting forever on a semaphore nothing gives\n");
+            abort();
+        }
+        return pdFALSE;
+    }
+    sem->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem->count == sem->max) {
+        return pdFALSE;
+    }
+    sem->count++;
+    mock_task_wake();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *higher_priority_task_woken)
+{
+    if (higher_priority_task_woken) {
+        *higher_priority_task_woken = pdFALSE;
+    }
+    return xSemaphoreGive(sem);
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t sem)
+{
+    return sem->count;
+}
+
+void mock_task_wake(void)
+{
+    s_gen++;
+}
+
+static bool task_runnable(const mock_task_t *task)
+{
+    return !task->exited && (!task->waiting || task->wait_gen != s_gen || task->deadline_ns <= mock_time_ns());
+}
+
+// Hand the baton from the caller to `task`, and unless the caller has exited, return once it is handed back
+static void task_switch(mock_task_t *self, mock_task_t *task)
+{
+    if (task == self) {
+        return;
+    }
+    pthread_mutex_lock(&s_baton_lock);
+    s_current = task;
+    pthread_cond_signal(&task->turn);
+    while (!self->exited && s_current != self) {
+        pthread_cond_wait(&self->turn, &s_baton_lock);
+    }
+    pthread_mutex_unlock(&s_baton_lock);
+}
+
+// Run the tasks after the caller in turn, the caller last, letting time pass while none of them can run
+static void task_schedule(void)
+{
+    mock_task_t *self = s_current;
+    for (;;) {
+        mock_task_t *task = self->next;
+        for (;;) {
+            if (task_runnable(task)) {
+                task_switch(self, task);
+                return;
+            }
+            if (task == self) {
+                break;
+            }
+            task = task->next;
+        }
+        int64_t deadline = INT64_MAX;
+        task = self;
+        do {
+            if (!task->exited && task->waiting && task->deadline_ns < deadline) {
+                deadline = task->deadline_ns;
+            }
+            task = task->next;
+        } while (task != self);
+        // an event due already is run without time passing, and may be what a task waits for
+        uint32_t gen = s_gen;
+        if (!mock_wait_next(deadline) && deadline == INT64_MAX && gen == s_gen) {
+            fprintf(stderr, "deadlock: every task waits and nothing is pending\n");
+            abort();
+        }
+    }
+}
+
+void mock_task_wait(int64_t deadline_ns)
+{
+    mock_task_t *self = s_current;
+    self->waiting = true;
+    self->wait_gen = s_gen;
+    self->deadline_ns = deadline_ns;
+    task_schedule();
+    self->waiting = false;
+}
+
+static void *task_main(void *arg)
+{
+    mock_task_t *self = arg;
+    pthread_mutex_lock(&s_baton_lock);
+    while (s_current != self) {
+        pthread_cond_wait(&self->turn, &s_baton_lock);
+    }
+    pthread_mutex_unlock(&s_baton_lock);
+    self->code(self->arg);
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task_code, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id)
+{
+    mock_task_t *task = calloc(1, sizeof(mock_task_t));
+    if (!task) {
+        return pdFALSE;
+    }
+    pthread_cond_init(&task->turn, NULL);
+    task->code = task_code;
+    task->arg = arg;
+    task->next = s_current->next;
+    s_current->next = task;
+    if (pthread_create(&task->thread, NULL, task_main, task)) {
+        s_current->next = task->next;
+        free(task);
+        return pdFALSE;
+    }
+    pthread_detach(task->thread);
+    if (created_task) {
+        *created_task = task;
+    }
+    // it runs until it first waits, as on the other core or at a higher priority
+    task_switch(s_current, task);
+    return pdPASS;
+}
+
+// The task stays in the ring, exited, so that handles to it never dangle
+void vTaskDelete(TaskHandle_t task)
+{
+    mock_task_t *self = s_current;
+    if (task && task != self) {
+        fprintf(stderr, "vTaskDelete of another task is not simulated\n");
+        abort();
+    }
+    if (self == &s_main_task) {
+        fprintf(stderr, "vTaskDelete of the main thread\n");
+        abort();
+    }
+    self->exited = true;
+    mock_task_wake();
+    task_schedule();
+    pthread_exit(NULL);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return s_current;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait)
+{
+    mock_task_t *self = s_current;
+    int64_t deadline = ticks_to_wait == portMAX_DELAY ? INT64_MAX : mock_time_ns() + ticks_to_wait * TICK_NS;
+    mock_poll();
+    self->notify_waiting = true;
+    while (!self->notify && mock_time_ns() < deadline) {
+        mock_task_wait(deadline);
+    }
+    self->notify_waiting = false;
+    uint32_t value = self->notify;
+    if (value) {
+        self->notify = clear_count_on_exit ? 0 : value - 1;
+    }
+    return value;
+}
+
+// A task woken from ulTaskNotifyTake runs before the caller goes on, as if it had the higher priority. One blocked on
+// anything else is not woken, and the caller carries on
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    mock_task_t *to = task;
+    to->notify++;
+    mock_task_wake();
+    if (to->notify_waiting) {
+        task_switch(s_current, to);
+    }
+    return pdPASS;
+}
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    return config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num)
+{
+    (void)gpio_num;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    mock_trace_gpio(MOCK_TRACE_GPIO, gpio_num, level);
+    return ESP_OK;
+}
+
+esp_err_t gpio_hold_en(gpio_num_t gpio_num)
+{
+    mock_trace_gpio(MOCK_TRACE_GPIO_HOLD, gpio_num, 1);
+    return ESP_OK;
+}
+
+esp_err_t gpio_hold_dis(gpio_num_t gpio_num)
+{
+    mock_trace_gpio(MOCK_TRACE_GPIO_HOLD, gpio_num, 0);
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_reset(esp_lcd_panel_handle_t panel)
+{
+    return panel->reset(panel);
+}
+
+esp_err_t esp_lcd_panel_init(esp_lcd_panel_handle_t panel)
+{
+    return panel->init(panel);
+}
+
+esp_err_t esp_lcd_panel_del(esp_lcd_panel_handle_t panel)
+{
+    return panel->del(panel);
+}
+
+esp_err_t esp_lcd_panel_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end, const void *color_data)
+{
+    return panel->draw_bitmap(panel, x_start, y_start, x_end, y_end, color_data);
+}
+
+esp_err_t esp_lcd_panel_mirror(esp_lcd_panel_handle_t panel, bool mirror_x, bool mirror_y)
+{
+    return panel->mirror(panel, mirror_x, mirror_y);
+}
+
+esp_err_t esp_lcd_panel_swap_xy(esp_lcd_panel_handle_t panel, bool swap_axes)
+{
+    return panel->swap_xy(panel, swap_axes);
+}
+
+esp_err_t esp_lcd_panel_set_gap(esp_lcd_panel_handle_t panel, int x_gap, int y_gap)
+{
+    return panel->set_gap(panel, x_gap, y_gap);
+}
+
+esp_err_t esp_lcd_panel_invert_color(esp_lcd_panel_handle_t panel, bool invert_color_data)
+{
+    return panel->invert_color(panel, invert_color_data);
+}
+
+esp_err_t esp_lcd_panel_disp_on_off(esp_lcd_panel_handle_t panel, bool on_off)
+{
+    return panel->disp_on_off(panel, on_off);
+}
+
+esp_err_t esp_lcd_panel_disp_sleep(esp_lcd_panel_handle_t panel, bool sleep)
+{
+    return panel->disp_sleep ? panel->disp_sleep(panel, sleep) : ESP_ERR_NOT_SUPPORTED;
+}
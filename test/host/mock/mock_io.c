@@ -0,0 +1,605 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/param.h>
+#include "esp_lcd_panel_commands.h"
+#include "driver/gpio.h"
+
+#include "mock.h"
+
+#define MOCK_IO_MAX             4       // panel IOs alive at once
+#define MOCK_IO_QUEUE_MAX       32      // deeper than any panel IO the driver is configured for
+#define MOCK_IO_READS_MAX       8
+#define MOCK_IO_READ_BYTES      8
+#define MOCK_GPIO_MAX           49
+
+typedef struct {
+    const uint8_t *data;        // read when the transaction finishes, as DMA would
+    size_t len;
+    bool restart;               // RAMWR: the write starts over at the window origin
+    int64_t done_ns;
+} mock_trans_t;
+
+struct esp_lcd_panel_io_t {
+    mock_io_config_t config;
+    esp_lcd_panel_io_color_trans_done_cb_t cb;
+    void *cb_ctx;
+    mock_trans_t queue[MOCK_IO_QUEUE_MAX];  // colour transactions in flight, oldest at head
+    size_t head;
+    size_t count;
+    int64_t bus_free_ns;        // when the bus has clocked out everything queued
+    struct {
+        int lcd_cmd;
+        uint8_t data[MOCK_IO_READ_BYTES];
+        size_t len;
+    } reads[MOCK_IO_READS_MAX];
+    size_t read_count;
+    uint8_t *gram;
+    int x_start;                // address window, inclusive, as CASET/RASET set it
+    int x_end;
+    int y_start;
+    int y_end;
+    int x;                      // next pixel the memory write lands on
+    int y;
+    size_t pixel_fill;          // bytes of a pixel split across transactions
+    size_t overruns;
+    struct {
+        mock_trace_type_t type;
+        size_t after;           // calls of `type` still let through
+        esp_err_t err;          // ESP_OK while no failure is armed
+    } fail;
+};
+
+static esp_lcd_panel_io_handle_t s_ios[MOCK_IO_MAX];
+static mock_trace_entry_t *s_trace;
+static size_t s_trace_count;
+static size_t s_trace_cap;
+static int64_t s_sim_ns;
+static bool s_realtime;
+static int64_t s_host_base_ns;
+static bool s_in_callback;
+static bool s_isr_service;
+static struct {
+    gpio_isr_t handler;
+    void *arg;
+} s_isr[MOCK_GPIO_MAX];
+static struct {
+    int gpio_num;
+    int64_t period_ns;          // 0 while no pulse source runs
+    int64_t next_ns;
+} s_pulse;
+
+static int64_t host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int64_t mock_time_ns(void)
+{
+    return s_sim_ns + (s_realtime ? host_ns() - s_host_base_ns : 0);
+}
+
+void mock_set_realtime(bool realtime)
+{
+    s_sim_ns = mock_time_ns();
+    s_realtime = realtime;
+    s_host_base_ns = host_ns();
+}
+
+static uint32_t fnv1a(const uint8_t *p, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static mock_trace_entry_t *trace_add(mock_trace_type_t type)
+{
+    if (s_trace_count == s_trace_cap) {
+        s_trace_cap = s_trace_cap ? s_trace_cap * 2 : 256;
+        s_trace = realloc(s_trace, s_trace_cap * sizeof(mock_trace_entry_t));
+        if (!s_trace) {
+            abort();
+        }
+    }
+    mock_trace_entry_t *entry = &s_trace[s_trace_count++];
+    memset(entry, 0, sizeof(*entry));
+    entry->type = type;
+    entry->time_ns = mock_time_ns();
+    return entry;
+}
+
+void mock_trace_delay(uint32_t ticks)
+{
+    trace_add(MOCK_TRACE_DELAY)->value = ticks;
+}
+
+void mock_trace_gpio(mock_trace_type_t type, int gpio_num, uint32_t level)
+{
+    mock_trace_entry_t *entry = trace_add(type);
+    entry->value = gpio_num;
+    entry->level = level;
+}
+
+void mock_trace_clear(void)
+{
+    s_trace_count = 0;
+}
+
+size_t mock_trace_count(void)
+{
+    return s_trace_count;
+}
+
+const mock_trace_entry_t *mock_trace_get(size_t index)
+{
+    return index < s_trace_count ? &s_trace[index] : NULL;
+}
+
+static void write_cmd(FILE *f, int lcd_cmd)
+{
+    if (lcd_cmd < 0) {
+        fprintf(f, " --");
+    } else if (lcd_cmd > 0xFF) {
+        fprintf(f, " %08x", (unsigned)lcd_cmd);
+    } else {
+        fprintf(f, " %02x", (unsigned)lcd_cmd);
+    }
+}
+
+void mock_trace_write(FILE *f)
+{
+    for (size_t i = 0; i < s_trace_count; i++) {
+        const mock_trace_entry_t *e = &s_trace[i];
+        switch (e->type) {
+        case MOCK_TRACE_PARAM:
+            fprintf(f, "cmd");
+            write_cmd(f, e->lcd_cmd);
+            for (size_t j = 0; j < MIN(e->bytes, (size_t)MOCK_TRACE_DATA_MAX); j++) {
+                fprintf(f, " %02x", e->data[j]);
+            }
+            break;
+        case MOCK_TRACE_COLOR:
+            fprintf(f, "color");
+            write_cmd(f, e->lcd_cmd);
+            fprintf(f, " %zu %08x", e->bytes, (unsigned)e->hash);
+            break;
+        case MOCK_TRACE_READ:
+            fprintf(f, "read");
+            write_cmd(f, e->lcd_cmd);
+            fprintf(f, " %zu", e->bytes);
+            break;
+        case MOCK_TRACE_DELAY:
+            fprintf(f, "delay %u", (unsigned)e->value);
+            break;
+        case MOCK_TRACE_GPIO:
+            fprintf(f, "gpio %u %u", (unsigned)e->value, (unsigned)e->level);
+            break;
+        case MOCK_TRACE_GPIO_HOLD:
+            fprintf(f, "hold %u %u", (unsigned)e->value, (unsigned)e->level);
+            break;
+        }
+        fprintf(f, "\n");
+    }
+}
+
+// The controller command without the QSPI opcode framing
+static int plain_cmd(esp_lcd_panel_io_handle_t io, int lcd_cmd)
+{
+    if (lcd_cmd < 0 || io->config.cmd_bits != 32) {
+        return lcd_cmd;
+    }
+    return (lcd_cmd >> 8) & 0xFF;
+}
+
+static void gram_write(esp_lcd_panel_io_handle_t io, const mock_trans_t *t)
+{
+    if (!io->gram) {
+        return;
+    }
+    size_t pixel_bytes = io->config.gram_pixel_bytes;
+    if (t->restart) {
+        io->x = io->x_start;
+        io->y = io->y_start;
+        io->pixel_fill = 0;
+    }
+    for (size_t i = 0; i < t->len; i++) {
+        if (io->y > io->y_end || io->x >= io->config.gram_width || io->y >= io->config.gram_height) {
+            io->overruns++;
+            continue;
+        }
+        io->gram[((size_t)io->y * io->config.gram_width + io->x) * pixel_bytes + io->pixel_fill] = t->data[i];
+        if (++io->pixel_fill == pixel_bytes) {
+            io->pixel_fill = 0;
+            if (++io->x > io->x_end) {
+                io->x = io->x_start;
+                io->y++;
+            }
+        }
+    }
+}
+
+// Finish the oldest colour transaction of `io`
+static void finish_one(esp_lcd_panel_io_handle_t io)
+{
+    mock_trans_t t = io->queue[io->head];
+    io->head = (io->head + 1) % MOCK_IO_QUEUE_MAX;
+    io->count--;
+    gram_write(io, &t);
+    if (io->cb) {
+        esp_lcd_panel_io_event_data_t edata = { 0 };
+        s_in_callback = true;
+        io->cb(io, &edata, io->cb_ctx);
+        s_in_callback = false;
+    }
+}
+
+// The panel IO whose next transaction finishes first, NULL if none is queued
+static esp_lcd_panel_io_handle_t next_due(void)
+{
+    esp_lcd_panel_io_handle_t next = NULL;
+    for (int i = 0; i < MOCK_IO_MAX; i++) {
+        esp_lcd_panel_io_handle_t io = s_ios[i];
+        if (io && io->count && (!next || io->queue[io->head].done_ns < next->queue[next->head].done_ns)) {
+            next = io;
+        }
+    }
+    return next;
+}
+
+// The next event: a colour transaction of `*io` finishing, or a GPIO pulse with `*io` NULL. False if none is pending
+static bool next_event(int64_t *due_ns, esp_lcd_panel_io_handle_t *io)
+{
+    *io = next_due();
+    if (*io && (!s_pulse.period_ns || (*io)->queue[(*io)->head].done_ns <= s_pulse.next_ns)) {
+        *due_ns = (*io)->queue[(*io)->head].done_ns;
+        return true;
+    }
+    *io = NULL;
+    *due_ns = s_pulse.next_ns;
+    return s_pulse.period_ns != 0;
+}
+
+static void run_event(esp_lcd_panel_io_handle_t io)
+{
+    mock_task_wake();
+    if (io) {
+        finish_one(io);
+        return;
+    }
+    s_pulse.next_ns += s_pulse.period_ns;
+    if (s_isr[s_pulse.gpio_num].handler) {
+        s_in_callback = true;
+        s_isr[s_pulse.gpio_num].handler(s_isr[s_pulse.gpio_num].arg);
+        s_in_callback = false;
+    }
+}
+
+void mock_poll(void)
+{
+    if (s_in_callback) {
+        return;
+    }
+    int64_t due;
+    esp_lcd_panel_io_handle_t io;
+    while (next_event(&due, &io) && due <= mock_time_ns()) {
+        run_event(io);
+    }
+}
+
+bool mock_wait_next(int64_t deadline_ns)
+{
+    mock_poll();
+    int64_t due;
+    esp_lcd_panel_io_handle_t io;
+    int64_t now = mock_time_ns();
+    if (!next_event(&due, &io) || due > deadline_ns) {
+        if (deadline_ns != INT64_MAX && deadline_ns > now) {
+            s_sim_ns += deadline_ns - now;
+        }
+        mock_poll();
+        return false;
+    }
+    if (due > now) {
+        s_sim_ns += due - now;
+    }
+    run_event(io);
+    return true;
+}
+
+void mock_advance_ns(int64_t ns)
+{
+    int64_t deadline = mock_time_ns() + ns;
+    while (mock_wait_next(deadline)) {
+    }
+}
+
+void mock_gpio_pulse(int gpio_num, int64_t first_ns, int64_t period_ns)
+{
+    if (gpio_num < 0 || gpio_num >= MOCK_GPIO_MAX || period_ns < 0) {
+        abort();
+    }
+    s_pulse.gpio_num = gpio_num;
+    s_pulse.period_ns = period_ns;
+    s_pulse.next_ns = first_ns;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    if (s_isr_service) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_isr_service = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args)
+{
+    if (!s_isr_service) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (gpio_num < 0 || gpio_num >= MOCK_GPIO_MAX || !isr_handler) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_isr[gpio_num].handler = isr_handler;
+    s_isr[gpio_num].arg = args;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+{
+    if (gpio_num < 0 || gpio_num >= MOCK_GPIO_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_isr[gpio_num].handler = NULL;
+    return ESP_OK;
+}
+
+// Wait for every colour transaction of `io`, as the panel IO does before a command
+static void drain(esp_lcd_panel_io_handle_t io)
+{
+    while (io->count) {
+        mock_task_wait(INT64_MAX);
+    }
+}
+
+// Time `bits` take on `lines` data lines of the bus
+static int64_t bus_ns(esp_lcd_panel_io_handle_t io, uint64_t bits, int lines)
+{
+    if (!io->config.pclk_hz) {
+        return 0;
+    }
+    return (int64_t)(bits * 1000000000ULL / ((uint64_t)io->config.pclk_hz * lines));
+}
+
+esp_err_t mock_io_new(const mock_io_config_t *config, esp_lcd_panel_io_handle_t *ret_io)
+{
+    if (!config || !ret_io || config->trans_queue_depth > MOCK_IO_QUEUE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int slot = 0;
+    while (slot < MOCK_IO_MAX && s_ios[slot]) {
+        slot++;
+    }
+    if (slot == MOCK_IO_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_lcd_panel_io_handle_t io = calloc(1, sizeof(struct esp_lcd_panel_io_t));
+    if (!io) {
+        return ESP_ERR_NO_MEM;
+    }
+    io->config = *config;
+    if (!io->config.bus_width) {
+        io->config.bus_width = 1;
+    }
+    if (!io->config.trans_queue_depth) {
+        io->config.trans_queue_depth = 1;
+    }
+    if (config->gram_width && config->gram_height) {
+        io->gram = calloc((size_t)config->gram_width * config->gram_height, config->gram_pixel_bytes);
+        if (!io->gram) {
+            free(io);
+            return ESP_ERR_NO_MEM;
+        }
+        io->x_end = config->gram_width - 1;
+        io->y_end = config->gram_height - 1;
+    }
+    s_ios[slot] = io;
+    *ret_io = io;
+    return ESP_OK;
+}
+
+void mock_io_del(esp_lcd_panel_io_handle_t io)
+{
+    drain(io);
+    for (int i = 0; i < MOCK_IO_MAX; i++) {
+        if (s_ios[i] == io) {
+            s_ios[i] = NULL;
+        }
+    }
+    free(io->gram);
+    free(io);
+}
+
+void mock_io_set_read(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *data, size_t len)
+{
+    size_t i = 0;
+    while (i < io->read_count && io->reads[i].lcd_cmd != lcd_cmd) {
+        i++;
+    }
+    if (i == MOCK_IO_READS_MAX || len > MOCK_IO_READ_BYTES) {
+        abort();
+    }
+    io->read_count = MAX(io->read_count, i + 1);
+    io->reads[i].lcd_cmd = lcd_cmd;
+    io->reads[i].len = len;
+    memcpy(io->reads[i].data, data, len);
+}
+
+const uint8_t *mock_io_gram(esp_lcd_panel_io_handle_t io, int x, int y)
+{
+    if (!io->gram || x < 0 || y < 0 || x >= io->config.gram_width || y >= io->config.gram_height) {
+        return NULL;
+    }
+    return io->gram + ((size_t)y * io->config.gram_width + x) * io->config.gram_pixel_bytes;
+}
+
+size_t mock_io_gram_overruns(esp_lcd_panel_io_handle_t io)
+{
+    return io->overruns;
+}
+
+size_t mock_io_in_flight(esp_lcd_panel_io_handle_t io)
+{
+    mock_poll();
+    return io->count;
+}
+
+bool mock_io_reading(esp_lcd_panel_io_handle_t io, const void *buf, size_t len)
+{
+    mock_poll();
+    const uint8_t *start = buf;
+    for (size_t i = 0; i < io->count; i++) {
+        const mock_trans_t *t = &io->queue[(io->head + i) % MOCK_IO_QUEUE_MAX];
+        if (t->data < start + len && start < t->data + t->len) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void mock_io_fail(esp_lcd_panel_io_handle_t io, mock_trace_type_t type, size_t after, esp_err_t err)
+{
+    io->fail.type = type;
+    io->fail.after = after;
+    io->fail.err = err;
+}
+
+// The armed failure, if this call of `type` is the one to fail
+static esp_err_t injected_error(esp_lcd_panel_io_handle_t io, mock_trace_type_t type)
+{
+    if (io->fail.err == ESP_OK || io->fail.type != type) {
+        return ESP_OK;
+    }
+    if (io->fail.after) {
+        io->fail.after--;
+        return ESP_OK;
+    }
+    esp_err_t err = io->fail.err;
+    io->fail.err = ESP_OK;
+    return err;
+}
+
+esp_err_t esp_lcd_panel_io_tx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *param, size_t param_size)
+{
+    if (!io || (param_size && !param)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = injected_error(io, MOCK_TRACE_PARAM);
+    if (err != ESP_OK) {
+        return err;
+    }
+    drain(io);
+    mock_trace_entry_t *entry = trace_add(MOCK_TRACE_PARAM);
+    entry->lcd_cmd = lcd_cmd;
+    entry->bytes = param_size;
+    memcpy(entry->data, param, MIN(param_size, (size_t)MOCK_TRACE_DATA_MAX));
+
+    const uint8_t *p = param;
+    int cmd = plain_cmd(io, lcd_cmd);
+    if ((cmd == LCD_CMD_CASET || cmd == LCD_CMD_RASET) && param_size == 4) {
+        int start = (p[0] << 8) | p[1];
+        int end = (p[2] << 8) | p[3];
+        if (cmd == LCD_CMD_CASET) {
+            io->x_start = start;
+            io->x_end = end;
+        } else {
+            io->y_start = start;
+            io->y_end = end;
+        }
+    }
+    // commands are polled, the caller waits for them to leave the bus
+    s_sim_ns += io->config.trans_overhead_ns + bus_ns(io, io->config.cmd_bits + (uint64_t)param_size * 8, 1);
+    mock_poll();
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_tx_color(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *color, size_t color_size)
+{
+    if (!io || !color || !color_size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = injected_error(io, MOCK_TRACE_COLOR);
+    if (err != ESP_OK) {
+        return err;
+    }
+    mock_poll();
+    if (lcd_cmd >= 0) {
+        // the command phase is polled, behind whatever is still queued
+        drain(io);
+        s_sim_ns += bus_ns(io, io->config.cmd_bits, 1);
+    }
+    while (io->count == io->config.trans_queue_depth) {
+        mock_task_wait(INT64_MAX);
+    }
+    mock_trace_entry_t *entry = trace_add(MOCK_TRACE_COLOR);
+    entry->lcd_cmd = lcd_cmd;
+    entry->bytes = color_size;
+    entry->hash = fnv1a(color, color_size);
+
+    int64_t start = MAX(mock_time_ns(), io->bus_free_ns);
+    io->bus_free_ns = start + io->config.trans_overhead_ns + bus_ns(io, (uint64_t)color_size * 8, io->config.bus_width);
+    entry->bus_start_ns = start;
+    entry->bus_end_ns = io->bus_free_ns;
+    mock_trans_t *t = &io->queue[(io->head + io->count) % MOCK_IO_QUEUE_MAX];
+    *t = (mock_trans_t) {
+        .data = color,
+        .len = color_size,
+        .restart = plain_cmd(io, lcd_cmd) == LCD_CMD_RAMWR,
+        .done_ns = io->bus_free_ns,
+    };
+    io->count++;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_rx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, void *param, size_t param_size)
+{
+    if (!io || (param_size && !param)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    drain(io);
+    mock_trace_entry_t *entry = trace_add(MOCK_TRACE_READ);
+    entry->lcd_cmd = lcd_cmd;
+    entry->bytes = param_size;
+    memset(param, 0, param_size);
+    for (size_t i = 0; i < io->read_count; i++) {
+        if (io->reads[i].lcd_cmd == lcd_cmd) {
+            memcpy(param, io->reads[i].data, MIN(param_size, io->reads[i].len));
+        }
+    }
+    s_sim_ns += bus_ns(io, io->config.cmd_bits + (uint64_t)param_size * 8, 1);
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_register_event_callbacks(esp_lcd_panel_io_handle_t io, const esp_lcd_panel_io_callbacks_t *cbs, void *user_ctx)
+{
+    if (!io || !cbs) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    io->cb = cbs->on_color_trans_done;
+    io->cb_ctx = user_ctx;
+    return ESP_OK;
+}
@@ -0,0 +1,29 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Host stand-in for the ESP-IDF header of the same name: only what the driver uses
+
+#pragma once
+
+#include "esp_lcd_types.h"
+
+struct esp_lcd_panel_t {
+    esp_err_t (*reset)(struct esp_lcd_panel_t *panel);
+    esp_err_t (*init)(struct esp_lcd_panel_t *panel);
+    esp_err_t (*draw_bitmap)(struct esp_lcd_panel_t *panel, int x_start, int y_start, int x_end, int y_end, const void *color_data);
+    esp_err_t (*mirror)(struct esp_lcd_panel_t *panel, bool x_axis, bool y_axis);
+    esp_err_t (*swap_xy)(struct esp_lcd_panel_t *panel, bool swap_axes);
+    esp_err_t (*set_gap)(struct esp_lcd_panel_t *panel, int x_gap, int y_gap);
+    esp_err_t (*invert_color)(struct esp_lcd_panel_t *panel, bool invert_color_data);
+    esp_err_t (*disp_on_off)(struct esp_lcd_panel_t *panel, bool on_off);
+    esp_err_t (*disp_sleep)(struct esp_lcd_panel_t *panel, bool sleep);
+    esp_err_t (*del)(struct esp_lcd_panel_t *panel);
+    void *user_data;
+};
+
+typedef struct esp_lcd_panel_t esp_lcd_panel_t;
@@ -0,0 +1,32 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Host stand-in for the ESP-IDF header of the same name: only what the driver uses
+
+#pragma once
+
+#include "esp_lcd_types.h"
+
+typedef struct {
+    uint32_t pclk_hz;
+    uint32_t h_res;
+    uint32_t v_res;
+    uint32_t hsync_pulse_width;
+    uint32_t hsync_back_porch;
+    uint32_t hsync_front_porch;
+    uint32_t vsync_pulse_width;
+    uint32_t vsync_back_porch;
+    uint32_t vsync_front_porch;
+    struct {
+        uint32_t hsync_idle_low: 1;
+        uint32_t vsync_idle_low: 1;
+        uint32_t de_idle_high: 1;
+        uint32_t pclk_active_neg: 1;
+        uint32_t pclk_idle_high: 1;
+    } flags;
+} esp_lcd_rgb_timing_t;
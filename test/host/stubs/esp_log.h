@@ -0,0 +1,21 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Host stand-in for the ESP-IDF header of the same name: only what the driver uses
+
+#pragma once
+
+#include <stdio.h>
+#include "esp_err.h"
+
+// errors are worth seeing in a failing test, the rest is noise
+#define ESP_LOGE(tag, format, ...)  fprintf(stderr, "E %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)  ((void)(tag))
+#define ESP_LOGI(tag, format, ...)  ((void)(tag))
+#define ESP_LOGD(tag, format, ...)  ((void)(tag))
+#define ESP_LOGV(tag, format, ...)  ((void)(tag))
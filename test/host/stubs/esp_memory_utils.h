@@ -0,0 +1,17 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Host stand-in for the ESP-IDF header of the same name: only what the driver uses
+
+#pragma once
+
+#include <stdbool.h>
+
+bool esp_ptr_external_ram(const void *p);
+bool esp_ptr_dma_capable(const void *p);
+bool esp_ptr_internal(const void *p);
@@ -0,0 +1,29 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Host stand-in for the generated sdkconfig.h: the Kconfig defaults, which a build variant may override
+
+#pragma once
+
+// the model only picks the menuconfig default, the tests choose theirs through the vendor config
+#if !defined(CONFIG_ESP32S3_4DLCD_24) && !defined(CONFIG_ESP32S3_4DLCD_28) && !defined(CONFIG_ESP32S3_4DLCD_32) && \
+    !defined(CONFIG_ESP32S3_4DLCD_35) && !defined(CONFIG_ESP32S3_4DLCD_43Q)
+#define CONFIG_ESP32S3_4DLCD_35 1
+#endif
+#if defined(CONFIG_ESP32S3_4DLCD_43Q)
+#define CONFIG_LCD_INTERFACE_QSPI 1
+#else
+#define CONFIG_LCD_INTERFACE_SPI 1
+#endif
+
+#ifndef CONFIG_ESP32S3_4DLCD_CHUNK_BUF_SIZE
+#define CONFIG_ESP32S3_4DLCD_CHUNK_BUF_SIZE 7680
+#endif
+#ifndef CONFIG_ESP32S3_4DLCD_CHUNK_BUF_COUNT
+#define CONFIG_ESP32S3_4DLCD_CHUNK_BUF_COUNT 2
+#endif
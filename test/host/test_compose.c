@@ -0,0 +1,214 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Composed windows: opaque, transparent and half transparent layers of every format, layers cut at the window edges,
+// black where no layer reaches, and the result in the panel format, big endian RGB565 or RGB666
+
+#include <string.h>
+#include <stdint.h>
+#include "esp32s3_4dlcd_priv.h"
+#include "test_host.h"
+
+#define BACKGROUND  0x001F      // what the screen is filled with before composing, blue
+
+static uint32_t rgb565_to_rgb888(uint16_t c)
+{
+    uint32_t r = (c >> 11) & 0x1F;
+    uint32_t g = (c >> 5) & 0x3F;
+    uint32_t b = c & 0x1F;
+    return ((r << 3 | r >> 2) << 16) | ((g << 2 | g >> 4) << 8) | (b << 3 | b >> 2);
+}
+
+// Colour and alpha (0..255) of a layer pixel
+static uint32_t layer_pixel(const esp32s3_4dlcd_layer_t *layer, int lx, int ly, uint32_t *alpha)
+{
+    const uint8_t *row = (const uint8_t *)layer->data + ly * layer->stride;
+    switch (layer->format) {
+    case ESP32S3_4DLCD_LAYER_RGB565:
+        *alpha = 255;
+        return rgb565_to_rgb888(((const uint16_t *)row)[lx]);
+    case ESP32S3_4DLCD_LAYER_ARGB8888: {
+        uint32_t c = ((const uint32_t *)row)[lx];
+        *alpha = c >> 24;
+        return c & 0xFFFFFF;
+    }
+    default: {
+        uint16_t c = ((const uint16_t *)row)[lx];
+        *alpha = (c >> 12) * 0x11;
+        return ((c >> 8) & 0xF) * 0x110000 | ((c >> 4) & 0xF) * 0x1100 | (c & 0xF) * 0x11;
+    }
+    }
+}
+
+// What the window should show at x, y, blended in real numbers. `blended` if any layer was neither opaque nor
+// transparent there, so the driver's rounding may differ
+static uint32_t reference(const esp32s3_4dlcd_layer_t *layers, int layer_count, int x, int y, bool *blended)
+{
+    double out[3] = { 0 };
+    *blended = false;
+    for (int i = 0; i < layer_count; i++) {
+        const esp32s3_4dlcd_layer_t *layer = &layers[i];
+        if (x < layer->x || x >= layer->x + layer->width || y < layer->y || y >= layer->y + layer->height) {
+            continue;
+        }
+        uint32_t alpha;
+        uint32_t c = layer_pixel(layer, x - layer->x, y - layer->y, &alpha);
+        double a = alpha / 255.0 * layer->opacity / 255.0;
+        *blended |= a > 0 && a < 1;
+        for (int ch = 0; ch < 3; ch++) {
+            double src = (c >> (16 - ch * 8)) & 0xFF;
+            out[ch] += (src - out[ch]) * a;
+        }
+    }
+    return (uint32_t)(out[0] + 0.5) << 16 | (uint32_t)(out[1] + 0.5) << 8 | (uint32_t)(out[2] + 0.5);
+}
+
+// Check the panel shows the RGB888 colour at x, y in its own precision, give or take `tolerance` steps of it
+static void check_pixel(host_panel_t *hp, int x, int y, uint32_t color, int tolerance, int line)
+{
+    const uint8_t *p = mock_io_gram(hp->io, x, y);
+    int got[3];
+    int want[3];
+    if (esp32s3_4dlcd_pixel_bytes(hp->panel) == 3) {
+        for (int ch = 0; ch < 3; ch++) {
+            got[ch] = p[ch] >> 2;
+            want[ch] = ((color >> (16 - ch * 8)) & 0xFF) >> 2;
+        }
+    } else {
+        uint16_t v = p[0] << 8 | p[1];
+        got[0] = v >> 11;
+        got[1] = (v >> 5) & 0x3F;
+        got[2] = v & 0x1F;
+        want[0] = (color >> 19) & 0x1F;
+        want[1] = (color >> 10) & 0x3F;
+        want[2] = (color >> 3) & 0x1F;
+    }
+    for (int ch = 0; ch < 3; ch++) {
+        if (abs(got[ch] - want[ch]) > tolerance) {
+            fprintf(stderr, "line %d: %s pixel %d,%d is %d,%d,%d, expected %d,%d,%d\n", line, hp->model->name, x, y,
+                    got[0], got[1], got[2], want[0], want[1], want[2]);
+            exit(1);
+        }
+    }
+}
+
+// Compose the window and check every pixel of it against the reference, and the ring of pixels around it untouched
+static void check_compose(host_panel_t *hp, int x_start, int y_start, int x_end, int y_end,
+                          const esp32s3_4dlcd_layer_t *layers, int layer_count)
+{
+    CHECK_OK(esp32s3_4dlcd_compose(hp->panel, x_start, y_start, x_end, y_end, layers, layer_count));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp->panel));
+    uint32_t background = rgb565_to_rgb888(BACKGROUND);
+    for (int y = y_start - 1; y <= y_end; y++) {
+        for (int x = x_start - 1; x <= x_end; x++) {
+            if (x < x_start || x >= x_end || y < y_start || y >= y_end) {
+                check_pixel(hp, x, y, background, 0, __LINE__);
+                continue;
+            }
+            bool blended;
+            uint32_t color = reference(layers, layer_count, x, y, &blended);
+            check_pixel(hp, x, y, color, blended ? 1 : 0, __LINE__);
+        }
+    }
+}
+
+static void test_compose(const host_model_t *model)
+{
+    host_panel_t hp;
+    host_panel_new(model, &hp);
+    host_panel_start(&hp);
+    size_t pixel_bytes = esp32s3_4dlcd_pixel_bytes(hp.panel);
+    CHECK_OK(esp32s3_4dlcd_fill_rect(hp.panel, 0, 0, model->width, model->height, BACKGROUND));
+
+    // a row of known pixels: white under transparent red, opaque red, half black, white the overlay does not reach
+    // and black no layer reaches
+    static const uint16_t white[4] = { 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF };
+    static const uint32_t overlay[3] = { 0x00FF0000, 0xFFFF0000, 0x80000000 };
+    esp32s3_4dlcd_layer_t known[] = {
+        { ESP32S3_4DLCD_LAYER_RGB565, white, sizeof(white), 10, 200, 4, 1, 255 },
+        { ESP32S3_4DLCD_LAYER_ARGB8888, overlay, sizeof(overlay), 10, 200, 3, 1, 255 },
+    };
+    CHECK_OK(esp32s3_4dlcd_compose(hp.panel, 10, 200, 15, 201, known, 2));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    static const uint8_t rgb565[5][2] = { { 0xFF, 0xFF }, { 0xF8, 0x00 }, { 0x7B, 0xEF }, { 0xFF, 0xFF }, { 0x00, 0x00 } };
+    static const uint8_t rgb666[5][3] = {
+        { 0xFC, 0xFC, 0xFC }, { 0xFC, 0x00, 0x00 }, { 0x7C, 0x7C, 0x7C }, { 0xFC, 0xFC, 0xFC }, { 0x00, 0x00, 0x00 },
+    };
+    for (int i = 0; i < 5; i++) {
+        CHECK(!memcmp(mock_io_gram(hp.io, 10 + i, 200), pixel_bytes == 3 ? rgb666[i] : rgb565[i], pixel_bytes));
+    }
+
+    // an RGB565 background, an ARGB8888 layer cut at the left and top of the window with transparent and half
+    // transparent parts, an ARGB4444 layer cut at the right and bottom, and a half opacity RGB565 layer over them.
+    // Rows are padded so the strides differ from the widths
+    enum { BG_W = 60, BG_H = 40, HUD_W = 40, HUD_H = 30, ICON_W = 40, ICON_H = 30, PAD = 3 };
+    static uint16_t bg[BG_H][BG_W + PAD];
+    static uint32_t hud[HUD_H][HUD_W + PAD];
+    static uint16_t icon[ICON_H][ICON_W + PAD];
+    for (int y = 0; y < BG_H; y++) {
+        for (int x = 0; x < BG_W; x++) {
+            bg[y][x] = (uint16_t)(x * 0x0841 + y * 0x2020);
+        }
+    }
+    for (int y = 0; y < HUD_H; y++) {
+        for (int x = 0; x < HUD_W; x++) {
+            uint32_t alpha = x < 5 ? 0x00 : y >= 20 ? 0x80 : 0xFF;
+            hud[y][x] = alpha << 24 | (uint32_t)(x * 6) << 16 | (uint32_t)(y * 8) << 8 | 0x40;
+        }
+    }
+    for (int y = 0; y < ICON_H; y++) {
+        for (int x = 0; x < ICON_W; x++) {
+            icon[y][x] = (uint16_t)((y < 10 ? 0xF000 : y < 20 ? 0x8000 : 0x0000) | (x & 0xF) << 8 | (y & 0xF) << 4 | 0x9);
+        }
+    }
+    esp32s3_4dlcd_layer_t layers[] = {
+        { ESP32S3_4DLCD_LAYER_RGB565, bg, sizeof(bg[0]), 30, 40, BG_W, BG_H, 255 },
+        { ESP32S3_4DLCD_LAYER_ARGB8888, hud, sizeof(hud[0]), 10, 20, HUD_W, HUD_H, 255 },
+        { ESP32S3_4DLCD_LAYER_ARGB4444, icon, sizeof(icon[0]), 100, 80, ICON_W, ICON_H, 255 },
+        { ESP32S3_4DLCD_LAYER_RGB565, bg, sizeof(bg[0]), 70, 35, BG_W, 20, 128 },
+    };
+    check_compose(&hp, 20, 30, 120, 90, layers, 4);
+
+    // through transfers of 1000 bytes, several rows to a chunk
+    CHECK_OK(esp32s3_4dlcd_set_max_transfer(hp.panel, 1000));
+    check_compose(&hp, 25, 100, 125, 140, (esp32s3_4dlcd_layer_t[]) {
+        { ESP32S3_4DLCD_LAYER_ARGB8888, hud, sizeof(hud[0]), 15, 95, HUD_W, HUD_H, 200 },
+        { ESP32S3_4DLCD_LAYER_ARGB4444, icon, sizeof(icon[0]), 100, 120, ICON_W, ICON_H, 255 },
+    }, 2);
+
+    // a layer at zero opacity or size changes nothing, and no layers at all is a black window
+    esp32s3_4dlcd_layer_t hidden[] = {
+        { ESP32S3_4DLCD_LAYER_RGB565, bg, sizeof(bg[0]), 150, 150, BG_W, BG_H, 0 },
+        { ESP32S3_4DLCD_LAYER_RGB565, bg, sizeof(bg[0]), 150, 150, 0, 0, 255 },
+    };
+    check_compose(&hp, 150, 150, 180, 170, hidden, 2);
+    check_compose(&hp, 150, 180, 180, 190, NULL, 0);
+
+    // refused before anything is sent
+    mock_trace_clear();
+    esp32s3_4dlcd_layer_t bad = layers[0];
+    bad.data = NULL;
+    CHECK_ERR(esp32s3_4dlcd_compose(hp.panel, 0, 0, 10, 10, &bad, 1), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_compose(hp.panel, 0, 0, 10, 10, layers, ESP32S3_4DLCD_COMPOSE_MAX_LAYERS + 1),
+              ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_compose(hp.panel, 0, 0, 10, 10, NULL, 1), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_compose(hp.panel, 10, 0, 10, 10, layers, 1), ESP_ERR_INVALID_ARG);
+    CHECK(mock_trace_count() == 0);
+
+    CHECK(mock_io_gram_overruns(hp.io) == 0);
+    host_panel_del(&hp);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < host_model_count; i++) {
+        test_compose(&host_models[i]);
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,175 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Solid and pattern fills: the window they open, the memory write split into RAMWR and RAMWRC chunks no larger than a
+// transfer, the pixels in the panel format, the tile phase carried across chunk boundaries, and the calls that fail
+
+#include <string.h>
+#include "esp32s3_4dlcd_pixel.h"
+#include "esp32s3_4dlcd_priv.h"
+#include "test_host.h"
+
+// Panel command of a recorded event, without the QSPI opcode framing
+static int plain_cmd(const host_model_t *model, int lcd_cmd)
+{
+    return model->io.cmd_bits == 32 && lcd_cmd >= 0 ? (lcd_cmd >> 8) & 0xFF : lcd_cmd;
+}
+
+// Check the events recorded since the last call are one window, then a memory write of `bytes` in chunks of `cap`
+// bytes, RAMWR first and RAMWRC after, and drop them
+static void check_stream(host_panel_t *hp, int x_start, int y_start, int x_end, int y_end, size_t cap)
+{
+    size_t bytes = (size_t)(x_end - x_start) * (y_end - y_start) * esp32s3_4dlcd_pixel_bytes(hp->panel);
+    CHECK(mock_trace_count() >= 3);
+    const mock_trace_entry_t *caset = mock_trace_get(0);
+    const mock_trace_entry_t *raset = mock_trace_get(1);
+    CHECK(caset->type == MOCK_TRACE_PARAM && plain_cmd(hp->model, caset->lcd_cmd) == 0x2A);
+    CHECK((caset->data[0] << 8 | caset->data[1]) == x_start && (caset->data[2] << 8 | caset->data[3]) == x_end - 1);
+    CHECK(raset->type == MOCK_TRACE_PARAM && plain_cmd(hp->model, raset->lcd_cmd) == 0x2B);
+    CHECK((raset->data[0] << 8 | raset->data[1]) == y_start && (raset->data[2] << 8 | raset->data[3]) == y_end - 1);
+
+    size_t sent = 0;
+    size_t i = 2;
+    for (; i < mock_trace_count() && mock_trace_get(i)->type == MOCK_TRACE_COLOR; i++) {
+        const mock_trace_entry_t *e = mock_trace_get(i);
+        CHECK(plain_cmd(hp->model, e->lcd_cmd) == (i == 2 ? 0x2C : 0x3C));
+        // every chunk but the last is full
+        CHECK(e->bytes == cap || (e->bytes < cap && sent + e->bytes == bytes));
+        sent += e->bytes;
+    }
+    CHECK(sent == bytes);
+    // then only the NOP of esp32s3_4dlcd_bus_sync
+    CHECK(i == mock_trace_count() - 1 && plain_cmd(hp->model, mock_trace_get(i)->lcd_cmd) == 0x00);
+    mock_trace_clear();
+}
+
+static void check_pixel(host_panel_t *hp, int x, int y, uint16_t color, int line)
+{
+    uint8_t expected[3];
+    size_t pixel_bytes = esp32s3_4dlcd_pixel_bytes(hp->panel);
+    if (pixel_bytes == 3) {
+        esp32s3_4dlcd_rgb565_to_rgb666(expected, &color, 1);
+    } else {
+        esp32s3_4dlcd_rgb565_to_be(expected, &color, 1);
+    }
+    if (memcmp(mock_io_gram(hp->io, x, y), expected, pixel_bytes)) {
+        fprintf(stderr, "line %d: %s pixel %d,%d is not %04x\n", line, hp->model->name, x, y, color);
+        exit(1);
+    }
+}
+
+// Check the rectangle shows `tile` repeated from its top left corner
+static void check_pattern(host_panel_t *hp, int x_start, int y_start, int x_end, int y_end, const uint16_t *tile,
+                          int tile_width, int tile_height, int line)
+{
+    for (int y = y_start; y < y_end; y++) {
+        for (int x = x_start; x < x_end; x++) {
+            check_pixel(hp, x, y, tile[(y - y_start) % tile_height * tile_width + (x - x_start) % tile_width], line);
+        }
+    }
+}
+
+// Check the rectangle is `color` and the pixels around it are `around`
+static void check_rect(host_panel_t *hp, int x_start, int y_start, int x_end, int y_end, uint16_t color,
+                       uint16_t around, int line)
+{
+    check_pattern(hp, x_start, y_start, x_end, y_end, &color, 1, 1, line);
+    for (int x = x_start; x < x_end; x++) {
+        check_pixel(hp, x, y_start - 1, around, line);
+        check_pixel(hp, x, y_end, around, line);
+    }
+    for (int y = y_start; y < y_end; y++) {
+        check_pixel(hp, x_start - 1, y, around, line);
+        check_pixel(hp, x_end, y, around, line);
+    }
+}
+
+static void test_fill(const host_model_t *model)
+{
+    host_panel_t hp;
+    host_panel_new(model, &hp);
+    host_panel_start(&hp);
+    size_t pixel_bytes = esp32s3_4dlcd_pixel_bytes(hp.panel);
+    int width = model->width;
+    int height = model->height;
+    mock_trace_clear();
+
+    // the whole screen in chunk buffers, a transfer of whole pixels each
+    CHECK_OK(esp32s3_4dlcd_set_max_transfer(hp.panel, 0));
+    CHECK_OK(esp32s3_4dlcd_fill_rect(hp.panel, 0, 0, width, height, 0x1234));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    check_stream(&hp, 0, 0, width, height, CONFIG_ESP32S3_4DLCD_CHUNK_BUF_SIZE / pixel_bytes * pixel_bytes);
+    check_pattern(&hp, 0, 0, width, height, (uint16_t[]) { 0x1234 }, 1, 1, __LINE__);
+
+    // transfers of 1000 bytes, 999 for RGB666
+    size_t cap = 1000 / pixel_bytes * pixel_bytes;
+    CHECK_OK(esp32s3_4dlcd_set_max_transfer(hp.panel, 1000));
+    CHECK_OK(esp32s3_4dlcd_fill_rect(hp.panel, 10, 20, 160, 40, 0xF81F));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    check_stream(&hp, 10, 20, 160, 40, cap);
+    check_rect(&hp, 10, 20, 160, 40, 0xF81F, 0x1234, __LINE__);
+
+    // a tile of 7x3 over rows of 150: rows run across chunks, so chunks start at every phase of the tile
+    uint16_t tile[7 * 3];
+    for (int i = 0; i < 7 * 3; i++) {
+        tile[i] = (uint16_t)(i * 0x0C63 + 0x0821);
+    }
+    CHECK_OK(esp32s3_4dlcd_fill_pattern(hp.panel, 5, 50, 155, 70, tile, 7, 3));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    check_stream(&hp, 5, 50, 155, 70, cap);
+    check_pattern(&hp, 5, 50, 155, 70, tile, 7, 3, __LINE__);
+
+    // rows wider than a transfer of 100 bytes are split within the row, mid tile
+    cap = 100 / pixel_bytes * pixel_bytes;
+    CHECK_OK(esp32s3_4dlcd_set_max_transfer(hp.panel, 100));
+    CHECK_OK(esp32s3_4dlcd_fill_pattern(hp.panel, 3, 100, 123, 104, tile, 5, 2));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    check_stream(&hp, 3, 100, 123, 104, cap);
+    check_pattern(&hp, 3, 100, 123, 104, tile, 5, 2, __LINE__);
+
+    // a tile wider than the rectangle is cut, a single pixel tile is a solid fill
+    CHECK_OK(esp32s3_4dlcd_fill_pattern(hp.panel, 200, 110, 203, 113, tile, 7, 3));
+    CHECK_OK(esp32s3_4dlcd_fill_pattern(hp.panel, 1, 120, 11, 121, tile, 1, 1));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    check_pattern(&hp, 200, 110, 203, 113, tile, 7, 3, __LINE__);
+    check_rect(&hp, 1, 120, 11, 121, tile[0], 0x1234, __LINE__);
+    mock_trace_clear();
+
+    // a chunk the panel IO refuses fails the fill, and the next one starts a fresh memory write
+    mock_io_fail(hp.io, MOCK_TRACE_COLOR, 2, ESP_FAIL);
+    CHECK_ERR(esp32s3_4dlcd_fill_rect(hp.panel, 10, 150, 110, 160, 0x07E0), ESP_FAIL);
+    mock_io_fail(hp.io, MOCK_TRACE_COLOR, 3, ESP_ERR_TIMEOUT);
+    CHECK_ERR(esp32s3_4dlcd_fill_pattern(hp.panel, 10, 150, 110, 160, tile, 7, 3), ESP_ERR_TIMEOUT);
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    mock_trace_clear();
+    CHECK_OK(esp32s3_4dlcd_fill_rect(hp.panel, 10, 180, 110, 190, 0x07E0));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    check_stream(&hp, 10, 180, 110, 190, cap);
+    check_rect(&hp, 10, 180, 110, 190, 0x07E0, 0x1234, __LINE__);
+
+    // refused before anything is sent
+    CHECK_ERR(esp32s3_4dlcd_fill_rect(hp.panel, 10, 10, 10, 20, 0), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_fill_rect(hp.panel, 10, 20, 20, 10, 0), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_fill_rect(NULL, 0, 0, 1, 1, 0), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_fill_pattern(hp.panel, 0, 0, 1, 1, NULL, 1, 1), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_fill_pattern(hp.panel, 0, 0, 1, 1, tile, 0, 1), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_fill_pattern(hp.panel, 0, 0, 1, 1, tile, 1, 0), ESP_ERR_INVALID_ARG);
+    CHECK(mock_trace_count() == 0);
+
+    CHECK(mock_io_gram_overruns(hp.io) == 0);
+    host_panel_del(&hp);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < host_model_count; i++) {
+        test_fill(&host_models[i]);
+    }
+    printf("ok\n");
+    return 0;
+}
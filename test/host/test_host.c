@@ -0,0 +1,284 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <sys/param.h>
+#include "test_host.h"
+
+// the bus clocks and queue depths of 4dlcd_spi.h, with a frame memory of the native size
+const host_model_t host_models[] = {
+    { ESP32S3_4DLCD_MODEL_24, "24", 240, 320, MOCK_IO_CONFIG(60, 1, 8, LCD_SPI_TRANS_QUEUE_DEPTH, 240, 320, 2) },
+    { ESP32S3_4DLCD_MODEL_28, "28", 240, 320, MOCK_IO_CONFIG(60, 1, 8, LCD_SPI_TRANS_QUEUE_DEPTH, 240, 320, 2) },
+    { ESP32S3_4DLCD_MODEL_32, "32", 240, 320, MOCK_IO_CONFIG(60, 1, 8, LCD_SPI_TRANS_QUEUE_DEPTH, 240, 320, 2) },
+    { ESP32S3_4DLCD_MODEL_35, "35", 320, 480, MOCK_IO_CONFIG(60, 1, 8, LCD_SPI_TRANS_QUEUE_DEPTH, 320, 480, 3) },
+    { ESP32S3_4DLCD_MODEL_43Q, "43Q", 480, 272, MOCK_IO_CONFIG(30, 4, 32, LCD_QSPI_TRANS_QUEUE_DEPTH, 480, 272, 2) },
+};
+const size_t host_model_count = sizeof(host_models) / sizeof(host_models[0]);
+
+void host_panel_new(const host_model_t *model, host_panel_t *hp)
+{
+    hp->model = model;
+    CHECK_OK(mock_io_new(&model->io, &hp->io));
+    esp32s3_4dlcd_vendor_config_t vendor_config = {
+        .model = model->model,
+    };
+    esp_lcd_panel_dev_config_t panel_config = {
+        .reset_gpio_num = HOST_RESET_GPIO,
+        .rgb_ele_order = LCD_RGB_ELEMENT_ORDER_RGB,
+        .vendor_config = &vendor_config,
+    };
+    CHECK_OK(esp_lcd_new_panel_esp32s3_4dlcd(hp->io, &panel_config, &hp->panel));
+}
+
+void host_panel_start(host_panel_t *hp)
+{
+    CHECK_OK(esp_lcd_panel_reset(hp->panel));
+    CHECK_OK(esp_lcd_panel_init(hp->panel));
+    CHECK_OK(esp_lcd_panel_disp_on_off(hp->panel, true));
+}
+
+void host_panel_del(host_panel_t *hp)
+{
+    CHECK_OK(esp_lcd_panel_del(hp->panel));
+    mock_io_del(hp->io);
+}
+
+void host_rotate_pixel(esp32s3_4dlcd_rotation_t rotation, int width, int height, int fx, int fy, int *px, int *py)
+{
+    switch (rotation) {
+    case ESP32S3_4DLCD_ROTATE_90:
+        *px = width - 1 - fy;
+        *py = fx;
+        break;
+    case ESP32S3_4DLCD_ROTATE_180:
+        *px = width - 1 - fx;
+        *py = height - 1 - fy;
+        break;
+    case ESP32S3_4DLCD_ROTATE_270:
+        *px = fy;
+        *py = height - 1 - fx;
+        break;
+    default:
+        *px = fx;
+        *py = fy;
+        break;
+    }
+}
+
+void host_font_make(int bpp, int height, esp32s3_4dlcd_font_t *font)
+{
+    int count = '~' - ' ' + 1;
+    int ppb = 8 / bpp;
+    esp32s3_4dlcd_glyph_t *glyphs = calloc(count, sizeof(esp32s3_4dlcd_glyph_t));
+    size_t size = 0;
+    for (int i = 0; i < count; i++) {
+        // the space is blank, the rest cycle through widths that end mid byte at every bit depth
+        glyphs[i].width = i ? 1 + i % 8 : 0;
+        glyphs[i].advance = glyphs[i].width + 1;
+        glyphs[i].offset = size;
+        size += (size_t)((glyphs[i].width + ppb - 1) / ppb) * height;
+    }
+    uint8_t *bitmap = malloc(size ? size : 1);
+    CHECK(glyphs && bitmap);
+    for (size_t i = 0; i < size; i++) {
+        bitmap[i] = (uint8_t)(i * 37 + (i >> 3) * 11 + 0x5A);
+    }
+    *font = (esp32s3_4dlcd_font_t) {
+        .bpp = bpp,
+        .height = height,
+        .first = ' ',
+        .count = count,
+        .fallback = '?' - ' ',
+        .glyphs = glyphs,
+        .bitmap = bitmap,
+        .bitmap_size = size,
+    };
+}
+
+void host_font_free(esp32s3_4dlcd_font_t *font)
+{
+    free((void *)font->glyphs);
+    free((void *)font->bitmap);
+}
+
+const esp32s3_4dlcd_glyph_t *host_font_glyph(const esp32s3_4dlcd_font_t *font, uint8_t c)
+{
+    return &font->glyphs[c >= font->first && c - font->first < font->count ? c - font->first : font->fallback];
+}
+
+uint32_t host_font_alpha(const esp32s3_4dlcd_font_t *font, const esp32s3_4dlcd_glyph_t *glyph, int row, int col)
+{
+    if (col >= glyph->width) {
+        return 0;
+    }
+    int ppb = 8 / font->bpp;
+    uint8_t byte = font->bitmap[glyph->offset + row * ((glyph->width + ppb - 1) / ppb) + col / ppb];
+    return (byte >> (8 - font->bpp * (col % ppb + 1))) & ((1 << font->bpp) - 1);
+}
+
+uint16_t host_blend565(uint16_t fg, uint16_t bg, uint32_t alpha, uint32_t max)
+{
+    uint32_t r = (((fg >> 11) & 0x1F) * alpha + ((bg >> 11) & 0x1F) * (max - alpha) + max / 2) / max;
+    uint32_t g = (((fg >> 5) & 0x3F) * alpha + ((bg >> 5) & 0x3F) * (max - alpha) + max / 2) / max;
+    uint32_t b = ((fg & 0x1F) * alpha + (bg & 0x1F) * (max - alpha) + max / 2) / max;
+    return (r << 11) | (g << 5) | b;
+}
+
+// A port of encode() in tools/4dlcd_image.py, op for op, so the decoder sees what the tool writes
+#define IMAGE_LONG_COUNT        63
+#define IMAGE_MAX_COUNT         (64 + 0xFFFF)
+
+enum { IMAGE_OP_SKIP, IMAGE_OP_RUN, IMAGE_OP_LITERAL, IMAGE_OP_REPEAT };
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+    const int *index;           // palette index of every colour, NULL without a palette
+} image_buf_t;
+
+static void image_put(image_buf_t *buf, const void *src, size_t len)
+{
+    if (buf->size + len > buf->capacity) {
+        buf->capacity = (buf->size + len) * 2;
+        buf->data = realloc(buf->data, buf->capacity);
+        CHECK(buf->data);
+    }
+    memcpy(buf->data + buf->size, src, len);
+    buf->size += len;
+}
+
+static void image_put_u16(image_buf_t *buf, uint32_t v)
+{
+    uint8_t bytes[2] = { v & 0xFF, v >> 8 };
+    image_put(buf, bytes, 2);
+}
+
+static void image_put_op(image_buf_t *buf, int op, size_t count)
+{
+    uint8_t code = (op << 6) | (count - 1 < IMAGE_LONG_COUNT ? count - 1 : IMAGE_LONG_COUNT);
+    image_put(buf, &code, 1);
+    if (count - 1 >= IMAGE_LONG_COUNT) {
+        image_put_u16(buf, count - 64);
+    }
+}
+
+static void image_put_colour(image_buf_t *buf, uint16_t colour)
+{
+    if (buf->index) {
+        uint8_t i = buf->index[colour];
+        image_put(buf, &i, 1);
+    } else {
+        image_put_u16(buf, colour);
+    }
+}
+
+static void image_flush(image_buf_t *buf, const uint16_t *literal, size_t *count, uint16_t *last)
+{
+    for (size_t start = 0; start < *count; start += IMAGE_MAX_COUNT) {
+        size_t part = MIN(*count - start, (size_t)IMAGE_MAX_COUNT);
+        image_put_op(buf, IMAGE_OP_LITERAL, part);
+        for (size_t i = 0; i < part; i++) {
+            image_put_colour(buf, literal[start + i]);
+        }
+    }
+    if (*count) {
+        *last = literal[*count - 1];
+    }
+    *count = 0;
+}
+
+uint8_t *host_image_encode(int width, int height, const uint16_t *pixels, size_t *size)
+{
+    size_t n = (size_t)width * height;
+    uint32_t *counts = calloc(65536, sizeof(uint32_t));
+    int *index = malloc(65536 * sizeof(int));
+    uint16_t palette[256];
+    int palette_count = 0;
+    CHECK(counts && index);
+    // colours in order of first appearance, then by count as the tool's stable sort leaves them
+    for (size_t i = 0; i < n; i++) {
+        if (!counts[pixels[i]]++ && palette_count <= 256) {
+            if (palette_count < 256) {
+                palette[palette_count] = pixels[i];
+            }
+            palette_count++;
+        }
+    }
+    if (palette_count > 256) {
+        palette_count = 0;
+    }
+    for (int i = 1; i < palette_count; i++) {
+        uint16_t c = palette[i];
+        int j = i;
+        for (; j > 0 && counts[palette[j - 1]] < counts[c]; j--) {
+            palette[j] = palette[j - 1];
+        }
+        palette[j] = c;
+    }
+    for (int i = 0; i < palette_count; i++) {
+        index[palette[i]] = i;
+    }
+
+    image_buf_t header = { 0 };
+    image_put(&header, "4DIM\x01\x00", 6);
+    image_put_u16(&header, width);
+    image_put_u16(&header, height);
+    image_put_u16(&header, palette_count);
+    image_buf_t buf = { .index = palette_count ? index : NULL };
+    uint16_t *literal = malloc(n * sizeof(uint16_t));
+    CHECK(literal);
+    size_t literal_count = 0;
+    uint16_t last = 0;
+
+    for (size_t i = 0; i < n;) {
+        size_t skip = 0;
+        while (i + skip < n && skip < IMAGE_MAX_COUNT &&
+                pixels[i + skip] == (i + skip >= (size_t)width ? pixels[i + skip - width] : 0)) {
+            skip++;
+        }
+        size_t run = 1;
+        while (i + run < n && run < IMAGE_MAX_COUNT && pixels[i + run] == pixels[i]) {
+            run++;
+        }
+        uint16_t pending_last = literal_count ? literal[literal_count - 1] : last;
+
+        if (skip >= 2 && skip >= run) {
+            image_flush(&buf, literal, &literal_count, &last);
+            image_put_op(&buf, IMAGE_OP_SKIP, skip);
+            i += skip;
+        } else if (run >= 2 && pixels[i] == pending_last) {
+            image_flush(&buf, literal, &literal_count, &last);
+            image_put_op(&buf, IMAGE_OP_REPEAT, run);
+            i += run;
+        } else if (run >= 3) {
+            image_flush(&buf, literal, &literal_count, &last);
+            image_put_op(&buf, IMAGE_OP_RUN, run);
+            image_put_colour(&buf, pixels[i]);
+            last = pixels[i];
+            i += run;
+        } else {
+            literal[literal_count++] = pixels[i++];
+        }
+    }
+    image_flush(&buf, literal, &literal_count, &last);
+
+    image_put_u16(&header, buf.size & 0xFFFF);
+    image_put_u16(&header, buf.size >> 16);
+    for (int i = 0; i < palette_count; i++) {
+        image_put_u16(&header, palette[i]);
+    }
+    image_put(&header, buf.data, buf.size);
+    free(buf.data);
+    free(literal);
+    free(index);
+    free(counts);
+    *size = header.size;
+    return header.data;
+}
@@ -0,0 +1,113 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Shared by the host tests: the models they run on and the checks they fail with
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp32s3_4dlcd.h"
+#include "mock.h"
+
+#define CHECK(cond) do {                                                            \
+        if (!(cond)) {                                                              \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                                \
+        }                                                                           \
+    } while (0)
+
+#define CHECK_ERR(expr, expected) do {                                              \
+        esp_err_t rc_ = (expr);                                                     \
+        if (rc_ != (expected)) {                                                    \
+            fprintf(stderr, "%s:%d: %s returned %s, expected %s\n", __FILE__, __LINE__, #expr, \
+                    esp_err_to_name(rc_), esp_err_to_name(expected));               \
+            exit(1);                                                                \
+        }                                                                           \
+    } while (0)
+
+#define CHECK_OK(expr)  CHECK_ERR(expr, ESP_OK)
+
+#define HOST_RESET_GPIO     7
+
+/**
+ * @brief A display model as the host tests see it.
+ */
+typedef struct {
+    esp32s3_4dlcd_model_t model;
+    const char *name;           /*!< Model suffix, names the golden trace */
+    int width;                  /*!< Native size */
+    int height;
+    mock_io_config_t io;        /*!< Bus and frame memory of the board */
+} host_model_t;
+
+extern const host_model_t host_models[];
+extern const size_t host_model_count;
+
+/**
+ * @brief Panel on a mock IO.
+ */
+typedef struct {
+    const host_model_t *model;
+    esp_lcd_panel_io_handle_t io;
+    esp_lcd_panel_handle_t panel;
+} host_panel_t;
+
+/**
+ * @brief Create a panel of `model` on a new mock IO, reset on `HOST_RESET_GPIO`, not reset or initialised yet
+ */
+void host_panel_new(const host_model_t *model, host_panel_t *hp);
+
+/**
+ * @brief Reset, initialise and switch on the panel
+ */
+void host_panel_start(host_panel_t *hp);
+
+/**
+ * @brief Delete the panel and its mock IO
+ */
+void host_panel_del(host_panel_t *hp);
+
+/**
+ * @brief Panel pixel `fx`, `fy` of the software rotated frame lands on, the image turned clockwise on the glass
+ */
+void host_rotate_pixel(esp32s3_4dlcd_rotation_t rotation, int width, int height, int fx, int fy, int *px, int *py);
+
+/**
+ * @brief Make a font of characters ' ' to '~' with `bpp` bits of alpha and `height` rows, its bitmap a pattern
+ *
+ * Glyphs are 0 to 8 pixels wide plus a column of spacing, the fallback is '?'. Free with `host_font_free`.
+ */
+void host_font_make(int bpp, int height, esp32s3_4dlcd_font_t *font);
+
+/**
+ * @brief Free the glyphs and bitmap of a font made by `host_font_make`
+ */
+void host_font_free(esp32s3_4dlcd_font_t *font);
+
+/**
+ * @brief Glyph drawn for character `c`
+ */
+const esp32s3_4dlcd_glyph_t *host_font_glyph(const esp32s3_4dlcd_font_t *font, uint8_t c);
+
+/**
+ * @brief Alpha of pixel `col`, `row` of a glyph, 0 past its bitmap
+ */
+uint32_t host_font_alpha(const esp32s3_4dlcd_font_t *font, const esp32s3_4dlcd_glyph_t *glyph, int row, int col);
+
+/**
+ * @brief RGB565 colour of alpha `alpha` out of `max` between `bg` and `fg`, rounded per channel
+ */
+uint16_t host_blend565(uint16_t fg, uint16_t bg, uint32_t alpha, uint32_t max);
+
+/**
+ * @brief Encode RGB565 pixels as `tools/4dlcd_image.py` does, for `esp32s3_4dlcd_draw_image`
+ *
+ * @return The image, `*size` bytes, to free with `free`
+ */
+uint8_t *host_image_encode(int width, int height, const uint16_t *pixels, size_t *size);
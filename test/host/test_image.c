@@ -0,0 +1,141 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Images encoded as tools/4dlcd_image.py does, decoded by the driver and read back from the simulated frame memory:
+// paletted and not, every op, long counts and runs across row ends, then truncated and corrupt images
+
+#include <string.h>
+#include "esp32s3_4dlcd_pixel.h"
+#include "esp32s3_4dlcd_priv.h"
+#include "test_host.h"
+
+typedef enum {
+    IMAGE_FLAT,                 // one colour, runs longer than a long count
+    IMAGE_BANDS,                // rows repeating the one above, a few colours
+    IMAGE_PALETTE,              // 256 colours in short runs and literals
+    IMAGE_GRADIENT,             // thousands of colours, no palette
+    IMAGE_NOISE,                // literals only
+} image_kind_t;
+
+static const char *const image_kind_names[] = { "flat", "bands", "palette", "gradient", "noise" };
+
+static void image_pixels(image_kind_t kind, int width, int height, uint16_t *pixels)
+{
+    uint32_t seed = 0x4D15;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint16_t *p = &pixels[y * width + x];
+            seed = seed * 1103515245 + 12345;
+            switch (kind) {
+            case IMAGE_FLAT:
+                *p = 0x7BEF;
+                break;
+            case IMAGE_BANDS:
+                *p = (y / 8) % 3 ? 0xF800 | ((y / 24) & 0x3F) << 5 : 0x001F;
+                break;
+            case IMAGE_PALETTE:
+                *p = (uint16_t)(((x / 3 + y) & 0xFF) * 0x0101);
+                break;
+            case IMAGE_GRADIENT:
+                *p = (x * 31 / width) << 11 | (y * 63 / height) << 5 | ((x + y) & 0x1F);
+                break;
+            case IMAGE_NOISE:
+                *p = seed >> 16;
+                break;
+            }
+        }
+    }
+}
+
+// Check the image's pixels at `x`, `y` in the frame memory
+static void check_image(host_panel_t *hp, int x, int y, int width, int height, const uint16_t *pixels, const char *name)
+{
+    size_t pixel_bytes = esp32s3_4dlcd_pixel_bytes(hp->panel);
+    for (int row = 0; row < height; row++) {
+        for (int col = 0; col < width; col++) {
+            uint8_t expected[3];
+            if (pixel_bytes == 3) {
+                esp32s3_4dlcd_rgb565_to_rgb666(expected, &pixels[row * width + col], 1);
+            } else {
+                esp32s3_4dlcd_rgb565_to_be(expected, &pixels[row * width + col], 1);
+            }
+            if (memcmp(mock_io_gram(hp->io, x + col, y + row), expected, pixel_bytes)) {
+                fprintf(stderr, "%s %s %dx%d: differs at %d,%d\n", hp->model->name, name, width, height, col, row);
+                exit(1);
+            }
+        }
+    }
+}
+
+static void test_round_trip(host_panel_t *hp, image_kind_t kind, int x, int y, int width, int height)
+{
+    uint16_t *pixels = malloc((size_t)width * height * sizeof(uint16_t));
+    CHECK(pixels);
+    image_pixels(kind, width, height, pixels);
+    size_t size;
+    uint8_t *image = host_image_encode(width, height, pixels, &size);
+
+    int info_width;
+    int info_height;
+    CHECK_OK(esp32s3_4dlcd_image_info(image, size, &info_width, &info_height));
+    CHECK(info_width == width && info_height == height);
+    CHECK_OK(esp32s3_4dlcd_draw_image(hp->panel, x, y, image, size));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp->panel));
+    check_image(hp, x, y, width, height, pixels, image_kind_names[kind]);
+
+    // a stream one byte short, header and all, fails rather than reading past it
+    uint32_t data_size = image[12] | image[13] << 8 | image[14] << 16 | (uint32_t)image[15] << 24;
+    data_size--;
+    memcpy(image + 12, (uint8_t[]) { data_size, data_size >> 8, data_size >> 16, data_size >> 24 }, 4);
+    CHECK_ERR(esp32s3_4dlcd_draw_image(hp->panel, x, y, image, size - 1), ESP_FAIL);
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp->panel));
+
+    free(image);
+    free(pixels);
+}
+
+static void test_image(const host_model_t *model)
+{
+    host_panel_t hp;
+    host_panel_new(model, &hp);
+    host_panel_start(&hp);
+
+    for (image_kind_t kind = IMAGE_FLAT; kind <= IMAGE_NOISE; kind++) {
+        test_round_trip(&hp, kind, 0, 0, model->width, model->height);
+        test_round_trip(&hp, kind, 5, 7, 61, 43);
+        test_round_trip(&hp, kind, model->width - 1, model->height - 1, 1, 1);
+    }
+
+    // headers the decoder refuses
+    uint16_t pixels[4 * 4];
+    image_pixels(IMAGE_BANDS, 4, 4, pixels);
+    size_t size;
+    uint8_t *image = host_image_encode(4, 4, pixels, &size);
+    CHECK_ERR(esp32s3_4dlcd_draw_image(hp.panel, model->width - 3, 0, image, size), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_draw_image(hp.panel, 0, 0, image, 15), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_draw_image(hp.panel, 0, 0, image, size - 1), ESP_ERR_INVALID_ARG);
+    image[4] = 2;
+    CHECK_ERR(esp32s3_4dlcd_draw_image(hp.panel, 0, 0, image, size), ESP_ERR_INVALID_ARG);
+    image[4] = 1;
+    image[10] = 0x01;
+    image[11] = 0x01;
+    CHECK_ERR(esp32s3_4dlcd_draw_image(hp.panel, 0, 0, image, size), ESP_ERR_INVALID_ARG);
+    free(image);
+
+    CHECK(mock_io_gram_overruns(hp.io) == 0);
+    host_panel_del(&hp);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < host_model_count; i++) {
+        test_image(&host_models[i]);
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,311 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Partial, idle mode and vertical scrolling: the commands each change sends, how they follow mirroring, swapped axes and
+// the gap, the areas and models they are refused for, and where scrolled draws land in the frame memory
+
+#include <string.h>
+#include "esp32s3_4dlcd_priv.h"
+#include "test_host.h"
+
+// Check the commands recorded since the last call are `expected`, one trace line each
+#define CHECK_TRACE(expected) check_trace(__LINE__, expected)
+
+static void check_trace(int line, const char *expected)
+{
+    char *trace;
+    size_t size;
+    FILE *f = open_memstream(&trace, &size);
+    CHECK(f);
+    mock_trace_write(f);
+    fclose(f);
+    if (strcmp(trace, expected)) {
+        fprintf(stderr, "line %d: expected\n%sgot\n%s", line, expected, trace);
+        exit(1);
+    }
+    free(trace);
+    mock_trace_clear();
+}
+
+static void test_partial(const host_model_t *model)
+{
+    host_panel_t hp;
+    host_panel_new(model, &hp);
+    host_panel_start(&hp);
+    int height = model->height;
+    mock_trace_clear();
+
+    CHECK_OK(esp32s3_4dlcd_set_partial_area(hp.panel, 100, 200));
+    CHECK_TRACE("cmd 30 00 64 00 c7\n"
+                "cmd 12\n");
+    // moving the band keeps partial mode on
+    CHECK_OK(esp32s3_4dlcd_set_partial_area(hp.panel, 0, 50));
+    CHECK_TRACE("cmd 30 00 00 00 31\n");
+
+    // the band follows draw_bitmap rows, flipped with MY, and MADCTL keeps every other bit
+    CHECK_OK(esp_lcd_panel_mirror(hp.panel, false, true));
+    char expected[128];
+    snprintf(expected, sizeof(expected), "cmd 36 88\ncmd 30 %02x %02x %02x %02x\n", (height - 50) >> 8, (height - 50) & 0xFF, (height - 1) >> 8, (height - 1) & 0xFF);
+    CHECK_TRACE(expected);
+    CHECK_OK(esp_lcd_panel_mirror(hp.panel, false, false));
+    CHECK_TRACE("cmd 36 08\n"
+                "cmd 30 00 00 00 31\n");
+
+    // rows run across the band with the axes swapped: the whole panel until they are swapped back
+    CHECK_OK(esp_lcd_panel_swap_xy(hp.panel, true));
+    CHECK_TRACE("cmd 36 28\n"
+                "cmd 13\n");
+    CHECK_OK(esp_lcd_panel_swap_xy(hp.panel, false));
+    CHECK_TRACE("cmd 36 08\n"
+                "cmd 30 00 00 00 31\n"
+                "cmd 12\n");
+
+    // drawing is addressed the same in partial mode
+    uint8_t pixels[4 * 3] = { 0 };
+    CHECK_OK(esp_lcd_panel_draw_bitmap(hp.panel, 0, 120, 2, 122, pixels));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    CHECK(mock_trace_get(0)->lcd_cmd == 0x2A && mock_trace_get(1)->lcd_cmd == 0x2B);
+    CHECK(mock_trace_get(1)->data[1] == 120 && mock_trace_get(1)->data[3] == 121);
+    mock_trace_clear();
+
+    // the gap moves the band with the rows
+    CHECK_OK(esp_lcd_panel_set_gap(hp.panel, 0, 10));
+    CHECK_TRACE("cmd 30 00 0a 00 3b\n");
+
+    // refused without a command: empty, negative, or past the panel once the gap is applied
+    CHECK_ERR(esp32s3_4dlcd_set_partial_area(hp.panel, 20, 20), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_set_partial_area(hp.panel, -1, 20), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_set_partial_area(hp.panel, 0, height - 5), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_set_partial_area(NULL, 0, 10), ESP_ERR_INVALID_ARG);
+    CHECK_TRACE("");
+    CHECK_OK(esp_lcd_panel_set_gap(hp.panel, 0, 0));
+    CHECK_TRACE("cmd 30 00 00 00 31\n");
+
+    CHECK_OK(esp32s3_4dlcd_set_normal_mode(hp.panel));
+    CHECK_TRACE("cmd 13\n");
+    // already in normal mode
+    CHECK_OK(esp32s3_4dlcd_set_normal_mode(hp.panel));
+    CHECK_OK(esp_lcd_panel_mirror(hp.panel, false, false));
+    CHECK_TRACE("cmd 36 08\n");
+
+    CHECK_OK(esp32s3_4dlcd_set_idle_mode(hp.panel, true));
+    CHECK_TRACE("cmd 39\n");
+    CHECK_OK(esp32s3_4dlcd_set_idle_mode(hp.panel, false));
+    CHECK_TRACE("cmd 38\n");
+    host_panel_del(&hp);
+}
+
+// Check the commands recorded since the last call are `prefix`, then VSCRDEF and VSCSAD with these rows
+#define CHECK_SCROLL(prefix, top, height, bottom, start) check_scroll(__LINE__, prefix, top, height, bottom, start)
+
+static void check_scroll(int line, const char *prefix, int top, int height, int bottom, int start)
+{
+    char expected[160];
+    snprintf(expected, sizeof(expected), "%scmd 33 %02x %02x %02x %02x %02x %02x\ncmd 37 %02x %02x\n", prefix,
+             top >> 8, top & 0xFF, height >> 8, height & 0xFF, bottom >> 8, bottom & 0xFF, start >> 8, start & 0xFF);
+    check_trace(line, expected);
+}
+
+// Rows of 2 pixels, every byte of row `r` set to `r + 1`
+static void *scroll_rows(host_panel_t *hp, int rows, size_t *stride)
+{
+    *stride = 2 * esp32s3_4dlcd_pixel_bytes(hp->panel);
+    uint8_t *data = malloc(rows * *stride);
+    CHECK(data);
+    for (int r = 0; r < rows; r++) {
+        memset(data + r * *stride, r + 1, *stride);
+    }
+    return data;
+}
+
+// Check frame memory row `gram_row` holds row `r` of `scroll_rows`
+static void check_gram_row(host_panel_t *hp, int gram_row, int r, int line)
+{
+    for (int x = 0; x < 2; x++) {
+        if (*mock_io_gram(hp->io, x, gram_row) != r + 1) {
+            fprintf(stderr, "line %d: %s frame memory row %d shows %d, expected %d\n", line, hp->model->name, gram_row,
+                    *mock_io_gram(hp->io, x, gram_row) - 1, r);
+            exit(1);
+        }
+    }
+}
+
+// Count the RASETs recorded since the last call
+static size_t count_row_windows(host_panel_t *hp)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < mock_trace_count(); i++) {
+        const mock_trace_entry_t *e = mock_trace_get(i);
+        int cmd = hp->model->io.cmd_bits == 32 ? (e->lcd_cmd >> 8) & 0xFF : e->lcd_cmd;
+        count += e->type == MOCK_TRACE_PARAM && cmd == 0x2B;
+    }
+    mock_trace_clear();
+    return count;
+}
+
+static void test_scroll(const host_model_t *model)
+{
+    host_panel_t hp;
+    host_panel_new(model, &hp);
+    host_panel_start(&hp);
+    int height = model->height;
+    mock_trace_clear();
+
+    // rows 40 to 139 scroll, the controller counts them from the top of the glass
+    CHECK_OK(esp32s3_4dlcd_scroll_set_area(hp.panel, 40, 100));
+    CHECK_SCROLL("", 40, 100, height - 140, 40);
+    CHECK(esp32s3_4dlcd_scroll_is_hw(hp.panel));
+    CHECK_OK(esp32s3_4dlcd_scroll_set_offset(hp.panel, 30));
+    CHECK_SCROLL("", 40, 100, height - 140, 70);
+    CHECK_OK(esp32s3_4dlcd_scroll_set_offset(hp.panel, -10));
+    CHECK_SCROLL("", 40, 100, height - 140, 130);
+    CHECK(esp32s3_4dlcd_scroll_map_row(hp.panel, 39) == 39);
+    CHECK(esp32s3_4dlcd_scroll_map_row(hp.panel, 40) == 130);
+    CHECK(esp32s3_4dlcd_scroll_map_row(hp.panel, 49) == 139);
+    CHECK(esp32s3_4dlcd_scroll_map_row(hp.panel, 50) == 40);
+    CHECK(esp32s3_4dlcd_scroll_map_row(hp.panel, 140) == 140);
+
+    // with MY the area is counted from the other end and the offset runs the other way
+    CHECK_OK(esp_lcd_panel_mirror(hp.panel, false, true));
+    CHECK_SCROLL("cmd 36 88\n", height - 140, 100, 40, height - 140 + 10);
+    CHECK_OK(esp_lcd_panel_mirror(hp.panel, false, false));
+    CHECK_SCROLL("cmd 36 08\n", 40, 100, height - 140, 130);
+
+    // rows run sideways with the axes swapped: the controller goes back to one unscrolled area until they are swapped
+    // back
+    CHECK_OK(esp_lcd_panel_swap_xy(hp.panel, true));
+    CHECK_SCROLL("cmd 36 28\n", 0, height, 0, 0);
+    CHECK(!esp32s3_4dlcd_scroll_is_hw(hp.panel));
+    CHECK_OK(esp_lcd_panel_swap_xy(hp.panel, false));
+    CHECK_SCROLL("cmd 36 08\n", 40, 100, height - 140, 130);
+    CHECK(esp32s3_4dlcd_scroll_is_hw(hp.panel));
+
+    // the gap moves the area with the rows, and gives up hardware scrolling once it pushes the area off the panel
+    CHECK_OK(esp_lcd_panel_set_gap(hp.panel, 0, 10));
+    CHECK_SCROLL("", 50, 100, height - 150, 140);
+    CHECK_OK(esp_lcd_panel_set_gap(hp.panel, 0, height - 120));
+    CHECK_SCROLL("", 0, height, 0, 0);
+    CHECK(!esp32s3_4dlcd_scroll_is_hw(hp.panel));
+    CHECK_OK(esp_lcd_panel_set_gap(hp.panel, 0, 0));
+    CHECK_SCROLL("", 40, 100, height - 140, 130);
+
+    // screen rows 35 to 59 cross the top of the area and the wrap: the fixed rows, then the area up to its end in frame
+    // memory, then on from its start
+    size_t stride;
+    uint8_t *rows = scroll_rows(&hp, 25, &stride);
+    CHECK_OK(esp32s3_4dlcd_scroll_draw_bitmap(hp.panel, 0, 35, 2, 60, rows));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    const int windows[][2] = { { 35, 39 }, { 130, 139 }, { 40, 49 } };
+    size_t window = 0;
+    for (size_t i = 0; i < mock_trace_count(); i++) {
+        const mock_trace_entry_t *e = mock_trace_get(i);
+        if (e->type == MOCK_TRACE_PARAM && e->lcd_cmd == 0x2B) {
+            CHECK(window < 3);
+            CHECK((e->data[0] << 8 | e->data[1]) == windows[window][0]);
+            CHECK((e->data[2] << 8 | e->data[3]) == windows[window][1]);
+            window++;
+        }
+    }
+    CHECK(window == 3);
+    for (int y = 35; y < 60; y++) {
+        check_gram_row(&hp, esp32s3_4dlcd_scroll_map_row(hp.panel, y), y - 35, __LINE__);
+    }
+    mock_trace_clear();
+
+    // the controller scrolls, so there is nothing to redraw
+    CHECK_OK(esp32s3_4dlcd_scroll_sync(hp.panel, 0, 2, rows, stride));
+    CHECK_TRACE("");
+    free(rows);
+
+    // an empty area puts the controller back to its reset state, and leaves nothing to scroll
+    CHECK_OK(esp32s3_4dlcd_scroll_set_area(hp.panel, 0, 0));
+    CHECK_SCROLL("", 0, height, 0, 0);
+    CHECK(!esp32s3_4dlcd_scroll_is_hw(hp.panel));
+    CHECK_ERR(esp32s3_4dlcd_scroll_set_offset(hp.panel, 5), ESP_ERR_INVALID_STATE);
+    CHECK_ERR(esp32s3_4dlcd_scroll_set_area(hp.panel, -1, 10), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_scroll_set_area(hp.panel, 0, -1), ESP_ERR_INVALID_ARG);
+    CHECK_TRACE("");
+    host_panel_del(&hp);
+}
+
+// Without VSCRDEF the area is only remembered, and esp32s3_4dlcd_scroll_sync redraws it rotated by the offset
+static void test_scroll_sw(const host_model_t *model)
+{
+    host_panel_t hp;
+    host_panel_new(model, &hp);
+    host_panel_start(&hp);
+    mock_trace_clear();
+
+    CHECK_OK(esp32s3_4dlcd_scroll_set_area(hp.panel, 40, 100));
+    CHECK_OK(esp32s3_4dlcd_scroll_set_offset(hp.panel, 30));
+    CHECK_TRACE("");
+    CHECK(!esp32s3_4dlcd_scroll_is_hw(hp.panel));
+    CHECK(esp32s3_4dlcd_scroll_map_row(hp.panel, 40) == 70);
+    CHECK(esp32s3_4dlcd_scroll_map_row(hp.panel, 109) == 139);
+    CHECK(esp32s3_4dlcd_scroll_map_row(hp.panel, 110) == 40);
+
+    // area rows 30 to 99 at the top of the area, then 0 to 29
+    size_t stride;
+    uint8_t *rows = scroll_rows(&hp, 100, &stride);
+    CHECK_OK(esp32s3_4dlcd_scroll_sync(hp.panel, 0, 2, rows, stride));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    for (int y = 40; y < 140; y++) {
+        check_gram_row(&hp, y, esp32s3_4dlcd_scroll_map_row(hp.panel, y) - 40, __LINE__);
+    }
+    CHECK(count_row_windows(&hp) == 2);
+
+    // unscrolled, one window
+    CHECK_OK(esp32s3_4dlcd_scroll_set_offset(hp.panel, 100));
+    CHECK_OK(esp32s3_4dlcd_scroll_sync(hp.panel, 0, 2, rows, stride));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    for (int y = 40; y < 140; y++) {
+        check_gram_row(&hp, y, y - 40, __LINE__);
+    }
+    CHECK(count_row_windows(&hp) == 1);
+
+    // draws land where they are asked to
+    CHECK_OK(esp32s3_4dlcd_scroll_set_offset(hp.panel, 30));
+    CHECK_OK(esp32s3_4dlcd_scroll_draw_bitmap(hp.panel, 0, 45, 2, 50, rows));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    for (int y = 45; y < 50; y++) {
+        check_gram_row(&hp, y, y - 45, __LINE__);
+    }
+
+    CHECK_OK(esp32s3_4dlcd_scroll_set_area(hp.panel, 0, 0));
+    CHECK_ERR(esp32s3_4dlcd_scroll_sync(hp.panel, 0, 2, rows, stride), ESP_ERR_INVALID_STATE);
+    free(rows);
+    host_panel_del(&hp);
+}
+
+static void test_unsupported(const host_model_t *model)
+{
+    host_panel_t hp;
+    host_panel_new(model, &hp);
+    host_panel_start(&hp);
+    mock_trace_clear();
+    CHECK_ERR(esp32s3_4dlcd_set_partial_area(hp.panel, 0, 10), ESP_ERR_NOT_SUPPORTED);
+    CHECK_ERR(esp32s3_4dlcd_set_idle_mode(hp.panel, true), ESP_ERR_NOT_SUPPORTED);
+    CHECK_TRACE("");
+    host_panel_del(&hp);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < host_model_count; i++) {
+        const host_model_t *model = &host_models[i];
+        if (model->model == ESP32S3_4DLCD_MODEL_43Q) {
+            test_unsupported(model);
+            test_scroll_sw(model);
+        } else {
+            test_partial(model);
+            test_scroll(model);
+        }
+    }
+    printf("ok\n");
+    return 0;
+}
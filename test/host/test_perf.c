@@ -0,0 +1,192 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Performance counters: commands and colour transactions counted against the bus trace, the queue high-water mark
+// while transactions are tracked, refused transactions and the last error, the draw histogram against durations
+// measured around each call, and the reset that clears them
+
+#include <string.h>
+#include <sys/param.h>
+#include "esp_timer.h"
+#include "esp32s3_4dlcd_priv.h"
+#include "test_host.h"
+
+// What the counters should hold, built from the trace and from the calls the test makes
+typedef struct {
+    uint32_t cmd_count;
+    uint32_t color_count;
+    uint64_t cmd_bytes;
+    uint64_t color_bytes;
+    uint32_t draw_count;
+    uint32_t draw_max_us;
+    uint32_t draw_hist[ESP32S3_4DLCD_PERF_HIST_BUCKETS];
+} expected_t;
+
+// Add the transactions recorded since the last call to the expected counts, and drop them
+static void count_trace(expected_t *exp)
+{
+    for (size_t i = 0; i < mock_trace_count(); i++) {
+        const mock_trace_entry_t *e = mock_trace_get(i);
+        if (e->type == MOCK_TRACE_PARAM) {
+            exp->cmd_count++;
+            exp->cmd_bytes += e->bytes;
+        } else if (e->type == MOCK_TRACE_COLOR) {
+            exp->color_count++;
+            exp->color_bytes += e->bytes;
+        }
+    }
+    mock_trace_clear();
+}
+
+// Draw through `esp_lcd_panel_draw_bitmap`, timing the call from outside and binning it the way the header says
+static void draw(host_panel_t *hp, expected_t *exp, int x_start, int y_start, int x_end, int y_end,
+                 const uint16_t *pixels)
+{
+    int64_t start_us = esp_timer_get_time();
+    CHECK_OK(esp_lcd_panel_draw_bitmap(hp->panel, x_start, y_start, x_end, y_end, pixels));
+    uint32_t duration_us = esp_timer_get_time() - start_us;
+    int bucket = 0;
+    while (bucket < ESP32S3_4DLCD_PERF_HIST_BUCKETS - 1 &&
+            duration_us >= ((uint32_t)ESP32S3_4DLCD_PERF_HIST_BASE_US << bucket)) {
+        bucket++;
+    }
+    exp->draw_count++;
+    exp->draw_hist[bucket]++;
+    exp->draw_max_us = MAX(exp->draw_max_us, duration_us);
+}
+
+static void check_perf(host_panel_t *hp, const expected_t *exp, esp32s3_4dlcd_perf_t *perf)
+{
+    CHECK_OK(esp32s3_4dlcd_get_perf(hp->panel, perf));
+    CHECK(perf->cmd_count == exp->cmd_count);
+    CHECK(perf->color_count == exp->color_count);
+    CHECK(perf->cmd_bytes == exp->cmd_bytes);
+    CHECK(perf->color_bytes == exp->color_bytes);
+    CHECK(perf->draw_count == exp->draw_count);
+    CHECK(perf->draw_max_us == exp->draw_max_us);
+    uint32_t total = 0;
+    for (int i = 0; i < ESP32S3_4DLCD_PERF_HIST_BUCKETS; i++) {
+        CHECK(perf->draw_hist[i] == exp->draw_hist[i]);
+        total += perf->draw_hist[i];
+    }
+    CHECK(total == perf->draw_count);
+}
+
+static void check_cleared(host_panel_t *hp)
+{
+    esp32s3_4dlcd_perf_t perf;
+    memset(&perf, 0xA5, sizeof(perf));
+    CHECK_OK(esp32s3_4dlcd_get_perf(hp->panel, &perf));
+    CHECK(!memcmp(&perf, &(esp32s3_4dlcd_perf_t) {
+        0
+    }, sizeof(perf)));
+}
+
+static void test_perf(const host_model_t *model)
+{
+    host_panel_t hp;
+    host_panel_new(model, &hp);
+    host_panel_start(&hp);
+    size_t pixel_bytes = esp32s3_4dlcd_pixel_bytes(hp.panel);
+    int width = model->width;
+    int height = model->height;
+    uint16_t *pixels = calloc((size_t)width * height, sizeof(uint16_t));
+    CHECK(pixels);
+
+    // the init sequence was counted, and the reset forgets it
+    esp32s3_4dlcd_perf_t perf;
+    CHECK_OK(esp32s3_4dlcd_get_perf(hp.panel, &perf));
+    CHECK(perf.cmd_count > 0);
+    CHECK_OK(esp32s3_4dlcd_reset_perf(hp.panel));
+    check_cleared(&hp);
+    mock_trace_clear();
+
+    // untracked draws of one pixel, a block and the whole screen, and a fill that is no draw call: the window costs
+    // CASET and RASET with 4 bytes each, the pixels go out in the panel format, nothing is timed or seen in flight
+    expected_t exp = { 0 };
+    CHECK_OK(esp32s3_4dlcd_set_max_transfer(hp.panel, 0));
+    draw(&hp, &exp, 5, 5, 6, 6, pixels);
+    CHECK_OK(esp32s3_4dlcd_get_perf(hp.panel, &perf));
+    CHECK(perf.cmd_count == 2 && perf.cmd_bytes == 8);
+    CHECK(perf.color_count == 1 && perf.color_bytes == pixel_bytes);
+    draw(&hp, &exp, 10, 10, 60, 60, pixels);
+    draw(&hp, &exp, 0, 0, width, height, pixels);
+    CHECK_OK(esp32s3_4dlcd_fill_rect(hp.panel, 0, 0, 30, 30, 0xFFFF));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    count_trace(&exp);
+    check_perf(&hp, &exp, &perf);
+    CHECK(perf.color_bytes == (1 + 50 * 50 + (uint64_t)width * height + 30 * 30) * pixel_bytes);
+    CHECK(perf.cmd_errors == 0 && perf.color_errors == 0 && perf.last_error == ESP_OK);
+    CHECK(perf.timed_count == 0 && perf.queued_us == 0 && perf.wire_us == 0);
+    CHECK(perf.queue_high_water == 0);
+    // the whole screen took longer than the single pixel, in a later bucket
+    CHECK(exp.draw_hist[0] >= 1 && perf.draw_max_us >= ESP32S3_4DLCD_PERF_HIST_BASE_US);
+
+    // tracked, the whole screen in transfers of 1000 bytes fills the IO queue, and every transaction is seen completing.
+    // On QSPI each transfer carries its own memory write command, which waits for the queue to drain
+    CHECK_OK(esp32s3_4dlcd_reset_perf(hp.panel));
+    check_cleared(&hp);
+    exp = (expected_t) {
+        0
+    };
+    CHECK_OK(esp32s3_4dlcd_trans_track(hp.panel, NULL, NULL));
+    CHECK_OK(esp32s3_4dlcd_set_max_transfer(hp.panel, 1000));
+    draw(&hp, &exp, 0, 0, width, height, pixels);
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    count_trace(&exp);
+    check_perf(&hp, &exp, &perf);
+    CHECK(perf.queue_high_water == (model->io.cmd_bits == 32 ? 1 : model->io.trans_queue_depth));
+    CHECK(perf.timed_count == perf.color_count);
+    CHECK(perf.wire_us > 0 && perf.queued_us > 0);
+    esp32s3_4dlcd_trans_untrack(hp.panel, NULL, NULL);
+
+    // refused transactions are counted apart, with the error, and not as sent
+    mock_io_fail(hp.io, MOCK_TRACE_PARAM, 1, ESP_ERR_TIMEOUT);
+    CHECK_ERR(esp_lcd_panel_draw_bitmap(hp.panel, 20, 20, 40, 40, pixels), ESP_ERR_TIMEOUT);
+    exp.draw_count++;
+    count_trace(&exp);
+    CHECK_OK(esp32s3_4dlcd_get_perf(hp.panel, &perf));
+    CHECK(perf.cmd_errors == 1 && perf.color_errors == 0 && perf.last_error == ESP_ERR_TIMEOUT);
+    CHECK(perf.cmd_count == exp.cmd_count && perf.draw_count == exp.draw_count);
+
+    mock_io_fail(hp.io, MOCK_TRACE_COLOR, 1, ESP_FAIL);
+    CHECK_OK(esp32s3_4dlcd_set_max_transfer(hp.panel, 100));
+    CHECK_ERR(esp_lcd_panel_draw_bitmap(hp.panel, 20, 20, 40, 40, pixels), ESP_FAIL);
+    exp.draw_count++;
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    count_trace(&exp);
+    CHECK_OK(esp32s3_4dlcd_get_perf(hp.panel, &perf));
+    CHECK(perf.cmd_errors == 1 && perf.color_errors == 1 && perf.last_error == ESP_FAIL);
+    CHECK(perf.cmd_count == exp.cmd_count && perf.color_count == exp.color_count);
+    CHECK(perf.cmd_bytes == exp.cmd_bytes && perf.color_bytes == exp.color_bytes);
+    uint32_t total = 0;
+    for (int i = 0; i < ESP32S3_4DLCD_PERF_HIST_BUCKETS; i++) {
+        total += perf.draw_hist[i];
+    }
+    CHECK(total == exp.draw_count);
+
+    // and the reset clears all of it
+    CHECK_OK(esp32s3_4dlcd_reset_perf(hp.panel));
+    check_cleared(&hp);
+
+    CHECK_ERR(esp32s3_4dlcd_get_perf(NULL, &perf), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_get_perf(hp.panel, NULL), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_reset_perf(NULL), ESP_ERR_INVALID_ARG);
+
+    free(pixels);
+    host_panel_del(&hp);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < host_model_count; i++) {
+        test_perf(&host_models[i]);
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// RGB565 input: the conversion kernels against a per-channel reference, and draws on the 18-bit ILI9488 read back
+// from the simulated frame memory. Built with CONFIG_ESP32S3_4DLCD_RGB565_INPUT.
+
+#include <string.h>
+#include "esp32s3_4dlcd_pixel.h"
+#include "esp32s3_4dlcd_priv.h"
+#include "test_host.h"
+
+// A 5 or 6-bit channel widened to 6 bits with its top bit repeated below, in the top bits of a byte
+static uint8_t channel666(uint32_t value, int bits)
+{
+    uint32_t v6 = bits == 6 ? value : (value << 1) | (value >> 4);
+    return v6 << 2;
+}
+
+static void ref_rgb666(uint8_t *dst, uint16_t p)
+{
+    dst[0] = channel666(p >> 11, 5);
+    dst[1] = channel666((p >> 5) & 0x3F, 6);
+    dst[2] = channel666(p & 0x1F, 5);
+}
+
+static void test_rgb666_all_colours(void)
+{
+    static uint16_t src[65536];
+    static uint8_t dst[65536 * 3];
+    for (int i = 0; i < 65536; i++) {
+        src[i] = i;
+    }
+    esp32s3_4dlcd_rgb565_to_rgb666(dst, src, 65536);
+    for (int i = 0; i < 65536; i++) {
+        uint8_t ref[3];
+        ref_rgb666(ref, i);
+        CHECK(!memcmp(dst + i * 3, ref, 3));
+    }
+}
+
+// Every tail length of the unrolled loop, and nothing written past the last pixel
+static void test_rgb666_lengths(void)
+{
+    uint16_t src[16];
+    for (int i = 0; i < 16; i++) {
+        src[i] = 0x1234 * (i + 1);
+    }
+    for (size_t n = 0; n <= 13; n++) {
+        uint8_t dst[16 * 3 + 4];
+        memset(dst, 0xA5, sizeof(dst));
+        esp32s3_4dlcd_rgb565_to_rgb666(dst, src, n);
+        for (size_t i = 0; i < n; i++) {
+            uint8_t ref[3];
+            ref_rgb666(ref, src[i]);
+            CHECK(!memcmp(dst + i * 3, ref, 3));
+        }
+        for (size_t i = n * 3; i < sizeof(dst); i++) {
+            CHECK(dst[i] == 0xA5);
+        }
+    }
+}
+
+static void test_rgb565_to_be(void)
+{
+    uint16_t src[5] = { 0x0000, 0xFFFF, 0x1234, 0xF800, 0x001F };
+    uint8_t dst[11];
+    memset(dst, 0xA5, sizeof(dst));
+    esp32s3_4dlcd_rgb565_to_be(dst, src, 5);
+    CHECK(!memcmp(dst, "\x00\x00\xff\xff\x12\x34\xf8\x00\x00\x1f\xa5", 11));
+}
+
+static void test_repeat(void)
+{
+    uint8_t buf[50];
+    for (size_t period = 1; period <= 7; period++) {
+        memset(buf, 0, sizeof(buf));
+        for (size_t i = 0; i < period; i++) {
+            buf[i] = i + 1;
+        }
+        esp32s3_4dlcd_repeat(buf, period, 47);
+        for (size_t i = 0; i < 47; i++) {
+            CHECK(buf[i] == i % period + 1);
+        }
+        CHECK(buf[47] == 0);
+    }
+}
+
+static void check_gram(host_panel_t *hp, int x_start, int y_start, int x_end, int y_end, const uint16_t *src, size_t pixel_bytes)
+{
+    for (int y = y_start; y < y_end; y++) {
+        for (int x = x_start; x < x_end; x++) {
+            uint16_t p = src[(y - y_start) * (x_end - x_start) + x - x_start];
+            uint8_t ref[3];
+            if (pixel_bytes == 3) {
+                ref_rgb666(ref, p);
+            } else {
+                memcpy(ref, &p, 2);
+            }
+            CHECK(!memcmp(mock_io_gram(hp->io, x, y), ref, pixel_bytes));
+        }
+    }
+}
+
+// Draw RGB565, wider than a chunk buffer so conversion runs ahead of the bus into the buffer ring
+static void test_draw(const host_model_t *model, size_t pixel_bytes)
+{
+    host_panel_t hp;
+    host_panel_new(model, &hp);
+    host_panel_start(&hp);
+    CHECK(esp32s3_4dlcd_src_pixel_bytes(hp.panel) == 2);
+    CHECK(esp32s3_4dlcd_pixel_bytes(hp.panel) == pixel_bytes);
+
+    int rows = 3 * CONFIG_ESP32S3_4DLCD_CHUNK_BUF_SIZE / (model->width * 2) + 1;
+    size_t pixels = (size_t)model->width * rows;
+    uint16_t *src = malloc(pixels * 2);
+    CHECK(src);
+    for (size_t i = 0; i < pixels; i++) {
+        src[i] = (uint16_t)(i * 2654435761u >> 7);
+    }
+    CHECK_OK(esp_lcd_panel_draw_bitmap(hp.panel, 0, 10, model->width, 10 + rows, src));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    check_gram(&hp, 0, 10, model->width, 10 + rows, src, pixel_bytes);
+
+    CHECK_OK(esp_lcd_panel_draw_bitmap(hp.panel, 5, 3, 12, 8, src));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    check_gram(&hp, 5, 3, 12, 8, src, pixel_bytes);
+
+    CHECK(mock_io_gram_overruns(hp.io) == 0);
+    free(src);
+    host_panel_del(&hp);
+}
+
+int main(void)
+{
+    test_rgb666_all_colours();
+    test_rgb666_lengths();
+    test_rgb565_to_be();
+    test_repeat();
+    for (size_t i = 0; i < host_model_count; i++) {
+        const host_model_t *model = &host_models[i];
+        // 16-bit panels take RGB565 as it is
+        test_draw(model, model->model == ESP32S3_4DLCD_MODEL_35 ? 3 : 2);
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,108 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// The present queue against the mock IO, which reads colour data when a transaction finishes as DMA does: a buffer
+// is never handed out while a queued transaction still reads it, after untracked draws, full frames, or a draw that
+// failed part way
+
+#include <string.h>
+#include "esp32s3_4dlcd_priv.h"
+#include "test_host.h"
+
+#define FRAMES          6
+#define MAX_TRANSFER    4096    // several transactions per frame on every model
+
+static void fill_frame(uint8_t *buf, size_t len, int frame)
+{
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = (uint8_t)(i * 7 + frame * 13);
+    }
+}
+
+static void check_gram(host_panel_t *hp, const uint8_t *buf)
+{
+    size_t pixel_bytes = esp32s3_4dlcd_pixel_bytes(hp->panel);
+    for (int y = 0; y < hp->model->height; y++) {
+        for (int x = 0; x < hp->model->width; x++) {
+            CHECK(!memcmp(mock_io_gram(hp->io, x, y), buf + ((size_t)y * hp->model->width + x) * pixel_bytes, pixel_bytes));
+        }
+    }
+}
+
+// Acquire the next buffer and check nothing on the bus still reads it
+static int acquire(esp32s3_4dlcd_present_handle_t present, host_panel_t *hp, size_t frame_bytes, uint8_t **buf)
+{
+    int index;
+    CHECK_OK(esp32s3_4dlcd_present_acquire(present, portMAX_DELAY, &index, (void **)buf));
+    CHECK(!mock_io_reading(hp->io, *buf, frame_bytes));
+    return index;
+}
+
+static void test_present(const host_model_t *model)
+{
+    host_panel_t hp;
+    host_panel_new(model, &hp);
+    host_panel_start(&hp);
+    CHECK_OK(esp32s3_4dlcd_set_max_transfer(hp.panel, MAX_TRANSFER));
+    size_t frame_bytes = (size_t)model->width * model->height * esp32s3_4dlcd_src_pixel_bytes(hp.panel);
+    uint8_t *buffers[2] = { malloc(frame_bytes), malloc(frame_bytes) };
+    CHECK(buffers[0] && buffers[1]);
+
+    // a draw made before tracking starts is still on the bus, its completion must not count towards later fences
+    fill_frame(buffers[0], frame_bytes, 0);
+    CHECK_OK(esp_lcd_panel_draw_bitmap(hp.panel, 0, 0, model->width, model->height, buffers[0]));
+    CHECK(mock_io_in_flight(hp.io) > 0);
+    esp32s3_4dlcd_present_config_t config = {
+        .buffers = (void *const *)buffers,
+        .num_buffers = 2,
+    };
+    esp32s3_4dlcd_present_handle_t present;
+    CHECK_OK(esp32s3_4dlcd_present_new(hp.panel, &config, &present));
+    CHECK(mock_io_in_flight(hp.io) == 0);
+    CHECK(!esp32s3_4dlcd_trans_is_done(hp.panel, esp32s3_4dlcd_trans_seq(hp.panel) + 1));
+
+    // full frames, each buffer filled as soon as it is handed back
+    uint8_t *buf;
+    for (int frame = 1; frame <= FRAMES; frame++) {
+        int index = acquire(present, &hp, frame_bytes, &buf);
+        CHECK(buf == buffers[(frame - 1) % 2] && index == (frame - 1) % 2);
+        fill_frame(buf, frame_bytes, frame);
+        CHECK_OK(esp32s3_4dlcd_present_submit(present, index, 0, 0, model->width, model->height));
+    }
+    CHECK_OK(esp32s3_4dlcd_present_flush(present, portMAX_DELAY));
+    check_gram(&hp, buffers[(FRAMES - 1) % 2]);
+
+    // a draw that fails after queueing part of the buffer keeps it fenced
+    int index = acquire(present, &hp, frame_bytes, &buf);
+    fill_frame(buf, frame_bytes, FRAMES + 1);
+    mock_io_fail(hp.io, MOCK_TRACE_COLOR, 3, ESP_FAIL);
+    CHECK_ERR(esp32s3_4dlcd_present_submit(present, index, 0, 0, model->width, model->height), ESP_FAIL);
+    CHECK(mock_io_reading(hp.io, buf, frame_bytes));
+    acquire(present, &hp, frame_bytes, &buf);
+    index = acquire(present, &hp, frame_bytes, &buf);
+    fill_frame(buf, frame_bytes, FRAMES + 2);
+    CHECK_OK(esp32s3_4dlcd_present_submit(present, index, 0, 0, model->width, model->height));
+    CHECK_OK(esp32s3_4dlcd_present_wait(present, index, portMAX_DELAY));
+    CHECK(!mock_io_reading(hp.io, buf, frame_bytes));
+    check_gram(&hp, buf);
+
+    CHECK_OK(esp32s3_4dlcd_present_del(present));
+    CHECK(mock_io_gram_overruns(hp.io) == 0);
+    free(buffers[0]);
+    free(buffers[1]);
+    host_panel_del(&hp);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < host_model_count; i++) {
+        test_present(&host_models[i]);
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,216 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// RGB frame buffer flips driven by simulated vsyncs: which frame buffer is handed out, pending and scanned after each
+// call, the rectangles a frame buffer is caught up with, and the pixels they copy from the newest frame
+
+#include <string.h>
+#include "esp32s3_4dlcd_rgb_flip.h"
+#include "test_host.h"
+
+#define WIDTH   64
+#define HEIGHT  48
+
+typedef struct {
+    esp32s3_4dlcd_rgb_flip_t flip;
+    uint16_t fbs[ESP32S3_4DLCD_RGB_MAX_FBS][HEIGHT][WIDTH];
+} rig_t;
+
+static void rig_init(rig_t *rig, size_t num_fbs)
+{
+    esp32s3_4dlcd_damage_config_t damage_config = {
+        .width = WIDTH,
+        .height = HEIGHT,
+        .max_rects = 16,
+        .pclk_hz = 40 * 1000 * 1000,
+        .bus_width = 8,
+        .bits_per_pixel = 16,
+        .trans_overhead_ns = 1000,
+    };
+    memset(rig->fbs, 0, sizeof(rig->fbs));
+    CHECK_OK(esp32s3_4dlcd_rgb_flip_init(&rig->flip, num_fbs, &damage_config));
+    for (size_t i = 0; i < num_fbs; i++) {
+        rig->flip.fbs[i] = (uint8_t *)rig->fbs[i];
+    }
+}
+
+// Check every frame buffer state, and which one is handed out, pending and scanned
+static void check_states(rig_t *rig, const char *states, int back, int pending, int scanned, int line)
+{
+    static const char names[] = { 'F', 'D', 'P', 'S' };
+    for (size_t i = 0; i < rig->flip.num_fbs; i++) {
+        if (names[rig->flip.state[i]] != states[i]) {
+            fprintf(stderr, "line %d: frame buffer %u is %c, expected %c\n", line, (unsigned)i, names[rig->flip.state[i]],
+                    states[i]);
+            exit(1);
+        }
+    }
+    if (rig->flip.back != back || rig->flip.pending != pending || rig->flip.scanned != scanned) {
+        fprintf(stderr, "line %d: back %d pending %d scanned %d, expected %d %d %d\n", line, rig->flip.back,
+                rig->flip.pending, rig->flip.scanned, back, pending, scanned);
+        exit(1);
+    }
+}
+#define CHECK_STATES(rig, states, back, pending, scanned) check_states(rig, states, back, pending, scanned, __LINE__)
+
+// Draw a rectangle into the frame buffer handed out, and record it unless `hidden`
+static void draw(rig_t *rig, const esp32s3_4dlcd_rect_t *r, uint16_t color, bool hidden)
+{
+    for (int y = r->y_start; y < r->y_end; y++) {
+        for (int x = r->x_start; x < r->x_end; x++) {
+            rig->fbs[rig->flip.back][y][x] = color;
+        }
+    }
+    if (!hidden) {
+        CHECK_OK(esp32s3_4dlcd_rgb_flip_damage(&rig->flip, r->x_start, r->y_start, r->x_end, r->y_end));
+    }
+}
+
+// Take a frame buffer, check it is `expected` and is caught up with exactly `rects`, then holds the newest frame
+static void take(rig_t *rig, int expected, const esp32s3_4dlcd_rect_t *rects, size_t num_rects)
+{
+    int fb = esp32s3_4dlcd_rgb_flip_take(&rig->flip);
+    CHECK(fb == expected);
+    const esp32s3_4dlcd_rect_t *stale;
+    CHECK(esp32s3_4dlcd_damage_get_rects(rig->flip.stale[fb], &stale) == num_rects);
+    uint64_t area = 0;
+    for (size_t i = 0; i < num_rects; i++) {
+        bool found = false;
+        for (size_t j = 0; j < num_rects; j++) {
+            found |= !memcmp(&stale[j], &rects[i], sizeof(rects[i]));
+        }
+        CHECK(found);
+        area += (uint64_t)(rects[i].x_end - rects[i].x_start) * (rects[i].y_end - rects[i].y_start);
+    }
+    CHECK(esp32s3_4dlcd_rgb_flip_catch_up(&rig->flip, fb) == area);
+    CHECK(esp32s3_4dlcd_damage_get_rects(rig->flip.stale[fb], &stale) == 0);
+    CHECK(!memcmp(rig->fbs[fb], rig->fbs[rig->flip.latest], sizeof(rig->fbs[fb])));
+}
+
+static void test_double(void)
+{
+    rig_t *rig = calloc(1, sizeof(rig_t));
+    CHECK(rig);
+    rig_init(rig, 2);
+    CHECK_STATES(rig, "SF", -1, -1, 0);
+    // nothing to flip to
+    CHECK(!esp32s3_4dlcd_rgb_flip_vsync(&rig->flip));
+
+    const esp32s3_4dlcd_rect_t a = { 2, 3, 20, 10 };
+    const esp32s3_4dlcd_rect_t b = { 40, 30, 60, 45 };
+    take(rig, 1, NULL, 0);
+    CHECK_STATES(rig, "SD", 1, -1, 0);
+    CHECK(esp32s3_4dlcd_rgb_flip_take(&rig->flip) == -1);
+    draw(rig, &a, 0x1111, false);
+    esp32s3_4dlcd_rgb_flip_present(&rig->flip);
+    CHECK_STATES(rig, "SP", -1, 1, 0);
+    // the scanned frame buffer stays out of reach until the vsync
+    CHECK(esp32s3_4dlcd_rgb_flip_take(&rig->flip) == -1);
+    CHECK(esp32s3_4dlcd_rgb_flip_vsync(&rig->flip));
+    CHECK_STATES(rig, "FS", -1, -1, 1);
+    CHECK(!esp32s3_4dlcd_rgb_flip_vsync(&rig->flip));
+
+    // the frame buffer scanned before missed the frame drawn in the other one
+    take(rig, 0, &a, 1);
+    CHECK_STATES(rig, "DS", 0, -1, 1);
+    draw(rig, &b, 0x2222, false);
+    esp32s3_4dlcd_rgb_flip_present(&rig->flip);
+    CHECK_STATES(rig, "PS", -1, 0, 1);
+    CHECK(esp32s3_4dlcd_rgb_flip_vsync(&rig->flip));
+    CHECK_STATES(rig, "SF", -1, -1, 0);
+    take(rig, 1, &b, 1);
+    CHECK_STATES(rig, "SD", 1, -1, 0);
+
+    // an area drawn and not recorded is not copied, the other frame buffer keeps its stale pixels there
+    const esp32s3_4dlcd_rect_t hidden = { 30, 0, 34, 4 };
+    draw(rig, &hidden, 0x3333, true);
+    esp32s3_4dlcd_rgb_flip_present(&rig->flip);
+    CHECK(esp32s3_4dlcd_rgb_flip_vsync(&rig->flip));
+    CHECK(esp32s3_4dlcd_rgb_flip_take(&rig->flip) == 0);
+    CHECK(esp32s3_4dlcd_rgb_flip_catch_up(&rig->flip, 0) == 0);
+    CHECK(rig->fbs[0][0][30] == 0 && rig->fbs[1][0][30] == 0x3333);
+    esp32s3_4dlcd_rgb_flip_deinit(&rig->flip);
+    free(rig);
+}
+
+static void test_triple(void)
+{
+    rig_t *rig = calloc(1, sizeof(rig_t));
+    CHECK(rig);
+    rig_init(rig, 3);
+    CHECK_STATES(rig, "SFF", -1, -1, 0);
+
+    // drawing runs a frame ahead of the scan: a frame buffer is free while the previous one is still pending
+    const esp32s3_4dlcd_rect_t a = { 0, 0, 8, 8 };
+    const esp32s3_4dlcd_rect_t b = { 50, 40, 64, 48 };
+    const esp32s3_4dlcd_rect_t c = { 20, 20, 30, 25 };
+    take(rig, 1, NULL, 0);
+    draw(rig, &a, 0xAAAA, false);
+    esp32s3_4dlcd_rgb_flip_present(&rig->flip);
+    CHECK_STATES(rig, "SPF", -1, 1, 0);
+    take(rig, 2, &a, 1);
+    CHECK_STATES(rig, "SPD", 2, 1, 0);
+    draw(rig, &b, 0xBBBB, false);
+    // a second flip waits for the first, here the vsync that completes it
+    CHECK(esp32s3_4dlcd_rgb_flip_vsync(&rig->flip));
+    CHECK_STATES(rig, "FSD", 2, -1, 1);
+    esp32s3_4dlcd_rgb_flip_present(&rig->flip);
+    CHECK_STATES(rig, "FSP", -1, 2, 1);
+
+    // the first frame buffer missed both frames and is caught up from the newest
+    take(rig, 0, (esp32s3_4dlcd_rect_t[]) {
+        a, b
+    }, 2);
+    CHECK_STATES(rig, "DSP", 0, 2, 1);
+    draw(rig, &c, 0xCCCC, false);
+    CHECK(esp32s3_4dlcd_rgb_flip_vsync(&rig->flip));
+    CHECK_STATES(rig, "DFS", 0, -1, 2);
+    esp32s3_4dlcd_rgb_flip_present(&rig->flip);
+    CHECK(esp32s3_4dlcd_rgb_flip_vsync(&rig->flip));
+    CHECK_STATES(rig, "SFF", -1, -1, 0);
+
+    // the second one missed the last two, the third only the last
+    take(rig, 1, (esp32s3_4dlcd_rect_t[]) {
+        b, c
+    }, 2);
+    esp32s3_4dlcd_rgb_flip_present(&rig->flip);
+    take(rig, 2, &c, 1);
+    CHECK(rig->fbs[2][0][0] == 0xAAAA && rig->fbs[2][47][63] == 0xBBBB && rig->fbs[2][20][20] == 0xCCCC);
+    esp32s3_4dlcd_rgb_flip_deinit(&rig->flip);
+    free(rig);
+}
+
+static void test_single(void)
+{
+    rig_t *rig = calloc(1, sizeof(rig_t));
+    CHECK(rig);
+    rig_init(rig, 1);
+    // the only frame buffer is drawn while scanned and never flips
+    for (int i = 0; i < 3; i++) {
+        CHECK(esp32s3_4dlcd_rgb_flip_take(&rig->flip) == 0);
+        CHECK_STATES(rig, "S", 0, -1, 0);
+        draw(rig, &(esp32s3_4dlcd_rect_t) {
+            i, i, i + 4, i + 4
+        }, 0x1234, false);
+        CHECK(esp32s3_4dlcd_rgb_flip_catch_up(&rig->flip, 0) == 0);
+        esp32s3_4dlcd_rgb_flip_present(&rig->flip);
+        CHECK_STATES(rig, "S", -1, -1, 0);
+        CHECK(!esp32s3_4dlcd_rgb_flip_vsync(&rig->flip));
+    }
+    esp32s3_4dlcd_rgb_flip_deinit(&rig->flip);
+    free(rig);
+}
+
+int main(void)
+{
+    test_double();
+    test_triple();
+    test_single();
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Software rotation: every rotation on every model, with and without a gap, read back from the simulated frame
+// memory pixel by pixel. Built once per input format.
+
+#include <string.h>
+#include "esp32s3_4dlcd_pixel.h"
+#include "esp32s3_4dlcd_priv.h"
+#include "test_host.h"
+
+static void test_rotation(const host_model_t *model, esp32s3_4dlcd_rotation_t rotation, int x_gap, int y_gap)
+{
+    host_panel_t hp;
+    host_panel_new(model, &hp);
+    host_panel_start(&hp);
+    CHECK_OK(esp_lcd_panel_set_gap(hp.panel, x_gap, y_gap));
+    CHECK_OK(esp32s3_4dlcd_set_sw_rotation(hp.panel, rotation));
+
+    int frame_width;
+    int frame_height;
+    esp32s3_4dlcd_frame_size(hp.panel, &frame_width, &frame_height);
+    bool quarter = rotation == ESP32S3_4DLCD_ROTATE_90 || rotation == ESP32S3_4DLCD_ROTATE_270;
+    CHECK(frame_width == (quarter ? model->height : model->width));
+    CHECK(frame_height == (quarter ? model->width : model->height));
+
+    // the whole frame without a gap, with one a rectangle further off every edge than the gap, so it lands on the glass
+    // whichever edge it is turned to
+    int margin = x_gap || y_gap ? 9 : 0;
+    int x_start = margin;
+    int y_start = margin;
+    int x_end = frame_width - margin;
+    int y_end = frame_height - margin;
+    size_t src_bytes = esp32s3_4dlcd_src_pixel_bytes(hp.panel);
+    size_t dst_bytes = esp32s3_4dlcd_pixel_bytes(hp.panel);
+    size_t pixels = (size_t)(x_end - x_start) * (y_end - y_start);
+    uint8_t *src = malloc(pixels * src_bytes);
+    CHECK(src);
+    for (size_t i = 0; i < pixels * src_bytes; i++) {
+        src[i] = (uint8_t)(i * 131 + (i >> 9) + 1);
+    }
+    CHECK_OK(esp_lcd_panel_draw_bitmap(hp.panel, x_start, y_start, x_end, y_end, src));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+
+    for (int fy = y_start; fy < y_end; fy++) {
+        for (int fx = x_start; fx < x_end; fx++) {
+            const uint8_t *s = src + ((size_t)(fy - y_start) * (x_end - x_start) + fx - x_start) * src_bytes;
+            uint8_t expected[3];
+            if (src_bytes == dst_bytes) {
+                memcpy(expected, s, dst_bytes);
+            } else {
+                uint16_t c;
+                memcpy(&c, s, 2);
+                esp32s3_4dlcd_rgb565_to_rgb666(expected, &c, 1);
+            }
+            int px;
+            int py;
+            host_rotate_pixel(rotation, model->width, model->height, fx, fy, &px, &py);
+            const uint8_t *got = mock_io_gram(hp.io, px + x_gap, py + y_gap);
+            if (!got || memcmp(got, expected, dst_bytes)) {
+                fprintf(stderr, "%s rotation %d gap %d,%d: pixel %d,%d not at %d,%d\n", model->name, rotation * 90,
+                        x_gap, y_gap, fx, fy, px + x_gap, py + y_gap);
+                exit(1);
+            }
+        }
+    }
+    CHECK(mock_io_gram_overruns(hp.io) == 0);
+    free(src);
+    host_panel_del(&hp);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < host_model_count; i++) {
+        for (int rotation = ESP32S3_4DLCD_ROTATE_0; rotation <= ESP32S3_4DLCD_ROTATE_270; rotation++) {
+            test_rotation(&host_models[i], rotation, 0, 0);
+            test_rotation(&host_models[i], rotation, 3, 6);
+        }
+    }
+    printf("ok\n");
+    return 0;
+}
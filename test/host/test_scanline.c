@@ -0,0 +1,194 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Windows drawn from a line producer: the row ranges it is asked for, the memory write they go out under, with and
+// without transaction tracking, the pixels that land, and the producer errors and rows too wide that stop the draw
+
+#include <string.h>
+#include <sys/param.h>
+#include "esp32s3_4dlcd_priv.h"
+#include "test_host.h"
+
+typedef struct {
+    int x_start;
+    int y_start;
+    int y_end;
+    size_t row_bytes;
+    size_t cap;                 // bytes of a chunk buffer
+    int next_y;                 // row the next call has to start at
+    int calls;
+    int fail_call;              // call to fail, -1 for none
+} producer_ctx_t;
+
+static uint8_t pixel_byte(int x, int y, size_t byte)
+{
+    return (uint8_t)(x * 7 + y * 13 + byte);
+}
+
+static esp_err_t producer(int y, int lines, void *dst, void *user_ctx)
+{
+    producer_ctx_t *ctx = user_ctx;
+    // rows come in order, as many as fit a chunk buffer
+    CHECK(y == ctx->next_y);
+    CHECK(lines == MIN(ctx->y_end - y, (int)(ctx->cap / ctx->row_bytes)));
+    if (ctx->calls++ == ctx->fail_call) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint8_t *p = dst;
+    for (int row = y; row < y + lines; row++) {
+        for (size_t i = 0; i < ctx->row_bytes; i++) {
+            *p++ = pixel_byte(ctx->x_start, row, i);
+        }
+    }
+    ctx->next_y = y + lines;
+    return ESP_OK;
+}
+
+// Panel command of a recorded event, without the QSPI opcode framing
+static int plain_cmd(const host_model_t *model, int lcd_cmd)
+{
+    return model->io.cmd_bits == 32 && lcd_cmd >= 0 ? (lcd_cmd >> 8) & 0xFF : lcd_cmd;
+}
+
+// Draw the window and check the calls, the trace and the pixels. `same_window` if the last draw had the same window,
+// which is not sent again
+static void draw(host_panel_t *hp, int x_start, int y_start, int x_end, int y_end, size_t cap, bool tracked,
+                 bool same_window)
+{
+    size_t pixel_bytes = esp32s3_4dlcd_pixel_bytes(hp->panel);
+    producer_ctx_t ctx = {
+        .x_start = x_start,
+        .y_start = y_start,
+        .y_end = y_end,
+        .row_bytes = (x_end - x_start) * pixel_bytes,
+        .cap = cap,
+        .next_y = y_start,
+        .fail_call = -1,
+    };
+    mock_trace_clear();
+    CHECK_OK(esp32s3_4dlcd_draw_lines(hp->panel, x_start, y_start, x_end, y_end, producer, &ctx));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp->panel));
+    CHECK(ctx.next_y == y_end);
+
+    // one window, then a chunk per call under one memory write: RAMWR, then RAMWRC or, queued on SPI behind a
+    // tracked transaction, no command at all
+    size_t first = 0;
+    if (!same_window) {
+        const mock_trace_entry_t *caset = mock_trace_get(0);
+        const mock_trace_entry_t *raset = mock_trace_get(1);
+        CHECK(plain_cmd(hp->model, caset->lcd_cmd) == 0x2A);
+        CHECK((caset->data[0] << 8 | caset->data[1]) == x_start && (caset->data[2] << 8 | caset->data[3]) == x_end - 1);
+        CHECK(plain_cmd(hp->model, raset->lcd_cmd) == 0x2B);
+        CHECK((raset->data[0] << 8 | raset->data[1]) == y_start && (raset->data[2] << 8 | raset->data[3]) == y_end - 1);
+        first = 2;
+    }
+    int continued = tracked && hp->model->io.cmd_bits == 8 ? -1 : 0x3C;
+    size_t rows_per_chunk = cap / ctx.row_bytes;
+    size_t chunks = 0;
+    for (size_t i = first; i < mock_trace_count(); i++) {
+        const mock_trace_entry_t *e = mock_trace_get(i);
+        CHECK(e->type == MOCK_TRACE_COLOR || i == mock_trace_count() - 1);
+        if (e->type != MOCK_TRACE_COLOR) {
+            // the NOP of esp32s3_4dlcd_bus_sync, without tracking
+            CHECK(!tracked && plain_cmd(hp->model, e->lcd_cmd) == 0x00);
+            continue;
+        }
+        CHECK(plain_cmd(hp->model, e->lcd_cmd) == (chunks ? continued : 0x2C));
+        CHECK(e->bytes == MIN(rows_per_chunk, (size_t)(y_end - y_start) - chunks * rows_per_chunk) * ctx.row_bytes);
+        chunks++;
+    }
+    CHECK(chunks == (size_t)ctx.calls);
+    CHECK(chunks == ((size_t)(y_end - y_start) + rows_per_chunk - 1) / rows_per_chunk);
+
+    for (int y = y_start; y < y_end; y++) {
+        for (int x = x_start; x < x_end; x++) {
+            const uint8_t *p = mock_io_gram(hp->io, x, y);
+            for (size_t b = 0; b < pixel_bytes; b++) {
+                CHECK(p[b] == pixel_byte(x_start, y, (x - x_start) * pixel_bytes + b));
+            }
+        }
+    }
+}
+
+static void test_scanline(const host_model_t *model, bool tracked)
+{
+    host_panel_t hp;
+    host_panel_new(model, &hp);
+    host_panel_start(&hp);
+    if (tracked) {
+        CHECK_OK(esp32s3_4dlcd_trans_track(hp.panel, NULL, NULL));
+    }
+    size_t pixel_bytes = esp32s3_4dlcd_pixel_bytes(hp.panel);
+
+    // the whole screen, a whole number of rows per chunk buffer
+    CHECK_OK(esp32s3_4dlcd_set_max_transfer(hp.panel, 0));
+    draw(&hp, 0, 0, model->width, model->height, CONFIG_ESP32S3_4DLCD_CHUNK_BUF_SIZE / pixel_bytes * pixel_bytes,
+         tracked, false);
+
+    // transfers of 1000 bytes: rows of 150 pixels go three or two at a time, the rest of the buffer unused
+    CHECK_OK(esp32s3_4dlcd_set_max_transfer(hp.panel, 1000));
+    size_t cap = 1000 / pixel_bytes * pixel_bytes;
+    draw(&hp, 10, 20, 160, 37, cap, tracked, false);
+
+    // the producer's error stops the draw after the chunks already sent
+    producer_ctx_t ctx = {
+        .x_start = 0,
+        .y_start = 50,
+        .y_end = 80,
+        .row_bytes = 100 * pixel_bytes,
+        .cap = cap,
+        .next_y = 50,
+        .fail_call = 2,
+    };
+    mock_trace_clear();
+    CHECK_ERR(esp32s3_4dlcd_draw_lines(hp.panel, 0, 50, 100, 80, producer, &ctx), ESP_ERR_INVALID_STATE);
+    CHECK(ctx.calls == 3);
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    size_t colors = 0;
+    for (size_t i = 0; i < mock_trace_count(); i++) {
+        colors += mock_trace_get(i)->type == MOCK_TRACE_COLOR;
+    }
+    CHECK(colors == 2);
+    // and the next draw in the same window starts the memory write over
+    draw(&hp, 0, 50, 100, 80, cap, tracked, true);
+
+    // rows of exactly a transfer, one per call
+    CHECK_OK(esp32s3_4dlcd_set_max_transfer(hp.panel, 100 * pixel_bytes));
+    cap = 100 * pixel_bytes;
+    draw(&hp, 5, 90, 105, 95, cap, tracked, false);
+
+    // a row wider than a chunk buffer is refused before the producer is called or a pixel is sent
+    ctx = (producer_ctx_t) {
+        .fail_call = -1,
+    };
+    mock_trace_clear();
+    CHECK_ERR(esp32s3_4dlcd_draw_lines(hp.panel, 0, 100, 101, 101, producer, &ctx), ESP_ERR_INVALID_SIZE);
+    CHECK(ctx.calls == 0);
+    for (size_t i = 0; i < mock_trace_count(); i++) {
+        CHECK(mock_trace_get(i)->type != MOCK_TRACE_COLOR);
+    }
+
+    CHECK_ERR(esp32s3_4dlcd_draw_lines(hp.panel, 0, 0, 0, 1, producer, &ctx), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_draw_lines(hp.panel, 0, 0, 1, 1, NULL, &ctx), ESP_ERR_INVALID_ARG);
+
+    CHECK(mock_io_gram_overruns(hp.io) == 0);
+    if (tracked) {
+        esp32s3_4dlcd_trans_untrack(hp.panel, NULL, NULL);
+    }
+    host_panel_del(&hp);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < host_model_count; i++) {
+        test_scanline(&host_models[i], false);
+        test_scanline(&host_models[i], true);
+    }
+    printf("ok\n");
+    return 0;
+}
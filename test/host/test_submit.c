@@ -0,0 +1,299 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Submission queue fed by producer tasks against a mock IO: contiguous draws merged into one window, only the last of
+// repeated state commands sent, submissions finding the queue full counted, completions reported only once the
+// batch has left the bus, and the statistics against what was submitted
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "test_host.h"
+
+#define NUM_PRODUCERS   3
+#define BAND_ROWS       96      // rows of the frame each producer draws
+#define STRIP_ROWS      8       // rows per submitted draw
+
+typedef struct {
+    host_panel_t *hp;
+    esp32s3_4dlcd_submit_handle_t submit;
+    const uint8_t *fb;          // frame in the panel format, what the frame memory must end up holding
+    size_t stride;
+    SemaphoreHandle_t finished; // given once per producer whose last command has completed
+    uint32_t completed[NUM_PRODUCERS];
+    uint32_t failed;
+} rig_t;
+
+typedef struct {
+    rig_t *rig;
+    uint8_t producer;
+    int y_start;
+    int y_end;
+} draw_ctx_t;
+
+// Count the `cmd` commands recorded since the trace was cleared
+static size_t count_cmds(int cmd)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < mock_trace_count(); i++) {
+        const mock_trace_entry_t *e = mock_trace_get(i);
+        count += e->type == MOCK_TRACE_PARAM && e->lcd_cmd == cmd;
+    }
+    return count;
+}
+
+// A draw completes only once its pixels are in the frame memory and nothing of the batch is left on the bus, so the
+// producer can reuse the buffer
+static void draw_done(esp_err_t result, void *user_ctx)
+{
+    draw_ctx_t *ctx = user_ctx;
+    rig_t *rig = ctx->rig;
+    if (result != ESP_OK || mock_io_in_flight(rig->hp->io)) {
+        rig->failed++;
+    }
+    int width = rig->hp->model->width;
+    for (int y = ctx->y_start; y < ctx->y_end; y++) {
+        if (memcmp(mock_io_gram(rig->hp->io, 0, y), rig->fb + y * rig->stride, width * 2)) {
+            rig->failed++;
+        }
+    }
+    rig->completed[ctx->producer]++;
+}
+
+static void sync_done(esp_err_t result, void *user_ctx)
+{
+    rig_t *rig = user_ctx;
+    if (result != ESP_OK) {
+        rig->failed++;
+    }
+    xSemaphoreGive(rig->finished);
+}
+
+static void submit_draw(rig_t *rig, draw_ctx_t *ctx, uint8_t producer, int y_start, int y_end)
+{
+    *ctx = (draw_ctx_t) {
+        .rig = rig,
+        .producer = producer,
+        .y_start = y_start,
+        .y_end = y_end,
+    };
+    esp32s3_4dlcd_submit_cmd_t cmd = {
+        .op = ESP32S3_4DLCD_SUBMIT_DRAW,
+        .producer = producer,
+        .draw = { 0, y_start, rig->hp->model->width, y_end, rig->fb + y_start * rig->stride },
+        .done_cb = draw_done,
+        .user_ctx = ctx,
+    };
+    CHECK_OK(esp32s3_4dlcd_submit(rig->submit, &cmd, portMAX_DELAY));
+}
+
+static void submit_sync(rig_t *rig, uint8_t producer)
+{
+    esp32s3_4dlcd_submit_cmd_t cmd = {
+        .op = ESP32S3_4DLCD_SUBMIT_SYNC,
+        .producer = producer,
+        .done_cb = sync_done,
+        .user_ctx = rig,
+    };
+    CHECK_OK(esp32s3_4dlcd_submit(rig->submit, &cmd, portMAX_DELAY));
+}
+
+typedef struct {
+    rig_t *rig;
+    uint8_t producer;
+    draw_ctx_t strips[BAND_ROWS / STRIP_ROWS];
+} producer_t;
+
+// Draw the producer's band strip by strip, top down, then wait for it with a sync
+static void producer_task(void *arg)
+{
+    producer_t *p = arg;
+    int y = p->producer * BAND_ROWS;
+    for (size_t i = 0; i < BAND_ROWS / STRIP_ROWS; i++, y += STRIP_ROWS) {
+        submit_draw(p->rig, &p->strips[i], p->producer, y, y + STRIP_ROWS);
+    }
+    submit_sync(p->rig, p->producer);
+    vTaskDelete(NULL);
+}
+
+static void rig_init(rig_t *rig, host_panel_t *hp, uint8_t *fb, size_t queue_size)
+{
+    int width = hp->model->width;
+    int height = hp->model->height;
+    *rig = (rig_t) {
+        .hp = hp,
+        .fb = fb,
+        .stride = (size_t)width * 2,
+        .finished = xSemaphoreCreateCounting(NUM_PRODUCERS, 0),
+    };
+    CHECK(rig->finished);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width * 2; x++) {
+            fb[y * rig->stride + x] = (uint8_t)(x * 7 + y * 13 + 1);
+        }
+    }
+    esp32s3_4dlcd_submit_config_t config = ESP32S3_4DLCD_SUBMIT_DEFAULT_CONFIG();
+    config.queue_size = queue_size;
+    CHECK_OK(esp32s3_4dlcd_submit_new(hp->panel, &config, &rig->submit));
+}
+
+static void rig_del(rig_t *rig)
+{
+    CHECK_OK(esp32s3_4dlcd_submit_del(rig->submit));
+    vSemaphoreDelete(rig->finished);
+}
+
+// One producer, deterministic: the first draw keeps the flush task on the bus while the rest queue up behind it
+static void test_batches(host_panel_t *hp, uint8_t *fb)
+{
+    rig_t rig;
+    rig_init(&rig, hp, fb, 32);
+    int width = hp->model->width;
+    mock_trace_clear();
+
+    // the flush task takes the first strip alone, the next four continue it in the frame and go out as one window
+    draw_ctx_t strips[5];
+    for (int i = 0; i < 5; i++) {
+        submit_draw(&rig, &strips[i], 0, i * STRIP_ROWS, (i + 1) * STRIP_ROWS);
+    }
+    // a strip that does not continue the previous one keeps its own window
+    draw_ctx_t apart;
+    submit_draw(&rig, &apart, 0, 100, 100 + STRIP_ROWS);
+    // of repeated state commands only the last is sent
+    const bool inverts[] = { true, false, true };
+    for (size_t i = 0; i < 3; i++) {
+        esp32s3_4dlcd_submit_cmd_t cmd = {
+            .op = ESP32S3_4DLCD_SUBMIT_INVERT,
+            .invert_color = inverts[i],
+        };
+        CHECK_OK(esp32s3_4dlcd_submit(rig.submit, &cmd, portMAX_DELAY));
+    }
+    const bool mirrors[][2] = { { true, false }, { false, true } };
+    for (size_t i = 0; i < 2; i++) {
+        esp32s3_4dlcd_submit_cmd_t cmd = {
+            .op = ESP32S3_4DLCD_SUBMIT_MIRROR,
+            .mirror = { mirrors[i][0], mirrors[i][1] },
+        };
+        CHECK_OK(esp32s3_4dlcd_submit(rig.submit, &cmd, portMAX_DELAY));
+    }
+    submit_sync(&rig, 0);
+    CHECK(xSemaphoreTake(rig.finished, portMAX_DELAY));
+
+    CHECK(count_cmds(0x2B) == 3);
+    CHECK(count_cmds(0x20) == 0 && count_cmds(0x21) == 1);
+    CHECK(count_cmds(0x36) == 1);
+    for (size_t i = 0; i < mock_trace_count(); i++) {
+        const mock_trace_entry_t *e = mock_trace_get(i);
+        if (e->type == MOCK_TRACE_PARAM && e->lcd_cmd == 0x2B && e->data[1] == STRIP_ROWS) {
+            // the merged window runs to the end of the fifth strip
+            CHECK((e->data[2] << 8 | e->data[3]) == 5 * STRIP_ROWS - 1);
+        }
+    }
+    CHECK(rig.completed[0] == 6 && !rig.failed);
+    for (int y = 0; y < 5 * STRIP_ROWS; y++) {
+        CHECK(!memcmp(mock_io_gram(hp->io, 0, y), fb + y * rig.stride, width * 2));
+    }
+
+    esp32s3_4dlcd_submit_stats_t stats;
+    CHECK_OK(esp32s3_4dlcd_submit_get_stats(rig.submit, &stats));
+    CHECK(stats.commands == 12);
+    CHECK(stats.batches == 2);
+    // three strips, two inverts and one mirror
+    CHECK(stats.merged == 6);
+    CHECK(stats.queue_full == 0);
+    CHECK(stats.queue_high_water == 11);
+    CHECK(stats.producers[0].commands == 12);
+    CHECK(stats.producers[0].max_latency_us > 0);
+    CHECK(stats.producers[0].total_latency_us >= stats.producers[0].max_latency_us);
+    CHECK_OK(esp32s3_4dlcd_submit_reset_stats(rig.submit));
+    CHECK_OK(esp32s3_4dlcd_submit_get_stats(rig.submit, &stats));
+    CHECK(stats.commands == 0 && stats.batches == 0 && stats.producers[0].commands == 0);
+    rig_del(&rig);
+}
+
+// Several producer tasks on a queue too small for them: each gets its band drawn, in order, through a full queue
+static void test_producers(host_panel_t *hp, uint8_t *fb)
+{
+    rig_t rig;
+    rig_init(&rig, hp, fb, 4);
+    int width = hp->model->width;
+    mock_trace_clear();
+
+    producer_t producers[NUM_PRODUCERS];
+    for (uint8_t i = 0; i < NUM_PRODUCERS; i++) {
+        producers[i] = (producer_t) {
+            .rig = &rig,
+            .producer = i,
+        };
+        CHECK(xTaskCreatePinnedToCore(producer_task, "producer", 4096, &producers[i], 4, NULL, i % 2) == pdPASS);
+    }
+    for (int i = 0; i < NUM_PRODUCERS; i++) {
+        CHECK(xSemaphoreTake(rig.finished, portMAX_DELAY));
+    }
+
+    const uint32_t strips = BAND_ROWS / STRIP_ROWS;
+    esp32s3_4dlcd_submit_stats_t stats;
+    CHECK_OK(esp32s3_4dlcd_submit_get_stats(rig.submit, &stats));
+    CHECK(stats.commands == NUM_PRODUCERS * (strips + 1));
+    for (int i = 0; i < NUM_PRODUCERS; i++) {
+        CHECK(rig.completed[i] == strips);
+        CHECK(stats.producers[i].commands == strips + 1);
+    }
+    CHECK(!rig.failed);
+    // every window the bus saw is a draw that was not merged away
+    CHECK(stats.merged > 0);
+    CHECK(count_cmds(0x2B) == NUM_PRODUCERS * strips - stats.merged);
+    CHECK(stats.batches < stats.commands);
+    CHECK(stats.queue_full > 0);
+    CHECK(stats.queue_high_water == 4);
+    for (int y = 0; y < NUM_PRODUCERS * BAND_ROWS; y++) {
+        CHECK(!memcmp(mock_io_gram(hp->io, 0, y), fb + y * rig.stride, width * 2));
+    }
+    CHECK(mock_io_gram_overruns(hp->io) == 0);
+    rig_del(&rig);
+}
+
+static void test_invalid(host_panel_t *hp)
+{
+    esp32s3_4dlcd_submit_config_t config = ESP32S3_4DLCD_SUBMIT_DEFAULT_CONFIG();
+    esp32s3_4dlcd_submit_handle_t submit;
+    config.queue_size = 24;
+    CHECK_ERR(esp32s3_4dlcd_submit_new(hp->panel, &config, &submit), ESP_ERR_INVALID_ARG);
+    config.queue_size = 4;
+    CHECK_ERR(esp32s3_4dlcd_submit_new(NULL, &config, &submit), ESP_ERR_INVALID_ARG);
+    CHECK_OK(esp32s3_4dlcd_submit_new(hp->panel, &config, &submit));
+    esp32s3_4dlcd_submit_cmd_t cmd = {
+        .op = ESP32S3_4DLCD_SUBMIT_SYNC,
+        .producer = ESP32S3_4DLCD_SUBMIT_MAX_PRODUCERS,
+    };
+    CHECK_ERR(esp32s3_4dlcd_submit(submit, &cmd, portMAX_DELAY), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_submit_get_stats(submit, NULL), ESP_ERR_INVALID_ARG);
+    CHECK_OK(esp32s3_4dlcd_submit_del(submit));
+    CHECK_ERR(esp32s3_4dlcd_submit_del(NULL), ESP_ERR_INVALID_ARG);
+}
+
+int main(void)
+{
+    // SPI with 2 bytes per pixel, the frame goes to the frame memory as is
+    const host_model_t *model = &host_models[0];
+    host_panel_t hp;
+    host_panel_new(model, &hp);
+    host_panel_start(&hp);
+    uint8_t *fb = malloc((size_t)model->width * model->height * 2);
+    CHECK(fb);
+
+    test_batches(&hp, fb);
+    test_producers(&hp, fb);
+    test_invalid(&hp);
+
+    free(fb);
+    host_panel_del(&hp);
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// The TE presenter against a simulated panel scan. A pulse source stands in for the TE output; the scan reads native
+// row n at n / rows of a period after each pulse. Every frame the presenter counts as synced must write each of its
+// rows at least the margin away from any time the scan reads that row.
+
+#include <string.h>
+#include <sys/param.h>
+#include "esp32s3_4dlcd_priv.h"
+#include "esp32s3_4dlcd_te_schedule.h"
+#include "test_host.h"
+
+#define TE_GPIO             5
+#define PERIOD_NS           16666666    // 60Hz refresh
+#define MARGIN_US           500
+#define WARMUP_FRAMES       3           // the refresh period is measured over the first pulses
+#define FRAMES              6
+
+// Commands sent between the scheduled start and the first pixel, which the margin absorbs
+#define OVERHEAD_NS         20000
+
+typedef struct {
+    int x_start;
+    int y_start;
+    int x_end;
+    int y_end;
+} window_t;
+
+// Closest the scan comes to the write of native row `row`, over [write_start, write_end]. Reads before the pulse the
+// write started from were over when it came, and the write ends within the refresh after.
+static int64_t scan_distance(int rows, int row, int64_t first_pulse_ns, int64_t write_start, int64_t write_end)
+{
+    int64_t read_offset = (int64_t)row * PERIOD_NS / rows;
+    int64_t pulse = (write_start - first_pulse_ns) / PERIOD_NS;
+    int64_t closest = INT64_MAX;
+    for (int64_t i = pulse; i <= pulse + 2; i++) {
+        int64_t read = first_pulse_ns + i * PERIOD_NS + read_offset;
+        int64_t d = read < write_start ? write_start - read : read > write_end ? read - write_end : 0;
+        closest = MIN(closest, d);
+    }
+    return closest;
+}
+
+// Time the bus clocks out byte `offset` of the colour data recorded in the trace
+static int64_t byte_time(size_t offset)
+{
+    for (size_t i = 0; i < mock_trace_count(); i++) {
+        const mock_trace_entry_t *e = mock_trace_get(i);
+        if (e->type != MOCK_TRACE_COLOR) {
+            continue;
+        }
+        if (offset < e->bytes) {
+            return e->bus_start_ns + (e->bus_end_ns - e->bus_start_ns) * (int64_t)offset / (int64_t)e->bytes;
+        }
+        offset -= e->bytes;
+    }
+    CHECK(false);
+    return 0;
+}
+
+// Check the frame just written, whose trace is recorded, keeps clear of the scan; the closest approach in ns
+static int64_t check_frame(host_panel_t *hp, const window_t *w, bool mirror_y, int64_t first_pulse_ns)
+{
+    int rows = hp->model->height;
+    size_t row_bytes = (size_t)(w->x_end - w->x_start) * esp32s3_4dlcd_pixel_bytes(hp->panel);
+    int64_t closest = INT64_MAX;
+    for (int i = 0; i < w->y_end - w->y_start; i++) {
+        int y = w->y_start + i;
+        int native = mirror_y ? rows - 1 - y : y;
+        int64_t start = byte_time(i * row_bytes);
+        int64_t end = byte_time((i + 1) * row_bytes - 1);
+        closest = MIN(closest, scan_distance(rows, native, first_pulse_ns, start, end));
+    }
+    return closest;
+}
+
+static void test_te(const host_model_t *model, esp32s3_4dlcd_te_mode_t mode, bool mirror_y)
+{
+    host_panel_t hp;
+    host_panel_new(model, &hp);
+    host_panel_start(&hp);
+    CHECK_OK(esp_lcd_panel_mirror(hp.panel, false, mirror_y));
+
+    esp32s3_4dlcd_te_config_t config = {
+        .gpio_num = TE_GPIO,
+        .mode = mode,
+        .pclk_hz = model->io.pclk_hz,
+        .bus_width = model->io.bus_width,
+        .margin_us = MARGIN_US,
+    };
+    esp32s3_4dlcd_te_handle_t te;
+    CHECK_OK(esp32s3_4dlcd_te_new(hp.panel, &config, &te));
+    int64_t first_pulse_ns = mock_time_ns() + 1234567;
+    mock_gpio_pulse(TE_GPIO, first_pulse_ns, PERIOD_NS);
+
+    int w = model->width;
+    int h = model->height;
+    const window_t windows[] = {
+        { 0, 0, w, 40 },
+        { 0, h / 2 - 20, w, h / 2 + 20 },
+        { 0, h - 40, w, h },
+        { 10, 100, 74, 164 },
+        { 0, 0, w, h / 2 },
+        { 0, h / 2, w, h },
+        { 0, 0, w, h },
+    };
+    size_t pixels = (size_t)w * h;
+    uint8_t *data = calloc(pixels, esp32s3_4dlcd_src_pixel_bytes(hp.panel));
+    CHECK(data);
+
+    for (int i = 0; i < WARMUP_FRAMES; i++) {
+        CHECK_OK(esp32s3_4dlcd_te_present(te, 0, 0, w, 10, data));
+    }
+    for (size_t n = 0; n < sizeof(windows) / sizeof(windows[0]); n++) {
+        const window_t *win = &windows[n];
+        int synced = 0;
+        for (int i = 0; i < FRAMES; i++) {
+            esp32s3_4dlcd_te_stats_t before;
+            esp32s3_4dlcd_te_stats_t after;
+            CHECK_OK(esp32s3_4dlcd_te_get_stats(te, &before));
+            CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+            mock_trace_clear();
+            CHECK_OK(esp32s3_4dlcd_te_present(te, win->x_start, win->y_start, win->x_end, win->y_end, data));
+            CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+            CHECK_OK(esp32s3_4dlcd_te_get_stats(te, &after));
+            if (after.unsynced != before.unsynced) {
+                continue;
+            }
+            synced++;
+            int64_t closest = check_frame(&hp, win, mirror_y, first_pulse_ns);
+            if (closest < MARGIN_US * 1000 - OVERHEAD_NS) {
+                fprintf(stderr, "%s %s%s: window rows %d..%d written %lld ns from the scan\n", model->name,
+                        mode == ESP32S3_4DLCD_TE_CHASE ? "chase" : "vblank", mirror_y ? " mirrored" : "",
+                        win->y_start, win->y_end, (long long)closest);
+                exit(1);
+            }
+        }
+        // a 40-row band is always placed clear of the scan when chasing it
+        if (mode == ESP32S3_4DLCD_TE_CHASE && win->y_end - win->y_start <= 40) {
+            CHECK(synced == FRAMES);
+        }
+        printf("%s %s%s rows %d..%d: %d/%d synced\n", model->name, mode == ESP32S3_4DLCD_TE_CHASE ? "chase" : "vblank",
+               mirror_y ? " mirrored" : "", win->y_start, win->y_end, synced, FRAMES);
+    }
+
+    mock_gpio_pulse(TE_GPIO, 0, 0);
+    CHECK_OK(esp32s3_4dlcd_te_del(te));
+    free(data);
+    host_panel_del(&hp);
+}
+
+// The schedule on its own: 320 rows scanned in 16ms, 50us per row
+static void test_schedule(void)
+{
+    int64_t delay;
+    // a band low on the panel is written before the scan gets there
+    CHECK(esp32s3_4dlcd_te_schedule(16000000, 320, 50000, 200, 240, false, 500000, &delay) && delay == 0);
+    // the top band follows the scan down, the margin behind it
+    CHECK(esp32s3_4dlcd_te_schedule(16000000, 320, 50000, 0, 40, false, 500000, &delay) && delay == 500000);
+    // written bottom first it would meet the scan, so it waits until the scan has passed the bottom row
+    CHECK(esp32s3_4dlcd_te_schedule(16000000, 320, 50000, 0, 40, true, 500000, &delay) && delay == 2500000);
+    CHECK(esp32s3_4dlcd_te_schedule(16000000, 320, 50000, 120, 160, true, 500000, &delay) && delay == 0);
+    // written against the scan, half the panel cannot stay clear of it
+    CHECK(!esp32s3_4dlcd_te_schedule(16000000, 320, 50000, 0, 160, true, 500000, &delay) && delay == 0);
+}
+
+int main(void)
+{
+    test_schedule();
+    for (size_t i = 0; i < host_model_count; i++) {
+        test_te(&host_models[i], ESP32S3_4DLCD_TE_CHASE, false);
+        test_te(&host_models[i], ESP32S3_4DLCD_TE_CHASE, true);
+        test_te(&host_models[i], ESP32S3_4DLCD_TE_VBLANK, false);
+    }
+    printf("ok\n");
+    return 0;
+}
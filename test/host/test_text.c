@@ -0,0 +1,110 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Text rendering against a per-pixel reference, read back from the simulated frame memory: every bit depth on every
+// model, the fallback glyph, colour changes and clipping at the panel edges
+
+#include <string.h>
+#include "esp32s3_4dlcd_pixel.h"
+#include "esp32s3_4dlcd_priv.h"
+#include "test_host.h"
+
+#define FONT_HEIGHT     12
+
+// Panel bytes of an RGB565 colour
+static void panel_colour(uint8_t *dst, uint16_t colour, size_t pixel_bytes)
+{
+    if (pixel_bytes == 3) {
+        esp32s3_4dlcd_rgb565_to_rgb666(dst, &colour, 1);
+    } else {
+        esp32s3_4dlcd_rgb565_to_be(dst, &colour, 1);
+    }
+}
+
+// Check `str` was drawn at `x`, `y`, clipped to the panel, and nothing right of it on its rows
+static void check_text(host_panel_t *hp, const esp32s3_4dlcd_font_t *font, int x, int y, const char *str, uint16_t fg,
+                       uint16_t bg)
+{
+    size_t pixel_bytes = esp32s3_4dlcd_pixel_bytes(hp->panel);
+    uint32_t max = (1 << font->bpp) - 1;
+    for (int row = 0; row < font->height && y + row < hp->model->height; row++) {
+        int px = x;
+        for (const uint8_t *s = (const uint8_t *)str; *s; s++) {
+            const esp32s3_4dlcd_glyph_t *glyph = host_font_glyph(font, *s);
+            for (int col = 0; col < glyph->advance && px < hp->model->width; col++, px++) {
+                uint8_t expected[3];
+                panel_colour(expected, host_blend565(fg, bg, host_font_alpha(font, glyph, row, col), max), pixel_bytes);
+                if (memcmp(mock_io_gram(hp->io, px, y + row), expected, pixel_bytes)) {
+                    fprintf(stderr, "%s %d-bit: \"%s\" differs at %d,%d\n", hp->model->name, font->bpp, str, px, y + row);
+                    exit(1);
+                }
+            }
+        }
+    }
+}
+
+static void test_text(const host_model_t *model, int bpp)
+{
+    host_panel_t hp;
+    host_panel_new(model, &hp);
+    host_panel_start(&hp);
+    esp32s3_4dlcd_font_t font;
+    host_font_make(bpp, FONT_HEIGHT, &font);
+    esp32s3_4dlcd_text_handle_t text;
+    CHECK_OK(esp32s3_4dlcd_text_new(hp.panel, &font, &text));
+
+    const char *str = "Hello, 4D Systems! {0123456789} ~";
+    int expected_width = 0;
+    for (const uint8_t *s = (const uint8_t *)str; *s; s++) {
+        expected_width += host_font_glyph(&font, *s)->advance;
+    }
+    CHECK(esp32s3_4dlcd_text_width(text, str) == expected_width);
+
+    int width;
+    CHECK_OK(esp32s3_4dlcd_text_draw(text, 3, 5, str, 0xFFFF, 0x0000, &width));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    CHECK(width == expected_width);
+    check_text(&hp, &font, 3, 5, str, 0xFFFF, 0x0000);
+
+    // other colours rebuild the table, characters outside the font draw the fallback
+    CHECK_OK(esp32s3_4dlcd_text_draw(text, 0, 20, "a\x01\xff?z", 0xF81F, 0x07E0, NULL));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    check_text(&hp, &font, 0, 20, "a??" "?z", 0xF81F, 0x07E0);
+
+    // clipped at the right edge, the width is what was drawn
+    CHECK_OK(esp32s3_4dlcd_text_draw(text, model->width - 17, 40, str, 0x1234, 0xFEDC, &width));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    CHECK(width == 17);
+    check_text(&hp, &font, model->width - 17, 40, str, 0x1234, 0xFEDC);
+
+    // and at the bottom
+    CHECK_OK(esp32s3_4dlcd_text_draw(text, 30, model->height - 5, str, 0x8410, 0x0841, NULL));
+    CHECK_OK(esp32s3_4dlcd_bus_sync(hp.panel));
+    check_text(&hp, &font, 30, model->height - 5, str, 0x8410, 0x0841);
+
+    // entirely off the panel draws nothing
+    mock_trace_clear();
+    CHECK_OK(esp32s3_4dlcd_text_draw(text, model->width, 0, str, 0xFFFF, 0, &width));
+    CHECK(width == 0 && mock_trace_count() == 0);
+    CHECK(mock_io_gram_overruns(hp.io) == 0);
+
+    CHECK_OK(esp32s3_4dlcd_text_del(text));
+    host_font_free(&font);
+    host_panel_del(&hp);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < host_model_count; i++) {
+        test_text(&host_models[i], 1);
+        test_text(&host_models[i], 2);
+        test_text(&host_models[i], 4);
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,254 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Tile hashing of a frame buffer: single pixels flipped and the exact rectangles reported for them, tile runs joined
+// along a row and down matching rows, edge tiles clipped, and tiles grown to fit the hash budget
+
+#include <string.h>
+#include "test_host.h"
+
+#define FB_WIDTH        64
+#define FB_HEIGHT       48
+#define TILE_SIZE       8
+
+static uint8_t s_fb[FB_WIDTH * FB_HEIGHT * 3];
+
+// A tracker that keeps every rectangle as added: on a 1 MHz bus with no transaction overhead, the bounding box of two
+// tiles is only cheaper than both when it adds no pixels
+static esp32s3_4dlcd_damage_handle_t damage_new(void)
+{
+    esp32s3_4dlcd_damage_config_t config = {
+        .width = FB_WIDTH,
+        .height = FB_HEIGHT,
+        .max_rects = 64,
+        .pclk_hz = 1000 * 1000,
+        .bus_width = 1,
+        .bits_per_pixel = 16,
+    };
+    esp32s3_4dlcd_damage_handle_t damage;
+    CHECK_OK(esp32s3_4dlcd_damage_new(&config, &damage));
+    return damage;
+}
+
+static esp32s3_4dlcd_tilehash_handle_t tilehash_new(int width, int height, size_t bytes_per_pixel, size_t max_hash_bytes)
+{
+    esp32s3_4dlcd_tilehash_config_t config = {
+        .width = width,
+        .height = height,
+        .bytes_per_pixel = bytes_per_pixel,
+        .tile_width = TILE_SIZE,
+        .tile_height = TILE_SIZE,
+        .max_hash_bytes = max_hash_bytes,
+    };
+    esp32s3_4dlcd_tilehash_handle_t tilehash;
+    CHECK_OK(esp32s3_4dlcd_tilehash_new(&config, &tilehash));
+    return tilehash;
+}
+
+// Scan the frame buffer and check it reports exactly `expected`, in any order
+static void check_scan(esp32s3_4dlcd_tilehash_handle_t tilehash, esp32s3_4dlcd_damage_handle_t damage,
+                       const esp32s3_4dlcd_rect_t *expected, size_t count, int line)
+{
+    CHECK_OK(esp32s3_4dlcd_tilehash_scan(tilehash, s_fb, damage));
+    const esp32s3_4dlcd_rect_t *rects;
+    size_t got = esp32s3_4dlcd_damage_get_rects(damage, &rects);
+    bool ok = got == count;
+    for (size_t i = 0; ok && i < count; i++) {
+        ok = false;
+        for (size_t j = 0; j < got; j++) {
+            ok |= !memcmp(&expected[i], &rects[j], sizeof(rects[j]));
+        }
+    }
+    if (!ok) {
+        fprintf(stderr, "line %d: scan reported", line);
+        for (size_t j = 0; j < got; j++) {
+            fprintf(stderr, " %d,%d-%d,%d", rects[j].x_start, rects[j].y_start, rects[j].x_end, rects[j].y_end);
+        }
+        fprintf(stderr, ", expected %zu rectangles\n", count);
+        exit(1);
+    }
+    esp32s3_4dlcd_damage_clear(damage);
+}
+
+#define CHECK_SCAN(tilehash, damage, ...) do {                                      \
+        const esp32s3_4dlcd_rect_t expected_[] = { __VA_ARGS__ };                   \
+        check_scan(tilehash, damage, expected_, sizeof(expected_) / sizeof(expected_[0]), __LINE__); \
+    } while (0)
+
+#define CHECK_SCAN_NONE(tilehash, damage)   check_scan(tilehash, damage, NULL, 0, __LINE__)
+
+static void flip(int width, size_t bytes_per_pixel, int x, int y, size_t byte)
+{
+    s_fb[((size_t)y * width + x) * bytes_per_pixel + byte] ^= 0x01;
+}
+
+// Every byte of every pixel is seen, in the hash lanes and the tail, and only its tile is reported
+static void test_single_pixels(size_t bytes_per_pixel)
+{
+    esp32s3_4dlcd_damage_handle_t damage = damage_new();
+    esp32s3_4dlcd_tilehash_handle_t tilehash = tilehash_new(FB_WIDTH, FB_HEIGHT, bytes_per_pixel, 0);
+    memset(s_fb, 0, sizeof(s_fb));
+
+    // the first scan reports the whole frame, the next one nothing
+    CHECK_SCAN(tilehash, damage, { 0, 0, FB_WIDTH, FB_HEIGHT });
+    CHECK_SCAN_NONE(tilehash, damage);
+
+    for (int y = 0; y < FB_HEIGHT; y++) {
+        for (int x = 0; x < FB_WIDTH; x++) {
+            for (size_t byte = 0; byte < bytes_per_pixel; byte++) {
+                esp32s3_4dlcd_rect_t tile = {
+                    x / TILE_SIZE * TILE_SIZE, y / TILE_SIZE * TILE_SIZE,
+                    (x / TILE_SIZE + 1) * TILE_SIZE, (y / TILE_SIZE + 1) * TILE_SIZE,
+                };
+                flip(FB_WIDTH, bytes_per_pixel, x, y, byte);
+                check_scan(tilehash, damage, &tile, 1, __LINE__);
+                // flipping it back is a change too
+                flip(FB_WIDTH, bytes_per_pixel, x, y, byte);
+                check_scan(tilehash, damage, &tile, 1, __LINE__);
+            }
+        }
+    }
+
+    // invalidating reports the whole frame again, unchanged as it is
+    esp32s3_4dlcd_tilehash_invalidate(tilehash);
+    CHECK_SCAN(tilehash, damage, { 0, 0, FB_WIDTH, FB_HEIGHT });
+    CHECK_SCAN_NONE(tilehash, damage);
+
+    CHECK_OK(esp32s3_4dlcd_tilehash_del(tilehash));
+    CHECK_OK(esp32s3_4dlcd_damage_del(damage));
+}
+
+// Changed tiles next to each other in a tile row make one rectangle, runs over the same columns of consecutive tile
+// rows grow it downwards, anything else stays apart
+static void test_runs(void)
+{
+    esp32s3_4dlcd_damage_handle_t damage = damage_new();
+    esp32s3_4dlcd_tilehash_handle_t tilehash = tilehash_new(FB_WIDTH, FB_HEIGHT, 2, 0);
+    memset(s_fb, 0, sizeof(s_fb));
+    CHECK_SCAN(tilehash, damage, { 0, 0, FB_WIDTH, FB_HEIGHT });
+
+    // tiles 1 and 2 of a row
+    flip(FB_WIDTH, 2, 10, 3, 0);
+    flip(FB_WIDTH, 2, 23, 7, 1);
+    CHECK_SCAN(tilehash, damage, { 8, 0, 24, 8 });
+
+    // tiles 0 and 3 of a row
+    flip(FB_WIDTH, 2, 0, 9, 0);
+    flip(FB_WIDTH, 2, 31, 9, 0);
+    CHECK_SCAN(tilehash, damage, { 0, 8, 8, 16 }, { 24, 8, 32, 16 });
+
+    // a column of tiles down the whole frame, and the bottom two rows of the last column
+    for (int y = 0; y < FB_HEIGHT; y += TILE_SIZE) {
+        flip(FB_WIDTH, 2, 44, y + 5, 1);
+    }
+    flip(FB_WIDTH, 2, 63, 32, 0);
+    flip(FB_WIDTH, 2, 63, 47, 0);
+    CHECK_SCAN(tilehash, damage, { 40, 0, 48, FB_HEIGHT }, { 56, 32, 64, FB_HEIGHT });
+
+    // two tiles over one: the run changes width, so the rows stay apart, and the next run starts afresh
+    flip(FB_WIDTH, 2, 8, 16, 0);
+    flip(FB_WIDTH, 2, 16, 16, 0);
+    flip(FB_WIDTH, 2, 8, 24, 0);
+    flip(FB_WIDTH, 2, 8, 32, 0);
+    CHECK_SCAN(tilehash, damage, { 8, 16, 24, 24 }, { 8, 24, 16, 40 });
+
+    // a run interrupted by an unchanged tile row ends above it
+    flip(FB_WIDTH, 2, 50, 0, 0);
+    flip(FB_WIDTH, 2, 50, 8, 0);
+    flip(FB_WIDTH, 2, 50, 24, 0);
+    CHECK_SCAN(tilehash, damage, { 48, 0, 56, 16 }, { 48, 24, 56, 32 });
+
+    CHECK_OK(esp32s3_4dlcd_tilehash_del(tilehash));
+    CHECK_OK(esp32s3_4dlcd_damage_del(damage));
+}
+
+// Tiles past the right and bottom edges are cut to the frame
+static void test_edges(void)
+{
+    const int width = FB_WIDTH - 4;
+    const int height = FB_HEIGHT - 3;
+    esp32s3_4dlcd_damage_handle_t damage = damage_new();
+    esp32s3_4dlcd_tilehash_handle_t tilehash = tilehash_new(width, height, 3, 0);
+    memset(s_fb, 0, sizeof(s_fb));
+    CHECK_SCAN(tilehash, damage, { 0, 0, width, height });
+
+    flip(width, 3, width - 1, height - 1, 2);
+    CHECK_SCAN(tilehash, damage, { 56, 40, width, height });
+    flip(width, 3, width - 1, 0, 0);
+    flip(width, 3, 0, height - 1, 0);
+    CHECK_SCAN(tilehash, damage, { 56, 0, width, 8 }, { 0, 40, 8, height });
+
+    CHECK_OK(esp32s3_4dlcd_tilehash_del(tilehash));
+    CHECK_OK(esp32s3_4dlcd_damage_del(damage));
+}
+
+// Tiles grow, width first, until the table fits the budget, and a pixel then reports the bigger tile
+static void test_budget(void)
+{
+    esp32s3_4dlcd_damage_handle_t damage = damage_new();
+    memset(s_fb, 0, sizeof(s_fb));
+
+    // 8x6 tiles of 8x8 fit exactly
+    esp32s3_4dlcd_tilehash_handle_t tilehash = tilehash_new(FB_WIDTH, FB_HEIGHT, 2, 8 * 6 * sizeof(uint32_t));
+    CHECK_SCAN(tilehash, damage, { 0, 0, FB_WIDTH, FB_HEIGHT });
+    flip(FB_WIDTH, 2, 10, 3, 0);
+    CHECK_SCAN(tilehash, damage, { 8, 0, 16, 8 });
+    CHECK_OK(esp32s3_4dlcd_tilehash_del(tilehash));
+
+    // a byte less and they become 16x8
+    tilehash = tilehash_new(FB_WIDTH, FB_HEIGHT, 2, 8 * 6 * sizeof(uint32_t) - 1);
+    CHECK_SCAN(tilehash, damage, { 0, 0, FB_WIDTH, FB_HEIGHT });
+    flip(FB_WIDTH, 2, 10, 3, 0);
+    CHECK_SCAN(tilehash, damage, { 0, 0, 16, 8 });
+    flip(FB_WIDTH, 2, 40, 20, 0);
+    CHECK_SCAN(tilehash, damage, { 32, 16, 48, 24 });
+    CHECK_OK(esp32s3_4dlcd_tilehash_del(tilehash));
+
+    // 16x16: width, then height
+    tilehash = tilehash_new(FB_WIDTH, FB_HEIGHT, 2, 4 * 3 * sizeof(uint32_t));
+    CHECK_SCAN(tilehash, damage, { 0, 0, FB_WIDTH, FB_HEIGHT });
+    flip(FB_WIDTH, 2, 40, 20, 0);
+    CHECK_SCAN(tilehash, damage, { 32, 16, 48, 32 });
+    CHECK_OK(esp32s3_4dlcd_tilehash_del(tilehash));
+
+    // one tile for the whole frame
+    tilehash = tilehash_new(FB_WIDTH, FB_HEIGHT, 2, sizeof(uint32_t));
+    CHECK_SCAN(tilehash, damage, { 0, 0, FB_WIDTH, FB_HEIGHT });
+    CHECK_SCAN_NONE(tilehash, damage);
+    flip(FB_WIDTH, 2, 63, 47, 1);
+    CHECK_SCAN(tilehash, damage, { 0, 0, FB_WIDTH, FB_HEIGHT });
+    CHECK_OK(esp32s3_4dlcd_tilehash_del(tilehash));
+
+    // not even that
+    esp32s3_4dlcd_tilehash_config_t config = {
+        .width = FB_WIDTH,
+        .height = FB_HEIGHT,
+        .bytes_per_pixel = 2,
+        .tile_width = TILE_SIZE,
+        .tile_height = TILE_SIZE,
+        .max_hash_bytes = sizeof(uint32_t) - 1,
+    };
+    CHECK_ERR(esp32s3_4dlcd_tilehash_new(&config, &tilehash), ESP_ERR_INVALID_SIZE);
+    config.max_hash_bytes = 0;
+    config.tile_width = 0;
+    CHECK_ERR(esp32s3_4dlcd_tilehash_new(&config, &tilehash), ESP_ERR_INVALID_ARG);
+    CHECK_ERR(esp32s3_4dlcd_tilehash_new(NULL, &tilehash), ESP_ERR_INVALID_ARG);
+
+    CHECK_OK(esp32s3_4dlcd_damage_del(damage));
+}
+
+int main(void)
+{
+    test_single_pixels(2);
+    test_single_pixels(3);
+    test_runs();
+    test_edges();
+    test_budget();
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+// Command traces of bring-up and drawing, per model, against the golden traces in golden/. Run with UPDATE_GOLDEN=1
+// to rewrite them after an intended change, and review the diff.
+
+#include <string.h>
+#include "esp32s3_4dlcd_priv.h"
+#include "test_host.h"
+
+static uint8_t *pattern(size_t bytes, unsigned seed)
+{
+    uint8_t *p = malloc(bytes);
+    CHECK(p);
+    for (size_t i = 0; i < bytes; i++) {
+        p[i] = (uint8_t)(i * 7 + seed * 31 + (i >> 8));
+    }
+    return p;
+}
+
+static void draw(host_panel_t *hp, int x_start, int y_start, int x_end, int y_end, unsigned seed)
+{
+    size_t bytes = (size_t)(x_end - x_start) * (y_end - y_start) * esp32s3_4dlcd_src_pixel_bytes(hp->panel);
+    uint8_t *data = pattern(bytes, seed);
+    CHECK_OK(esp_lcd_panel_draw_bitmap(hp->panel, x_start, y_start, x_end, y_end, data));
+    // the panel IO reads the pixels as it sends them
+    while (mock_io_in_flight(hp->io)) {
+        mock_wait_next(INT64_MAX);
+    }
+    free(data);
+}
+
+static void run_scenario(const host_model_t *model)
+{
+    host_panel_t hp;
+    mock_trace_clear();
+    host_panel_new(model, &hp);
+    host_panel_start(&hp);
+
+    draw(&hp, 0, 0, 16, 16, 1);
+    size_t count = mock_trace_count();
+    draw(&hp, 0, 0, 16, 16, 2);
+    // the same window again is not addressed again
+    for (size_t i = count; i < mock_trace_count(); i++) {
+        CHECK(mock_trace_get(i)->type == MOCK_TRACE_COLOR);
+    }
+    draw(&hp, 32, 16, 48, 32, 3);
+    draw(&hp, 0, 40, model->width, 56, 4);
+
+    CHECK_OK(esp_lcd_panel_mirror(hp.panel, true, false));
+    CHECK_OK(esp_lcd_panel_swap_xy(hp.panel, true));
+    draw(&hp, 8, 8, 24, 24, 5);
+    CHECK_OK(esp_lcd_panel_invert_color(hp.panel, true));
+    CHECK_OK(esp_lcd_panel_disp_on_off(hp.panel, false));
+    CHECK(mock_io_gram_overruns(hp.io) == 0);
+    host_panel_del(&hp);
+}
+
+static char *read_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *text = calloc(1, size + 1);
+    CHECK(text && fread(text, 1, size, f) == (size_t)size);
+    fclose(f);
+    return text;
+}
+
+int main(void)
+{
+    bool update = getenv("UPDATE_GOLDEN") != NULL;
+    int failures = 0;
+
+    for (size_t i = 0; i < host_model_count; i++) {
+        const host_model_t *model = &host_models[i];
+        char path[64];
+        snprintf(path, sizeof(path), "golden/%s.trace", model->name);
+        run_scenario(model);
+
+        if (update) {
+            FILE *f = fopen(path, "w");
+            CHECK(f);
+            mock_trace_write(f);
+            fclose(f);
+            printf("%s: written\n", path);
+            continue;
+        }
+        char *trace;
+        size_t size;
+        FILE *f = open_memstream(&trace, &size);
+        CHECK(f);
+        mock_trace_write(f);
+        fclose(f);
+        char *golden = read_file(path);
+        if (!golden || strcmp(golden, trace)) {
+            fprintf(stderr, "%s: trace differs, UPDATE_GOLDEN=1 rewrites it\n", path);
+            failures++;
+        } else {
+            printf("%s: ok\n", path);
+        }
+        free(golden);
+        free(trace);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,272 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp32s3_4dlcd_priv.h"
+#include "bench.h"
+
+static const char *TAG = "bench";
+
+#define BENCH_TASK_STACK    4096
+#define BENCH_TASK_PRIO     5
+
+static const char *const workload_names[BENCH_MAX] = {
+    [BENCH_FULL_FRAME] = "full_frame",
+    [BENCH_STRIP] = "strip",
+    [BENCH_SMALL_RECT] = "small_rect",
+    [BENCH_FILL] = "fill",
+    [BENCH_INIT] = "init",
+};
+
+typedef struct {
+    esp_lcd_panel_handle_t panel;
+    const bench_config_t *config;
+    int width;              // frame size in draw_bitmap coordinates, after software rotation
+    int height;
+    int native_width;       // frame size draw_lines and the fills address, which software rotation does not apply to
+    int native_height;
+    uint8_t *buf;           // DMA capable source pixels for the strip and small rectangle draws
+} bench_ctx_t;
+
+// Full frame rows are generated into the chunk buffers, so no frame buffer is needed
+static esp_err_t gradient_lines(int y, int lines, void *dst, void *user_ctx)
+{
+    bench_ctx_t *ctx = (bench_ctx_t *)user_ctx;
+    size_t row_bytes = ctx->native_width * esp32s3_4dlcd_pixel_bytes(ctx->panel);
+    for (int i = 0; i < lines; i++) {
+        memset((uint8_t *)dst + i * row_bytes, (y + i) & 0xFF, row_bytes);
+    }
+    return ESP_OK;
+}
+
+// One call of a workload, returning the pixel bytes it sends
+static esp_err_t bench_call(bench_ctx_t *ctx, bench_workload_t workload, int i, size_t *bytes)
+{
+    esp_lcd_panel_handle_t panel = ctx->panel;
+    size_t pixel_bytes = esp32s3_4dlcd_pixel_bytes(panel);
+    int strip_rows = MIN(ctx->config->strip_rows, ctx->height);
+    int rect = MIN(ctx->config->rect_size, MIN(ctx->width, ctx->height));
+
+    switch (workload) {
+    case BENCH_FULL_FRAME:
+        *bytes = (size_t)ctx->native_width * ctx->native_height * pixel_bytes;
+        return esp32s3_4dlcd_draw_lines(panel, 0, 0, ctx->native_width, ctx->native_height, gradient_lines, ctx);
+    case BENCH_STRIP: {
+        // walk down the frame so the address window changes on every call
+        int y = (i * strip_rows) % (ctx->height - strip_rows + 1);
+        *bytes = (size_t)ctx->width * strip_rows * pixel_bytes;
+        return esp_lcd_panel_draw_bitmap(panel, 0, y, ctx->width, y + strip_rows, ctx->buf);
+    }
+    case BENCH_SMALL_RECT: {
+        int x = (i * rect) % (ctx->width - rect + 1);
+        int y = (i * rect) % (ctx->height - rect + 1);
+        *bytes = (size_t)rect * rect * pixel_bytes;
+        return esp_lcd_panel_draw_bitmap(panel, x, y, x + rect, y + rect, ctx->buf);
+    }
+    case BENCH_FILL:
+        *bytes = (size_t)ctx->native_width * ctx->native_height * pixel_bytes;
+        return esp32s3_4dlcd_fill_rect(panel, 0, 0, ctx->native_width, ctx->native_height, (uint16_t)(i * 0x0841));
+    case BENCH_INIT:
+        *bytes = 0;
+        ESP_RETURN_ON_ERROR(esp_lcd_panel_reset(panel), TAG, "reset failed");
+        return esp_lcd_panel_init(panel);
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+}
+
+static esp_err_t bench_workload(bench_ctx_t *ctx, bench_workload_t workload, bench_result_t *result)
+{
+    const bench_config_t *config = ctx->config;
+    int64_t cpu_us = 0;
+    size_t bytes = 0;
+
+    ESP_RETURN_ON_ERROR(esp32s3_4dlcd_bus_sync(ctx->panel), TAG, "bus sync failed");
+#if CONFIG_ESP32S3_4DLCD_PERF_COUNTERS
+    esp32s3_4dlcd_perf_t perf_start;
+    esp32s3_4dlcd_get_perf(ctx->panel, &perf_start);
+#endif
+    uint32_t seq_start = esp32s3_4dlcd_trans_seq(ctx->panel);
+    int64_t start_us = esp_timer_get_time();
+    for (int i = 0; i < config->iterations; i++) {
+        int64_t call_us = esp_timer_get_time();
+        ESP_RETURN_ON_ERROR(bench_call(ctx, workload, i, &bytes), TAG, "%s failed", workload_names[workload]);
+        cpu_us += esp_timer_get_time() - call_us;
+    }
+    ESP_RETURN_ON_ERROR(esp32s3_4dlcd_bus_sync(ctx->panel), TAG, "bus sync failed");
+    int64_t wall_us = esp_timer_get_time() - start_us;
+
+    *result = (bench_result_t) {
+        .workload = workload,
+        .calls = config->iterations,
+        .bytes_per_call = bytes,
+        .cpu_us = cpu_us / config->iterations,
+        .wall_us = wall_us / config->iterations,
+        .wire_us = bench_wire_time_us(bytes, config->pclk_hz, config->bus_width),
+        .color_trans_per_call = (esp32s3_4dlcd_trans_seq(ctx->panel) - seq_start) / config->iterations,
+    };
+    // what the driver could sustain if the bus were the only limit, and what it did sustain
+    uint32_t bound_us = MAX(result->cpu_us, result->wire_us);
+    result->fps_ceiling = bound_us ? 1000000.0f / bound_us : 0;
+    result->fps_measured = result->wall_us ? 1000000.0f / result->wall_us : 0;
+    result->wire_utilization = result->wall_us ? (float)result->wire_us / result->wall_us : 0;
+#if CONFIG_ESP32S3_4DLCD_PERF_COUNTERS
+    esp32s3_4dlcd_perf_t perf_end;
+    esp32s3_4dlcd_get_perf(ctx->panel, &perf_end);
+    result->commands_per_call = (perf_end.cmd_count - perf_start.cmd_count) / config->iterations;
+#endif
+    return ESP_OK;
+}
+
+uint32_t bench_wire_time_us(size_t bytes, uint32_t pclk_hz, uint8_t bus_width)
+{
+    if (!pclk_hz || !bus_width) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)bytes * 8 * 1000000 / ((uint64_t)pclk_hz * bus_width));
+}
+
+esp_err_t bench_run(esp_lcd_panel_handle_t panel, const bench_config_t *config,
+                    bench_result_t *results, size_t *count)
+{
+    ESP_RETURN_ON_FALSE(panel && config && results && count && config->iterations > 0 && config->strip_rows > 0 &&
+                        config->rect_size > 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp_err_t ret = ESP_OK;
+    bench_ctx_t ctx = {
+        .panel = panel,
+        .config = config,
+    };
+    esp32s3_4dlcd_frame_size(panel, &ctx.width, &ctx.height);
+    esp32s3_4dlcd_unrotated_size(panel, &ctx.native_width, &ctx.native_height);
+
+    // one buffer serves both the strip and the small rectangle, the pixel values do not matter
+    size_t src_bytes = esp32s3_4dlcd_src_pixel_bytes(panel);
+    size_t buf_size = MAX((size_t)ctx.width * MIN(config->strip_rows, ctx.height), (size_t)config->rect_size * config->rect_size) * src_bytes;
+    ctx.buf = heap_caps_malloc(buf_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    ESP_RETURN_ON_FALSE(ctx.buf, ESP_ERR_NO_MEM, TAG, "no mem for bench buffer");
+    memset(ctx.buf, 0xA5, buf_size);
+
+    *count = 0;
+    for (int w = 0; w < BENCH_MAX; w++) {
+        if (w == BENCH_INIT && !config->run_init) {
+            continue;
+        }
+        ESP_GOTO_ON_ERROR(bench_workload(&ctx, w, &results[*count]), err, TAG, "workload %s failed", workload_names[w]);
+        (*count)++;
+    }
+
+err:
+    heap_caps_free(ctx.buf);
+    return ret;
+}
+
+void bench_print(esp_lcd_panel_handle_t panel, const bench_result_t *results, size_t count)
+{
+    // one JSON object per line, easy to collect from the console and compare across builds
+    for (size_t i = 0; i < count; i++) {
+        const bench_result_t *r = &results[i];
+        printf("{\"model\":\"%s\",\"workload\":\"%s\",\"calls\":%u,\"bytes_per_call\":%u,\"cpu_us\":%u,\"wall_us\":%u,"
+               "\"wire_us\":%u,\"fps_ceiling\":%.1f,\"fps_measured\":%.1f,\"wire_utilization\":%.3f,\"commands_per_call\":%u,"
+               "\"color_trans_per_call\":%u}\n",
+               esp32s3_4dlcd_model_name(panel), workload_names[r->workload], (unsigned)r->calls, (unsigned)r->bytes_per_call,
+               (unsigned)r->cpu_us, (unsigned)r->wall_us, (unsigned)r->wire_us, r->fps_ceiling, r->fps_measured, r->wire_utilization,
+               (unsigned)r->commands_per_call, (unsigned)r->color_trans_per_call);
+    }
+}
+
+typedef struct {
+    bench_panel_t *panel;
+    SemaphoreHandle_t done;
+} bench_task_arg_t;
+
+static void bench_task(void *arg)
+{
+    bench_task_arg_t *task_arg = arg;
+    bench_panel_t *p = task_arg->panel;
+    p->start_us = esp_timer_get_time();
+    p->ret = bench_run(p->panel, &p->config, p->results, &p->count);
+    p->end_us = esp_timer_get_time();
+    p->bytes = 0;
+    for (size_t i = 0; i < p->count; i++) {
+        p->bytes += (uint64_t)p->results[i].bytes_per_call * p->results[i].calls;
+    }
+    xSemaphoreGive(task_arg->done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t bench_run_parallel(bench_panel_t *panels, size_t num_panels)
+{
+    ESP_RETURN_ON_FALSE(panels && num_panels, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp_err_t ret = ESP_OK;
+    size_t started = 0;
+    bench_task_arg_t *args = calloc(num_panels, sizeof(bench_task_arg_t));
+    ESP_RETURN_ON_FALSE(args, ESP_ERR_NO_MEM, TAG, "no mem for bench tasks");
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(num_panels, 0);
+    ESP_GOTO_ON_FALSE(done, ESP_ERR_NO_MEM, err, TAG, "no mem for bench semaphore");
+
+    for (; started < num_panels; started++) {
+        args[started] = (bench_task_arg_t) {
+            .panel = &panels[started],
+            .done = done,
+        };
+        if (xTaskCreatePinnedToCore(bench_task, "bench", BENCH_TASK_STACK, &args[started], BENCH_TASK_PRIO, NULL,
+                                    panels[started].core) != pdPASS) {
+            ESP_LOGE(TAG, "create bench task for panel %u failed", (unsigned)started);
+            ret = ESP_ERR_NO_MEM;
+            break;
+        }
+    }
+    // the tasks started use the arguments until they finish
+    for (size_t i = 0; i < started; i++) {
+        xSemaphoreTake(done, portMAX_DELAY);
+    }
+    for (size_t i = 0; i < started && ret == ESP_OK; i++) {
+        ret = panels[i].ret;
+    }
+    vSemaphoreDelete(done);
+
+err:
+    free(args);
+    return ret;
+}
+
+void bench_print_parallel(const bench_panel_t *panels, size_t num_panels)
+{
+    int64_t start_us = INT64_MAX;
+    int64_t end_us = INT64_MIN;
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < num_panels; i++) {
+        const bench_panel_t *p = &panels[i];
+        bench_print(p->panel, p->results, p->count);
+        int64_t us = p->end_us - p->start_us;
+        printf("{\"model\":\"%s\",\"workload\":\"parallel\",\"core\":%d,\"bytes\":%llu,\"us\":%lld,"
+               "\"mbytes_per_s\":%.2f}\n",
+               esp32s3_4dlcd_model_name(p->panel), (int)p->core, (unsigned long long)p->bytes, (long long)us,
+               us ? (double)p->bytes / us : 0);
+        start_us = MIN(start_us, p->start_us);
+        end_us = MAX(end_us, p->end_us);
+        bytes += p->bytes;
+    }
+    // every panel over the span they ran in together: above the fastest single panel if they did not serialise
+    int64_t us = end_us - start_us;
+    printf("{\"model\":\"combined\",\"workload\":\"parallel\",\"panels\":%u,\"bytes\":%llu,\"us\":%lld,"
+           "\"mbytes_per_s\":%.2f}\n",
+           (unsigned)num_panels, (unsigned long long)bytes, (long long)us, us ? (double)bytes / us : 0);
+}
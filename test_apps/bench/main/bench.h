@@ -0,0 +1,160 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file
+ * @brief Throughput benchmark for 4D Systems' ESP32-S3 series displays
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "esp32s3_4dlcd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Benchmark workloads.
+ *
+ */
+typedef enum {
+    BENCH_FULL_FRAME,               /*!< Whole unrotated frame through `esp32s3_4dlcd_draw_lines`, no frame buffer */
+    BENCH_STRIP,                    /*!< Full width strips through `esp_lcd_panel_draw_bitmap` */
+    BENCH_SMALL_RECT,               /*!< Small squares through `esp_lcd_panel_draw_bitmap` */
+    BENCH_FILL,                     /*!< Whole unrotated frame through `esp32s3_4dlcd_fill_rect` */
+    BENCH_INIT,                     /*!< `esp_lcd_panel_reset` followed by `esp_lcd_panel_init` */
+    BENCH_MAX,                      /*!< Number of workloads */
+} bench_workload_t;
+
+/**
+ * @brief Benchmark configuration.
+ *
+ */
+typedef struct {
+    uint32_t pclk_hz;           /*!< Bus clock the panel IO was created with, for the wire time model */
+    uint8_t bus_width;          /*!< Data lines carrying pixel data, 1 for SPI and 4 for QSPI */
+    int iterations;             /*!< Calls per workload */
+    int strip_rows;             /*!< Rows per strip */
+    int rect_size;              /*!< Side of the small squares, in pixels */
+    bool run_init;              /*!< Also time reset and init, which blanks the panel and reloads its registers */
+} bench_config_t;
+
+/**
+ * @brief Default benchmark configuration for the board selected in menuconfig
+ *
+ */
+#define BENCH_CONFIG_DEFAULT()                                  \
+    {                                                           \
+        .pclk_hz = LCD_SPI_PCLK_MHZ * 1000 * 1000,              \
+        .bus_width = LCD_BUS_WIDTH,                             \
+        .iterations = 20,                                       \
+        .strip_rows = 16,                                       \
+        .rect_size = 32,                                        \
+        .run_init = false,                                      \
+    }
+
+/**
+ * @brief Result of one benchmark workload, times are averages per call.
+ *
+ */
+typedef struct {
+    bench_workload_t workload;
+    uint32_t calls;                 /*!< Calls made */
+    uint32_t bytes_per_call;        /*!< Pixel bytes sent per call */
+    uint32_t cpu_us;                /*!< Time until the call returned, the driver overhead the caller sees */
+    uint32_t wall_us;               /*!< Time until the bus was idle again, divided by the calls */
+    uint32_t wire_us;               /*!< Time the pixel bytes need on the wire at the configured clock, commands excluded */
+    float fps_ceiling;              /*!< Calls per second if limited only by the slower of CPU and wire time */
+    float fps_measured;             /*!< Calls per second actually sustained */
+    float wire_utilization;         /*!< `wire_us` over `wall_us`: the share of the bus' theoretical throughput achieved */
+    uint32_t commands_per_call;     /*!< Commands sent per call, 0 unless `CONFIG_ESP32S3_4DLCD_PERF_COUNTERS` is enabled */
+    uint32_t color_trans_per_call;  /*!< Colour transactions per call */
+} bench_result_t;
+
+/**
+ * @brief Time `bytes` take on a bus, ignoring command phases and gaps between transactions
+ *
+ * @param[in] bytes Bytes sent
+ * @param[in] pclk_hz Bus clock
+ * @param[in] bus_width Data lines
+ * @return Time in microseconds, 0 if the clock or width is 0
+ */
+uint32_t bench_wire_time_us(size_t bytes, uint32_t pclk_hz, uint8_t bus_width);
+
+/**
+ * @brief Run the benchmark workloads on a panel
+ *
+ * @note  The panel must have been initialised and is drawn over. Run it for each model to compare them; panels on
+ *        separate buses may be benchmarked from separate tasks at the same time. Allocates one strip of internal
+ *        DMA memory for the duration of the call.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_esp32s3_4dlcd`
+ * @param[in] config Benchmark configuration
+ * @param[out] results Array of at least `BENCH_MAX` results
+ * @param[out] count Returned number of results filled
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t bench_run(esp_lcd_panel_handle_t panel, const bench_config_t *config, bench_result_t *results, size_t *count);
+
+/**
+ * @brief Print benchmark results to stdout, one JSON object per line
+ *
+ * @param[in] panel LCD panel handle the results were measured on
+ * @param[in] results Results returned by `bench_run`
+ * @param[in] count Number of results
+ */
+void bench_print(esp_lcd_panel_handle_t panel, const bench_result_t *results, size_t count);
+
+/**
+ * @brief One panel of a parallel run, and what it measured.
+ *
+ */
+typedef struct {
+    esp_lcd_panel_handle_t panel;   /*!< Panel, on a bus of its own */
+    bench_config_t config;          /*!< Benchmark configuration of this panel */
+    BaseType_t core;                /*!< Core the task benchmarking this panel is pinned to */
+    bench_result_t results[BENCH_MAX];  /*!< Results of `bench_run` on this panel */
+    size_t count;                   /*!< Number of results filled */
+    uint64_t bytes;                 /*!< Pixel bytes sent over all workloads */
+    int64_t start_us;               /*!< When the task started its workloads */
+    int64_t end_us;                 /*!< When the task finished them */
+    esp_err_t ret;                  /*!< What `bench_run` returned */
+} bench_panel_t;
+
+/**
+ * @brief Run the benchmark workloads on several panels at once, each from its own task pinned to its core
+ *
+ * @note  The panels must be on separate buses and initialised. Returns once every task has finished.
+ *
+ * @param[inout] panels Panels with their configuration and core, filled with what each measured
+ * @param[in] num_panels Number of panels
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NO_MEM        if a task could not be created
+ *          - the first error of `bench_run` on any panel
+ *          - ESP_OK                on success
+ */
+esp_err_t bench_run_parallel(bench_panel_t *panels, size_t num_panels);
+
+/**
+ * @brief Print the results of a parallel run: those of each panel as `bench_print` does, then the throughput of each
+ *        panel over its own run and of all panels over the time they ran together, one JSON object per line
+ *
+ * @param[in] panels Panels measured by `bench_run_parallel`
+ * @param[in] num_panels Number of panels
+ */
+void bench_print_parallel(const bench_panel_t *panels, size_t num_panels);
+
+#ifdef __cplusplus
+}
+#endif
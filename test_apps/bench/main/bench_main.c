@@ -0,0 +1,98 @@
+/*
+ * 4D Systems Pty Ltd
+ * www.4dsystems.com.au
+ *
+ * SPDX-FileCopyrightText: 
+ *   - 4D Systems Pty Ltd
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "esp_log.h"
+#include "esp_check.h"
+#include "driver/spi_master.h"
+#include "esp_lcd_panel_io.h"
+
+#include "bench.h"
+
+#if CONFIG_LCD_INTERFACE_RGB
+#error "The benchmark drives SPI and QSPI panels, select one in menuconfig"
+#endif
+
+static const char *TAG = "bench_main";
+
+#if CONFIG_BENCH_SECOND_PANEL
+#if CONFIG_BENCH_SECOND_MODEL_24
+#define BENCH_SECOND_MODEL  ESP32S3_4DLCD_MODEL_24
+#elif CONFIG_BENCH_SECOND_MODEL_28
+#define BENCH_SECOND_MODEL  ESP32S3_4DLCD_MODEL_28
+#elif CONFIG_BENCH_SECOND_MODEL_32
+#define BENCH_SECOND_MODEL  ESP32S3_4DLCD_MODEL_32
+#else
+#define BENCH_SECOND_MODEL  ESP32S3_4DLCD_MODEL_35
+#endif
+
+// The second panel of the dual display rig, on SPI3 with pins of its own
+static esp_lcd_panel_handle_t second_panel_new(void)
+{
+    spi_bus_config_t bus_config = ESP32S3_4DLCD_BUS_SPI_CONFIG_EX(CONFIG_BENCH_SECOND_SCLK_GPIO, CONFIG_BENCH_SECOND_MOSI_GPIO,
+                                                                 -1, 0);
+    ESP_ERROR_CHECK(spi_bus_initialize(SPI3_HOST, &bus_config, SPI_DMA_CH_AUTO));
+
+    esp_lcd_panel_io_handle_t io = NULL;
+    esp_lcd_panel_io_spi_config_t io_config = ESP32S3_4DLCD_IO_SPI_CONFIG_EX(CONFIG_BENCH_SECOND_CS_GPIO,
+                                                                            CONFIG_BENCH_SECOND_DC_GPIO,
+                                                                            LCD_SPI_PCLK_MHZ, NULL, NULL);
+    ESP_ERROR_CHECK(esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)SPI3_HOST, &io_config, &io));
+
+    esp32s3_4dlcd_vendor_config_t vendor_config = {
+        .model = BENCH_SECOND_MODEL,
+    };
+    esp_lcd_panel_dev_config_t panel_config = {
+        .reset_gpio_num = CONFIG_BENCH_SECOND_RST_GPIO,
+        .rgb_ele_order = LCD_COLOR_ORDER,
+        .flags.reset_active_high = LCD_RST_ACTIVE_HIGH,
+        .vendor_config = &vendor_config,
+    };
+    esp_lcd_panel_handle_t panel = NULL;
+    ESP_ERROR_CHECK(esp_lcd_new_panel_esp32s3_4dlcd(io, &panel_config, &panel));
+    ESP_ERROR_CHECK(esp_lcd_panel_reset(panel));
+    ESP_ERROR_CHECK(esp_lcd_panel_init(panel));
+    ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(panel, true));
+    return panel;
+}
+#endif
+
+void app_main(void)
+{
+    spi_bus_config_t bus_config = ESP32S3_4DLCD_BUS_SPI_CONFIG(0);
+    ESP_ERROR_CHECK(spi_bus_initialize(SPI2_HOST, &bus_config, SPI_DMA_CH_AUTO));
+
+    esp_lcd_panel_io_handle_t io = NULL;
+    esp_lcd_panel_io_spi_config_t io_config = ESP32S3_4DLCD_IO_SPI_CONFIG(NULL, NULL);
+    ESP_ERROR_CHECK(esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)SPI2_HOST, &io_config, &io));
+
+    esp_lcd_panel_handle_t panel = NULL;
+    ESP_ERROR_CHECK(esp_lcd_new_esp32s3_4dlcd(io, &panel));
+    ESP_ERROR_CHECK(esp_lcd_panel_reset(panel));
+    ESP_ERROR_CHECK(esp_lcd_panel_init(panel));
+    ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(panel, true));
+
+#if CONFIG_BENCH_SECOND_PANEL
+    // both panels flush at once, one per core, each on its own bus
+    static bench_panel_t panels[2] = {
+        { .config = BENCH_CONFIG_DEFAULT(), .core = 0 },
+        { .config = BENCH_CONFIG_DEFAULT(), .core = 1 },
+    };
+    panels[0].panel = panel;
+    panels[1].panel = second_panel_new();
+    ESP_ERROR_CHECK(bench_run_parallel(panels, 2));
+    bench_print_parallel(panels, 2);
+#else
+    bench_config_t config = BENCH_CONFIG_DEFAULT();
+    bench_result_t results[BENCH_MAX];
+    size_t count;
+    ESP_ERROR_CHECK(bench_run(panel, &config, results, &count));
+    bench_print(panel, results, count);
+#endif
+    ESP_LOGI(TAG, "done");
+}
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+#
+# 4D Systems Pty Ltd
+# www.4dsystems.com.au
+#
+# SPDX-FileCopyrightText: 
+#   - 4D Systems Pty Ltd
+# SPDX-License-Identifier: Apache-2.0
+#
+"""Encode images for esp32s3_4dlcd_draw_image.
+
+The input is a raw RGB565 blob (little endian, as dumped from a frame buffer) or, with Pillow installed, any image
+Pillow can open. The output is the compressed image, or a C array of it with --c-array.
+
+    4dlcd_image.py splash.png splash.4di
+    4dlcd_image.py --raw 480x320 menu.bin menu.c --c-array menu_image
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b'4DIM'
+VERSION = 1
+
+OP_SKIP = 0
+OP_RUN = 1
+OP_LITERAL = 2
+OP_REPEAT = 3
+
+LONG_COUNT = 63
+MAX_COUNT = 64 + 0xFFFF
+
+
+def load_raw(path, size):
+    width, height = (int(v) for v in size.lower().split('x'))
+    with open(path, 'rb') as f:
+        data = f.read()
+    if len(data) != width * height * 2:
+        sys.exit(f'{path}: {len(data)} bytes is not {width}x{height} RGB565')
+    return width, height, list(struct.unpack(f'<{width * height}H', data))
+
+
+def load_image(path):
+    try:
+        from PIL import Image
+    except ImportError:
+        sys.exit('Pillow is needed to read images, or give a raw RGB565 blob with --raw')
+    image = Image.open(path).convert('RGB')
+    pixels = [((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3) for r, g, b in image.getdata()]
+    return image.width, image.height, pixels
+
+
+def op_header(op, count):
+    if count - 1 < LONG_COUNT:
+        return bytes([(op << 6) | (count - 1)])
+    return bytes([(op << 6) | LONG_COUNT]) + struct.pack('<H', count - 64)
+
+
+def encode(width, pixels):
+    """Encode pixels into the op stream and palette, see esp32s3_4dlcd_image.c for the layout."""
+    counts = {}
+    for p in pixels:
+        counts[p] = counts.get(p, 0) + 1
+    palette = sorted(counts, key=counts.get, reverse=True) if len(counts) <= 256 else []
+    index = {c: i for i, c in enumerate(palette)}
+
+    def colour(c):
+        return bytes([index[c]]) if palette else struct.pack('<H', c)
+
+    n = len(pixels)
+    out = bytearray()
+    literal = []
+    last = 0    # colour the decoder repeats, the last one written
+
+    def above(i):
+        return pixels[i - width] if i >= width else 0
+
+    def flush():
+        nonlocal last
+        for start in range(0, len(literal), MAX_COUNT):
+            part = literal[start:start + MAX_COUNT]
+            out.extend(op_header(OP_LITERAL, len(part)))
+            for c in part:
+                out.extend(colour(c))
+        if literal:
+            last = literal[-1]
+        literal.clear()
+
+    i = 0
+    while i < n:
+        skip = 0
+        while i + skip < n and skip < MAX_COUNT and pixels[i + skip] == above(i + skip):
+            skip += 1
+        run = 1
+        while i + run < n and run < MAX_COUNT and pixels[i + run] == pixels[i]:
+            run += 1
+        pending_last = literal[-1] if literal else last
+
+        if skip >= 2 and skip >= run:
+            flush()
+            out.extend(op_header(OP_SKIP, skip))
+            i += skip
+        elif run >= 2 and pixels[i] == pending_last:
+            flush()
+            out.extend(op_header(OP_REPEAT, run))
+            i += run
+        elif run >= 3:
+            flush()
+            out.extend(op_header(OP_RUN, run) + colour(pixels[i]))
+            last = pixels[i]
+            i += run
+        else:
+            literal.append(pixels[i])
+            i += 1
+    flush()
+    return palette, bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Encode an image for esp32s3_4dlcd_draw_image')
+    parser.add_argument('input', help='image file, or raw RGB565 with --raw')
+    parser.add_argument('output', help='compressed image, or C source with --c-array')
+    parser.add_argument('--raw', metavar='WxH', help='input is a raw little endian RGB565 blob of this size')
+    parser.add_argument('--c-array', metavar='NAME', help='write a C array of this name instead of a binary')
+    args = parser.parse_args()
+
+    if args.raw:
+        width, height, pixels = load_raw(args.input, args.raw)
+    else:
+        width, height, pixels = load_image(args.input)
+    if not 0 < width <= 0xFFFF or not 0 < height <= 0xFFFF:
+        sys.exit(f'{args.input}: {width}x{height} is too large')
+
+    palette, stream = encode(width, pixels)
+    image = (MAGIC + struct.pack('<BBHHHI', VERSION, 0, width, height, len(palette), len(stream)) +
+             struct.pack(f'<{len(palette)}H', *palette) + stream)
+
+    if args.c_array:
+        with open(args.output, 'w') as f:
+            f.write('#include <stdint.h>\n#include <stddef.h>\n\n')
+            f.write(f'// {width}x{height}, made from {args.input} by 4dlcd_image.py\n')
+            f.write(f'const uint8_t {args.c_array}[] = {{\n')
+            for start in range(0, len(image), 16):
+                f.write('    ' + ', '.join(f'0x{b:02x}' for b in image[start:start + 16]) + ',\n')
+            f.write('};\n')
+            f.write(f'const size_t {args.c_array}_size = sizeof({args.c_array});\n')
+    else:
+        with open(args.output, 'wb') as f:
+            f.write(image)
+
+    raw = width * height * 2
+    print(f'{width}x{height}, {len(palette) or "no"} palette colours: {raw} bytes raw, {len(image)} encoded '
+          f'({raw / len(image):.1f}:1)')
+
+
+if __name__ == '__main__':
+    main()